@@ -0,0 +1,268 @@
+#include "io/BinaryPersistence.h"
+#include "io/LASFile.h"
+#include "io/LASPersistence.h"
+#include "tiling/OctreeAlgorithms.h"
+#include "tiling/PointOrder.h"
+#include "types/Units.h"
+#include "util/stuff.h"
+
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <unordered_set>
+
+namespace fs = std::experimental::filesystem;
+namespace bpo = boost::program_options;
+
+/**
+ * Compares the point orders of the nodes of an output. The points of all
+ * LAS/LAZ files in the source directory are sorted in Morton order and split
+ * into nodes of 'points-per-node' points, like the nodes that tiling produces.
+ * The points of each node are then written once in each order, as LAZ and as
+ * compressed binary files, and the sizes of the files and the locality of
+ * consecutive points are compared
+ */
+struct Args
+{
+  fs::path source_directory;
+  fs::path output_directory;
+  size_t points_per_node;
+};
+
+static Args
+parse_args(int argc, char** argv)
+{
+  std::string source_directory;
+  std::string output_directory;
+  size_t points_per_node;
+
+  bpo::options_description options("Options");
+  options.add_options()("help,h", "Produce help message")(
+    "source,i",
+    bpo::value<std::string>(&source_directory)->required(),
+    "Source directory containing one or more LAS/LAZ files")(
+    "output,o",
+    bpo::value<std::string>(&output_directory)->required(),
+    "Output directory for the node files")(
+    "points-per-node",
+    bpo::value<size_t>(&points_per_node)->default_value(100'000),
+    "Number of points in each node");
+
+  bpo::variables_map variables;
+  try {
+    bpo::store(bpo::command_line_parser(argc, argv).options(options).run(), variables);
+
+    if (variables.count("help") || variables.empty()) {
+      std::cout << "Usage: " << argv[0] << " [options]\n";
+      options.print(std::cout);
+      std::exit(EXIT_SUCCESS);
+    }
+
+    bpo::notify(variables);
+  } catch (const std::exception& ex) {
+    std::cerr << ex.what() << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  if (!points_per_node) {
+    std::cerr << "points-per-node must be greater than zero" << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  return Args{ source_directory, output_directory, points_per_node };
+}
+
+static PointBuffer
+read_points(const fs::path& directory)
+{
+  std::vector<Vector3<double>> positions;
+  std::vector<uint16_t> intensities;
+  for (const auto& file : get_all_files_in_directory(directory, Recursive::Yes)) {
+    const auto extension = fs::path{ file }.extension();
+    if (extension != ".las" && extension != ".laz")
+      continue;
+
+    const LASFile las_file{ file, LASFile::OpenMode::Read };
+    const auto& las_header = las_file.get_metadata();
+    for (auto point : las_file) {
+      positions.push_back(position_from_las_point(point, las_header));
+      intensities.push_back(point.intensity);
+    }
+  }
+
+  const auto count = positions.size();
+  return { count, std::move(positions), {}, {}, std::move(intensities) };
+}
+
+static AABB
+bounds_of(const std::vector<PointBuffer::PointReference>& points)
+{
+  AABB bounds{ Vector3<double>{ std::numeric_limits<double>::max() },
+               Vector3<double>{ std::numeric_limits<double>::lowest() } };
+  for (const auto& point : points) {
+    bounds.min = Vector3<double>::minByAxis(bounds.min, point.position());
+    bounds.max = Vector3<double>::maxByAxis(bounds.max, point.position());
+  }
+  return bounds;
+}
+
+constexpr static uint32_t LOCALITY_GRID_SIZE = 128;
+
+/**
+ * Locality of consecutive points of a node. The cells are those of a 128^3
+ * grid over the node, which is about the size of the grids that the sampling
+ * strategies use. A switch to a cell that was not visited recently is a likely
+ * cache miss when accessing per-cell data in point order
+ */
+struct Locality
+{
+  double total_distance = 0;
+  size_t cell_switches = 0;
+  size_t distant_cell_switches = 0;
+};
+
+static void
+measure_locality(const std::vector<PointBuffer::PointReference>& points,
+                 const AABB& node_bounds,
+                 Locality& locality)
+{
+  // The bounds of a node are the bounds of its points, which are flat for
+  // e.g. a single point
+  const auto grid_scale = grid_scale_for_extent(node_bounds.extent(), LOCALITY_GRID_SIZE);
+  const auto cell_of = [&](const Vector3<double>& position) {
+    const auto normalized = (position - node_bounds.min).multiply_component_wise(grid_scale);
+    const auto to_index = [](double coordinate) {
+      return std::min(static_cast<int64_t>(coordinate), static_cast<int64_t>(LOCALITY_GRID_SIZE - 1));
+    };
+    return Vector3<int64_t>{ to_index(normalized.x), to_index(normalized.y), to_index(normalized.z) };
+  };
+
+  for (size_t idx = 1; idx < points.size(); ++idx) {
+    const auto previous_position = points[idx - 1].position();
+    const auto position = points[idx].position();
+    locality.total_distance += (position - previous_position).length();
+
+    const auto cell_delta = cell_of(position) - cell_of(previous_position);
+    if (cell_delta == Vector3<int64_t>{ 0, 0, 0 })
+      continue;
+    ++locality.cell_switches;
+    if (std::abs(cell_delta.x) + std::abs(cell_delta.y) + std::abs(cell_delta.z) > 1) {
+      ++locality.distant_cell_switches;
+    }
+  }
+}
+
+static size_t
+total_file_size(const fs::path& directory)
+{
+  size_t total_size = 0;
+  for (const auto& file : fs::directory_iterator(directory)) {
+    total_size += fs::file_size(file.path());
+  }
+  return total_size;
+}
+
+static void
+run_benchmark(const std::vector<std::vector<PointBuffer::PointReference>>& nodes,
+              const std::string& order_name,
+              PointOrder point_order,
+              const Args& args)
+{
+  PointAttributes attributes;
+  attributes.insert(PointAttribute::Position);
+  attributes.insert(PointAttribute::Intensity);
+
+  const auto las_directory = args.output_directory / (order_name + "_laz");
+  const auto binary_directory = args.output_directory / (order_name + "_binz");
+  fs::create_directories(las_directory);
+  fs::create_directories(binary_directory);
+
+  Locality locality;
+  std::chrono::nanoseconds ordering_time{ 0 };
+  {
+    LASPersistence las_persistence{
+      las_directory.string(), attributes, attributes, Compressed::Yes
+    };
+    BinaryPersistence binary_persistence{
+      binary_directory.string(), attributes, attributes, Compressed::Yes
+    };
+
+    for (size_t node_idx = 0; node_idx < nodes.size(); ++node_idx) {
+      auto node_points = nodes[node_idx];
+      const auto node_bounds = bounds_of(node_points);
+      const auto node_name = concat("r", node_idx);
+
+      const auto ordering_start = std::chrono::high_resolution_clock::now();
+      order_points_in_node(node_points, node_bounds, point_order);
+      ordering_time += std::chrono::high_resolution_clock::now() - ordering_start;
+
+      measure_locality(node_points, node_bounds, locality);
+
+      las_persistence.persist_points(
+        std::begin(node_points), std::end(node_points), node_bounds, node_name);
+      binary_persistence.persist_points(
+        std::begin(node_points), std::end(node_points), node_bounds, node_name);
+    }
+  }
+
+  const auto points_count =
+    std::accumulate(std::begin(nodes), std::end(nodes), size_t{ 0 }, [](size_t sum, const auto& node) {
+      return sum + node.size();
+    });
+  const auto transitions = std::max(size_t{ 1 }, points_count - nodes.size());
+
+  std::cout << order_name << ":"
+            << "\n\tLAZ size:                  "
+            << unit::format_with_binary_prefix(total_file_size(las_directory), 2) << "B"
+            << "\n\tCompressed binary size:    "
+            << unit::format_with_binary_prefix(total_file_size(binary_directory), 2) << "B"
+            << "\n\tOrdering time:             "
+            << unit::format_with_metric_prefix(ordering_time.count() / 1e9, 2) << "s"
+            << "\n\tMean consecutive distance: " << (locality.total_distance / transitions)
+            << "\n\tGrid cell switches:        "
+            << (100.0 * locality.cell_switches / transitions) << "%"
+            << "\n\tNon-adjacent cell switches: "
+            << (100.0 * locality.distant_cell_switches / transitions) << "%\n";
+
+  fs::remove_all(las_directory);
+  fs::remove_all(binary_directory);
+}
+
+int
+main(int argc, char** argv)
+{
+  const auto args = parse_args(argc, argv);
+  if (!fs::exists(args.output_directory)) {
+    std::cerr << "Output directory does not exist!\n";
+    return EXIT_FAILURE;
+  }
+
+  auto points = read_points(args.source_directory);
+  if (points.empty()) {
+    std::cerr << "No points found in " << args.source_directory << "\n";
+    return EXIT_FAILURE;
+  }
+
+  std::vector<PointBuffer::PointReference> all_points{ std::begin(points), std::end(points) };
+  const auto bounds = bounds_of(all_points);
+  order_points_in_node(all_points, bounds, PointOrder::Morton);
+
+  std::vector<std::vector<PointBuffer::PointReference>> nodes;
+  for (size_t first = 0; first < all_points.size(); first += args.points_per_node) {
+    const auto last = std::min(all_points.size(), first + args.points_per_node);
+    nodes.emplace_back(std::begin(all_points) + first, std::begin(all_points) + last);
+  }
+
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << "Comparing point orders for " << all_points.size() << " points in "
+            << nodes.size() << " nodes\n\n";
+
+  run_benchmark(nodes, "MORTON", PointOrder::Morton, args);
+  run_benchmark(nodes, "HILBERT", PointOrder::Hilbert, args);
+  run_benchmark(nodes, "LOD_PREFIX", PointOrder::LODPrefix, args);
+
+  return 0;
+}
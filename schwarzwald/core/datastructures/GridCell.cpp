@@ -45,20 +45,11 @@ GridCell::isDistant(const Vector3<double>& p,
                     const double& squaredSpacing,
                     size_t* num_comparisons) const
 {
-  for (const Vector3<double>& point : points) {
-    if (num_comparisons) {
-      ++(*num_comparisons);
-    }
-    if (p.squaredDistanceTo(point) < squaredSpacing) {
-      return false;
-    }
-  }
-
-  return true;
+  return points.all_distant(p, squaredSpacing, num_comparisons);
 }
 
 size_t
 GridCell::content_byte_size() const
 {
-  return vector_byte_size(points) + vector_byte_size(neighbours);
+  return points.content_byte_size() + vector_byte_size(neighbours);
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "datastructures/GridIndex.h"
+#include "datastructures/PositionsSoA.h"
 #include "math/Vector3.h"
 
 #include <math.h>
@@ -11,7 +12,16 @@ class SparseGrid;
 class GridCell
 {
 public:
-  std::vector<Vector3<double>> points;
+  /**
+   * Cells are 5 times as wide as the spacing, so once a node is saturated, the
+   * cells on a surface hold 10 to 20 points and allocate their points anyway.
+   * Cells at the edges of surfaces and the cells of sparse nodes hold only a
+   * few points, which are stored inline. Four inline points keep a cell at
+   * about 190 bytes, while eight would make it about 290 bytes
+   */
+  constexpr static size_t INLINE_POINTS_CAPACITY = 4;
+
+  PositionsSoA<INLINE_POINTS_CAPACITY> points;
   std::vector<GridCell*> neighbours;
 
   GridCell();
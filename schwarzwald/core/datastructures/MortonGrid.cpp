@@ -221,11 +221,7 @@ bool
 MortonGrid::fits_in_cell(const MortonGrid::Cell& cell,
                          const Vector3<double>& point) const
 {
-  return std::all_of(
-    std::begin(cell), std::end(cell), [this, &point](const auto& other_point) {
-      ++_dbg_num_comparisons;
-      return point.squaredDistanceTo(other_point) >= _squared_spacing;
-    });
+  return cell.all_distant(point, _squared_spacing, &_dbg_num_comparisons);
 }
 
 size_t
@@ -2,6 +2,7 @@
 
 #include "MortonIndex.h"
 #include "OctreeNodeIndex.h"
+#include "PositionsSoA.h"
 #include "math/AABB.h"
 
 #include <boost/container/flat_map.hpp>
@@ -28,7 +29,9 @@ struct MortonGrid
   size_t dbg_num_comparisons() const;
 
 private:
-  using Cell = std::vector<Vector3<double>>;
+  // A cell is between 'spacing' and '2 * spacing' wide, so it holds only a
+  // few points
+  using Cell = PositionsSoA<4>;
   bool fits_in_cell(const Cell& cell, const Vector3<double>& point) const;
 
   bool try_add_naive(const Vector3<double>& point, MortonIndex64 point_index);
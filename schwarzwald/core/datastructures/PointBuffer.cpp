@@ -2,6 +2,110 @@
 
 #include "util/stuff.h"
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <numeric>
+#include <utility>
+
+constexpr size_t COLUMN_ALIGNMENT = 64;
+
+constexpr std::array<size_t, 15> COLUMN_ELEMENT_SIZES = {
+  sizeof(Vector3<double>), // Position
+  sizeof(Vector3<uint8_t>), // RGB
+  sizeof(uint16_t),        // Intensity
+  sizeof(uint8_t),         // Classification
+  sizeof(Vector3<float>),  // Normal
+  sizeof(double),          // GPSTime
+  sizeof(uint8_t),         // EdgeOfFlightLine
+  sizeof(uint8_t),         // NumberOfReturns
+  sizeof(uint8_t),         // ReturnNumber
+  sizeof(uint16_t),        // PointSourceID
+  sizeof(int8_t),          // ScanAngleRank
+  sizeof(uint8_t),         // ScanDirectionFlag
+  sizeof(uint8_t),         // UserData
+  sizeof(Vector3<float>),  // LocalPosition
+  sizeof(uint64_t)         // PointID
+};
+
+/**
+ * Capacity that a PointBuffer grows to if it has to reallocate to fit 'count' points
+ */
+static size_t
+grown_capacity(size_t current_capacity, size_t count)
+{
+  return std::max(count, std::max(size_t{ 16 }, current_capacity + current_capacity / 2));
+}
+
+PointBuffer::Layout
+PointBuffer::Layout::for_columns(ColumnMask columns, size_t capacity)
+{
+  Layout layout;
+  layout.columns = columns;
+  layout.capacity = capacity;
+  for (size_t column = 0; column < NumColumns; ++column) {
+    if (!layout.has_column(column))
+      continue;
+    layout.offsets[column] = layout.byte_size;
+    const auto column_size = capacity * COLUMN_ELEMENT_SIZES[column];
+    layout.byte_size += (column_size + COLUMN_ALIGNMENT - 1) / COLUMN_ALIGNMENT * COLUMN_ALIGNMENT;
+  }
+  return layout;
+}
+
+void
+PointBuffer::AlignedDelete::operator()(std::byte* data) const
+{
+  ::operator delete[](data, std::align_val_t{ COLUMN_ALIGNMENT });
+}
+
+PointBuffer::Storage
+PointBuffer::allocate(const Layout& layout)
+{
+  if (!layout.byte_size)
+    return {};
+  auto data = static_cast<std::byte*>(
+    ::operator new[](layout.byte_size, std::align_val_t{ COLUMN_ALIGNMENT }));
+  // All attribute types are zero-initialized by default
+  std::memset(data, 0, layout.byte_size);
+  return Storage{ data };
+}
+
+PointBuffer::ColumnMask
+PointBuffer::columns_for_schema(const PointAttributes& schema)
+{
+  ColumnMask columns = 0;
+  for (auto attribute : schema) {
+    columns |= ColumnMask{ 1 } << static_cast<size_t>(attribute);
+  }
+  return columns;
+}
+
+PointBuffer::ColumnMask
+PointBuffer::columns_for_point(PointConstReference point)
+{
+  ColumnMask columns = ColumnMask{ 1 } << PositionColumn;
+  const auto add_if = [&columns](const void* attribute, Column column) {
+    if (attribute)
+      columns |= ColumnMask{ 1 } << column;
+  };
+  add_if(point.rgbColor(), RGBColumn);
+  add_if(point.intensity(), IntensityColumn);
+  add_if(point.classification(), ClassificationColumn);
+  add_if(point.normal(), NormalColumn);
+  add_if(point.gps_time(), GPSTimeColumn);
+  add_if(point.edge_of_flight_line(), EdgeOfFlightLineColumn);
+  add_if(point.number_of_returns(), NumberOfReturnsColumn);
+  add_if(point.return_number(), ReturnNumberColumn);
+  add_if(point.point_source_id(), PointSourceIDColumn);
+  add_if(point.scan_angle_rank(), ScanAngleRankColumn);
+  add_if(point.scan_direction_flag(), ScanDirectionFlagColumn);
+  add_if(point.user_data(), UserDataColumn);
+  add_if(point.point_id(), PointIDColumn);
+  return columns;
+}
+
 PointBuffer::PointBuffer()
   : _count(0)
 {}
@@ -21,232 +125,110 @@ PointBuffer::PointBuffer(size_t count,
                          std::vector<int8_t> scan_angle_ranks,
                          std::vector<uint8_t> user_data)
   : _count(count)
-  , _positions(std::move(positions))
-  , _rgbColors(std::move(rgbColors))
-  , _normals(std::move(normals))
-  , _intensities(std::move(intensities))
-  , _classifications(std::move(classifications))
-  , _edge_of_flight_lines(std::move(edge_of_flight_lines))
-  , _gps_times(std::move(gps_times))
-  , _number_of_returns(std::move(number_of_returns))
-  , _return_numbers(std::move(return_numbers))
-  , _point_source_ids(std::move(point_source_ids))
-  , _scan_direction_flags(std::move(scan_direction_flags))
-  , _scan_angle_ranks(std::move(scan_angle_ranks))
-  , _user_data(std::move(user_data))
-{
-  if (_positions.size() != count) {
+{
+  if (positions.size() != count) {
     throw std::invalid_argument{ "positions.size() does not equal count!" };
   }
-  if (_rgbColors.size() && _rgbColors.size() != count) {
+  if (rgbColors.size() && rgbColors.size() != count) {
     throw std::invalid_argument{ "rgbColors.size() does not equal count!" };
   }
-  if (_normals.size() && _normals.size() != count) {
+  if (normals.size() && normals.size() != count) {
     throw std::invalid_argument{ "normals.size() does not equal count!" };
   }
-  if (_intensities.size() && _intensities.size() != count) {
+  if (intensities.size() && intensities.size() != count) {
     throw std::invalid_argument{ "intensities.size() does not equal count!" };
   }
-  if (_classifications.size() && _classifications.size() != count) {
-    throw std::invalid_argument{ "positions.size() does not equal count!" };
+  if (classifications.size() && classifications.size() != count) {
+    throw std::invalid_argument{ "classifications.size() does not equal count!" };
   }
-  if (_edge_of_flight_lines.size() && _edge_of_flight_lines.size() != count) {
+  if (edge_of_flight_lines.size() && edge_of_flight_lines.size() != count) {
     throw std::invalid_argument{ "edge_of_flight_lines.size() does not equal count!" };
   }
-  if (_gps_times.size() && _gps_times.size() != count) {
+  if (gps_times.size() && gps_times.size() != count) {
     throw std::invalid_argument{ "gps_times.size() does not equal count!" };
   }
-  if (_number_of_returns.size() && _number_of_returns.size() != count) {
+  if (number_of_returns.size() && number_of_returns.size() != count) {
     throw std::invalid_argument{ "number_of_returns.size() does not equal count!" };
   }
-  if (_return_numbers.size() && _return_numbers.size() != count) {
+  if (return_numbers.size() && return_numbers.size() != count) {
     throw std::invalid_argument{ "return_numbers.size() does not equal count!" };
   }
-  if (_point_source_ids.size() && _point_source_ids.size() != count) {
+  if (point_source_ids.size() && point_source_ids.size() != count) {
     throw std::invalid_argument{ "point_source_ids.size() does not equal count!" };
   }
-  if (_scan_direction_flags.size() && _scan_direction_flags.size() != count) {
+  if (scan_direction_flags.size() && scan_direction_flags.size() != count) {
     throw std::invalid_argument{ "scan_direction_flags.size() does not equal count!" };
   }
-  if (_scan_angle_ranks.size() && _scan_angle_ranks.size() != count) {
+  if (scan_angle_ranks.size() && scan_angle_ranks.size() != count) {
     throw std::invalid_argument{ "scan_angle_ranks.size() does not equal count!" };
   }
-  if (_user_data.size() && _user_data.size() != count) {
+  if (user_data.size() && user_data.size() != count) {
     throw std::invalid_argument{ "user_data.size() does not equal count!" };
   }
+
+  ColumnMask columns = ColumnMask{ 1 } << PositionColumn;
+  const auto add_if_not_empty = [&columns](const auto& attribute, Column column) {
+    if (!attribute.empty())
+      columns |= ColumnMask{ 1 } << column;
+  };
+  add_if_not_empty(rgbColors, RGBColumn);
+  add_if_not_empty(normals, NormalColumn);
+  add_if_not_empty(intensities, IntensityColumn);
+  add_if_not_empty(classifications, ClassificationColumn);
+  add_if_not_empty(edge_of_flight_lines, EdgeOfFlightLineColumn);
+  add_if_not_empty(gps_times, GPSTimeColumn);
+  add_if_not_empty(number_of_returns, NumberOfReturnsColumn);
+  add_if_not_empty(return_numbers, ReturnNumberColumn);
+  add_if_not_empty(point_source_ids, PointSourceIDColumn);
+  add_if_not_empty(scan_direction_flags, ScanDirectionFlagColumn);
+  add_if_not_empty(scan_angle_ranks, ScanAngleRankColumn);
+  add_if_not_empty(user_data, UserDataColumn);
+
+  _layout = Layout::for_columns(columns, count);
+  _storage = allocate(_layout);
+
+  const auto copy_column = [this](const auto& attribute, Column column) {
+    using Attribute_t = typename std::decay_t<decltype(attribute)>::value_type;
+    std::copy(attribute.begin(), attribute.end(), column_data<Attribute_t>(column));
+  };
+  copy_column(positions, PositionColumn);
+  copy_column(rgbColors, RGBColumn);
+  copy_column(normals, NormalColumn);
+  copy_column(intensities, IntensityColumn);
+  copy_column(classifications, ClassificationColumn);
+  copy_column(edge_of_flight_lines, EdgeOfFlightLineColumn);
+  copy_column(gps_times, GPSTimeColumn);
+  copy_column(number_of_returns, NumberOfReturnsColumn);
+  copy_column(return_numbers, ReturnNumberColumn);
+  copy_column(point_source_ids, PointSourceIDColumn);
+  copy_column(scan_direction_flags, ScanDirectionFlagColumn);
+  copy_column(scan_angle_ranks, ScanAngleRankColumn);
+  copy_column(user_data, UserDataColumn);
 }
 
 PointBuffer::PointBuffer(gsl::span<PointReference> points)
-  : _count(points.size())
+  : _count(0)
 {
-  if (!_count)
+  if (points.empty())
     return;
 
-  const auto& first_point = points.at(0);
-
-  _positions.reserve(_count);
-  if (first_point.rgbColor() != nullptr) {
-    _rgbColors.reserve(_count);
-  }
-  if (first_point.normal() != nullptr) {
-    _normals.reserve(_count);
-  }
-  if (first_point.intensity() != nullptr) {
-    _intensities.reserve(_count);
-  }
-  if (first_point.classification() != nullptr) {
-    _classifications.reserve(_count);
-  }
-  if (first_point.edge_of_flight_line() != nullptr) {
-    _edge_of_flight_lines.reserve(_count);
-  }
-  if (first_point.gps_time() != nullptr) {
-    _gps_times.reserve(_count);
-  }
-  if (first_point.number_of_returns() != nullptr) {
-    _number_of_returns.reserve(_count);
-  }
-  if (first_point.point_source_id() != nullptr) {
-    _point_source_ids.reserve(_count);
-  }
-  if (first_point.return_number() != nullptr) {
-    _return_numbers.reserve(_count);
-  }
-  if (first_point.scan_angle_rank() != nullptr) {
-    _scan_angle_ranks.reserve(_count);
-  }
-  if (first_point.scan_direction_flag() != nullptr) {
-    _scan_direction_flags.reserve(_count);
-  }
-  if (first_point.user_data() != nullptr) {
-    _user_data.reserve(_count);
-  }
-
+  _layout = Layout::for_columns(columns_for_point(points[0]), points.size());
+  _storage = allocate(_layout);
   for (auto& point : points) {
-    _positions.push_back(point.position());
-    if (point.rgbColor()) {
-      _rgbColors.push_back(*point.rgbColor());
-    }
-    if (point.normal()) {
-      _normals.push_back(*point.normal());
-    }
-    if (point.intensity()) {
-      _intensities.push_back(*point.intensity());
-    }
-    if (point.classification()) {
-      _classifications.push_back(*point.classification());
-    }
-    if (point.edge_of_flight_line()) {
-      _edge_of_flight_lines.push_back(*point.edge_of_flight_line());
-    }
-    if (point.gps_time()) {
-      _gps_times.push_back(*point.gps_time());
-    }
-    if (point.number_of_returns()) {
-      _number_of_returns.push_back(*point.number_of_returns());
-    }
-    if (point.point_source_id()) {
-      _point_source_ids.push_back(*point.point_source_id());
-    }
-    if (point.return_number()) {
-      _return_numbers.push_back(*point.return_number());
-    }
-    if (point.scan_angle_rank()) {
-      _scan_angle_ranks.push_back(*point.scan_angle_rank());
-    }
-    if (point.scan_direction_flag()) {
-      _scan_direction_flags.push_back(*point.scan_direction_flag());
-    }
-    if (point.user_data()) {
-      _user_data.push_back(*point.user_data());
-    }
+    write_point(_count++, point);
   }
 }
 
 PointBuffer::PointBuffer(gsl::span<PointConstReference> points)
-  : _count(points.size())
+  : _count(0)
 {
-  if (!_count)
+  if (points.empty())
     return;
 
-  const auto& first_point = points.at(0);
-
-  _positions.reserve(_count);
-  if (first_point.rgbColor() != nullptr) {
-    _rgbColors.reserve(_count);
-  }
-  if (first_point.normal() != nullptr) {
-    _normals.reserve(_count);
-  }
-  if (first_point.intensity() != nullptr) {
-    _intensities.reserve(_count);
-  }
-  if (first_point.classification() != nullptr) {
-    _classifications.reserve(_count);
-  }
-  if (first_point.edge_of_flight_line() != nullptr) {
-    _edge_of_flight_lines.reserve(_count);
-  }
-  if (first_point.gps_time() != nullptr) {
-    _gps_times.reserve(_count);
-  }
-  if (first_point.number_of_returns() != nullptr) {
-    _number_of_returns.reserve(_count);
-  }
-  if (first_point.point_source_id() != nullptr) {
-    _point_source_ids.reserve(_count);
-  }
-  if (first_point.return_number() != nullptr) {
-    _return_numbers.reserve(_count);
-  }
-  if (first_point.scan_angle_rank() != nullptr) {
-    _scan_angle_ranks.reserve(_count);
-  }
-  if (first_point.scan_direction_flag() != nullptr) {
-    _scan_direction_flags.reserve(_count);
-  }
-  if (first_point.user_data() != nullptr) {
-    _user_data.reserve(_count);
-  }
-
+  _layout = Layout::for_columns(columns_for_point(points[0]), points.size());
+  _storage = allocate(_layout);
   for (auto& point : points) {
-    _positions.push_back(point.position());
-    if (point.rgbColor()) {
-      _rgbColors.push_back(*point.rgbColor());
-    }
-    if (point.normal()) {
-      _normals.push_back(*point.normal());
-    }
-    if (point.intensity()) {
-      _intensities.push_back(*point.intensity());
-    }
-    if (point.classification()) {
-      _classifications.push_back(*point.classification());
-    }
-    if (point.edge_of_flight_line()) {
-      _edge_of_flight_lines.push_back(*point.edge_of_flight_line());
-    }
-    if (point.gps_time()) {
-      _gps_times.push_back(*point.gps_time());
-    }
-    if (point.number_of_returns()) {
-      _number_of_returns.push_back(*point.number_of_returns());
-    }
-    if (point.point_source_id()) {
-      _point_source_ids.push_back(*point.point_source_id());
-    }
-    if (point.return_number()) {
-      _return_numbers.push_back(*point.return_number());
-    }
-    if (point.scan_angle_rank()) {
-      _scan_angle_ranks.push_back(*point.scan_angle_rank());
-    }
-    if (point.scan_direction_flag()) {
-      _scan_direction_flags.push_back(*point.scan_direction_flag());
-    }
-    if (point.user_data()) {
-      _user_data.push_back(*point.user_data());
-    }
+    write_point(_count++, point);
   }
 }
 
@@ -257,74 +239,126 @@ PointBuffer::PointBuffer(size_t count, const PointAttributes& attributes)
     throw std::invalid_argument{ "PointAttribute::Position is mandatory for PointBuffer" };
   }
 
-  _positions.resize(count);
-
-  if (has_attribute(attributes, PointAttribute::Classification)) {
-    _classifications.resize(count);
-  }
-
-  if (has_attribute(attributes, PointAttribute::EdgeOfFlightLine)) {
-    _edge_of_flight_lines.resize(count);
-  }
-
-  if (has_attribute(attributes, PointAttribute::GPSTime)) {
-    _gps_times.resize(count);
-  }
+  _layout = Layout::for_columns(columns_for_schema(attributes), count);
+  _storage = allocate(_layout);
+}
 
-  if (has_attribute(attributes, PointAttribute::Intensity)) {
-    _intensities.resize(count);
+PointBuffer::PointBuffer(const PointBuffer& other)
+  : _count(other._count)
+  , _has_local_positions(other._has_local_positions)
+  , _local_origin(other._local_origin)
+{
+  // Copies are not expected to grow, so they only allocate what they need
+  _layout = Layout::for_columns(other._layout.columns, other._count);
+  _storage = allocate(_layout);
+  if (!_count)
+    return;
+  for (size_t column = 0; column < NumColumns; ++column) {
+    if (!_layout.has_column(column))
+      continue;
+    std::memcpy(_storage.get() + _layout.offsets[column],
+                other._storage.get() + other._layout.offsets[column],
+                _count * COLUMN_ELEMENT_SIZES[column]);
   }
+}
 
-  if (has_attribute(attributes, PointAttribute::Normal)) {
-    _normals.resize(count);
-  }
+PointBuffer::PointBuffer(PointBuffer&& other) noexcept
+  : _count(other._count)
+  , _has_local_positions(other._has_local_positions)
+  , _local_origin(other._local_origin)
+  , _layout(other._layout)
+  , _storage(std::move(other._storage))
+{
+  other._count = 0;
+  other._layout = {};
+}
 
-  if (has_attribute(attributes, PointAttribute::NumberOfReturns)) {
-    _number_of_returns.resize(count);
+PointBuffer&
+PointBuffer::operator=(const PointBuffer& other)
+{
+  if (this != &other) {
+    *this = PointBuffer{ other };
   }
+  return *this;
+}
 
-  if (has_attribute(attributes, PointAttribute::PointSourceID)) {
-    _point_source_ids.resize(count);
-  }
+PointBuffer&
+PointBuffer::operator=(PointBuffer&& other) noexcept
+{
+  _count = other._count;
+  _has_local_positions = other._has_local_positions;
+  _local_origin = other._local_origin;
+  _layout = other._layout;
+  _storage = std::move(other._storage);
+  other._count = 0;
+  other._layout = {};
+  return *this;
+}
 
-  if (has_attribute(attributes, PointAttribute::ReturnNumber)) {
-    _return_numbers.resize(count);
+std::pair<PointBuffer::Layout, PointBuffer::Storage>
+PointBuffer::relayout(ColumnMask columns, size_t capacity)
+{
+  auto new_layout = Layout::for_columns(columns, capacity);
+  auto new_storage = allocate(new_layout);
+  const auto num_points_to_copy = std::min(_count, capacity);
+  for (size_t column = 0; column < NumColumns && num_points_to_copy; ++column) {
+    if (!new_layout.has_column(column) || !_layout.has_column(column))
+      continue;
+    std::memcpy(new_storage.get() + new_layout.offsets[column],
+                _storage.get() + _layout.offsets[column],
+                num_points_to_copy * COLUMN_ELEMENT_SIZES[column]);
   }
 
-  if (has_attribute(attributes, PointAttribute::RGB)) {
-    _rgbColors.resize(count);
-  }
+  auto old_layout = std::exchange(_layout, new_layout);
+  auto old_storage = std::exchange(_storage, std::move(new_storage));
+  return { old_layout, std::move(old_storage) };
+}
 
-  if (has_attribute(attributes, PointAttribute::ScanAngleRank)) {
-    _scan_angle_ranks.resize(count);
-  }
+void
+PointBuffer::grow_to_fit(size_t count)
+{
+  if (count <= _layout.capacity)
+    return;
+  relayout(_layout.columns, grown_capacity(_layout.capacity, count));
+}
 
-  if (has_attribute(attributes, PointAttribute::ScanDirectionFlag)) {
-    _scan_direction_flags.resize(count);
-  }
+void
+PointBuffer::write_point(size_t index, PointConstReference point)
+{
+  set_position_at(index, point.position());
 
-  if (has_attribute(attributes, PointAttribute::UserData)) {
-    _user_data.resize(count);
-  }
+  // Attributes that the point does not have are set to their default values,
+  // since the slot might have been used by a previous point
+  const auto write_attribute = [this, index](const auto* attribute, Column column) {
+    using Attribute_t = std::decay_t<decltype(*attribute)>;
+    auto target = column_data<Attribute_t>(column);
+    if (target) {
+      target[index] = attribute ? *attribute : Attribute_t{};
+    }
+  };
+  write_attribute(point.rgbColor(), RGBColumn);
+  write_attribute(point.normal(), NormalColumn);
+  write_attribute(point.intensity(), IntensityColumn);
+  write_attribute(point.classification(), ClassificationColumn);
+  write_attribute(point.edge_of_flight_line(), EdgeOfFlightLineColumn);
+  write_attribute(point.gps_time(), GPSTimeColumn);
+  write_attribute(point.number_of_returns(), NumberOfReturnsColumn);
+  write_attribute(point.return_number(), ReturnNumberColumn);
+  write_attribute(point.point_source_id(), PointSourceIDColumn);
+  write_attribute(point.scan_direction_flag(), ScanDirectionFlagColumn);
+  write_attribute(point.scan_angle_rank(), ScanAngleRankColumn);
+  write_attribute(point.user_data(), UserDataColumn);
+  write_attribute(point.point_id(), PointIDColumn);
 }
 
 void
 PointBuffer::push_point(PointConstReference point)
 {
-  _positions.push_back(point.position());
-  if (point.rgbColor()) {
-    _rgbColors.push_back(*point.rgbColor());
-  }
-  if (point.normal()) {
-    _normals.push_back(*point.normal());
-  }
-  if (point.intensity()) {
-    _intensities.push_back(*point.intensity());
-  }
-  if (point.classification()) {
-    _classifications.push_back(*point.classification());
+  if (!_layout.columns) {
+    _layout.columns = columns_for_point(point);
   }
-  ++_count;
+  grow_to_fit(_count + 1);
+  write_point(_count++, point);
 }
 
 PointBuffer::PointConstReference
@@ -342,156 +376,110 @@ PointBuffer::get_point(size_t point_index)
 void
 PointBuffer::append_buffer(const PointBuffer& other)
 {
-  _positions.insert(_positions.end(), other.positions().begin(), other.positions().end());
-
-  const auto appendAttributes = [](auto& sourceAttributeContainer,
-                                   const auto& targetAttributeContainer,
-                                   auto sourceHasAttribute,
-                                   auto targetHasAttribute,
-                                   auto sourcePointSize,
-                                   auto targetPointSize) {
-    if (targetHasAttribute) {
-      if (!sourceHasAttribute) {
-        sourceAttributeContainer.resize(sourcePointSize);
-      }
-
-      sourceAttributeContainer.insert(sourceAttributeContainer.end(),
-                                      targetAttributeContainer.begin(),
-                                      targetAttributeContainer.end());
-    } else if (sourceHasAttribute) {
-      sourceAttributeContainer.resize(sourceAttributeContainer.size() + targetPointSize);
+  if (!other._count)
+    return;
+
+  if (!_layout.columns) {
+    _has_local_positions = other._has_local_positions;
+    _local_origin = other._local_origin;
+  }
+
+  // Attributes of the other buffer that this buffer does not have yet are
+  // added to this buffer
+  const auto position_columns =
+    (ColumnMask{ 1 } << PositionColumn) | (ColumnMask{ 1 } << LocalPositionColumn);
+  const auto own_position_column =
+    _has_local_positions ? (ColumnMask{ 1 } << LocalPositionColumn)
+                         : (ColumnMask{ 1 } << PositionColumn);
+  const auto columns = ((_layout.columns | other._layout.columns) & ~position_columns) |
+                       own_position_column;
+  const auto new_count = _count + other._count;
+  if (columns != _layout.columns || new_count > _layout.capacity) {
+    // Grow geometrically like 'push_point', so that appending many buffers
+    // does not reallocate on every append
+    relayout(columns,
+             (new_count > _layout.capacity) ? grown_capacity(_layout.capacity, new_count)
+                                            : _layout.capacity);
+  }
+
+  for (size_t column = 0; column < NumColumns; ++column) {
+    if (column == PositionColumn || column == LocalPositionColumn || !_layout.has_column(column))
+      continue;
+    auto target =
+      _storage.get() + _layout.offsets[column] + _count * COLUMN_ELEMENT_SIZES[column];
+    const auto byte_count = other._count * COLUMN_ELEMENT_SIZES[column];
+    if (other._layout.has_column(column)) {
+      std::memcpy(target, other._storage.get() + other._layout.offsets[column], byte_count);
+    } else {
+      // Without a relayout, the slots might still hold points from before a
+      // 'clear', so attributes that the other buffer lacks get default values
+      std::memset(target, 0, byte_count);
     }
-  };
+  }
+
+  if (_has_local_positions == other._has_local_positions &&
+      (!_has_local_positions || _local_origin == other._local_origin)) {
+    const auto column = _has_local_positions ? LocalPositionColumn : PositionColumn;
+    std::memcpy(_storage.get() + _layout.offsets[column] + _count * COLUMN_ELEMENT_SIZES[column],
+                other._storage.get() + other._layout.offsets[column],
+                other._count * COLUMN_ELEMENT_SIZES[column]);
+  } else {
+    for (size_t idx = 0; idx < other._count; ++idx) {
+      set_position_at(_count + idx, other.position_at(idx));
+    }
+  }
 
-  appendAttributes(
-    _rgbColors, other.rgbColors(), hasColors(), other.hasColors(), count(), other.count());
-  appendAttributes(
-    _normals, other.normals(), hasNormals(), other.hasNormals(), count(), other.count());
-  appendAttributes(_intensities,
-                   other.intensities(),
-                   hasIntensities(),
-                   other.hasIntensities(),
-                   count(),
-                   other.count());
-  appendAttributes(_classifications,
-                   other.classifications(),
-                   hasClassifications(),
-                   other.hasClassifications(),
-                   count(),
-                   other.count());
-  appendAttributes(_edge_of_flight_lines,
-                   other.edge_of_flight_lines(),
-                   has_edge_of_flight_lines(),
-                   other.has_edge_of_flight_lines(),
-                   count(),
-                   other.count());
-  appendAttributes(
-    _gps_times, other.gps_times(), has_gps_times(), other.has_gps_times(), count(), other.count());
-  appendAttributes(_number_of_returns,
-                   other.number_of_returns(),
-                   has_number_of_returns(),
-                   other.has_number_of_returns(),
-                   count(),
-                   other.count());
-  appendAttributes(_return_numbers,
-                   other.return_numbers(),
-                   has_return_numbers(),
-                   other.has_return_numbers(),
-                   count(),
-                   other.count());
-  appendAttributes(_point_source_ids,
-                   other.point_source_ids(),
-                   has_point_source_ids(),
-                   other.has_point_source_ids(),
-                   count(),
-                   other.count());
-  appendAttributes(_scan_direction_flags,
-                   other.scan_direction_flags(),
-                   has_scan_direction_flags(),
-                   other.has_scan_direction_flags(),
-                   count(),
-                   other.count());
-  appendAttributes(_scan_angle_ranks,
-                   other.scan_angle_ranks(),
-                   has_scan_angle_ranks(),
-                   other.has_scan_angle_ranks(),
-                   count(),
-                   other.count());
-  appendAttributes(
-    _user_data, other.user_data(), has_user_data(), other.has_user_data(), count(), other.count());
-
-  _count += other.count();
+  _count = new_count;
 }
 
 void
 PointBuffer::clear()
 {
+  // Keeps the allocation, so that the buffer can be refilled without
+  // reallocating
   _count = 0;
-  _positions.clear();
-  _rgbColors.clear();
-  _normals.clear();
-  _intensities.clear();
-  _classifications.clear();
-  _edge_of_flight_lines.clear();
-  _gps_times.clear();
-  _number_of_returns.clear();
-  _return_numbers.clear();
-  _point_source_ids.clear();
-  _scan_angle_ranks.clear();
-  _scan_direction_flags.clear();
-  _user_data.clear();
+}
+
+void
+PointBuffer::reserve(size_t capacity)
+{
+  if (capacity <= _layout.capacity)
+    return;
+  if (!_layout.columns) {
+    _layout.columns = ColumnMask{ 1 } << PositionColumn;
+  }
+  relayout(_layout.columns, capacity);
 }
 
 void
 PointBuffer::shrink_to_fit()
 {
-  _positions.shrink_to_fit();
-  _rgbColors.shrink_to_fit();
-  _normals.shrink_to_fit();
-  _intensities.shrink_to_fit();
-  _classifications.shrink_to_fit();
-  _edge_of_flight_lines.shrink_to_fit();
-  _gps_times.shrink_to_fit();
-  _number_of_returns.shrink_to_fit();
-  _return_numbers.shrink_to_fit();
-  _point_source_ids.shrink_to_fit();
-  _scan_angle_ranks.shrink_to_fit();
-  _scan_direction_flags.shrink_to_fit();
-  _user_data.shrink_to_fit();
+  if (_count == _layout.capacity)
+    return;
+  relayout(_layout.columns, _count);
 }
 
 void
 PointBuffer::resize(size_t new_size)
 {
-
-  _positions.resize(new_size);
-
-  // If this PointBuffer is empty, we don't know the schema, so we only resize the positions since
-  // those are mandatory
-  // TODO HACK We should tie the schema to the PointBuffer through e.g. a bitmask
-  if (!_count) {
-    return;
+  if (!_layout.columns) {
+    _layout.columns = ColumnMask{ 1 } << PositionColumn;
   }
 
-  _count = new_size;
-
-#define RESIZE_IF_NOT_EMPTY(vec)                                                                   \
-  if (!vec.empty()) {                                                                              \
-    vec.resize(new_size);                                                                          \
+  if (new_size > _layout.capacity) {
+    relayout(_layout.columns, new_size);
+  } else if (new_size > _count) {
+    // Slots beyond the old count might contain stale points
+    for (size_t column = 0; column < NumColumns; ++column) {
+      if (!_layout.has_column(column))
+        continue;
+      std::memset(_storage.get() + _layout.offsets[column] + _count * COLUMN_ELEMENT_SIZES[column],
+                  0,
+                  (new_size - _count) * COLUMN_ELEMENT_SIZES[column]);
+    }
   }
 
-  RESIZE_IF_NOT_EMPTY(_classifications)
-  RESIZE_IF_NOT_EMPTY(_edge_of_flight_lines)
-  RESIZE_IF_NOT_EMPTY(_gps_times)
-  RESIZE_IF_NOT_EMPTY(_intensities)
-  RESIZE_IF_NOT_EMPTY(_normals)
-  RESIZE_IF_NOT_EMPTY(_number_of_returns)
-  RESIZE_IF_NOT_EMPTY(_point_source_ids)
-  RESIZE_IF_NOT_EMPTY(_return_numbers)
-  RESIZE_IF_NOT_EMPTY(_rgbColors)
-  RESIZE_IF_NOT_EMPTY(_scan_angle_ranks)
-  RESIZE_IF_NOT_EMPTY(_scan_direction_flags)
-  RESIZE_IF_NOT_EMPTY(_user_data)
+  _count = new_size;
 }
 
 void
@@ -501,141 +489,240 @@ PointBuffer::apply_schema(const PointAttributes& new_schema)
     throw std::invalid_argument{ "PointAttribute::Position is mandatory for PointBuffer schema!" };
   }
 
-#define RESIZE_ATTRIBUTE(attribute, member)                                                        \
-  member.resize(has_attribute(new_schema, attribute) ? _count : 0)
+  auto columns = columns_for_schema(new_schema);
+  if (_has_local_positions) {
+    columns = (columns & ~(ColumnMask{ 1 } << PositionColumn)) |
+              (ColumnMask{ 1 } << LocalPositionColumn);
+  }
+  columns |= _layout.columns & (ColumnMask{ 1 } << PointIDColumn);
+  if (columns == _layout.columns)
+    return;
+
+  relayout(columns, _layout.capacity);
+}
 
-  RESIZE_ATTRIBUTE(PointAttribute::Classification, _classifications);
-  RESIZE_ATTRIBUTE(PointAttribute::EdgeOfFlightLine, _edge_of_flight_lines);
-  RESIZE_ATTRIBUTE(PointAttribute::GPSTime, _gps_times);
-  RESIZE_ATTRIBUTE(PointAttribute::Intensity, _intensities);
-  RESIZE_ATTRIBUTE(PointAttribute::Normal, _normals);
-  RESIZE_ATTRIBUTE(PointAttribute::NumberOfReturns, _number_of_returns);
-  RESIZE_ATTRIBUTE(PointAttribute::PointSourceID, _point_source_ids);
-  RESIZE_ATTRIBUTE(PointAttribute::ReturnNumber, _return_numbers);
-  RESIZE_ATTRIBUTE(PointAttribute::RGB, _rgbColors);
-  RESIZE_ATTRIBUTE(PointAttribute::ScanAngleRank, _scan_angle_ranks);
-  RESIZE_ATTRIBUTE(PointAttribute::ScanDirectionFlag, _scan_direction_flags);
-  RESIZE_ATTRIBUTE(PointAttribute::UserData, _user_data);
+PointAttributes
+PointBuffer::schema() const
+{
+  PointAttributes attributes;
+  for (size_t column = 0; column < LocalPositionColumn; ++column) {
+    if (_layout.has_column(column)) {
+      attributes.insert(static_cast<PointAttribute>(column));
+    }
+  }
+  if (_has_local_positions) {
+    attributes.insert(PointAttribute::Position);
+  }
+  return attributes;
 }
 
 bool
 PointBuffer::hasColors() const
 {
-  return !_rgbColors.empty();
+  return _layout.has_column(RGBColumn);
 }
 
 bool
 PointBuffer::hasNormals() const
 {
-  return !_normals.empty();
+  return _layout.has_column(NormalColumn);
 }
 
 bool
 PointBuffer::hasIntensities() const
 {
-  return !_intensities.empty();
+  return _layout.has_column(IntensityColumn);
 }
 
 bool
 PointBuffer::hasClassifications() const
 {
-  return !_classifications.empty();
+  return _layout.has_column(ClassificationColumn);
 }
 
 bool
 PointBuffer::has_edge_of_flight_lines() const
 {
-  return !_edge_of_flight_lines.empty();
+  return _layout.has_column(EdgeOfFlightLineColumn);
 }
 bool
 PointBuffer::has_gps_times() const
 {
-  return !_gps_times.empty();
+  return _layout.has_column(GPSTimeColumn);
 }
 bool
 PointBuffer::has_number_of_returns() const
 {
-  return !_number_of_returns.empty();
+  return _layout.has_column(NumberOfReturnsColumn);
 }
 bool
 PointBuffer::has_return_numbers() const
 {
-  return !_return_numbers.empty();
+  return _layout.has_column(ReturnNumberColumn);
 }
 bool
 PointBuffer::has_point_source_ids() const
 {
-  return !_point_source_ids.empty();
+  return _layout.has_column(PointSourceIDColumn);
 }
 bool
 PointBuffer::has_scan_direction_flags() const
 {
-  return !_scan_direction_flags.empty();
+  return _layout.has_column(ScanDirectionFlagColumn);
 }
 bool
 PointBuffer::has_scan_angle_ranks() const
 {
-  return !_scan_angle_ranks.empty();
+  return _layout.has_column(ScanAngleRankColumn);
 }
 bool
 PointBuffer::has_user_data() const
 {
-  return !_user_data.empty();
+  return _layout.has_column(UserDataColumn);
 }
 
 void
 PointBuffer::verify() const
 {
-  if (_positions.size() != _count) {
-    throw std::invalid_argument{ "positions.size() does not equal count!" };
-  }
-  if (_rgbColors.size() && _rgbColors.size() != _count) {
-    throw std::invalid_argument{ "rgbColors.size() does not equal count!" };
-  }
-  if (_normals.size() && _normals.size() != _count) {
-    throw std::invalid_argument{ "normals.size() does not equal count!" };
-  }
-  if (_intensities.size() && _intensities.size() != _count) {
-    throw std::invalid_argument{ "intensities.size() does not equal count!" };
-  }
-  if (_classifications.size() && _classifications.size() != _count) {
-    throw std::invalid_argument{ "positions.size() does not equal count!" };
+  if (_count > _layout.capacity) {
+    throw std::invalid_argument{ "count exceeds the capacity of the PointBuffer!" };
   }
-  if (_edge_of_flight_lines.size() && _edge_of_flight_lines.size() != _count) {
-    throw std::invalid_argument{ "edge_of_flight_lines.size() does not equal count!" };
-  }
-  if (_gps_times.size() && _gps_times.size() != _count) {
-    throw std::invalid_argument{ "gps_times.size() does not equal count!" };
-  }
-  if (_number_of_returns.size() && _number_of_returns.size() != _count) {
-    throw std::invalid_argument{ "number_of_returns.size() does not equal count!" };
-  }
-  if (_return_numbers.size() && _return_numbers.size() != _count) {
-    throw std::invalid_argument{ "return_numbers.size() does not equal count!" };
+  if (_count && !_layout.has_column(_has_local_positions ? LocalPositionColumn : PositionColumn)) {
+    throw std::invalid_argument{ "PointBuffer has no positions!" };
   }
-  if (_point_source_ids.size() && _point_source_ids.size() != _count) {
-    throw std::invalid_argument{ "point_source_ids.size() does not equal count!" };
-  }
-  if (_scan_direction_flags.size() && _scan_direction_flags.size() != _count) {
-    throw std::invalid_argument{ "scan_direction_flags.size() does not equal count!" };
-  }
-  if (_scan_angle_ranks.size() && _scan_angle_ranks.size() != _count) {
-    throw std::invalid_argument{ "scan_angle_ranks.size() does not equal count!" };
+}
+
+size_t
+PointBuffer::content_byte_size() const
+{
+  return _layout.byte_size;
+}
+
+void
+PointBuffer::make_positions_local(const Vector3<double>& origin)
+{
+  if (_has_local_positions) {
+    if (origin == _local_origin)
+      return;
+    make_positions_global();
   }
-  if (_user_data.size() && _user_data.size() != _count) {
-    throw std::invalid_argument{ "user_data.size() does not equal count!" };
+  if (!_layout.columns)
+    return;
+
+  const auto columns = (_layout.columns & ~(ColumnMask{ 1 } << PositionColumn)) |
+                       (ColumnMask{ 1 } << LocalPositionColumn);
+  const auto [old_layout, old_storage] = relayout(columns, _count);
+  const auto global_positions =
+    reinterpret_cast<const Vector3<double>*>(old_storage.get() + old_layout.offsets[PositionColumn]);
+  std::transform(global_positions,
+                 global_positions + _count,
+                 column_data<Vector3<float>>(LocalPositionColumn),
+                 [&origin](const Vector3<double>& position) {
+                   return Vector3<double>::cast<float>(position - origin);
+                 });
+
+  _local_origin = origin;
+  _has_local_positions = true;
+}
+
+void
+PointBuffer::make_positions_global()
+{
+  if (!_has_local_positions)
+    return;
+
+  const auto columns = (_layout.columns & ~(ColumnMask{ 1 } << LocalPositionColumn)) |
+                       (ColumnMask{ 1 } << PositionColumn);
+  const auto [old_layout, old_storage] = relayout(columns, _count);
+  const auto local_positions = reinterpret_cast<const Vector3<float>*>(
+    old_storage.get() + old_layout.offsets[LocalPositionColumn]);
+  std::transform(local_positions,
+                 local_positions + _count,
+                 column_data<Vector3<double>>(PositionColumn),
+                 [this](const Vector3<float>& local_position) {
+                   return _local_origin + Vector3<float>::cast<double>(local_position);
+                 });
+
+  _local_origin = {};
+  _has_local_positions = false;
+}
+
+void
+PointBuffer::assign_point_ids(uint64_t first_id)
+{
+  if (!_layout.columns)
+    return;
+  if (!has_point_ids()) {
+    relayout(_layout.columns | (ColumnMask{ 1 } << PointIDColumn), _layout.capacity);
   }
+  auto ids = point_ids();
+  std::iota(ids.begin(), ids.end(), first_id);
+}
+
+void
+PointBuffer::remove_point_ids()
+{
+  if (!has_point_ids())
+    return;
+  relayout(_layout.columns & ~(ColumnMask{ 1 } << PointIDColumn), _layout.capacity);
+}
+
+gsl::span<std::byte>
+PointBuffer::attribute_bytes(PointAttribute attribute)
+{
+  const auto column = static_cast<size_t>(attribute);
+  assert(column != PositionColumn || !_has_local_positions);
+  if (!_layout.has_column(column))
+    return {};
+  return gsl::make_span(_storage.get() + _layout.offsets[column],
+                        _count * COLUMN_ELEMENT_SIZES[column]);
+}
+
+gsl::span<const std::byte>
+PointBuffer::attribute_bytes(PointAttribute attribute) const
+{
+  const auto column = static_cast<size_t>(attribute);
+  assert(column != PositionColumn || !_has_local_positions);
+  if (!_layout.has_column(column))
+    return {};
+  return gsl::make_span(static_cast<const std::byte*>(_storage.get() + _layout.offsets[column]),
+                        _count * COLUMN_ELEMENT_SIZES[column]);
 }
 
 size_t
-PointBuffer::content_byte_size() const
+PointBuffer::attribute_byte_size(PointAttribute attribute)
+{
+  return COLUMN_ELEMENT_SIZES[static_cast<size_t>(attribute)];
+}
+
+bool
+PointBuffer::local_positions_are_precise(const Vector3<double>& extent)
+{
+  constexpr double MAX_LOCAL_POSITION_ERROR = 0.00005;
+  // Rounding a float in [0;extent] has an error of at most half a ULP
+  const auto max_extent = std::max(extent.x, std::max(extent.y, extent.z));
+  return (max_extent * std::numeric_limits<float>::epsilon() / 2) <= MAX_LOCAL_POSITION_ERROR;
+}
+
+Vector3<double>
+PointBuffer::position_at(size_t index) const
 {
-  return vector_byte_size(_positions) + vector_byte_size(_rgbColors) + vector_byte_size(_normals) +
-         vector_byte_size(_intensities) + vector_byte_size(_classifications) +
-         vector_byte_size(_edge_of_flight_lines) + vector_byte_size(_gps_times) +
-         vector_byte_size(_number_of_returns) + vector_byte_size(_return_numbers) +
-         vector_byte_size(_point_source_ids) + vector_byte_size(_scan_angle_ranks) +
-         vector_byte_size(_scan_direction_flags) + vector_byte_size(_user_data);
+  if (_has_local_positions) {
+    return _local_origin +
+           Vector3<float>::cast<double>(column_data<Vector3<float>>(LocalPositionColumn)[index]);
+  }
+  return column_data<Vector3<double>>(PositionColumn)[index];
+}
+
+void
+PointBuffer::set_position_at(size_t index, const Vector3<double>& position)
+{
+  if (_has_local_positions) {
+    column_data<Vector3<float>>(LocalPositionColumn)[index] =
+      Vector3<double>::cast<float>(position - _local_origin);
+  } else {
+    column_data<Vector3<double>>(PositionColumn)[index] = position;
+  }
 }
 
 PointBuffer::PointIterator
@@ -662,101 +749,95 @@ PointBuffer::end() const
 }
 
 #pragma region PointConstReference
-const Vector3<double>&
+Vector3<double>
 PointBuffer::PointConstReference::position() const
 {
-  return _pointBuffer->positions()[_index];
+  return _pointBuffer->position_at(_index);
 }
 
 const Vector3<uint8_t>*
 PointBuffer::PointConstReference::rgbColor() const
 {
-  if (!_pointBuffer->hasColors())
-    return nullptr;
-  return _pointBuffer->rgbColors().data() + _index;
+  const auto column = _pointBuffer->column_data<Vector3<uint8_t>>(RGBColumn);
+  return column ? column + _index : nullptr;
 }
 
 const Vector3<float>*
 PointBuffer::PointConstReference::normal() const
 {
-  if (!_pointBuffer->hasNormals())
-    return nullptr;
-  return _pointBuffer->normals().data() + _index;
+  const auto column = _pointBuffer->column_data<Vector3<float>>(NormalColumn);
+  return column ? column + _index : nullptr;
 }
 
 const uint16_t*
 PointBuffer::PointConstReference::intensity() const
 {
-  if (!_pointBuffer->hasIntensities())
-    return nullptr;
-  return _pointBuffer->intensities().data() + _index;
+  const auto column = _pointBuffer->column_data<uint16_t>(IntensityColumn);
+  return column ? column + _index : nullptr;
 }
 
 const uint8_t*
 PointBuffer::PointConstReference::classification() const
 {
-  if (!_pointBuffer->hasClassifications())
-    return nullptr;
-  return _pointBuffer->classifications().data() + _index;
+  const auto column = _pointBuffer->column_data<uint8_t>(ClassificationColumn);
+  return column ? column + _index : nullptr;
 }
 
 const uint8_t*
 PointBuffer::PointConstReference::edge_of_flight_line() const
 {
-  if (!_pointBuffer->has_edge_of_flight_lines())
-    return nullptr;
-  return _pointBuffer->edge_of_flight_lines().data() + _index;
+  const auto column = _pointBuffer->column_data<uint8_t>(EdgeOfFlightLineColumn);
+  return column ? column + _index : nullptr;
 }
 const double*
 PointBuffer::PointConstReference::gps_time() const
 {
-  if (!_pointBuffer->has_gps_times())
-    return nullptr;
-  return _pointBuffer->gps_times().data() + _index;
+  const auto column = _pointBuffer->column_data<double>(GPSTimeColumn);
+  return column ? column + _index : nullptr;
 }
 const uint8_t*
 PointBuffer::PointConstReference::number_of_returns() const
 {
-  if (!_pointBuffer->has_number_of_returns())
-    return nullptr;
-  return _pointBuffer->number_of_returns().data() + _index;
+  const auto column = _pointBuffer->column_data<uint8_t>(NumberOfReturnsColumn);
+  return column ? column + _index : nullptr;
 }
 
 const uint8_t*
 PointBuffer::PointConstReference::return_number() const
 {
-  if (!_pointBuffer->has_return_numbers())
-    return nullptr;
-  return _pointBuffer->return_numbers().data() + _index;
+  const auto column = _pointBuffer->column_data<uint8_t>(ReturnNumberColumn);
+  return column ? column + _index : nullptr;
 }
 
 const uint16_t*
 PointBuffer::PointConstReference::point_source_id() const
 {
-  if (!_pointBuffer->has_point_source_ids())
-    return nullptr;
-  return _pointBuffer->point_source_ids().data() + _index;
+  const auto column = _pointBuffer->column_data<uint16_t>(PointSourceIDColumn);
+  return column ? column + _index : nullptr;
 }
 const uint8_t*
 PointBuffer::PointConstReference::scan_direction_flag() const
 {
-  if (!_pointBuffer->has_scan_direction_flags())
-    return nullptr;
-  return _pointBuffer->scan_direction_flags().data() + _index;
+  const auto column = _pointBuffer->column_data<uint8_t>(ScanDirectionFlagColumn);
+  return column ? column + _index : nullptr;
 }
 const int8_t*
 PointBuffer::PointConstReference::scan_angle_rank() const
 {
-  if (!_pointBuffer->has_scan_angle_ranks())
-    return nullptr;
-  return _pointBuffer->scan_angle_ranks().data() + _index;
+  const auto column = _pointBuffer->column_data<int8_t>(ScanAngleRankColumn);
+  return column ? column + _index : nullptr;
 }
 const uint8_t*
 PointBuffer::PointConstReference::user_data() const
 {
-  if (!_pointBuffer->has_user_data())
-    return nullptr;
-  return _pointBuffer->user_data().data() + _index;
+  const auto column = _pointBuffer->column_data<uint8_t>(UserDataColumn);
+  return column ? column + _index : nullptr;
+}
+const uint64_t*
+PointBuffer::PointConstReference::point_id() const
+{
+  const auto column = _pointBuffer->column_data<uint64_t>(PointIDColumn);
+  return column ? column + _index : nullptr;
 }
 
 PointBuffer::PointConstReference::PointConstReference()
@@ -777,101 +858,101 @@ PointBuffer::PointConstReference::PointConstReference(PointBuffer const* pointBu
 #pragma endregion
 
 #pragma region PointReference
-Vector3<double>&
+Vector3<double>
 PointBuffer::PointReference::position() const
 {
-  return _pointBuffer->positions()[_index];
+  return _pointBuffer->position_at(_index);
+}
+
+void
+PointBuffer::PointReference::set_position(const Vector3<double>& position) const
+{
+  _pointBuffer->set_position_at(_index, position);
 }
 
 Vector3<uint8_t>*
 PointBuffer::PointReference::rgbColor() const
 {
-  if (!_pointBuffer->hasColors())
-    return nullptr;
-  return _pointBuffer->rgbColors().data() + _index;
+  const auto column = _pointBuffer->column_data<Vector3<uint8_t>>(RGBColumn);
+  return column ? column + _index : nullptr;
 }
 
 Vector3<float>*
 PointBuffer::PointReference::normal() const
 {
-  if (!_pointBuffer->hasNormals())
-    return nullptr;
-  return _pointBuffer->normals().data() + _index;
+  const auto column = _pointBuffer->column_data<Vector3<float>>(NormalColumn);
+  return column ? column + _index : nullptr;
 }
 
 uint16_t*
 PointBuffer::PointReference::intensity() const
 {
-  if (!_pointBuffer->hasIntensities())
-    return nullptr;
-  return _pointBuffer->intensities().data() + _index;
+  const auto column = _pointBuffer->column_data<uint16_t>(IntensityColumn);
+  return column ? column + _index : nullptr;
 }
 
 uint8_t*
 PointBuffer::PointReference::classification() const
 {
-  if (!_pointBuffer->hasClassifications())
-    return nullptr;
-  return _pointBuffer->classifications().data() + _index;
+  const auto column = _pointBuffer->column_data<uint8_t>(ClassificationColumn);
+  return column ? column + _index : nullptr;
 }
 
 uint8_t*
 PointBuffer::PointReference::edge_of_flight_line() const
 {
-  if (!_pointBuffer->has_edge_of_flight_lines())
-    return nullptr;
-  return _pointBuffer->edge_of_flight_lines().data() + _index;
+  const auto column = _pointBuffer->column_data<uint8_t>(EdgeOfFlightLineColumn);
+  return column ? column + _index : nullptr;
 }
 double*
 PointBuffer::PointReference::gps_time() const
 {
-  if (!_pointBuffer->has_gps_times())
-    return nullptr;
-  return _pointBuffer->gps_times().data() + _index;
+  const auto column = _pointBuffer->column_data<double>(GPSTimeColumn);
+  return column ? column + _index : nullptr;
 }
 uint8_t*
 PointBuffer::PointReference::number_of_returns() const
 {
-  if (!_pointBuffer->has_number_of_returns())
-    return nullptr;
-  return _pointBuffer->number_of_returns().data() + _index;
+  const auto column = _pointBuffer->column_data<uint8_t>(NumberOfReturnsColumn);
+  return column ? column + _index : nullptr;
 }
 
 uint8_t*
 PointBuffer::PointReference::return_number() const
 {
-  if (!_pointBuffer->has_return_numbers())
-    return nullptr;
-  return _pointBuffer->return_numbers().data() + _index;
+  const auto column = _pointBuffer->column_data<uint8_t>(ReturnNumberColumn);
+  return column ? column + _index : nullptr;
 }
 
 uint16_t*
 PointBuffer::PointReference::point_source_id() const
 {
-  if (!_pointBuffer->has_point_source_ids())
-    return nullptr;
-  return _pointBuffer->point_source_ids().data() + _index;
+  const auto column = _pointBuffer->column_data<uint16_t>(PointSourceIDColumn);
+  return column ? column + _index : nullptr;
 }
 uint8_t*
 PointBuffer::PointReference::scan_direction_flag() const
 {
-  if (!_pointBuffer->has_scan_direction_flags())
-    return nullptr;
-  return _pointBuffer->scan_direction_flags().data() + _index;
+  const auto column = _pointBuffer->column_data<uint8_t>(ScanDirectionFlagColumn);
+  return column ? column + _index : nullptr;
 }
 int8_t*
 PointBuffer::PointReference::scan_angle_rank() const
 {
-  if (!_pointBuffer->has_scan_angle_ranks())
-    return nullptr;
-  return _pointBuffer->scan_angle_ranks().data() + _index;
+  const auto column = _pointBuffer->column_data<int8_t>(ScanAngleRankColumn);
+  return column ? column + _index : nullptr;
 }
 uint8_t*
 PointBuffer::PointReference::user_data() const
 {
-  if (!_pointBuffer->has_user_data())
-    return nullptr;
-  return _pointBuffer->user_data().data() + _index;
+  const auto column = _pointBuffer->column_data<uint8_t>(UserDataColumn);
+  return column ? column + _index : nullptr;
+}
+uint64_t*
+PointBuffer::PointReference::point_id() const
+{
+  const auto column = _pointBuffer->column_data<uint64_t>(PointIDColumn);
+  return column ? column + _index : nullptr;
 }
 
 PointBuffer::PointReference::PointReference()
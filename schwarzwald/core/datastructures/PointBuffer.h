@@ -4,17 +4,25 @@
 #include "math/Vector3.h"
 #include "pointcloud/PointAttributes.h"
 
+#include <array>
+#include <cassert>
+#include <cstddef>
 #include <gsl/gsl>
+#include <memory>
 #include <optional>
 #include <vector>
 
-// TECH_DEBT Make attributes more dynamic (map<AttributeType, GenericAttribute*>
-// or something like that)
-
 /// <summary>
 /// Buffer structure that stores point attributes (position, color etc.) for
 /// multiple points at once in a structure-of-array fashion. Compared to storing
-/// all points as Point structures, this has better performance for data access
+/// all points as Point structures, this has better performance for data access.
+/// The columns of all attributes in the schema of the PointBuffer live in a
+/// single, cache-line aligned allocation, so allocating, growing and moving a
+/// PointBuffer touches only one block of memory. Positions are either stored
+/// as absolute double-precision positions or, after calling
+/// make_positions_local, as single-precision offsets to a per-buffer origin.
+/// Use PointReference::position() to access positions independent of the
+/// storage mode
 /// </summary>
 struct PointBuffer
 {
@@ -32,7 +40,8 @@ struct PointBuffer
     PointReference(const PointReference&) = default;
     PointReference& operator=(const PointReference&) = default;
 
-    Vector3<double>& position() const;
+    Vector3<double> position() const;
+    void set_position(const Vector3<double>& position) const;
     Vector3<uint8_t>* rgbColor() const;
     Vector3<float>* normal() const;
     uint16_t* intensity() const;
@@ -45,6 +54,7 @@ struct PointBuffer
     uint8_t* scan_direction_flag() const;
     int8_t* scan_angle_rank() const;
     uint8_t* user_data() const;
+    uint64_t* point_id() const;
 
   private:
     PointReference(PointBuffer* pointBuffer, size_t index);
@@ -65,7 +75,7 @@ struct PointBuffer
     PointConstReference(const PointConstReference&) = default;
     PointConstReference& operator=(const PointConstReference&) = default;
 
-    const Vector3<double>& position() const;
+    Vector3<double> position() const;
     const Vector3<uint8_t>* rgbColor() const;
     const Vector3<float>* normal() const;
     const uint16_t* intensity() const;
@@ -78,6 +88,7 @@ struct PointBuffer
     const uint8_t* scan_direction_flag() const;
     const int8_t* scan_angle_rank() const;
     const uint8_t* user_data() const;
+    const uint64_t* point_id() const;
 
   private:
     PointConstReference(PointBuffer const* pointBuffer, size_t index);
@@ -126,11 +137,11 @@ struct PointBuffer
    */
   PointBuffer(size_t count, const PointAttributes& attributes);
 
-  PointBuffer(const PointBuffer&) = default;
-  PointBuffer(PointBuffer&&) = default;
+  PointBuffer(const PointBuffer& other);
+  PointBuffer(PointBuffer&& other) noexcept;
 
-  PointBuffer& operator=(const PointBuffer&) = default;
-  PointBuffer& operator=(PointBuffer&&) = default;
+  PointBuffer& operator=(const PointBuffer& other);
+  PointBuffer& operator=(PointBuffer&& other) noexcept;
 
   /// <summary>
   /// Push a single point into this PointBuffer. If the point has attributes
@@ -172,35 +183,131 @@ struct PointBuffer
   void shrink_to_fit();
   void resize(size_t new_size);
 
-  std::vector<Vector3<double>>& positions() { return _positions; }
-  std::vector<Vector3<uint8_t>>& rgbColors() { return _rgbColors; }
-  std::vector<Vector3<float>>& normals() { return _normals; }
-  std::vector<uint16_t>& intensities() { return _intensities; }
-  std::vector<uint8_t>& classifications() { return _classifications; }
-
-  auto& edge_of_flight_lines() { return _edge_of_flight_lines; }
-  auto& gps_times() { return _gps_times; }
-  auto& number_of_returns() { return _number_of_returns; }
-  auto& return_numbers() { return _return_numbers; }
-  auto& point_source_ids() { return _point_source_ids; }
-  auto& scan_direction_flags() { return _scan_direction_flags; }
-  auto& scan_angle_ranks() { return _scan_angle_ranks; }
-  auto& user_data() { return _user_data; }
-
-  const std::vector<Vector3<double>>& positions() const { return _positions; }
-  const std::vector<Vector3<uint8_t>>& rgbColors() const { return _rgbColors; }
-  const std::vector<Vector3<float>>& normals() const { return _normals; }
-  const std::vector<uint16_t>& intensities() const { return _intensities; }
-  const std::vector<uint8_t>& classifications() const { return _classifications; }
-
-  const auto& edge_of_flight_lines() const { return _edge_of_flight_lines; }
-  const auto& gps_times() const { return _gps_times; }
-  const auto& number_of_returns() const { return _number_of_returns; }
-  const auto& return_numbers() const { return _return_numbers; }
-  const auto& point_source_ids() const { return _point_source_ids; }
-  const auto& scan_direction_flags() const { return _scan_direction_flags; }
-  const auto& scan_angle_ranks() const { return _scan_angle_ranks; }
-  const auto& user_data() const { return _user_data; }
+  /**
+   * Reserves memory for 'capacity' points, so that appending points up to this
+   * capacity does not reallocate
+   */
+  void reserve(size_t capacity);
+  size_t capacity() const { return _layout.capacity; }
+
+  /**
+   * The attributes that this PointBuffer stores. An empty PointBuffer without
+   * a schema takes the schema of the first points pushed or appended to it
+   */
+  PointAttributes schema() const;
+
+  gsl::span<Vector3<double>> positions()
+  {
+    assert(!_has_local_positions);
+    return column<Vector3<double>>(PositionColumn);
+  }
+  gsl::span<Vector3<uint8_t>> rgbColors() { return column<Vector3<uint8_t>>(RGBColumn); }
+  gsl::span<Vector3<float>> normals() { return column<Vector3<float>>(NormalColumn); }
+  gsl::span<uint16_t> intensities() { return column<uint16_t>(IntensityColumn); }
+  gsl::span<uint8_t> classifications() { return column<uint8_t>(ClassificationColumn); }
+
+  gsl::span<uint8_t> edge_of_flight_lines() { return column<uint8_t>(EdgeOfFlightLineColumn); }
+  gsl::span<double> gps_times() { return column<double>(GPSTimeColumn); }
+  gsl::span<uint8_t> number_of_returns() { return column<uint8_t>(NumberOfReturnsColumn); }
+  gsl::span<uint8_t> return_numbers() { return column<uint8_t>(ReturnNumberColumn); }
+  gsl::span<uint16_t> point_source_ids() { return column<uint16_t>(PointSourceIDColumn); }
+  gsl::span<uint8_t> scan_direction_flags() { return column<uint8_t>(ScanDirectionFlagColumn); }
+  gsl::span<int8_t> scan_angle_ranks() { return column<int8_t>(ScanAngleRankColumn); }
+  gsl::span<uint8_t> user_data() { return column<uint8_t>(UserDataColumn); }
+
+  gsl::span<const Vector3<double>> positions() const
+  {
+    assert(!_has_local_positions);
+    return column<Vector3<double>>(PositionColumn);
+  }
+  gsl::span<const Vector3<uint8_t>> rgbColors() const
+  {
+    return column<Vector3<uint8_t>>(RGBColumn);
+  }
+  gsl::span<const Vector3<float>> normals() const { return column<Vector3<float>>(NormalColumn); }
+  gsl::span<const uint16_t> intensities() const { return column<uint16_t>(IntensityColumn); }
+  gsl::span<const uint8_t> classifications() const
+  {
+    return column<uint8_t>(ClassificationColumn);
+  }
+
+  gsl::span<const uint8_t> edge_of_flight_lines() const
+  {
+    return column<uint8_t>(EdgeOfFlightLineColumn);
+  }
+  gsl::span<const double> gps_times() const { return column<double>(GPSTimeColumn); }
+  gsl::span<const uint8_t> number_of_returns() const
+  {
+    return column<uint8_t>(NumberOfReturnsColumn);
+  }
+  gsl::span<const uint8_t> return_numbers() const { return column<uint8_t>(ReturnNumberColumn); }
+  gsl::span<const uint16_t> point_source_ids() const
+  {
+    return column<uint16_t>(PointSourceIDColumn);
+  }
+  gsl::span<const uint8_t> scan_direction_flags() const
+  {
+    return column<uint8_t>(ScanDirectionFlagColumn);
+  }
+  gsl::span<const int8_t> scan_angle_ranks() const
+  {
+    return column<int8_t>(ScanAngleRankColumn);
+  }
+  gsl::span<const uint8_t> user_data() const { return column<uint8_t>(UserDataColumn); }
+
+  /**
+   * Converts the positions of this PointBuffer into single-precision offsets to
+   * 'origin', which halves the memory required for the positions. This is
+   * precise enough if all points lie close to 'origin', e.g. if 'origin' is
+   * the minimum corner of the octree node that the points belong to. While the
+   * positions are local, positions() must not be used
+   */
+  void make_positions_local(const Vector3<double>& origin);
+  /**
+   * Converts local positions back into absolute double-precision positions
+   */
+  void make_positions_global();
+
+  /**
+   * Can positions that lie within 'extent' of their origin be stored as local
+   * positions without losing precision? This is the case if the rounding error
+   * of the local positions is at most half of the finest scale factor that
+   * LASPersistence uses (0.0001)
+   */
+  static bool local_positions_are_precise(const Vector3<double>& extent);
+
+  bool has_local_positions() const { return _has_local_positions; }
+  const Vector3<double>& local_origin() const { return _local_origin; }
+  gsl::span<const Vector3<float>> local_positions() const
+  {
+    return column<Vector3<float>>(LocalPositionColumn);
+  }
+
+  /**
+   * Global point IDs, which identify the points of this PointBuffer in an
+   * AttributeStore. Point IDs are not part of the schema, but they are kept by
+   * apply_schema and copied along when pushing or appending points that have IDs
+   */
+  gsl::span<uint64_t> point_ids() { return column<uint64_t>(PointIDColumn); }
+  gsl::span<const uint64_t> point_ids() const { return column<uint64_t>(PointIDColumn); }
+  bool has_point_ids() const { return _layout.has_column(PointIDColumn); }
+  /**
+   * Numbers the points of this PointBuffer consecutively, starting at 'first_id'
+   */
+  void assign_point_ids(uint64_t first_id);
+  void remove_point_ids();
+
+  /**
+   * The raw memory of the column of 'attribute', or an empty span if this
+   * PointBuffer does not have 'attribute'. Positions are only accessible while
+   * they are not local
+   */
+  gsl::span<std::byte> attribute_bytes(PointAttribute attribute);
+  gsl::span<const std::byte> attribute_bytes(PointAttribute attribute) const;
+  /**
+   * Size in bytes of a single value of 'attribute'
+   */
+  static size_t attribute_byte_size(PointAttribute attribute);
 
   bool hasColors() const;
   bool hasNormals() const;
@@ -220,8 +327,8 @@ struct PointBuffer
   /// <summary>
   /// Returns the raw size in bytes of the contents (positions, normals etc.) of
   /// this PointBuffer. This does NOT include the in-memory size of a
-  /// PointBuffer structure itself, but rather the allocated memory of all the
-  /// vectors of the PointBuffer
+  /// PointBuffer structure itself, but rather the size of the allocation that
+  /// stores the columns of the PointBuffer
   /// </summary>
   size_t content_byte_size() const;
 
@@ -288,20 +395,96 @@ struct PointBuffer
   PointConstIterator end() const;
 
 private:
+  /**
+   * The columns of a PointBuffer. The attribute columns have the same order as
+   * PointAttribute, local positions and point IDs are stored in extra columns
+   */
+  enum Column : size_t
+  {
+    PositionColumn,
+    RGBColumn,
+    IntensityColumn,
+    ClassificationColumn,
+    NormalColumn,
+    GPSTimeColumn,
+    EdgeOfFlightLineColumn,
+    NumberOfReturnsColumn,
+    ReturnNumberColumn,
+    PointSourceIDColumn,
+    ScanAngleRankColumn,
+    ScanDirectionFlagColumn,
+    UserDataColumn,
+    LocalPositionColumn,
+    PointIDColumn,
+    NumColumns
+  };
+
+  using ColumnMask = uint16_t;
+
+  /**
+   * Byte offsets of the columns of a PointBuffer within its allocation. Each
+   * column starts at a cache line boundary
+   */
+  struct Layout
+  {
+    ColumnMask columns = 0;
+    size_t capacity = 0;
+    size_t byte_size = 0;
+    std::array<size_t, NumColumns> offsets = {};
+
+    static Layout for_columns(ColumnMask columns, size_t capacity);
+
+    bool has_column(size_t column) const { return (columns & (ColumnMask{ 1 } << column)) != 0; }
+  };
+
+  struct AlignedDelete
+  {
+    void operator()(std::byte* data) const;
+  };
+  using Storage = std::unique_ptr<std::byte[], AlignedDelete>;
+
+  static Storage allocate(const Layout& layout);
+  static ColumnMask columns_for_schema(const PointAttributes& schema);
+  static ColumnMask columns_for_point(PointConstReference point);
+
+  template<typename T>
+  T* column_data(size_t column) const
+  {
+    if (!_layout.has_column(column))
+      return nullptr;
+    return reinterpret_cast<T*>(_storage.get() + _layout.offsets[column]);
+  }
+
+  template<typename T>
+  gsl::span<T> column(size_t column)
+  {
+    return gsl::make_span(column_data<T>(column), _layout.has_column(column) ? _count : 0);
+  }
+
+  template<typename T>
+  gsl::span<const T> column(size_t column) const
+  {
+    return gsl::make_span(static_cast<const T*>(column_data<T>(column)),
+                          _layout.has_column(column) ? _count : 0);
+  }
+
+  /**
+   * Moves the contents of this PointBuffer into a new allocation with the given
+   * columns and capacity. Columns that exist in both layouts are copied, new
+   * columns are filled with default values. Returns the old layout and storage
+   */
+  std::pair<Layout, Storage> relayout(ColumnMask columns, size_t capacity);
+  void grow_to_fit(size_t count);
+  void write_point(size_t index, PointConstReference point);
+
+  Vector3<double> position_at(size_t index) const;
+  void set_position_at(size_t index, const Vector3<double>& position);
+
   size_t _count;
-  std::vector<Vector3<double>> _positions;
-  std::vector<Vector3<uint8_t>> _rgbColors;
-  std::vector<Vector3<float>> _normals;
-  std::vector<uint16_t> _intensities;
-  std::vector<uint8_t> _classifications;
-  std::vector<uint8_t> _edge_of_flight_lines;
-  std::vector<double> _gps_times;
-  std::vector<uint8_t> _number_of_returns;
-  std::vector<uint8_t> _return_numbers;
-  std::vector<uint16_t> _point_source_ids;
-  std::vector<uint8_t> _scan_direction_flags;
-  std::vector<int8_t> _scan_angle_ranks;
-  std::vector<uint8_t> _user_data;
+  bool _has_local_positions = false;
+  Vector3<double> _local_origin;
+  Layout _layout;
+  Storage _storage;
 };
 
 namespace std {
@@ -333,9 +516,7 @@ template<>
 inline unit::byte
 size_in_memory(PointBuffer const& point_buffer)
 {
-  return (sizeof(size_t) * boost::units::information::byte) +
-         size_in_memory(point_buffer.positions()) + size_in_memory(point_buffer.rgbColors()) +
-         size_in_memory(point_buffer.normals()) + size_in_memory(point_buffer.intensities()) +
-         size_in_memory(point_buffer.classifications());
+  return (sizeof(PointBuffer) + point_buffer.content_byte_size()) *
+         boost::units::information::byte;
 }
 } // namespace concepts
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "math/Vector3.h"
+
+#include <boost/container/small_vector.hpp>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+/**
+ * Positions stored as structure-of-arrays, with space for 'InlineCapacity'
+ * positions inside the structure itself. This is the storage of the cells of
+ * the grids that are used for minimum distance sampling. Distance tests run
+ * over contiguous coordinate arrays, four positions at once if AVX2 is enabled
+ * (SCHWARZWALD_ENABLE_AVX2)
+ */
+template<size_t InlineCapacity>
+struct PositionsSoA
+{
+  void push_back(const Vector3<double>& position)
+  {
+    _x.push_back(position.x);
+    _y.push_back(position.y);
+    _z.push_back(position.z);
+  }
+
+  size_t size() const { return _x.size(); }
+  bool empty() const { return _x.empty(); }
+
+  Vector3<double> operator[](size_t index) const
+  {
+    return { _x[index], _y[index], _z[index] };
+  }
+
+  /**
+   * Is the squared distance from 'position' to all stored positions at least
+   * 'squared_spacing'? If 'num_comparisons' is given, it is incremented by the
+   * number of stored positions that were compared to 'position'
+   */
+  bool all_distant(const Vector3<double>& position,
+                   double squared_spacing,
+                   size_t* num_comparisons = nullptr) const
+  {
+    const auto count = size();
+    const double* x = _x.data();
+    const double* y = _y.data();
+    const double* z = _z.data();
+    size_t idx = 0;
+
+#ifdef __AVX2__
+    const auto px = _mm256_set1_pd(position.x);
+    const auto py = _mm256_set1_pd(position.y);
+    const auto pz = _mm256_set1_pd(position.z);
+    const auto spacing = _mm256_set1_pd(squared_spacing);
+    for (; idx + 4 <= count; idx += 4) {
+      const auto dx = _mm256_sub_pd(_mm256_loadu_pd(x + idx), px);
+      const auto dy = _mm256_sub_pd(_mm256_loadu_pd(y + idx), py);
+      const auto dz = _mm256_sub_pd(_mm256_loadu_pd(z + idx), pz);
+      const auto squared_distances =
+        _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)),
+                      _mm256_mul_pd(dz, dz));
+      const auto too_close = _mm256_cmp_pd(squared_distances, spacing, _CMP_LT_OQ);
+      if (_mm256_movemask_pd(too_close)) {
+        if (num_comparisons)
+          *num_comparisons += idx + 4;
+        return false;
+      }
+    }
+#endif
+
+    for (; idx < count; ++idx) {
+      const auto dx = x[idx] - position.x;
+      const auto dy = y[idx] - position.y;
+      const auto dz = z[idx] - position.z;
+      if ((dx * dx + dy * dy + dz * dz) < squared_spacing) {
+        if (num_comparisons)
+          *num_comparisons += idx + 1;
+        return false;
+      }
+    }
+
+    if (num_comparisons)
+      *num_comparisons += count;
+    return true;
+  }
+
+  /**
+   * Size of the memory that this structure allocated dynamically, i.e. once it
+   * holds more than 'InlineCapacity' positions
+   */
+  size_t content_byte_size() const
+  {
+    if (_x.capacity() <= InlineCapacity)
+      return 0;
+    return 3 * _x.capacity() * sizeof(double);
+  }
+
+private:
+  boost::container::small_vector<double, InlineCapacity> _x, _y, _z;
+};
@@ -0,0 +1,345 @@
+#include "io/AttributeStore.h"
+
+#include "util/stuff.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+// Rows between two gathered points of the same chunk are read as well if they
+// are at most this large, which is cheaper than a separate read
+constexpr static size_t SPILL_READ_MAX_GAP_BYTES = 4096;
+
+AttributeStore::AttributeStore(const PointAttributes& deferred_attributes,
+                               const fs::path& spill_file_path)
+  : _spill_file_path(spill_file_path)
+{
+  std::copy_if(std::begin(deferred_attributes),
+               std::end(deferred_attributes),
+               std::inserter(_deferred_attributes, std::end(_deferred_attributes)),
+               [](PointAttribute attribute) { return attribute != PointAttribute::Position; });
+  _attribute_order.assign(std::begin(_deferred_attributes), std::end(_deferred_attributes));
+  std::sort(std::begin(_attribute_order), std::end(_attribute_order));
+
+  if (!_spill_file_path.empty()) {
+    _spill_file.open(_spill_file_path.string(),
+                     std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!_spill_file.is_open()) {
+      throw std::runtime_error{ concat("Could not open spill file ", _spill_file_path.string()) };
+    }
+  }
+}
+
+AttributeStore::~AttributeStore()
+{
+  if (_spill_file.is_open()) {
+    _spill_file_readers.clear();
+    _spill_file.close();
+    std::error_code ec;
+    fs::remove(_spill_file_path, ec);
+  }
+}
+
+PointBuffer
+AttributeStore::store(const PointBuffer& points, size_t count)
+{
+  assert(count <= points.count());
+
+  Chunk chunk;
+  chunk.count = count;
+  chunk.columns.reserve(_attribute_order.size());
+  chunk.has_column.reserve(_attribute_order.size());
+  size_t chunk_bytes = 0;
+  for (auto attribute : _attribute_order) {
+    const auto source = points.attribute_bytes(attribute);
+    const auto byte_count = source.empty() ? 0 : count * PointBuffer::attribute_byte_size(attribute);
+    chunk.columns.emplace_back(source.begin(), source.begin() + byte_count);
+    chunk.has_column.push_back(!source.empty());
+    chunk_bytes += byte_count;
+  }
+  chunk.byte_size = chunk_bytes;
+
+  PointAttributes remaining_attributes;
+  for (auto attribute : points.schema()) {
+    if (!has_attribute(_deferred_attributes, attribute)) {
+      remaining_attributes.insert(attribute);
+    }
+  }
+
+  PointBuffer stripped_points{ count, remaining_attributes };
+  for (auto attribute : remaining_attributes) {
+    if (attribute == PointAttribute::Position)
+      continue;
+    const auto source = points.attribute_bytes(attribute);
+    const auto target = stripped_points.attribute_bytes(attribute);
+    std::copy(source.begin(), source.begin() + target.size(), target.begin());
+  }
+  if (points.has_local_positions()) {
+    for (size_t idx = 0; idx < count; ++idx) {
+      stripped_points.get_point(idx).set_position(points.get_point(idx).position());
+    }
+  } else {
+    std::copy(points.positions().begin(),
+              points.positions().begin() + count,
+              stripped_points.positions().begin());
+  }
+
+  if (!count)
+    return stripped_points;
+
+  uint64_t first_id;
+  {
+    std::unique_lock _{ _lock };
+    first_id = _next_id;
+    chunk.first_id = first_id;
+    _next_id += count;
+    _stored_bytes += chunk_bytes;
+    _resident_bytes += chunk_bytes;
+    _chunks.push_back(std::move(chunk));
+  }
+
+  stripped_points.assign_point_ids(first_id);
+  return stripped_points;
+}
+
+void
+AttributeStore::store(PointBuffer& points)
+{
+  points = store(points, points.count());
+}
+
+void
+AttributeStore::gather(PointBuffer& points) const
+{
+  if (!points.has_point_ids())
+    return;
+
+  auto schema = points.schema();
+  schema.insert(std::begin(_deferred_attributes), std::end(_deferred_attributes));
+  points.apply_schema(schema);
+
+  std::vector<gsl::span<std::byte>> targets;
+  std::vector<size_t> element_sizes;
+  for (auto attribute : _attribute_order) {
+    targets.push_back(points.attribute_bytes(attribute));
+    element_sizes.push_back(PointBuffer::attribute_byte_size(attribute));
+  }
+
+  const auto point_ids = points.point_ids();
+  {
+    std::shared_lock _{ _lock };
+    // Points of a node mostly come from few batches, so consecutive points
+    // often are in the same chunk
+    const Chunk* chunk = nullptr;
+    std::vector<size_t> spilled_points;
+    for (size_t idx = 0; idx < point_ids.size(); ++idx) {
+      const auto point_id = point_ids[idx];
+      if (!chunk || point_id < chunk->first_id || point_id >= chunk->first_id + chunk->count) {
+        chunk = &chunk_for(point_id);
+      }
+      const auto index_in_chunk = point_id - chunk->first_id;
+
+      if (chunk->spill_offset) {
+        spilled_points.push_back(idx);
+        continue;
+      }
+
+      for (size_t column = 0; column < targets.size(); ++column) {
+        const auto& source = chunk->columns[column];
+        // Missing attributes keep the default values from 'apply_schema'
+        if (source.empty())
+          continue;
+        const auto element_size = element_sizes[column];
+        std::memcpy(targets[column].data() + idx * element_size,
+                    source.data() + index_in_chunk * element_size,
+                    element_size);
+      }
+    }
+
+    if (!spilled_points.empty()) {
+      gather_spilled(point_ids, std::move(spilled_points), targets, element_sizes);
+    }
+  }
+
+  points.remove_point_ids();
+}
+
+void
+AttributeStore::gather_spilled(gsl::span<const uint64_t> point_ids,
+                               std::vector<size_t> spilled_points,
+                               const std::vector<gsl::span<std::byte>>& targets,
+                               const std::vector<size_t>& element_sizes) const
+{
+  std::sort(std::begin(spilled_points),
+            std::end(spilled_points),
+            [point_ids](size_t lhs, size_t rhs) { return point_ids[lhs] < point_ids[rhs]; });
+
+  auto reader = acquire_spill_file_reader();
+  std::vector<std::byte> rows;
+  for (size_t range_begin = 0; range_begin < spilled_points.size();) {
+    const auto first_id = point_ids[spilled_points[range_begin]];
+    const auto& chunk = chunk_for(first_id);
+    const auto chunk_row_size = row_size(chunk);
+    const auto max_gap_rows = SPILL_READ_MAX_GAP_BYTES / std::max<size_t>(chunk_row_size, 1);
+
+    // The range ends at the end of the chunk or at the first large gap
+    auto range_end = range_begin + 1;
+    for (; range_end < spilled_points.size(); ++range_end) {
+      const auto point_id = point_ids[spilled_points[range_end]];
+      const auto previous_id = point_ids[spilled_points[range_end - 1]];
+      if (point_id >= chunk.first_id + chunk.count || point_id - previous_id > max_gap_rows + 1)
+        break;
+    }
+    const auto last_id = point_ids[spilled_points[range_end - 1]];
+
+    rows.resize((last_id - first_id + 1) * chunk_row_size);
+    read_spilled_rows(*reader, chunk, first_id - chunk.first_id, gsl::make_span(rows));
+
+    for (auto spilled_point = range_begin; spilled_point < range_end; ++spilled_point) {
+      const auto idx = spilled_points[spilled_point];
+      auto row_element = rows.data() + (point_ids[idx] - first_id) * chunk_row_size;
+      for (size_t column = 0; column < targets.size(); ++column) {
+        if (!chunk.has_column[column])
+          continue;
+        const auto element_size = element_sizes[column];
+        std::memcpy(targets[column].data() + idx * element_size, row_element, element_size);
+        row_element += element_size;
+      }
+    }
+
+    range_begin = range_end;
+  }
+  release_spill_file_reader(std::move(reader));
+}
+
+size_t
+AttributeStore::spill(size_t bytes)
+{
+  if (!_spill_file.is_open())
+    return 0;
+
+  std::unique_lock _{ _lock };
+  size_t freed_bytes = 0;
+  std::vector<std::byte> rows;
+  while (freed_bytes < bytes && _next_chunk_to_spill < _chunks.size()) {
+    auto& chunk = _chunks[_next_chunk_to_spill++];
+
+    // Transpose the columns into rows, so that gathering a point reads a single
+    // contiguous range of the file
+    const auto chunk_row_size = row_size(chunk);
+    rows.resize(chunk.count * chunk_row_size);
+    size_t offset_in_row = 0;
+    for (size_t column = 0; column < chunk.columns.size(); ++column) {
+      if (!chunk.has_column[column])
+        continue;
+      const auto element_size = PointBuffer::attribute_byte_size(_attribute_order[column]);
+      for (size_t idx = 0; idx < chunk.count; ++idx) {
+        std::memcpy(rows.data() + idx * chunk_row_size + offset_in_row,
+                    chunk.columns[column].data() + idx * element_size,
+                    element_size);
+      }
+      offset_in_row += element_size;
+    }
+
+    _spill_file.seekp(static_cast<std::streamoff>(_spill_file_size));
+    _spill_file.write(reinterpret_cast<const char*>(rows.data()),
+                      static_cast<std::streamsize>(rows.size()));
+    if (!_spill_file) {
+      throw std::runtime_error{ concat("Could not write to spill file ",
+                                       _spill_file_path.string()) };
+    }
+
+    chunk.spill_offset = _spill_file_size;
+    _spill_file_size += rows.size();
+    chunk.columns = std::vector<std::vector<std::byte>>(chunk.columns.size());
+    _resident_bytes -= chunk.byte_size;
+    freed_bytes += chunk.byte_size;
+  }
+
+  // Gathering reads the spill file through separate handles
+  _spill_file.flush();
+  if (!_spill_file) {
+    throw std::runtime_error{ concat("Could not write to spill file ",
+                                     _spill_file_path.string()) };
+  }
+  return freed_bytes;
+}
+
+size_t
+AttributeStore::stored_bytes() const
+{
+  std::shared_lock _{ _lock };
+  return _stored_bytes;
+}
+
+size_t
+AttributeStore::resident_bytes() const
+{
+  std::shared_lock _{ _lock };
+  return _resident_bytes;
+}
+
+const AttributeStore::Chunk&
+AttributeStore::chunk_for(uint64_t point_id) const
+{
+  const auto next_chunk = std::upper_bound(
+    std::begin(_chunks), std::end(_chunks), point_id, [](uint64_t id, const Chunk& chunk) {
+      return id < chunk.first_id;
+    });
+  if (next_chunk == std::begin(_chunks) || point_id >= _next_id) {
+    throw std::invalid_argument{ concat("Point ID ", point_id, " is not in the AttributeStore") };
+  }
+  return *std::prev(next_chunk);
+}
+
+size_t
+AttributeStore::row_size(const Chunk& chunk) const
+{
+  size_t size = 0;
+  for (size_t column = 0; column < _attribute_order.size(); ++column) {
+    if (chunk.has_column[column]) {
+      size += PointBuffer::attribute_byte_size(_attribute_order[column]);
+    }
+  }
+  return size;
+}
+
+void
+AttributeStore::read_spilled_rows(std::ifstream& reader,
+                                  const Chunk& chunk,
+                                  uint64_t first_index,
+                                  gsl::span<std::byte> rows) const
+{
+  reader.seekg(static_cast<std::streamoff>(*chunk.spill_offset + first_index * row_size(chunk)));
+  reader.read(reinterpret_cast<char*>(rows.data()), static_cast<std::streamsize>(rows.size()));
+  if (!reader) {
+    throw std::runtime_error{ concat("Could not read from spill file ",
+                                     _spill_file_path.string()) };
+  }
+}
+
+std::unique_ptr<std::ifstream>
+AttributeStore::acquire_spill_file_reader() const
+{
+  {
+    std::lock_guard _{ _spill_file_readers_lock };
+    if (!_spill_file_readers.empty()) {
+      auto reader = std::move(_spill_file_readers.back());
+      _spill_file_readers.pop_back();
+      return reader;
+    }
+  }
+
+  auto reader = std::make_unique<std::ifstream>(_spill_file_path.string(), std::ios::binary);
+  if (!reader->is_open()) {
+    throw std::runtime_error{ concat("Could not open spill file ", _spill_file_path.string()) };
+  }
+  return reader;
+}
+
+void
+AttributeStore::release_spill_file_reader(std::unique_ptr<std::ifstream> reader) const
+{
+  std::lock_guard _{ _spill_file_readers_lock };
+  _spill_file_readers.push_back(std::move(reader));
+}
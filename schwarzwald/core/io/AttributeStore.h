@@ -0,0 +1,147 @@
+#pragma once
+
+#include "datastructures/PointBuffer.h"
+#include "pointcloud/PointAttributes.h"
+#include "util/Definitions.h"
+
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <vector>
+
+/**
+ * Columnar store for the point attributes that tiling does not need. With
+ * deferred attributes, the points that are indexed, sorted, sampled and staged
+ * only carry their positions, the attributes that tiling itself reads or
+ * writes (e.g. normals) and a global point ID. All other attributes are stored
+ * here once per point and gathered again right before a node is encoded.
+ *
+ * Each call to 'store' adds a chunk of consecutive point IDs. Storing and
+ * gathering are thread-safe. Stored attributes are never removed, so points
+ * that are stored again (e.g. after reading them back from a persistence) use
+ * additional memory. With a spill file, chunks can be moved out of memory into
+ * the file, where the attributes of each point are found by its point ID
+ */
+struct AttributeStore
+{
+  /**
+   * Creates an AttributeStore for the given attributes. Positions are never
+   * deferred. Without a spill file, all stored attributes stay in memory
+   */
+  explicit AttributeStore(const PointAttributes& deferred_attributes,
+                          const fs::path& spill_file_path = {});
+  ~AttributeStore();
+
+  AttributeStore(const AttributeStore&) = delete;
+  AttributeStore& operator=(const AttributeStore&) = delete;
+
+  /**
+   * Stores the deferred attributes of the first 'count' points of 'points' and
+   * returns a copy of these points without the deferred attributes, but with
+   * their point IDs
+   */
+  PointBuffer store(const PointBuffer& points, size_t count);
+  /**
+   * Stores the deferred attributes of all points of 'points' and removes them
+   * from 'points'
+   */
+  void store(PointBuffer& points);
+
+  /**
+   * Restores the deferred attributes of 'points' from their point IDs and
+   * removes the point IDs. Points without point IDs are left unchanged
+   */
+  void gather(PointBuffer& points) const;
+
+  const PointAttributes& deferred_attributes() const { return _deferred_attributes; }
+
+  /**
+   * Moves the oldest chunks that are still in memory into the spill file, until
+   * at least 'bytes' bytes were freed or all chunks are spilled. Spilled
+   * attributes are read back in ranges of consecutive rows when they are
+   * gathered. Returns the number of freed bytes, which is 0 without a spill file
+   */
+  size_t spill(size_t bytes);
+
+  /**
+   * Number of bytes of all stored attributes, both in memory and spilled
+   */
+  size_t stored_bytes() const;
+  /**
+   * Number of bytes of the stored attributes that are in memory
+   */
+  size_t resident_bytes() const;
+
+private:
+  struct Chunk
+  {
+    uint64_t first_id;
+    size_t count;
+    /**
+     * One column for each entry in '_attribute_order'. Attributes that the
+     * stored points did not have are empty and gathered as default values.
+     * The columns of spilled chunks are empty as well
+     */
+    std::vector<std::vector<std::byte>> columns;
+    /**
+     * Did the stored points have the attribute of each column?
+     */
+    std::vector<bool> has_column;
+    size_t byte_size;
+    /**
+     * Offset of a spilled chunk in the spill file. Spilled chunks are stored
+     * row by row, so that all attributes of a point can be read at once
+     */
+    std::optional<uint64_t> spill_offset;
+  };
+
+  const Chunk& chunk_for(uint64_t point_id) const;
+  size_t row_size(const Chunk& chunk) const;
+  /**
+   * Gathers the attributes of the points at 'spilled_points' from the spill
+   * file. The points are sorted by their IDs, so that the rows of each chunk
+   * are read in ranges of consecutive rows with a single read per range.
+   * Requires '_lock' to be held
+   */
+  void gather_spilled(gsl::span<const uint64_t> point_ids,
+                      std::vector<size_t> spilled_points,
+                      const std::vector<gsl::span<std::byte>>& targets,
+                      const std::vector<size_t>& element_sizes) const;
+  /**
+   * Reads the rows of a spilled chunk, starting at the row 'first_index', into
+   * 'rows', whose size has to be a multiple of 'row_size(chunk)'
+   */
+  void read_spilled_rows(std::ifstream& reader,
+                         const Chunk& chunk,
+                         uint64_t first_index,
+                         gsl::span<std::byte> rows) const;
+  /**
+   * Takes a read handle of the spill file from '_spill_file_readers', or opens
+   * a new one if all are in use. Every concurrent gather has its own handle, so
+   * that reads don't share a file position
+   */
+  std::unique_ptr<std::ifstream> acquire_spill_file_reader() const;
+  void release_spill_file_reader(std::unique_ptr<std::ifstream> reader) const;
+
+  PointAttributes _deferred_attributes;
+  std::vector<PointAttribute> _attribute_order;
+
+  mutable std::shared_mutex _lock;
+  std::vector<Chunk> _chunks;
+  uint64_t _next_id = 0;
+  size_t _stored_bytes = 0;
+  size_t _resident_bytes = 0;
+  // Chunks are spilled in the order in which they were stored
+  size_t _next_chunk_to_spill = 0;
+
+  fs::path _spill_file_path;
+  // Only written by spilling, which holds '_lock' exclusively, so it never runs
+  // concurrently with reading
+  std::ofstream _spill_file;
+  uint64_t _spill_file_size = 0;
+  mutable std::mutex _spill_file_readers_lock;
+  mutable std::vector<std::unique_ptr<std::ifstream>> _spill_file_readers;
+};
@@ -3,6 +3,7 @@
 #include "datastructures/PointBuffer.h"
 #include "io/io_util.h"
 #include "math/AABB.h"
+#include "pointcloud/NodeStatistics.h"
 #include "pointcloud/PointAttributes.h"
 #include "util/Definitions.h"
 #include "util/stuff.h"
@@ -200,6 +201,9 @@ struct BinaryPersistence
 
   inline bool is_lossless() const { return true; }
 
+  // The binary format has no hierarchy metadata, so no statistics are collected
+  inline NodeStatistics dataset_statistics() const { return {}; }
+
 private:
   std::string _work_dir;
   PointAttributes _input_attributes;
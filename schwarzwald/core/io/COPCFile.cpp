@@ -0,0 +1,306 @@
+#include "io/COPCFile.h"
+#include "util/stuff.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <numeric>
+
+#pragma region Helpers
+
+// See https://copc.io for the layout of the COPC VLRs
+constexpr static const char* COPC_USER_ID = "copc";
+constexpr static laszip_U16 COPC_INFO_RECORD_ID = 1;
+constexpr static size_t COPC_INFO_SIZE = 160;
+constexpr static size_t COPC_HIERARCHY_ENTRY_SIZE = 32;
+
+namespace copc {
+template<typename T>
+static T
+read_value(const uint8_t* data)
+{
+  T value;
+  std::memcpy(&value, data, sizeof(T));
+  return value;
+}
+
+const laszip_vlr*
+find_info_vlr(laszip_header const& header)
+{
+  for (laszip_U32 idx = 0; idx < header.number_of_variable_length_records; ++idx) {
+    const auto& vlr = header.vlrs[idx];
+    if (vlr.record_id == COPC_INFO_RECORD_ID &&
+        std::strncmp(vlr.user_id, COPC_USER_ID, sizeof(vlr.user_id)) == 0)
+      return &vlr;
+  }
+  return nullptr;
+}
+
+Info
+read_info(laszip_vlr const& info_vlr, const std::string& source)
+{
+  if (info_vlr.record_length_after_header < COPC_INFO_SIZE || !info_vlr.data) {
+    throw std::runtime_error{ concat("The COPC info VLR of ", source, " is too small") };
+  }
+
+  const auto* data = info_vlr.data;
+  Info info;
+  info.center = { read_value<double>(data),
+                  read_value<double>(data + 8),
+                  read_value<double>(data + 16) };
+  info.halfsize = read_value<double>(data + 24);
+  info.root_hierarchy_offset = read_value<uint64_t>(data + 40);
+  info.root_hierarchy_size = read_value<uint64_t>(data + 48);
+  return info;
+}
+
+std::vector<PointFileNode>
+read_hierarchy(std::istream& stream,
+               const Info& info,
+               size_t points_in_file,
+               const std::string& source)
+{
+  struct Page
+  {
+    uint64_t offset;
+    uint64_t size;
+  };
+  struct Chunk
+  {
+    uint64_t offset;
+    PointFileNode node;
+  };
+
+  std::vector<Page> pages_to_read{ { info.root_hierarchy_offset, info.root_hierarchy_size } };
+  std::vector<Chunk> chunks;
+  std::vector<uint8_t> page_data;
+  while (!pages_to_read.empty()) {
+    const auto page = pages_to_read.back();
+    pages_to_read.pop_back();
+
+    if (page.size % COPC_HIERARCHY_ENTRY_SIZE) {
+      throw std::runtime_error{ concat(
+        "Malformed COPC hierarchy page at offset ", page.offset, " in ", source) };
+    }
+    page_data.resize(page.size);
+    stream.seekg(static_cast<std::streamoff>(page.offset));
+    stream.read(reinterpret_cast<char*>(page_data.data()),
+                static_cast<std::streamsize>(page.size));
+    if (!stream) {
+      throw std::runtime_error{ concat(
+        "Could not read the COPC hierarchy page at offset ", page.offset, " in ", source) };
+    }
+
+    for (size_t entry_offset = 0; entry_offset < page.size;
+         entry_offset += COPC_HIERARCHY_ENTRY_SIZE) {
+      const auto* entry = page_data.data() + entry_offset;
+      const auto level = read_value<int32_t>(entry);
+      const auto x = read_value<int32_t>(entry + 4);
+      const auto y = read_value<int32_t>(entry + 8);
+      const auto z = read_value<int32_t>(entry + 12);
+      const auto offset = read_value<uint64_t>(entry + 16);
+      const auto byte_size = read_value<int32_t>(entry + 24);
+      const auto points_count = read_value<int32_t>(entry + 28);
+
+      // A point count of -1 refers to another hierarchy page
+      if (points_count == -1) {
+        pages_to_read.push_back({ offset, static_cast<uint64_t>(byte_size) });
+        continue;
+      }
+      if (points_count <= 0)
+        continue;
+
+      if (level < 0 || level > static_cast<int32_t>(OctreeNodeIndex64::MAX_LEVELS) || x < 0 ||
+          y < 0 || z < 0) {
+        throw std::runtime_error{ concat(
+          "Invalid node ", level, "-", x, "-", y, "-", z, " in the hierarchy of ", source) };
+      }
+      const auto index = OctreeNodeIndex64::from_grid_index(
+        { static_cast<uint64_t>(x), static_cast<uint64_t>(y), static_cast<uint64_t>(z) },
+        static_cast<uint32_t>(level));
+      chunks.push_back({ offset, { index, static_cast<size_t>(points_count), 0 } });
+    }
+  }
+
+  // Each node is a LAZ chunk, so the points of the nodes are stored in the
+  // order of the chunks in the file
+  std::sort(std::begin(chunks), std::end(chunks), [](const auto& l, const auto& r) {
+    return l.offset < r.offset;
+  });
+  std::vector<PointFileNode> nodes;
+  nodes.reserve(chunks.size());
+  size_t first_point = 0;
+  for (auto& chunk : chunks) {
+    chunk.node.first_point = first_point;
+    first_point += chunk.node.points_count;
+    nodes.push_back(chunk.node);
+  }
+
+  if (first_point != points_in_file) {
+    throw std::runtime_error{ concat("The hierarchy of ",
+                                     source,
+                                     " contains ",
+                                     first_point,
+                                     " points, but the file contains ",
+                                     points_in_file,
+                                     " points") };
+  }
+
+  return nodes;
+}
+} // namespace copc
+
+#pragma endregion
+
+#pragma region COPCInputIterator
+
+COPCInputIterator::COPCInputIterator()
+  : _copc_file(nullptr)
+  , _node(std::numeric_limits<size_t>::max())
+  , _index_in_node(std::numeric_limits<size_t>::max())
+  , _distance_to_end(0)
+{}
+
+COPCInputIterator::COPCInputIterator(COPCFile const& copc_file, size_t node)
+  : _copc_file(&copc_file)
+  , _node(node)
+  , _index_in_node(0)
+  , _las_iterator(copc_file._las_file, copc_file._hierarchy.nodes[node].first_point)
+{
+  const auto& nodes = copc_file._hierarchy.nodes;
+  _distance_to_end = std::accumulate(std::begin(nodes) + node,
+                                     std::end(nodes),
+                                     size_t{ 0 },
+                                     [](size_t sum, const auto& hierarchy_node) {
+                                       return sum + hierarchy_node.points_count;
+                                     });
+}
+
+bool
+COPCInputIterator::operator==(const COPCInputIterator& other) const
+{
+  return !operator!=(other);
+}
+
+bool
+COPCInputIterator::operator!=(const COPCInputIterator& other) const
+{
+  return _copc_file != other._copc_file || _node != other._node ||
+         _index_in_node != other._index_in_node;
+}
+
+COPCInputIterator&
+COPCInputIterator::operator++()
+{
+  --_distance_to_end;
+
+  const auto& nodes = _copc_file->_hierarchy.nodes;
+  const auto& current_node = nodes[_node];
+  if (++_index_in_node < current_node.points_count) {
+    ++_las_iterator;
+    return *this;
+  }
+
+  if (++_node == nodes.size()) {
+    *this = {};
+    return *this;
+  }
+
+  _index_in_node = 0;
+  const auto& next_node = nodes[_node];
+  // Only seek if the next node is not the next chunk in the file
+  if (next_node.first_point == current_node.first_point + current_node.points_count) {
+    ++_las_iterator;
+  } else {
+    _las_iterator = LASInputIterator{ _copc_file->_las_file, next_node.first_point };
+  }
+  return *this;
+}
+
+laszip_point const& COPCInputIterator::operator*() const
+{
+  return *_las_iterator;
+}
+
+size_t
+COPCInputIterator::distance_to_end() const
+{
+  return _distance_to_end;
+}
+
+laszip_header const&
+COPCInputIterator::las_header() const
+{
+  return _copc_file->_las_file.get_metadata();
+}
+
+#pragma endregion
+
+#pragma region COPCFile
+
+COPCFile::COPCFile(LASFile las_file)
+  : _las_file(std::move(las_file))
+{
+  const auto* info_vlr = copc::find_info_vlr(_las_file.get_metadata());
+  if (!info_vlr) {
+    throw std::invalid_argument{ concat(source(), " is not a COPC file") };
+  }
+
+  const auto info = copc::read_info(*info_vlr, source());
+  const Vector3<double> halfsize{ info.halfsize, info.halfsize, info.halfsize };
+  _hierarchy.root_bounds = { info.center - halfsize, info.center + halfsize };
+
+  std::ifstream stream{ source(), std::ios::binary };
+  if (!stream.is_open()) {
+    throw std::runtime_error{ concat("Could not open ", source(), " to read its hierarchy") };
+  }
+  _hierarchy.nodes = copc::read_hierarchy(stream, info, size(), source());
+  sort_nodes_spatially(_hierarchy.nodes);
+}
+
+COPCFile::metadata const&
+COPCFile::get_metadata() const
+{
+  return _hierarchy;
+}
+
+LASFile const&
+COPCFile::las_file() const
+{
+  return _las_file;
+}
+
+size_t
+COPCFile::size() const
+{
+  return _las_file.size();
+}
+
+std::string
+COPCFile::source() const
+{
+  return _las_file.source();
+}
+
+COPCInputIterator
+COPCFile::cbegin() const
+{
+  if (_hierarchy.nodes.empty())
+    return {};
+  return { *this, 0 };
+}
+
+COPCInputIterator
+COPCFile::cend() const
+{
+  return {};
+}
+
+#pragma endregion
+
+bool
+is_copc_file(laszip_header const& header)
+{
+  return copc::find_info_vlr(header) != nullptr;
+}
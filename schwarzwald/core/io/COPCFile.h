@@ -0,0 +1,215 @@
+#pragma once
+
+#include "io/LASFile.h"
+#include "io/PointFileHierarchy.h"
+#include "io/PointcloudFile.h"
+
+#include <istream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+struct COPCFile;
+
+namespace copc {
+/**
+ * The parts of the COPC info VLR that are needed for reading the hierarchy
+ */
+struct Info
+{
+  Vector3<double> center;
+  double halfsize;
+  uint64_t root_hierarchy_offset;
+  uint64_t root_hierarchy_size;
+};
+
+/**
+ * Returns the COPC info VLR of the LAS file with the given header, or nullptr if
+ * the file is no COPC file
+ */
+const laszip_vlr*
+find_info_vlr(laszip_header const& header);
+
+/**
+ * Parses the given COPC info VLR. 'source' names the file in error messages
+ */
+Info
+read_info(laszip_vlr const& info_vlr, const std::string& source);
+
+/**
+ * Reads all hierarchy pages of a COPC file from the given stream, starting at
+ * the root page of 'info', and returns the nodes that contain points in the
+ * order in which they are stored in the file. Throws if the nodes don't contain
+ * exactly 'points_in_file' points
+ */
+std::vector<PointFileNode>
+read_hierarchy(std::istream& stream,
+               const Info& info,
+               size_t points_in_file,
+               const std::string& source);
+} // namespace copc
+
+/**
+ * Input iterator into a COPC file. The points are read node by node, in the
+ * order of the nodes in the hierarchy of the file
+ */
+struct COPCInputIterator
+{
+  using iterator_category = std::input_iterator_tag;
+  using value_type = laszip_point;
+  using difference_type = std::ptrdiff_t;
+  using pointer = laszip_point const*;
+  using reference = laszip_point const&;
+
+  COPCInputIterator();
+  /**
+   * Iterator to the first point of the node at position 'node' in the hierarchy
+   * of the given file
+   */
+  COPCInputIterator(COPCFile const& copc_file, size_t node);
+
+  bool operator==(const COPCInputIterator& other) const;
+  bool operator!=(const COPCInputIterator& other) const;
+
+  COPCInputIterator& operator++();
+
+  laszip_point const& operator*() const;
+
+  size_t distance_to_end() const;
+
+  /**
+   * Header of the LAS file that contains the current point
+   */
+  laszip_header const& las_header() const;
+
+private:
+  COPCFile const* _copc_file;
+  size_t _node;
+  size_t _index_in_node;
+  size_t _distance_to_end;
+  LASInputIterator _las_iterator;
+};
+
+/**
+ * Cloud Optimized Point Cloud (COPC) file, i.e. a LAZ file whose chunks are the
+ * nodes of an octree. Reading a COPC file yields its points node by node in the
+ * spatial order of its hierarchy, instead of the order in which the nodes are
+ * stored. Iterators refer to the COPCFile, so they are invalidated when the
+ * file is moved
+ */
+struct COPCFile
+{
+  friend struct COPCInputIterator;
+
+  using const_iterator = COPCInputIterator;
+  using metadata = PointFileHierarchy;
+
+  /**
+   * Reads the hierarchy of the given LAS file, which has to be a COPC file (see
+   * 'is_copc_file')
+   */
+  explicit COPCFile(LASFile las_file);
+  COPCFile(COPCFile const&) = delete;
+  COPCFile(COPCFile&&) = default;
+
+  COPCFile& operator=(COPCFile const&) = delete;
+  COPCFile& operator=(COPCFile&&) = default;
+
+  /**
+   * The metadata of a COPC file is its hierarchy
+   */
+  metadata const& get_metadata() const;
+  LASFile const& las_file() const;
+  size_t size() const;
+  std::string source() const;
+
+  COPCInputIterator begin() const { return cbegin(); }
+  COPCInputIterator end() const { return cend(); }
+
+  COPCInputIterator cbegin() const;
+  COPCInputIterator cend() const;
+
+private:
+  LASFile _las_file;
+  PointFileHierarchy _hierarchy;
+};
+
+/**
+ * Does the LAS file with the given header contain the COPC info VLR?
+ */
+bool
+is_copc_file(laszip_header const& header);
+
+namespace pc {
+template<>
+inline AABB
+get_bounds(COPCFile const& f)
+{
+  return get_bounds_from_las_header(f.las_file().get_metadata());
+}
+
+template<>
+inline AABB
+get_exact_bounds(COPCFile const& f)
+{
+  return las_exact_bounds(f.las_file());
+}
+
+template<>
+inline Vector3<double>
+get_offset(COPCFile const& f)
+{
+  return get_offset_from_las_header(f.las_file().get_metadata());
+}
+
+template<>
+inline size_t
+get_point_count(COPCFile const& f)
+{
+  return f.size();
+}
+
+template<>
+inline uint32_t
+get_point_record_length(COPCFile const& f)
+{
+  return f.las_file().get_metadata().point_data_record_length;
+}
+
+template<>
+inline bool
+is_compressed(COPCFile const&)
+{
+  return true;
+}
+
+template<>
+inline bool
+has_attribute(COPCFile const& f, PointAttribute const& attribute)
+{
+  return las_file_has_attribute(f.las_file().get_metadata(), attribute);
+}
+
+template<>
+inline COPCInputIterator
+read_points(COPCInputIterator begin,
+            size_t count,
+            PointFileHierarchy const&,
+            PointAttributes const& attributes,
+            PointBuffer& points)
+{
+  return read_las_points(begin, count, attributes, points);
+}
+
+template<>
+inline std::pair<COPCInputIterator, PointBuffer::PointIterator>
+read_points_into(COPCInputIterator file_begin,
+                 COPCInputIterator file_end,
+                 PointFileHierarchy const&,
+                 PointAttributes const&,
+                 util::Range<PointBuffer::PointIterator> point_range)
+{
+  return read_las_points_into(file_begin, file_end, point_range);
+}
+
+} // namespace pc
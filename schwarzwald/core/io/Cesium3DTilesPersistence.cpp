@@ -2,6 +2,8 @@
 
 #include "datastructures/DynamicMortonIndex.h"
 #include "datastructures/OctreeNodeIndex.h"
+#include "io/GLBReader.h"
+#include "io/GLBWriter.h"
 #include "io/PNTSReader.h"
 #include "io/PNTSWriter.h"
 #include "io/TileSetWriter.h"
@@ -15,10 +17,34 @@
 #include <queue>
 #include <taskflow/taskflow.hpp>
 
+/**
+ * Clips 'bounds' to 'limits' on all axes where the two overlap. Axes where they
+ * don't overlap (e.g. because of rounding) keep the extent of 'bounds'
+ */
+static AABB
+clip_bounds(const AABB& bounds, const std::optional<AABB>& limits)
+{
+  if (!limits)
+    return bounds;
+
+  auto clipped_bounds = bounds;
+  for (auto axis : { &Vector3<double>::x, &Vector3<double>::y, &Vector3<double>::z }) {
+    const auto min = std::max(bounds.min.*axis, limits->min.*axis);
+    const auto max = std::min(bounds.max.*axis, limits->max.*axis);
+    if (min > max)
+      continue;
+    clipped_bounds.min.*axis = min;
+    clipped_bounds.max.*axis = max;
+  }
+  return clipped_bounds;
+}
+
 PointAttributes
 Cesium3DTilesPersistence::supported_output_attributes()
 {
-  return { PointAttribute::Position, PointAttribute::RGB, PointAttribute::Intensity };
+  return {
+    PointAttribute::Position, PointAttribute::RGB, PointAttribute::Intensity, PointAttribute::Normal
+  };
 }
 
 Cesium3DTilesPersistence::Cesium3DTilesPersistence(const std::string& work_dir,
@@ -26,13 +52,19 @@ Cesium3DTilesPersistence::Cesium3DTilesPersistence(const std::string& work_dir,
                                                    const PointAttributes& output_attributes,
                                                    RGBMapping rgb_mapping,
                                                    float spacing_at_root,
-                                                   Vector3<double> const& global_offset)
+                                                   Vector3<double> const& global_offset,
+                                                   PNTSEncoding encoding,
+                                                   TileContentFormat content_format,
+                                                   std::optional<AABB> bounding_volume_limits)
   : _work_dir(work_dir)
   , _input_attributes(input_attributes)
   , _output_attributes(output_attributes)
   , _rgb_mapping(rgb_mapping)
   , _spacing_at_root(spacing_at_root)
   , _global_offset(global_offset)
+  , _encoding(encoding)
+  , _content_format(content_format)
+  , _bounding_volume_limits(std::move(bounding_volume_limits))
   , _tilesets_lock(std::make_unique<std::mutex>())
 {
   if (!attributes_are_subset(_input_attributes, _output_attributes)) {
@@ -59,36 +91,72 @@ Cesium3DTilesPersistence::persist_points(PointBuffer const& points,
     throw std::runtime_error{ "persist_points requires a non-empty range" };
   }
 
-  PNTSWriter writer{ concat(_work_dir, "/", node_name, ".pnts"), _output_attributes, _rgb_mapping };
-  writer.write_points(points);
-  writer.flush(_global_offset);
-
-  on_write_node(node_name, bounds);
+  on_write_node(node_name, bounds, write_tile_content(points, node_name));
 }
 
 void
 Cesium3DTilesPersistence::retrieve_points(const std::string& node_name, PointBuffer& points)
 {
-  const auto file_path = concat(_work_dir, "/", node_name, ".pnts");
+  const auto file_path = content_file_path(node_name);
   if (!std::experimental::filesystem::exists(file_path))
     return;
 
-  auto pnts_content = readPNTSFile(file_path, _input_attributes);
-  points = std::move(pnts_content->points);
+  if (_content_format == TileContentFormat::GLB) {
+    auto glb_content = readGLBFile(file_path, _input_attributes);
+    points = std::move(glb_content->points);
+  } else {
+    auto pnts_content = readPNTSFile(file_path, _input_attributes);
+    points = std::move(pnts_content->points);
+  }
+}
+
+std::string
+Cesium3DTilesPersistence::content_file_path(const std::string& node_name) const
+{
+  const auto extension = (_content_format == TileContentFormat::GLB) ? ".glb" : ".pnts";
+  return concat(_work_dir, "/", node_name, extension);
+}
+
+NodeStatistics
+Cesium3DTilesPersistence::write_tile_content(const PointBuffer& points,
+                                             const std::string& node_name) const
+{
+  if (_content_format == TileContentFormat::GLB) {
+    GLBWriter writer{ content_file_path(node_name), _output_attributes, _rgb_mapping };
+    writer.write_points(points);
+    writer.flush(_global_offset);
+    return writer.statistics();
+  }
+
+  PNTSWriter writer{ content_file_path(node_name), _output_attributes, _rgb_mapping, _encoding };
+  writer.write_points(points);
+  writer.flush(_global_offset);
+  return writer.statistics();
 }
 
 void
-Cesium3DTilesPersistence::on_write_node(const std::string& node_name, const AABB& node_bounds)
+Cesium3DTilesPersistence::on_write_node(const std::string& node_name,
+                                        const AABB& node_bounds,
+                                        NodeStatistics node_statistics)
 {
   std::lock_guard _{ *_tilesets_lock };
 
+  _dataset_statistics.merge(node_statistics);
+
   const auto setup_tileset =
     [this](Tileset& tileset, const std::string& node_name, const AABB& node_bounds) {
       const auto node_morton_index =
         DynamicMortonIndex::parse_string(node_name, MortonIndexNamingConvention::Potree).value();
 
-      tileset.boundingVolume = boundingVolumeFromAABB(node_bounds.translate(_global_offset));
-      tileset.content_url = concat(node_name, ".pnts");
+      tileset.boundingVolume = boundingVolumeFromAABB(
+        clip_bounds(node_bounds.translate(_global_offset), _bounding_volume_limits));
+      tileset.content_url = (_content_format == TileContentFormat::GLB)
+                              ? concat(node_name, ".glb")
+                              : concat(node_name, ".pnts");
+      // glTF tile content was introduced with 3D Tiles 1.1
+      if (_content_format == TileContentFormat::GLB) {
+        tileset.version = "1.1";
+      }
       tileset.url = concat(node_name, ".json");
       tileset.geometricError =
         _spacing_at_root / std::pow(2.0, static_cast<double>(node_morton_index.depth()));
@@ -116,6 +184,7 @@ Cesium3DTilesPersistence::on_write_node(const std::string& node_name, const AABB
       current_tileset = &child;
     }
 
+    current_tileset->statistics = std::move(node_statistics);
     return;
   }
 
@@ -143,15 +212,13 @@ Cesium3DTilesPersistence::on_write_node(const std::string& node_name, const AABB
       setup_tileset(child, substr, child_bounds);
 
       child_iter = std::prev(std::end(current_tileset->children));
-
-      if (idx == node_name.size() - 1) {
-        break;
-      }
     }
 
     current_tileset = &*child_iter;
     current_bounds = child_bounds;
   }
+
+  current_tileset->statistics = std::move(node_statistics);
 }
 
 static void
@@ -209,9 +276,15 @@ Cesium3DTilesPersistence::write_tilesets() const
   executor.run(taskflow).wait();
 }
 
+NodeStatistics
+Cesium3DTilesPersistence::dataset_statistics() const
+{
+  std::lock_guard _{ *_tilesets_lock };
+  return _dataset_statistics;
+}
+
 bool
 Cesium3DTilesPersistence::node_exists(const std::string& node_name) const
 {
-  const auto file_path = concat(_work_dir, "/", node_name, ".pnts");
-  return fs::exists(file_path);
+  return fs::exists(content_file_path(node_name));
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "datastructures/PointBuffer.h"
 #include "io/PNTSWriter.h"
 #include "math/AABB.h"
+#include "pointcloud/NodeStatistics.h"
 #include "pointcloud/PointAttributes.h"
 #include "pointcloud/Tileset.h"
 #include "util/stuff.h"
@@ -15,7 +16,22 @@
 struct SRSTransformHelper;
 
 /**
- * Sink for writing 3D Tiles files
+ * File format of the content of each tile
+ */
+enum class TileContentFormat
+{
+  // Point cloud tiles (.pnts) of 3D Tiles 1.0
+  PNTS,
+  // Binary glTF (.glb) with meshopt-compressed attributes, as used by 3D Tiles 1.1
+  GLB
+};
+
+/**
+ * Sink for writing 3D Tiles files. If 'bounding_volume_limits' are given, the
+ * bounding volumes of all tilesets are clipped to these bounds (in the same
+ * coordinate system as the points before they are shifted by
+ * 'global_offset'). This keeps the bounding volumes of flat datasets flat, even
+ * though the nodes themselves are cubes
  */
 struct Cesium3DTilesPersistence
 {
@@ -26,7 +42,10 @@ struct Cesium3DTilesPersistence
                            const PointAttributes& output_attributes,
                            RGBMapping rgb_mapping,
                            float spacing_at_root,
-                           const Vector3<double>& global_offset);
+                           const Vector3<double>& global_offset,
+                           PNTSEncoding encoding = PNTSEncoding::Default,
+                           TileContentFormat content_format = TileContentFormat::PNTS,
+                           std::optional<AABB> bounding_volume_limits = std::nullopt);
   Cesium3DTilesPersistence(Cesium3DTilesPersistence&&) = default;
   ~Cesium3DTilesPersistence();
 
@@ -40,19 +59,14 @@ struct Cesium3DTilesPersistence
       throw std::runtime_error{ "persist_points requires a non-empty range" };
     }
 
-    PNTSWriter writer{ concat(_work_dir, "/", node_name, ".pnts"),
-                       _output_attributes,
-                       _rgb_mapping };
     // OPTIMIZATION This is not optimal, writer should be able to take iterator
     // pair
     PointBuffer tmp_points;
-    std::for_each(points_begin, points_end, [&tmp_points](const auto& point_ref) {
+    std::for_each(points_begin, points_end, [&](const auto& point_ref) {
       tmp_points.push_point(point_ref);
     });
-    writer.write_points(tmp_points);
-    writer.flush(_global_offset);
 
-    on_write_node(node_name, bounds);
+    on_write_node(node_name, bounds, write_tile_content(tmp_points, node_name));
   }
   void persist_points(PointBuffer const& points, const AABB& bounds, const std::string& node_name);
 
@@ -60,10 +74,31 @@ struct Cesium3DTilesPersistence
 
   bool node_exists(const std::string& node_name) const;
 
-  inline bool is_lossless() const { return true; }
+  /**
+   * The compact encoding and GLB content quantize positions, colors and
+   * normals, so points that are read back differ slightly from the points that
+   * were written
+   */
+  inline bool is_lossless() const
+  {
+    return _encoding == PNTSEncoding::Default && _content_format == TileContentFormat::PNTS;
+  }
+
+  /**
+   * Returns the merged statistics of all nodes that have been written so far
+   */
+  NodeStatistics dataset_statistics() const;
 
 private:
-  void on_write_node(const std::string& node_name, const AABB& node_bounds);
+  std::string content_file_path(const std::string& node_name) const;
+  /**
+   * Writes the content file of a node and returns the statistics of the
+   * written attributes, which the writers accumulate while encoding them
+   */
+  NodeStatistics write_tile_content(const PointBuffer& points, const std::string& node_name) const;
+  void on_write_node(const std::string& node_name,
+                     const AABB& node_bounds,
+                     NodeStatistics node_statistics);
   void write_tilesets() const;
 
   std::string _work_dir;
@@ -72,7 +107,11 @@ private:
   RGBMapping _rgb_mapping;
   float _spacing_at_root;
   Vector3<double> _global_offset;
+  PNTSEncoding _encoding;
+  TileContentFormat _content_format;
+  std::optional<AABB> _bounding_volume_limits;
 
   std::unique_ptr<std::mutex> _tilesets_lock;
   std::optional<Tileset> _root_tileset;
+  NodeStatistics _dataset_statistics;
 };
\ No newline at end of file
@@ -0,0 +1,344 @@
+#include "io/EPTFile.h"
+#include "util/stuff.h"
+
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <rapidjson/document.h>
+
+namespace rj = rapidjson;
+
+#pragma region Helpers
+
+namespace ept {
+static rj::Document
+read_json_file(const fs::path& path)
+{
+  std::ifstream stream{ path };
+  if (!stream.is_open()) {
+    throw std::runtime_error{ concat("Could not open ", path.string()) };
+  }
+
+  const std::string json{ std::istreambuf_iterator<char>{ stream }, {} };
+  rj::Document document;
+  if (document.Parse<0>(json.c_str()).HasParseError() || !document.IsObject()) {
+    throw std::runtime_error{ concat("Could not parse ", path.string()) };
+  }
+  return document;
+}
+
+static bool
+is_bounds(const rj::Value& value)
+{
+  if (!value.IsArray() || value.Size() != 6)
+    return false;
+  for (auto element = value.Begin(); element != value.End(); ++element) {
+    if (!element->IsNumber())
+      return false;
+  }
+  return true;
+}
+
+/**
+ * EPT stores bounds as [xmin, ymin, zmin, xmax, ymax, zmax]
+ */
+static AABB
+bounds_from_json(const rj::Value& value)
+{
+  return { { value[0].GetDouble(), value[1].GetDouble(), value[2].GetDouble() },
+           { value[3].GetDouble(), value[4].GetDouble(), value[5].GetDouble() } };
+}
+
+/**
+ * Reads the nodes of the given hierarchy page and of all pages below it
+ */
+static void
+read_hierarchy_page(const fs::path& hierarchy_directory,
+                    const std::string& page_key,
+                    std::vector<PointFileNode>& nodes)
+{
+  const auto page_path = hierarchy_directory / (page_key + ".json");
+  const auto page = read_json_file(page_path);
+
+  for (auto entry = page.MemberBegin(); entry != page.MemberEnd(); ++entry) {
+    const std::string key = entry->name.GetString();
+    if (!entry->value.IsInt64()) {
+      throw std::runtime_error{ concat(
+        "Invalid point count of node ", key, " in ", page_path.string()) };
+    }
+
+    // A point count of -1 refers to the hierarchy page of the node. The node
+    // itself is listed in that page
+    const auto points_count = entry->value.GetInt64();
+    if (points_count == -1) {
+      if (key != page_key) {
+        read_hierarchy_page(hierarchy_directory, key, nodes);
+      }
+      continue;
+    }
+    if (points_count <= 0)
+      continue;
+
+    const auto index = OctreeNodeIndex64::from_string(key, MortonIndexNamingConvention::Entwine);
+    if (!index) {
+      throw std::runtime_error{ concat(
+        "Invalid node ", key, " in ", page_path.string(), ": ", index.error()) };
+    }
+    nodes.push_back({ *index, static_cast<size_t>(points_count), 0 });
+  }
+}
+} // namespace ept
+
+#pragma endregion
+
+#pragma region EPTInputIterator
+
+EPTInputIterator::EPTInputIterator()
+  : _ept_file(nullptr)
+  , _node(std::numeric_limits<size_t>::max())
+  , _index_in_node(std::numeric_limits<size_t>::max())
+  , _distance_to_end(0)
+{}
+
+EPTInputIterator::EPTInputIterator(EPTFile const& ept_file, size_t node)
+  : _ept_file(&ept_file)
+  , _node(node)
+  , _index_in_node(0)
+{
+  const auto& nodes = ept_file._hierarchy.nodes;
+  _distance_to_end = std::accumulate(std::begin(nodes) + node,
+                                     std::end(nodes),
+                                     size_t{ 0 },
+                                     [](size_t sum, const auto& hierarchy_node) {
+                                       return sum + hierarchy_node.points_count;
+                                     });
+  open_node_file();
+}
+
+bool
+EPTInputIterator::operator==(const EPTInputIterator& other) const
+{
+  return !operator!=(other);
+}
+
+bool
+EPTInputIterator::operator!=(const EPTInputIterator& other) const
+{
+  return _ept_file != other._ept_file || _node != other._node ||
+         _index_in_node != other._index_in_node;
+}
+
+EPTInputIterator&
+EPTInputIterator::operator++()
+{
+  --_distance_to_end;
+
+  const auto& nodes = _ept_file->_hierarchy.nodes;
+  if (++_index_in_node < nodes[_node].points_count) {
+    ++_las_iterator;
+    return *this;
+  }
+
+  if (++_node == nodes.size()) {
+    *this = {};
+    return *this;
+  }
+
+  _index_in_node = 0;
+  open_node_file();
+  return *this;
+}
+
+laszip_point const& EPTInputIterator::operator*() const
+{
+  return *_las_iterator;
+}
+
+size_t
+EPTInputIterator::distance_to_end() const
+{
+  return _distance_to_end;
+}
+
+laszip_header const&
+EPTInputIterator::las_header() const
+{
+  return _node_file->get_metadata();
+}
+
+void
+EPTInputIterator::open_node_file()
+{
+  const auto& node = _ept_file->_hierarchy.nodes[_node];
+  _node_file = std::make_shared<LASFile>(_ept_file->node_file_path(node.index),
+                                         LASFile::OpenMode::Read);
+  if (_node_file->size() != node.points_count) {
+    throw std::runtime_error{ concat("Node file ",
+                                     _node_file->source(),
+                                     " contains ",
+                                     _node_file->size(),
+                                     " points, but the hierarchy of the EPT dataset lists ",
+                                     node.points_count,
+                                     " points") };
+  }
+  _las_iterator = LASInputIterator{ *_node_file, 0 };
+}
+
+#pragma endregion
+
+#pragma region EPTFile
+
+EPTFile::EPTFile(fs::path const& ept_json_path)
+  : _ept_json_path(ept_json_path)
+{
+  const auto ept_json = ept::read_json_file(_ept_json_path);
+  if (!ept_json.HasMember("bounds") || !ept::is_bounds(ept_json["bounds"]) ||
+      !ept_json.HasMember("dataType") || !ept_json["dataType"].IsString()) {
+    throw std::runtime_error{ concat(_ept_json_path.string(),
+                                     " is missing the bounds or the data type") };
+  }
+
+  const std::string data_type = ept_json["dataType"].GetString();
+  if (data_type != "laszip") {
+    throw std::invalid_argument{ concat("The EPT dataset ",
+                                        _ept_json_path.string(),
+                                        " has the data type '",
+                                        data_type,
+                                        "'. Only EPT datasets with LAZ nodes (data type "
+                                        "'laszip') are supported") };
+  }
+  if (ept_json.HasMember("hierarchyType") && ept_json["hierarchyType"].IsString() &&
+      std::string{ ept_json["hierarchyType"].GetString() } != "json") {
+    throw std::invalid_argument{ concat("The EPT dataset ",
+                                        _ept_json_path.string(),
+                                        " has an unsupported hierarchy type") };
+  }
+
+  _hierarchy.root_bounds = ept::bounds_from_json(ept_json["bounds"]);
+  _conforming_bounds =
+    (ept_json.HasMember("boundsConforming") && ept::is_bounds(ept_json["boundsConforming"]))
+      ? ept::bounds_from_json(ept_json["boundsConforming"])
+      : _hierarchy.root_bounds;
+
+  const auto hierarchy_directory = _ept_json_path.parent_path() / "ept-hierarchy";
+  ept::read_hierarchy_page(hierarchy_directory, "0-0-0-0", _hierarchy.nodes);
+  if (_hierarchy.nodes.empty()) {
+    throw std::invalid_argument{ concat("The EPT dataset ",
+                                        _ept_json_path.string(),
+                                        " contains no points") };
+  }
+  sort_nodes_spatially(_hierarchy.nodes);
+
+  _points_count = std::accumulate(std::begin(_hierarchy.nodes),
+                                  std::end(_hierarchy.nodes),
+                                  size_t{ 0 },
+                                  [](size_t sum, const auto& node) {
+                                    return sum + node.points_count;
+                                  });
+
+  _first_node_file.open(node_file_path(_hierarchy.nodes.front().index), LASFile::OpenMode::Read);
+}
+
+EPTFile::metadata const&
+EPTFile::get_metadata() const
+{
+  return _hierarchy;
+}
+
+LASFile const&
+EPTFile::first_node_file() const
+{
+  return _first_node_file;
+}
+
+AABB const&
+EPTFile::conforming_bounds() const
+{
+  return _conforming_bounds;
+}
+
+size_t
+EPTFile::size() const
+{
+  return _points_count;
+}
+
+std::string
+EPTFile::source() const
+{
+  return _ept_json_path.string();
+}
+
+fs::path
+EPTFile::node_file_path(OctreeNodeIndex64 const& node) const
+{
+  return _ept_json_path.parent_path() / "ept-data" /
+         (OctreeNodeIndex64::to_string(node, MortonIndexNamingConvention::Entwine) + ".laz");
+}
+
+EPTInputIterator
+EPTFile::cbegin() const
+{
+  return { *this, 0 };
+}
+
+EPTInputIterator
+EPTFile::cend() const
+{
+  return {};
+}
+
+#pragma endregion
+
+bool
+is_ept_dataset(fs::path const& path)
+{
+  return path.filename() == "ept.json";
+}
+
+AABB
+ept_exact_bounds(EPTFile const& file)
+{
+  AABB bounds;
+  for (const auto& node : file.get_metadata().nodes) {
+    const LASFile node_file{ file.node_file_path(node.index), LASFile::OpenMode::Read };
+    bounds.update(las_exact_bounds(node_file));
+  }
+  return bounds;
+}
+
+AABB
+ept_exact_bounds(EPTFile const& file, tf::Subflow& subflow)
+{
+  const auto& nodes = file.get_metadata().nodes;
+  std::vector<AABB> node_bounds(nodes.size());
+  std::exception_ptr error;
+  std::mutex error_lock;
+
+  for (size_t node_idx = 0; node_idx < nodes.size(); ++node_idx) {
+    subflow
+      .emplace([&file, &nodes, &node_bounds, &error, &error_lock, node_idx]() {
+        try {
+          const LASFile node_file{ file.node_file_path(nodes[node_idx].index),
+                                   LASFile::OpenMode::Read };
+          node_bounds[node_idx] = las_exact_bounds(node_file);
+        } catch (...) {
+          std::lock_guard guard{ error_lock };
+          if (!error)
+            error = std::current_exception();
+        }
+      })
+      .name("ept_node_exact_bounds");
+  }
+  subflow.join();
+
+  if (error)
+    std::rethrow_exception(error);
+
+  AABB bounds;
+  for (const auto& bounds_of_node : node_bounds) {
+    bounds.update(bounds_of_node);
+  }
+  return bounds;
+}
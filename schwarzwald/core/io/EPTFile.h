@@ -0,0 +1,212 @@
+#pragma once
+
+#include "io/LASFile.h"
+#include "io/PointFileHierarchy.h"
+#include "io/PointcloudFile.h"
+
+#include <iterator>
+#include <memory>
+#include <taskflow/taskflow.hpp>
+
+struct EPTFile;
+
+/**
+ * Input iterator into an EPT dataset. The points are read node by node, in the
+ * order of the nodes in the hierarchy of the dataset. Copies of an iterator
+ * share the node file that is currently open
+ */
+struct EPTInputIterator
+{
+  using iterator_category = std::input_iterator_tag;
+  using value_type = laszip_point;
+  using difference_type = std::ptrdiff_t;
+  using pointer = laszip_point const*;
+  using reference = laszip_point const&;
+
+  EPTInputIterator();
+  /**
+   * Iterator to the first point of the node at position 'node' in the hierarchy
+   * of the given dataset
+   */
+  EPTInputIterator(EPTFile const& ept_file, size_t node);
+
+  bool operator==(const EPTInputIterator& other) const;
+  bool operator!=(const EPTInputIterator& other) const;
+
+  EPTInputIterator& operator++();
+
+  laszip_point const& operator*() const;
+
+  size_t distance_to_end() const;
+
+  /**
+   * Header of the LAS file that contains the current point
+   */
+  laszip_header const& las_header() const;
+
+private:
+  void open_node_file();
+
+  EPTFile const* _ept_file;
+  size_t _node;
+  size_t _index_in_node;
+  size_t _distance_to_end;
+  std::shared_ptr<LASFile> _node_file;
+  LASInputIterator _las_iterator;
+};
+
+/**
+ * Entwine Point Tile (EPT) dataset, opened through its 'ept.json' file. Reading
+ * an EPT dataset yields its points node by node in the spatial order of its
+ * hierarchy. Only datasets with LAZ nodes (data type 'laszip') are supported.
+ * Iterators refer to the EPTFile, so they are invalidated when the file is
+ * moved
+ */
+struct EPTFile
+{
+  friend struct EPTInputIterator;
+
+  using const_iterator = EPTInputIterator;
+  using metadata = PointFileHierarchy;
+
+  explicit EPTFile(fs::path const& ept_json_path);
+  EPTFile(EPTFile const&) = delete;
+  EPTFile(EPTFile&&) = default;
+
+  EPTFile& operator=(EPTFile const&) = delete;
+  EPTFile& operator=(EPTFile&&) = default;
+
+  /**
+   * The metadata of an EPT dataset is its hierarchy
+   */
+  metadata const& get_metadata() const;
+  /**
+   * The file of the first node of the dataset. All nodes have the same point
+   * format, scale and offset as this file
+   */
+  LASFile const& first_node_file() const;
+  /**
+   * Bounds of all points of the dataset ('boundsConforming' in 'ept.json').
+   * These bounds are conservative, they may be larger than the points
+   */
+  AABB const& conforming_bounds() const;
+  size_t size() const;
+  std::string source() const;
+
+  /**
+   * Path of the LAZ file with the points of the given node
+   */
+  fs::path node_file_path(OctreeNodeIndex64 const& node) const;
+
+  EPTInputIterator begin() const { return cbegin(); }
+  EPTInputIterator end() const { return cend(); }
+
+  EPTInputIterator cbegin() const;
+  EPTInputIterator cend() const;
+
+private:
+  fs::path _ept_json_path;
+  AABB _conforming_bounds;
+  PointFileHierarchy _hierarchy;
+  size_t _points_count;
+  LASFile _first_node_file;
+};
+
+/**
+ * Is the given path the 'ept.json' file of an EPT dataset?
+ */
+bool
+is_ept_dataset(fs::path const& path);
+
+/**
+ * Calculates the exact bounds of all points of the given EPT dataset by reading
+ * the points of all node files
+ */
+AABB
+ept_exact_bounds(EPTFile const& file);
+
+/**
+ * Like ept_exact_bounds, but reads the node files in parallel with one task of
+ * 'subflow' per node file. The subflow is joined before the bounds are
+ * returned. Throws the first error that occured while reading a node file
+ */
+AABB
+ept_exact_bounds(EPTFile const& file, tf::Subflow& subflow);
+
+namespace pc {
+template<>
+inline AABB
+get_bounds(EPTFile const& f)
+{
+  return f.conforming_bounds();
+}
+
+/**
+ * The conforming bounds of an EPT dataset may be larger than its points, so the
+ * exact bounds are calculated from the node files
+ */
+template<>
+inline AABB
+get_exact_bounds(EPTFile const& f)
+{
+  return ept_exact_bounds(f);
+}
+
+template<>
+inline Vector3<double>
+get_offset(EPTFile const& f)
+{
+  return get_offset_from_las_header(f.first_node_file().get_metadata());
+}
+
+template<>
+inline size_t
+get_point_count(EPTFile const& f)
+{
+  return f.size();
+}
+
+template<>
+inline uint32_t
+get_point_record_length(EPTFile const& f)
+{
+  return f.first_node_file().get_metadata().point_data_record_length;
+}
+
+template<>
+inline bool
+is_compressed(EPTFile const&)
+{
+  return true;
+}
+
+template<>
+inline bool
+has_attribute(EPTFile const& f, PointAttribute const& attribute)
+{
+  return las_file_has_attribute(f.first_node_file().get_metadata(), attribute);
+}
+
+template<>
+inline EPTInputIterator
+read_points(EPTInputIterator begin,
+            size_t count,
+            PointFileHierarchy const&,
+            PointAttributes const& attributes,
+            PointBuffer& points)
+{
+  return read_las_points(begin, count, attributes, points);
+}
+
+template<>
+inline std::pair<EPTInputIterator, PointBuffer::PointIterator>
+read_points_into(EPTInputIterator file_begin,
+                 EPTInputIterator file_end,
+                 PointFileHierarchy const&,
+                 PointAttributes const&,
+                 util::Range<PointBuffer::PointIterator> point_range)
+{
+  return read_las_points_into(file_begin, file_end, point_range);
+}
+
+} // namespace pc
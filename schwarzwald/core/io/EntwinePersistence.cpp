@@ -10,6 +10,8 @@
 #include <rapidjson/filewritestream.h>
 #include <rapidjson/writer.h>
 
+#include <unordered_set>
+
 namespace rj = rapidjson;
 
 static std::string
@@ -46,28 +48,51 @@ create_ept_folder_structure(const fs::path& root_dir)
   if (!fs::create_directory(root_dir / "ept-sources")) {
     throw std::runtime_error{ "Could not create ept-sources directory" };
   }
+  if (!fs::create_directory(root_dir / "ept-statistics")) {
+    throw std::runtime_error{ "Could not create ept-statistics directory" };
+  }
+}
+
+// Split large tree into subtrees of defined depth
+constexpr uint32_t SPLIT_DEPTH = 5;
+
+/**
+ * Returns the root node of the subtree that the given node belongs to
+ */
+static OctreeNodeIndex64
+get_parent_index_in_hierarchy(const OctreeNodeIndex64& index)
+{
+  auto parent_index = index;
+  while (parent_index.levels() % SPLIT_DEPTH != 0) {
+    parent_index = parent_index.parent();
+  }
+  return parent_index;
 }
 
+/**
+ * Writes the given JSON document to a temporary file that replaces the file at
+ * 'file_path', so that viewers never read a partially written file
+ */
 static void
-create_hierarchy_files(const fs::path& root_dir,
-                       const std::unordered_map<std::string, size_t>& hierarchy)
+replace_json_file(const rj::Document& document, const fs::path& file_path)
 {
-  // Split large tree into subtrees of defined depth
-  constexpr uint32_t SPLIT_DEPTH = 5;
+  const auto temporary_file_path = concat(file_path.string(), ".tmp");
+  write_json_to_file(document, temporary_file_path);
+  replace_file(temporary_file_path, file_path.string());
+}
 
+/**
+ * Writes the hierarchy files of the given subtrees
+ */
+static void
+create_hierarchy_files(const fs::path& root_dir,
+                       const std::unordered_map<std::string, size_t>& hierarchy,
+                       const std::unordered_set<OctreeNodeIndex64>& subtrees_to_write)
+{
   using Hierarchy = std::unordered_map<OctreeNodeIndex64, int64_t>;
 
   std::unordered_map<OctreeNodeIndex64, Hierarchy> split_hierarchies;
 
-  const auto get_parent_index_in_hierarchy =
-    [](const OctreeNodeIndex64& index) -> OctreeNodeIndex64 {
-    auto parent_index = index;
-    while (parent_index.levels() % SPLIT_DEPTH != 0) {
-      parent_index = parent_index.parent();
-    }
-    return parent_index;
-  };
-
   const auto write_hierarchy_json = [&root_dir](const OctreeNodeIndex64& parent,
                                                 const Hierarchy& hierarchy) {
     rj::Document document;
@@ -91,7 +116,7 @@ create_hierarchy_files(const fs::path& root_dir,
              ".json");
 
     try {
-      write_json_to_file(document, file_path);
+      replace_json_file(document, file_path);
     } catch (const std::exception& ex) {
       throw util::chain_error(ex, "Could not write hierarchy file");
     }
@@ -125,10 +150,64 @@ create_hierarchy_files(const fs::path& root_dir,
   }
 
   for (auto& kv : split_hierarchies) {
+    if (!subtrees_to_write.count(kv.first))
+      continue;
     write_hierarchy_json(kv.first, kv.second);
   }
 }
 
+/**
+ * Writes the statistics of all nodes into the 'ept-statistics' folder. These
+ * files are not part of the EPT specification, so we keep them separate from
+ * the 'ept-hierarchy' files, which have to contain plain point counts. They use
+ * the same subtree split as the hierarchy, so 'ept-statistics/X-Y-Z-W.json'
+ * contains the statistics of all nodes in 'ept-hierarchy/X-Y-Z-W.json'
+ */
+static void
+create_statistics_files(const fs::path& root_dir,
+                        const std::unordered_map<std::string, NodeStatistics>& statistics,
+                        const std::unordered_set<OctreeNodeIndex64>& subtrees_to_write)
+{
+  std::unordered_map<OctreeNodeIndex64, rj::Document> split_statistics;
+
+  for (auto& kv : statistics) {
+    const auto maybe_node_index =
+      OctreeNodeIndex64::from_string(kv.first, MortonIndexNamingConvention::Entwine);
+    if (!maybe_node_index.has_value()) {
+      std::cerr << "Could not include node " << kv.first
+                << " into ept-statistics: " << maybe_node_index.error() << "\n";
+      continue;
+    }
+
+    const auto subtree = get_parent_index_in_hierarchy(maybe_node_index.value());
+    if (!subtrees_to_write.count(subtree))
+      continue;
+
+    auto& document = split_statistics[subtree];
+    if (!document.IsObject()) {
+      document.SetObject();
+    }
+
+    auto& allocator = document.GetAllocator();
+    document.AddMember(
+      rj_string(kv.first, allocator), node_statistics_to_json(kv.second, allocator), allocator);
+  }
+
+  for (auto& kv : split_statistics) {
+    const auto file_path =
+      concat(root_dir.string(),
+             "/ept-statistics/",
+             OctreeNodeIndex64::to_string(kv.first, MortonIndexNamingConvention::Entwine),
+             ".json");
+
+    try {
+      replace_json_file(kv.second, file_path);
+    } catch (const std::exception& ex) {
+      throw util::chain_error(ex, "Could not write statistics file");
+    }
+  }
+}
+
 std::vector<EptSchemaEntry>
 point_attributes_to_ept_schema(const PointAttributes& point_attributes)
 {
@@ -262,7 +341,7 @@ write_ept_json(const fs::path& file_path, const EptJson& ept_json)
   document.AddMember("version", rj_string(ept_json.version, allocator), allocator);
 
   try {
-    write_json_to_file(document, file_path);
+    replace_json_file(document, file_path);
   } catch (const std::exception& ex) {
     throw util::chain_error(ex, "Could not write ept.json file");
   }
@@ -286,7 +365,39 @@ EntwinePersistence::EntwinePersistence(const std::string& work_dir,
 
 EntwinePersistence::~EntwinePersistence()
 {
-  create_hierarchy_files(_work_dir, _hierarchy);
+  // Moved-from persistences have no hierarchy
+  if (_hierarchy_lock) {
+    write_hierarchy();
+  }
+}
+
+void
+EntwinePersistence::write_hierarchy()
+{
+  std::lock_guard guard{ *_hierarchy_lock };
+  if (_updated_nodes.empty())
+    return;
+
+  // A new subtree is also listed in the hierarchy files of all subtrees above
+  // it, so these files are written again as well
+  std::unordered_set<OctreeNodeIndex64> updated_subtrees;
+  for (const auto& node_name : _updated_nodes) {
+    const auto maybe_node_index =
+      OctreeNodeIndex64::from_string(node_name, MortonIndexNamingConvention::Entwine);
+    if (!maybe_node_index.has_value())
+      continue;
+
+    auto subtree = get_parent_index_in_hierarchy(maybe_node_index.value());
+    updated_subtrees.insert(subtree);
+    while (subtree.levels() > 0) {
+      subtree = get_parent_index_in_hierarchy(subtree.parent());
+      updated_subtrees.insert(subtree);
+    }
+  }
+
+  create_hierarchy_files(_work_dir, _hierarchy, updated_subtrees);
+  create_statistics_files(_work_dir, _hierarchy_statistics, updated_subtrees);
+  _updated_nodes.clear();
 }
 
 void
@@ -299,10 +410,14 @@ EntwinePersistence::persist_points(PointBuffer const& points,
 
   const auto entwine_name = potree_name_to_entwine_name(node_name);
 
-  _las_persistence.persist_points(points, bounds, entwine_name);
+  auto statistics = _las_persistence.persist_points(points, bounds, entwine_name);
 
   std::lock_guard guard{ *_hierarchy_lock };
   _hierarchy[entwine_name] = points.count();
+  _updated_nodes.insert(entwine_name);
+  if (!statistics.empty()) {
+    _hierarchy_statistics[entwine_name] = std::move(statistics);
+  }
 }
 
 void
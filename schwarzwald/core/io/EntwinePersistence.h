@@ -4,12 +4,14 @@
 #include "io/LASFile.h"
 #include "io/LASPersistence.h"
 #include "math/AABB.h"
+#include "pointcloud/NodeStatistics.h"
 #include "pointcloud/PointAttributes.h"
 #include "util/Definitions.h"
 #include "util/stuff.h"
 
 #include <mutex>
 #include <unordered_map>
+#include <unordered_set>
 
 enum class EntwineFormat
 {
@@ -79,10 +81,15 @@ struct EntwinePersistence
 
     const auto entwine_name = potree_name_to_entwine_name(node_name);
 
-    _las_persistence.persist_points(points_begin, points_end, bounds, entwine_name);
+    auto statistics =
+      _las_persistence.persist_points(points_begin, points_end, bounds, entwine_name);
 
     std::lock_guard guard{ *_hierarchy_lock };
     _hierarchy[entwine_name] = num_points;
+    _updated_nodes.insert(entwine_name);
+    if (!statistics.empty()) {
+      _hierarchy_statistics[entwine_name] = std::move(statistics);
+    }
   }
 
   void persist_points(PointBuffer const& points, const AABB& bounds, const std::string& node_name);
@@ -93,6 +100,16 @@ struct EntwinePersistence
 
   inline bool is_lossless() const { return false; }
 
+  inline NodeStatistics dataset_statistics() const { return _las_persistence.dataset_statistics(); }
+
+  /**
+   * Writes the hierarchy and statistics files of all subtrees with nodes that
+   * were persisted since the last call. This is called on destruction, but can
+   * be called earlier to make the persisted nodes visible to viewers while the
+   * output is still being written
+   */
+  void write_hierarchy();
+
   auto& las_persistence() { return _las_persistence; }
 
 private:
@@ -104,6 +121,9 @@ private:
 
   std::unique_ptr<std::mutex> _hierarchy_lock;
   std::unordered_map<std::string, size_t> _hierarchy;
+  std::unordered_map<std::string, NodeStatistics> _hierarchy_statistics;
+  // Nodes that were persisted since the last call to 'write_hierarchy'
+  std::unordered_set<std::string> _updated_nodes;
 
   static std::string potree_name_to_entwine_name(const std::string& potree_name);
 };
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include "io/GLBReader.h"
+
+#include "io/MeshoptVertexCodec.h"
+#include "io/PNTSEncoding.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <rapidjson/document.h>
+#include <rapidjson/error/en.h>
+
+namespace rs = rapidjson;
+
+namespace {
+struct DecodedAttribute
+{
+  std::vector<std::byte> vertices;
+  size_t byte_stride;
+};
+} // namespace
+
+/// <summary>
+/// Decodes the meshopt-compressed data of the given attribute of the point
+/// primitive. Returns std::nullopt if the primitive does not have the attribute
+/// </summary>
+static std::optional<DecodedAttribute>
+decode_attribute(const rs::Document& document,
+                 const char* attribute_name,
+                 gsl::span<const std::byte> binary_chunk)
+{
+  const auto& primitive_attributes = document["meshes"][0]["primitives"][0]["attributes"];
+  const auto attribute_member = primitive_attributes.FindMember(attribute_name);
+  if (attribute_member == primitive_attributes.MemberEnd())
+    return std::nullopt;
+
+  const auto& accessor = document["accessors"][attribute_member->value.GetUint()];
+  const auto& buffer_view = document["bufferViews"][accessor["bufferView"].GetUint()];
+  const auto& meshopt_extension = buffer_view["extensions"]["EXT_meshopt_compression"];
+
+  const auto byte_offset = meshopt_extension["byteOffset"].GetUint64();
+  const auto byte_length = meshopt_extension["byteLength"].GetUint64();
+  const auto byte_stride = meshopt_extension["byteStride"].GetUint64();
+  const auto count = meshopt_extension["count"].GetUint64();
+  if (byte_offset + byte_length > static_cast<uint64_t>(binary_chunk.size())) {
+    throw std::runtime_error{ "Compressed attribute exceeds the binary chunk" };
+  }
+
+  return DecodedAttribute{
+    decode_vertex_buffer(binary_chunk.subspan(byte_offset, byte_length), count, byte_stride),
+    byte_stride
+  };
+}
+
+template<typename T>
+static const T&
+element_at(const DecodedAttribute& attribute, size_t index)
+{
+  return *reinterpret_cast<const T*>(attribute.vertices.data() + index * attribute.byte_stride);
+}
+
+std::optional<GLBFile>
+readGLBFile(const std::string& filepath, const PointAttributes& input_attributes)
+{
+  std::ifstream fs{ filepath, std::ios_base::in | std::ios_base::binary };
+  if (!fs.is_open()) {
+    std::cerr << "Could not open .glb file \"" << filepath << "\"!" << std::endl;
+    return std::nullopt;
+  }
+
+  std::vector<char> raw_data{ std::istreambuf_iterator<char>(fs), std::istreambuf_iterator<char>() };
+  if (raw_data.size() < sizeof(GLBHeader) + 2 * sizeof(GLBChunkHeader)) {
+    std::cerr << "File \"" << filepath << "\" is too small to be a .glb file" << std::endl;
+    return std::nullopt;
+  }
+
+  GLBHeader header;
+  std::memcpy(&header, raw_data.data(), sizeof(GLBHeader));
+  if (header.magic != GLB_MAGIC || header.version != GLB_VERSION) {
+    std::cerr << "File \"" << filepath << "\" is not a glTF 2.0 binary file" << std::endl;
+    return std::nullopt;
+  }
+
+  GLBChunkHeader json_chunk_header;
+  std::memcpy(&json_chunk_header, raw_data.data() + sizeof(GLBHeader), sizeof(GLBChunkHeader));
+  const auto json_begin = raw_data.data() + sizeof(GLBHeader) + sizeof(GLBChunkHeader);
+  const auto binary_chunk_header_offset =
+    sizeof(GLBHeader) + sizeof(GLBChunkHeader) + json_chunk_header.chunkLength;
+  if (json_chunk_header.chunkType != GLB_CHUNK_TYPE_JSON ||
+      binary_chunk_header_offset + sizeof(GLBChunkHeader) > raw_data.size()) {
+    std::cerr << "File \"" << filepath << "\" has an invalid JSON chunk" << std::endl;
+    return std::nullopt;
+  }
+
+  GLBChunkHeader binary_chunk_header;
+  std::memcpy(
+    &binary_chunk_header, raw_data.data() + binary_chunk_header_offset, sizeof(GLBChunkHeader));
+  const auto binary_begin = raw_data.data() + binary_chunk_header_offset + sizeof(GLBChunkHeader);
+  if (binary_chunk_header.chunkType != GLB_CHUNK_TYPE_BIN ||
+      binary_chunk_header_offset + sizeof(GLBChunkHeader) + binary_chunk_header.chunkLength >
+        raw_data.size()) {
+    std::cerr << "File \"" << filepath << "\" has an invalid binary chunk" << std::endl;
+    return std::nullopt;
+  }
+  const auto binary_chunk = gsl::make_span(reinterpret_cast<const std::byte*>(binary_begin),
+                                           binary_chunk_header.chunkLength);
+
+  std::string json{ json_begin, json_begin + json_chunk_header.chunkLength };
+  rs::Document document;
+  if (document.Parse<0>(json.c_str()).HasParseError()) {
+    std::cerr << "Could not parse glTF JSON in \"" << filepath << "\" ("
+              << rs::GetParseError_En(document.GetParseError()) << ")" << std::endl;
+    return std::nullopt;
+  }
+
+  // The node hierarchy is the one written by GLBWriter: The root node
+  // translates by the local center in y-up coordinates, its child dequantizes
+  // and rotates from z-up to y-up
+  const auto& translation = document["nodes"][0]["translation"];
+  const auto& matrix = document["nodes"][1]["matrix"];
+
+  GLBFile glb_file;
+  glb_file.rtc_center = { translation[0].GetDouble(),
+                          -translation[2].GetDouble(),
+                          translation[1].GetDouble() };
+
+  const auto quantized_max = static_cast<double>(std::numeric_limits<uint16_t>::max());
+  const QuantizedVolume quantized_volume{
+    { matrix[12].GetDouble(), -matrix[14].GetDouble(), matrix[13].GetDouble() },
+    { matrix[0].GetDouble() * quantized_max,
+      -matrix[6].GetDouble() * quantized_max,
+      matrix[9].GetDouble() * quantized_max }
+  };
+
+  const auto positions_attribute = decode_attribute(document, "POSITION", binary_chunk);
+  if (!positions_attribute) {
+    std::cerr << "File \"" << filepath << "\" has no positions" << std::endl;
+    return std::nullopt;
+  }
+  const auto count = positions_attribute->vertices.size() / positions_attribute->byte_stride;
+
+  std::vector<QuantizedPosition> quantized_positions;
+  quantized_positions.reserve(count);
+  for (size_t idx = 0; idx < count; ++idx) {
+    quantized_positions.push_back(element_at<QuantizedPosition>(*positions_attribute, idx));
+  }
+  std::vector<Vector3<double>> positions(count);
+  dequantize_positions(quantized_positions, quantized_volume, positions);
+
+  std::vector<Vector3<uint8_t>> colors;
+  if (has_attribute(input_attributes, PointAttribute::RGB)) {
+    if (const auto colors_attribute = decode_attribute(document, "COLOR_0", binary_chunk)) {
+      colors.reserve(count);
+      for (size_t idx = 0; idx < count; ++idx) {
+        colors.push_back(element_at<Vector3<uint8_t>>(*colors_attribute, idx));
+      }
+    }
+  }
+
+  std::vector<Vector3<float>> normals;
+  if (has_attribute(input_attributes, PointAttribute::Normal)) {
+    if (const auto normals_attribute = decode_attribute(document, "NORMAL", binary_chunk)) {
+      normals.reserve(count);
+      for (size_t idx = 0; idx < count; ++idx) {
+        const auto& normal = element_at<Vector3<int8_t>>(*normals_attribute, idx);
+        normals.push_back({ std::max(normal.x / 127.f, -1.f),
+                            std::max(normal.y / 127.f, -1.f),
+                            std::max(normal.z / 127.f, -1.f) });
+      }
+    }
+  }
+
+  std::vector<uint16_t> intensities;
+  if (has_attribute(input_attributes, PointAttribute::Intensity)) {
+    if (const auto intensities_attribute = decode_attribute(document, "_INTENSITY", binary_chunk)) {
+      intensities.reserve(count);
+      for (size_t idx = 0; idx < count; ++idx) {
+        intensities.push_back(element_at<uint16_t>(*intensities_attribute, idx));
+      }
+    }
+  }
+
+  glb_file.points = {
+    count, std::move(positions), std::move(colors), std::move(normals), std::move(intensities)
+  };
+
+  return std::make_optional<GLBFile>(std::move(glb_file));
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "datastructures/PointBuffer.h"
+
+#include <optional>
+#include <stdint.h>
+
+constexpr uint32_t GLB_MAGIC = 0x46546C67;           // "glTF"
+constexpr uint32_t GLB_VERSION = 2;
+constexpr uint32_t GLB_CHUNK_TYPE_JSON = 0x4E4F534A; // "JSON"
+constexpr uint32_t GLB_CHUNK_TYPE_BIN = 0x004E4942;  // "BIN\0"
+
+struct GLBHeader
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t length;
+};
+
+struct GLBChunkHeader
+{
+  uint32_t chunkLength;
+  uint32_t chunkType;
+};
+
+struct GLBFile
+{
+  Vector3<double> rtc_center;
+  PointBuffer points;
+};
+
+/// <summary>
+/// Tries to read the given .glb file, which has to be written by the
+/// GLBWriter. The positions of the points are relative to 'rtc_center'.
+/// Returns std::nullopt on failure
+/// </summary>
+std::optional<GLBFile>
+readGLBFile(const std::string& filepath, const PointAttributes& input_attributes);
@@ -0,0 +1,406 @@
+#include "io/GLBWriter.h"
+
+#include "io/GLBReader.h"
+#include "io/MeshoptVertexCodec.h"
+#include "io/PNTSEncoding.h"
+#include "io/PNTSWriter.h"
+#include "util/stuff.h"
+
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include <cmath>
+#include <fstream>
+
+namespace rj = rapidjson;
+
+constexpr static int GLTF_UNSIGNED_BYTE = 5121;
+constexpr static int GLTF_BYTE = 5120;
+constexpr static int GLTF_UNSIGNED_SHORT = 5123;
+constexpr static int GLTF_ARRAY_BUFFER = 34962;
+constexpr static int GLTF_MODE_POINTS = 0;
+
+namespace {
+/**
+ * A single vertex attribute of the point primitive. Vertex attributes in glTF
+ * have to be aligned to 4 bytes, so smaller elements are padded
+ */
+struct VertexStream
+{
+  const char* attribute_name;
+  int component_type;
+  const char* type;
+  bool normalized;
+  size_t byte_stride;
+  std::vector<std::byte> vertices;
+};
+
+template<typename Element>
+VertexStream
+make_vertex_stream(const char* attribute_name,
+                   int component_type,
+                   const char* type,
+                   bool normalized,
+                   size_t count)
+{
+  static_assert(sizeof(Element) % 4 == 0, "Vertex elements must be padded to 4 bytes");
+  return { attribute_name,
+           component_type,
+           type,
+           normalized,
+           sizeof(Element),
+           std::vector<std::byte>(count * sizeof(Element), std::byte{ 0 }) };
+}
+
+template<typename Element>
+gsl::span<Element>
+elements_of(VertexStream& stream)
+{
+  return gsl::make_span(reinterpret_cast<Element*>(stream.vertices.data()),
+                        stream.vertices.size() / sizeof(Element));
+}
+
+struct PaddedQuantizedPosition
+{
+  QuantizedPosition position;
+  uint16_t padding;
+};
+
+struct PaddedNormal
+{
+  int8_t x, y, z, padding;
+};
+
+struct PaddedIntensity
+{
+  uint16_t intensity;
+  uint16_t padding;
+};
+} // namespace
+
+static std::vector<Vector3<uint8_t>>
+colors_for_points(const PointBuffer& points, RGBMapping rgb_mapping)
+{
+  if (rgb_mapping == RGBMapping::None) {
+    return { points.rgbColors().begin(), points.rgbColors().end() };
+  }
+
+  // Reuses the intensity mappings of the .pnts writer
+  attributes::RGBFromIntensityAttribute rgb_from_intensity{
+    (rgb_mapping == RGBMapping::FromIntensityLinear)
+      ? attributes::RGBFromIntensityAttribute::MappingType::Linear
+      : attributes::RGBFromIntensityAttribute::MappingType::Log
+  };
+  rgb_from_intensity.extractFromPoints(points);
+
+  const auto rgb_begin =
+    reinterpret_cast<const RGB*>(rgb_from_intensity.getBinaryDataRange().data());
+  std::vector<Vector3<uint8_t>> colors;
+  colors.reserve(rgb_from_intensity.getNumEntries());
+  std::transform(rgb_begin,
+                 rgb_begin + rgb_from_intensity.getNumEntries(),
+                 std::back_inserter(colors),
+                 [](const RGB& rgb) -> Vector3<uint8_t> {
+                   return { rgb.R, rgb.G, rgb.B };
+                 });
+  return colors;
+}
+
+GLBWriter::GLBWriter(const std::string& file_path,
+                     const PointAttributes& point_attributes,
+                     RGBMapping rgb_mapping)
+  : _file_path(file_path)
+  , _point_attributes(point_attributes)
+  , _rgb_mapping(rgb_mapping)
+{}
+
+void
+GLBWriter::write_points(const PointBuffer& points)
+{
+  if (_points.empty()) {
+    _points = points;
+  } else {
+    _points.append_buffer(points);
+  }
+}
+
+void
+GLBWriter::flush(const Vector3<double>& local_center)
+{
+  const auto count = _points.count();
+
+  // Positions are quantized relative to the bounds of the points. Flat axes get
+  // a scale of 1, otherwise the node matrix would not be invertible
+  auto quantized_volume = quantized_volume_for(_points.positions());
+  const auto fix_flat_axis = [](double& scale) {
+    if (scale <= 0) {
+      scale = 1;
+    }
+  };
+  fix_flat_axis(quantized_volume.scale.x);
+  fix_flat_axis(quantized_volume.scale.y);
+  fix_flat_axis(quantized_volume.scale.z);
+
+  std::vector<VertexStream> streams;
+
+  {
+    std::vector<QuantizedPosition> quantized_positions(count);
+    quantize_positions(_points.positions(), quantized_volume, quantized_positions);
+
+    auto& stream = streams.emplace_back(make_vertex_stream<PaddedQuantizedPosition>(
+      "POSITION", GLTF_UNSIGNED_SHORT, "VEC3", false, count));
+    auto elements = elements_of<PaddedQuantizedPosition>(stream);
+    for (size_t idx = 0; idx < count; ++idx) {
+      elements[idx].position = quantized_positions[idx];
+    }
+  }
+
+  const auto colors = has_attribute(_point_attributes, PointAttribute::RGB)
+                        ? colors_for_points(_points, _rgb_mapping)
+                        : std::vector<Vector3<uint8_t>>{};
+  if (colors.size() == count) {
+    auto& stream = streams.emplace_back(make_vertex_stream<RGBA>(
+      "COLOR_0", GLTF_UNSIGNED_BYTE, "VEC4", true, count));
+    auto elements = elements_of<RGBA>(stream);
+    for (size_t idx = 0; idx < count; ++idx) {
+      elements[idx] = { colors[idx].x, colors[idx].y, colors[idx].z, 255 };
+    }
+  }
+
+  if (has_attribute(_point_attributes, PointAttribute::Normal) && _points.hasNormals()) {
+    auto& stream = streams.emplace_back(
+      make_vertex_stream<PaddedNormal>("NORMAL", GLTF_BYTE, "VEC3", true, count));
+    auto elements = elements_of<PaddedNormal>(stream);
+    const auto to_snorm8 = [](float value) {
+      return static_cast<int8_t>(std::round(std::clamp(value, -1.f, 1.f) * 127.f));
+    };
+    for (size_t idx = 0; idx < count; ++idx) {
+      const auto& normal = _points.normals()[idx];
+      elements[idx] = { to_snorm8(normal.x), to_snorm8(normal.y), to_snorm8(normal.z), 0 };
+    }
+  }
+
+  if (has_attribute(_point_attributes, PointAttribute::Intensity) && _points.hasIntensities()) {
+    auto& stream = streams.emplace_back(make_vertex_stream<PaddedIntensity>(
+      "_INTENSITY", GLTF_UNSIGNED_SHORT, "SCALAR", false, count));
+    auto elements = elements_of<PaddedIntensity>(stream);
+    for (size_t idx = 0; idx < count; ++idx) {
+      const auto intensity = _points.intensities()[idx];
+      elements[idx].intensity = intensity;
+      _statistics.add_intensity(intensity);
+    }
+  }
+
+  rj::Document document;
+  document.SetObject();
+  auto& allocator = document.GetAllocator();
+
+  const auto make_array = [&allocator](std::initializer_list<double> values) {
+    rj::Value array{ rj::kArrayType };
+    for (auto value : values) {
+      array.PushBack(value, allocator);
+    }
+    return array;
+  };
+  const auto make_string_array = [&allocator](std::initializer_list<const char*> values) {
+    rj::Value array{ rj::kArrayType };
+    for (auto value : values) {
+      array.PushBack(rj::StringRef(value), allocator);
+    }
+    return array;
+  };
+
+  {
+    rj::Value asset{ rj::kObjectType };
+    asset.AddMember("version", "2.0", allocator);
+    asset.AddMember("generator", "Schwarzwald", allocator);
+    document.AddMember("asset", asset, allocator);
+  }
+  document.AddMember("extensionsUsed",
+                     make_string_array({ "EXT_meshopt_compression", "KHR_mesh_quantization" }),
+                     allocator);
+  document.AddMember("extensionsRequired",
+                     make_string_array({ "EXT_meshopt_compression", "KHR_mesh_quantization" }),
+                     allocator);
+
+  {
+    rj::Value scene{ rj::kObjectType };
+    rj::Value scene_nodes{ rj::kArrayType };
+    scene_nodes.PushBack(0, allocator);
+    scene.AddMember("nodes", scene_nodes, allocator);
+    rj::Value scenes{ rj::kArrayType };
+    scenes.PushBack(scene, allocator);
+    document.AddMember("scene", 0, allocator);
+    document.AddMember("scenes", scenes, allocator);
+  }
+
+  {
+    // z-up (x, y, z) maps to y-up (x, z, -y)
+    rj::Value root_node{ rj::kObjectType };
+    rj::Value children{ rj::kArrayType };
+    children.PushBack(1, allocator);
+    root_node.AddMember("children", children, allocator);
+    root_node.AddMember(
+      "translation", make_array({ local_center.x, local_center.z, -local_center.y }), allocator);
+
+    const auto step = quantized_volume.scale / static_cast<double>(std::numeric_limits<uint16_t>::max());
+    const auto& offset = quantized_volume.offset;
+    rj::Value mesh_node{ rj::kObjectType };
+    mesh_node.AddMember("mesh", 0, allocator);
+    mesh_node.AddMember("matrix",
+                        make_array({ step.x,
+                                     0,
+                                     0,
+                                     0,
+                                     0,
+                                     0,
+                                     -step.y,
+                                     0,
+                                     0,
+                                     step.z,
+                                     0,
+                                     0,
+                                     offset.x,
+                                     offset.z,
+                                     -offset.y,
+                                     1 }),
+                        allocator);
+
+    rj::Value nodes{ rj::kArrayType };
+    nodes.PushBack(root_node, allocator);
+    nodes.PushBack(mesh_node, allocator);
+    document.AddMember("nodes", nodes, allocator);
+  }
+
+  // The compressed data is stored in the binary chunk (buffer 0). Buffer 1 is
+  // the uncompressed fallback buffer that EXT_meshopt_compression decodes into,
+  // which has no data of its own
+  std::vector<std::byte> binary_chunk;
+  size_t fallback_byte_length = 0;
+
+  rj::Value attributes{ rj::kObjectType };
+  rj::Value accessors{ rj::kArrayType };
+  rj::Value buffer_views{ rj::kArrayType };
+  for (size_t stream_idx = 0; stream_idx < streams.size(); ++stream_idx) {
+    const auto& stream = streams[stream_idx];
+    const auto encoded_vertices = encode_vertex_buffer(stream.vertices, stream.byte_stride);
+
+    const auto compressed_offset = binary_chunk.size();
+    binary_chunk.insert(
+      std::end(binary_chunk), std::begin(encoded_vertices), std::end(encoded_vertices));
+    binary_chunk.resize(align(binary_chunk.size(), size_t{ 4 }), std::byte{ 0 });
+
+    rj::Value meshopt_extension{ rj::kObjectType };
+    meshopt_extension.AddMember("buffer", 0, allocator);
+    meshopt_extension.AddMember("byteOffset", static_cast<uint64_t>(compressed_offset), allocator);
+    meshopt_extension.AddMember(
+      "byteLength", static_cast<uint64_t>(encoded_vertices.size()), allocator);
+    meshopt_extension.AddMember("byteStride", static_cast<uint64_t>(stream.byte_stride), allocator);
+    meshopt_extension.AddMember("count", static_cast<uint64_t>(count), allocator);
+    meshopt_extension.AddMember("mode", "ATTRIBUTES", allocator);
+    rj::Value extensions{ rj::kObjectType };
+    extensions.AddMember("EXT_meshopt_compression", meshopt_extension, allocator);
+
+    rj::Value buffer_view{ rj::kObjectType };
+    buffer_view.AddMember("buffer", 1, allocator);
+    buffer_view.AddMember("byteOffset", static_cast<uint64_t>(fallback_byte_length), allocator);
+    buffer_view.AddMember("byteLength", static_cast<uint64_t>(stream.vertices.size()), allocator);
+    buffer_view.AddMember("byteStride", static_cast<uint64_t>(stream.byte_stride), allocator);
+    buffer_view.AddMember("target", GLTF_ARRAY_BUFFER, allocator);
+    buffer_view.AddMember("extensions", extensions, allocator);
+    buffer_views.PushBack(buffer_view, allocator);
+    fallback_byte_length += stream.vertices.size();
+
+    rj::Value accessor{ rj::kObjectType };
+    accessor.AddMember("bufferView", static_cast<uint64_t>(stream_idx), allocator);
+    accessor.AddMember("componentType", stream.component_type, allocator);
+    accessor.AddMember("count", static_cast<uint64_t>(count), allocator);
+    accessor.AddMember("type", rj::StringRef(stream.type), allocator);
+    if (stream.normalized) {
+      accessor.AddMember("normalized", true, allocator);
+    }
+    // Bounds of the positions are mandatory
+    if (stream_idx == 0) {
+      std::array<uint16_t, 3> min = { std::numeric_limits<uint16_t>::max(),
+                                      std::numeric_limits<uint16_t>::max(),
+                                      std::numeric_limits<uint16_t>::max() };
+      std::array<uint16_t, 3> max = { 0, 0, 0 };
+      for (const auto& element : elements_of<PaddedQuantizedPosition>(streams[0])) {
+        min = { std::min(min[0], element.position.x),
+                std::min(min[1], element.position.y),
+                std::min(min[2], element.position.z) };
+        max = { std::max(max[0], element.position.x),
+                std::max(max[1], element.position.y),
+                std::max(max[2], element.position.z) };
+      }
+      accessor.AddMember("min", make_array({ 1.0 * min[0], 1.0 * min[1], 1.0 * min[2] }), allocator);
+      accessor.AddMember("max", make_array({ 1.0 * max[0], 1.0 * max[1], 1.0 * max[2] }), allocator);
+    }
+    accessors.PushBack(accessor, allocator);
+
+    attributes.AddMember(
+      rj::StringRef(stream.attribute_name), static_cast<uint64_t>(stream_idx), allocator);
+  }
+
+  {
+    rj::Value primitive{ rj::kObjectType };
+    primitive.AddMember("attributes", attributes, allocator);
+    primitive.AddMember("mode", GLTF_MODE_POINTS, allocator);
+    rj::Value primitives{ rj::kArrayType };
+    primitives.PushBack(primitive, allocator);
+    rj::Value mesh{ rj::kObjectType };
+    mesh.AddMember("primitives", primitives, allocator);
+    rj::Value meshes{ rj::kArrayType };
+    meshes.PushBack(mesh, allocator);
+    document.AddMember("meshes", meshes, allocator);
+  }
+
+  document.AddMember("accessors", accessors, allocator);
+  document.AddMember("bufferViews", buffer_views, allocator);
+
+  {
+    rj::Value binary_buffer{ rj::kObjectType };
+    binary_buffer.AddMember("byteLength", static_cast<uint64_t>(binary_chunk.size()), allocator);
+
+    rj::Value fallback_extension{ rj::kObjectType };
+    fallback_extension.AddMember("fallback", true, allocator);
+    rj::Value fallback_extensions{ rj::kObjectType };
+    fallback_extensions.AddMember("EXT_meshopt_compression", fallback_extension, allocator);
+    rj::Value fallback_buffer{ rj::kObjectType };
+    fallback_buffer.AddMember("byteLength", static_cast<uint64_t>(fallback_byte_length), allocator);
+    fallback_buffer.AddMember("extensions", fallback_extensions, allocator);
+
+    rj::Value buffers{ rj::kArrayType };
+    buffers.PushBack(binary_buffer, allocator);
+    buffers.PushBack(fallback_buffer, allocator);
+    document.AddMember("buffers", buffers, allocator);
+  }
+
+  rj::StringBuffer json_buffer;
+  rj::Writer<rj::StringBuffer> json_writer{ json_buffer };
+  document.Accept(json_writer);
+
+  // Both chunks have to be 4-byte aligned, the JSON chunk is padded with spaces
+  std::string json_chunk{ json_buffer.GetString(), json_buffer.GetSize() };
+  json_chunk.resize(align(json_chunk.size(), size_t{ 4 }), ' ');
+
+  const auto total_length = sizeof(GLBHeader) + 2 * sizeof(GLBChunkHeader) + json_chunk.size() +
+                            binary_chunk.size();
+
+  std::ofstream stream{ _file_path, std::ios::out | std::ios::binary };
+  if (!stream.is_open()) {
+    throw std::runtime_error{ concat("Could not write .glb file \"", _file_path, "\"") };
+  }
+
+  const GLBHeader header{ GLB_MAGIC, GLB_VERSION, static_cast<uint32_t>(total_length) };
+  const GLBChunkHeader json_chunk_header{ static_cast<uint32_t>(json_chunk.size()),
+                                          GLB_CHUNK_TYPE_JSON };
+  const GLBChunkHeader binary_chunk_header{ static_cast<uint32_t>(binary_chunk.size()),
+                                            GLB_CHUNK_TYPE_BIN };
+  stream.write(reinterpret_cast<const char*>(&header), sizeof(GLBHeader));
+  stream.write(reinterpret_cast<const char*>(&json_chunk_header), sizeof(GLBChunkHeader));
+  stream.write(json_chunk.data(), json_chunk.size());
+  stream.write(reinterpret_cast<const char*>(&binary_chunk_header), sizeof(GLBChunkHeader));
+  stream.write(reinterpret_cast<const char*>(binary_chunk.data()), binary_chunk.size());
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "datastructures/PointBuffer.h"
+#include "math/Vector3.h"
+#include "pointcloud/NodeStatistics.h"
+#include "pointcloud/PointAttributes.h"
+
+#include <string>
+
+/**
+ * Writer for binary glTF 2.0 (.glb) files that contain a single point
+ * primitive, for use as tile content in 3D Tiles 1.1:
+ * https://github.com/CesiumGS/3d-tiles/tree/main/specification/TileFormats/glTF
+ *
+ * Positions are quantized to 16 bits per axis relative to the bounds of the
+ * points (KHR_mesh_quantization), colors are stored as normalized bytes and
+ * normals as normalized signed bytes. Intensities are stored in the
+ * application-specific attribute _INTENSITY. All attributes are compressed
+ * using the vertex codec of EXT_meshopt_compression.
+ *
+ * The quantized positions are transformed into the tile frame by the node
+ * hierarchy of the glTF: The root node translates by the local center, its
+ * child dequantizes and rotates from the z-up tile frame into the y-up frame of
+ * glTF, which 3D Tiles rotates back
+ */
+class GLBWriter
+{
+public:
+  GLBWriter(const std::string& file_path,
+            const PointAttributes& point_attributes,
+            RGBMapping rgb_mapping);
+
+  void write_points(const PointBuffer& points);
+
+  void flush(const Vector3<double>& local_center);
+
+  /**
+   * Statistics of the attributes of the written points. They are accumulated
+   * while the attributes are encoded, so they are only complete after 'flush'
+   */
+  NodeStatistics statistics() const { return _statistics.statistics(); }
+
+private:
+  std::string _file_path;
+  PointAttributes _point_attributes;
+  RGBMapping _rgb_mapping;
+  PointBuffer _points;
+  NodeStatisticsAccumulator _statistics;
+};
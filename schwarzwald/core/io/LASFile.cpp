@@ -3,6 +3,8 @@
 #include "util/Error.h"
 #include "util/stuff.h"
 
+#include <algorithm>
+#include <array>
 #include <boost/format.hpp>
 #include <expected.hpp>
 #include <limits>
@@ -93,6 +95,50 @@ position_from_las_point(laszip_point const& point, laszip_header const& las_head
   return position;
 }
 
+void
+set_point_from_las_point(PointBuffer::PointReference point,
+                         laszip_point const& las_point,
+                         laszip_header const& las_header)
+{
+  point.set_position(position_from_las_point(las_point, las_header));
+  if (point.rgbColor()) {
+    // FEATURE Implement correct color scaling
+    point.rgbColor()->x = static_cast<uint8_t>(las_point.rgb[0] >> 8);
+    point.rgbColor()->y = static_cast<uint8_t>(las_point.rgb[1] >> 8);
+    point.rgbColor()->z = static_cast<uint8_t>(las_point.rgb[2] >> 8);
+  }
+  if (point.intensity()) {
+    *point.intensity() = las_point.intensity;
+  }
+  if (point.classification()) {
+    *point.classification() = las_point.classification;
+  }
+  if (point.gps_time()) {
+    *point.gps_time() = las_point.gps_time;
+  }
+  if (point.edge_of_flight_line()) {
+    *point.edge_of_flight_line() = las_point.edge_of_flight_line;
+  }
+  if (point.number_of_returns()) {
+    *point.number_of_returns() = las_point.number_of_returns;
+  }
+  if (point.return_number()) {
+    *point.return_number() = las_point.return_number;
+  }
+  if (point.point_source_id()) {
+    *point.point_source_id() = las_point.point_source_ID;
+  }
+  if (point.scan_angle_rank()) {
+    *point.scan_angle_rank() = las_point.scan_angle_rank;
+  }
+  if (point.scan_direction_flag()) {
+    *point.scan_direction_flag() = las_point.scan_direction_flag;
+  }
+  if (point.user_data()) {
+    *point.user_data() = las_point.user_data;
+  }
+}
+
 #pragma endregion
 
 #pragma region LASInputIterator
@@ -405,6 +451,66 @@ get_bounds_from_las_header(laszip_header const& header)
            { header.max_x, header.max_y, header.max_z } };
 }
 
+AABB
+las_exact_bounds(LASFile const& file)
+{
+  const auto& header = file.get_metadata();
+  if (!file.size())
+    return get_bounds_from_las_header(header);
+
+  // The raw integer coordinates are collected in blocks, so that the min/max
+  // reduction runs over contiguous arrays that the compiler can vectorize.
+  // Scale and offset are only applied to the final integer bounds
+  constexpr size_t BLOCK_SIZE = 4096;
+  std::array<std::array<laszip_I32, BLOCK_SIZE>, 3> block;
+  std::array<laszip_I32, 3> min_coordinates, max_coordinates;
+  min_coordinates.fill(std::numeric_limits<laszip_I32>::max());
+  max_coordinates.fill(std::numeric_limits<laszip_I32>::min());
+
+  const auto reduce_block = [&](size_t count) {
+    for (size_t axis = 0; axis < 3; ++axis) {
+      auto min_coordinate = min_coordinates[axis];
+      auto max_coordinate = max_coordinates[axis];
+      const auto* coordinates = block[axis].data();
+      for (size_t idx = 0; idx < count; ++idx) {
+        min_coordinate = std::min(min_coordinate, coordinates[idx]);
+        max_coordinate = std::max(max_coordinate, coordinates[idx]);
+      }
+      min_coordinates[axis] = min_coordinate;
+      max_coordinates[axis] = max_coordinate;
+    }
+  };
+
+  size_t block_count = 0;
+  for (auto iter = file.cbegin(); iter != file.cend(); ++iter) {
+    const auto& point = *iter;
+    block[0][block_count] = point.X;
+    block[1][block_count] = point.Y;
+    block[2][block_count] = point.Z;
+    if (++block_count == BLOCK_SIZE) {
+      reduce_block(block_count);
+      block_count = 0;
+    }
+  }
+  reduce_block(block_count);
+
+  // Scale factors may be negative, which swaps min and max
+  const auto axis_bounds =
+    [&](size_t axis, double scale, double offset, double header_min, double header_max) {
+      const auto first = offset + min_coordinates[axis] * scale;
+      const auto second = offset + max_coordinates[axis] * scale;
+      return std::make_pair(std::clamp(std::min(first, second), header_min, header_max),
+                            std::clamp(std::max(first, second), header_min, header_max));
+    };
+  const auto [min_x, max_x] =
+    axis_bounds(0, header.x_scale_factor, header.x_offset, header.min_x, header.max_x);
+  const auto [min_y, max_y] =
+    axis_bounds(1, header.y_scale_factor, header.y_offset, header.min_y, header.max_y);
+  const auto [min_z, max_z] =
+    axis_bounds(2, header.z_scale_factor, header.z_offset, header.min_z, header.max_z);
+  return { { min_x, min_y, min_z }, { max_x, max_y, max_z } };
+}
+
 Vector3<double>
 get_offset_from_las_header(laszip_header const& header)
 {
@@ -438,7 +544,9 @@ las_file_has_attribute(laszip_header const& header, PointAttribute const& attrib
     case PointAttribute::UserData:
       return true;
     case PointAttribute::GPSTime:
-      return header.point_data_format == 1 || header.point_data_format == 3;
+      // All formats except 0 and 2 have GPS times, including the LAS 1.4
+      // formats 6 to 10 that COPC uses
+      return header.point_data_format != 0 && header.point_data_format != 2;
     default:
       throw std::runtime_error{ "Unrecognized attribute type!" };
   }
@@ -582,50 +690,10 @@ las_read_points_into(LASInputIterator file_begin,
                      PointAttributes const& attributes,
                      util::Range<PointBuffer::PointIterator> point_range)
 {
-
   auto in_iter = file_begin;
   auto out_iter = std::begin(point_range);
   for (; in_iter != file_end && out_iter != std::end(point_range); ++in_iter, ++out_iter) {
-    auto& las_point = *in_iter;
-    auto buffered_point = *out_iter;
-
-    buffered_point.position() = position_from_las_point(las_point, header);
-    if (buffered_point.rgbColor()) {
-      // FEATURE Implement correct color scaling
-      buffered_point.rgbColor()->x = static_cast<uint8_t>(las_point.rgb[0] >> 8);
-      buffered_point.rgbColor()->y = static_cast<uint8_t>(las_point.rgb[1] >> 8);
-      buffered_point.rgbColor()->z = static_cast<uint8_t>(las_point.rgb[2] >> 8);
-    }
-    if (buffered_point.intensity()) {
-      *buffered_point.intensity() = las_point.intensity;
-    }
-    if (buffered_point.classification()) {
-      *buffered_point.classification() = las_point.classification;
-    }
-    if (buffered_point.gps_time()) {
-      *buffered_point.gps_time() = las_point.gps_time;
-    }
-    if (buffered_point.edge_of_flight_line()) {
-      *buffered_point.edge_of_flight_line() = las_point.edge_of_flight_line;
-    }
-    if (buffered_point.number_of_returns()) {
-      *buffered_point.number_of_returns() = las_point.number_of_returns;
-    }
-    if (buffered_point.return_number()) {
-      *buffered_point.return_number() = las_point.return_number;
-    }
-    if (buffered_point.point_source_id()) {
-      *buffered_point.point_source_id() = las_point.point_source_ID;
-    }
-    if (buffered_point.scan_angle_rank()) {
-      *buffered_point.scan_angle_rank() = las_point.scan_angle_rank;
-    }
-    if (buffered_point.scan_direction_flag()) {
-      *buffered_point.scan_direction_flag() = las_point.scan_direction_flag;
-    }
-    if (buffered_point.user_data()) {
-      *buffered_point.user_data() = las_point.user_data;
-    }
+    set_point_from_las_point(*out_iter, *in_iter, header);
   }
 
   return { in_iter, out_iter };
@@ -3,6 +3,7 @@
 #include "io/PointcloudFile.h"
 #include "util/Definitions.h"
 
+#include <algorithm>
 #include <experimental/filesystem>
 #include <iterator>
 #include <laszip_api.h>
@@ -143,6 +144,23 @@ las_file_has_all_attributes(laszip_header const& header,
 Vector3<double>
 position_from_las_point(laszip_point const& point, laszip_header const& las_header);
 
+/**
+ * Set the attributes of the given point from the given LAS point. Only the
+ * attributes that the PointBuffer of the point has are set
+ */
+void
+set_point_from_las_point(PointBuffer::PointReference point,
+                         laszip_point const& las_point,
+                         laszip_header const& las_header);
+
+/**
+ * Calculates the exact bounds of all points in the given LAS file by reading
+ * all of their positions. The bounds are limited to the bounds in the LAS
+ * header, like the positions returned by 'position_from_las_point'
+ */
+AABB
+las_exact_bounds(LASFile const& file);
+
 LASInputIterator
 las_read_points(LASInputIterator begin,
                 size_t count,
@@ -157,6 +175,42 @@ las_read_points_into(LASInputIterator file_begin,
                      PointAttributes const& attributes,
                      util::Range<PointBuffer::PointIterator> point_range);
 
+/**
+ * Reads points from an input iterator over the LAS points of several LAS files,
+ * such as the nodes of a COPC file or an EPT dataset. The iterator provides the
+ * header of the LAS file of its current point through 'las_header()'
+ */
+template<typename LASPointIter>
+std::pair<LASPointIter, PointBuffer::PointIterator>
+read_las_points_into(LASPointIter file_begin,
+                     LASPointIter file_end,
+                     util::Range<PointBuffer::PointIterator> point_range)
+{
+  auto in_iter = file_begin;
+  auto out_iter = std::begin(point_range);
+  for (; in_iter != file_end && out_iter != std::end(point_range); ++in_iter, ++out_iter) {
+    set_point_from_las_point(*out_iter, *in_iter, in_iter.las_header());
+  }
+
+  return { in_iter, out_iter };
+}
+
+/**
+ * Like 'read_las_points_into', but reads at most 'count' points into a new
+ * PointBuffer with the given attributes
+ */
+template<typename LASPointIter>
+LASPointIter
+read_las_points(LASPointIter begin,
+                size_t count,
+                PointAttributes const& attributes,
+                PointBuffer& points)
+{
+  points = PointBuffer{ std::min(count, begin.distance_to_end()), attributes };
+  return read_las_points_into(begin, LASPointIter{}, { std::begin(points), std::end(points) })
+    .first;
+}
+
 namespace pc {
 template<>
 inline AABB
@@ -165,6 +219,13 @@ get_bounds(LASFile const& f)
   return get_bounds_from_las_header(f.get_metadata());
 }
 
+template<>
+inline AABB
+get_exact_bounds(LASFile const& f)
+{
+  return las_exact_bounds(f);
+}
+
 template<>
 inline Vector3<double>
 get_offset(LASFile const& f)
@@ -179,6 +240,20 @@ get_point_count(LASFile const& f)
   return f.size();
 }
 
+template<>
+inline uint32_t
+get_point_record_length(LASFile const& f)
+{
+  return f.get_metadata().point_data_record_length;
+}
+
+template<>
+inline bool
+is_compressed(LASFile const& f)
+{
+  return fs::path{ f.source() }.extension() == ".laz";
+}
+
 template<>
 inline bool
 has_attribute(LASFile const& f, PointAttribute const& attribute)
@@ -27,6 +27,16 @@ compute_las_scale_from_bounds(const AABB& bounds)
   return 0.0001;
 }
 
+void
+replace_file(const std::string& temporary_file_path, const std::string& file_path)
+{
+  std::error_code error;
+  fs::rename(temporary_file_path, file_path, error);
+  if (error) {
+    std::cerr << "Could not replace file " << file_path << " (" << error.message() << ")\n";
+  }
+}
+
 PointAttributes
 LASPersistence::supported_output_attributes()
 {
@@ -48,6 +58,7 @@ LASPersistence::LASPersistence(const std::string& work_dir,
   , _output_attributes(output_attributes)
   , _compressed(compressed)
   , _file_extension(compressed == Compressed::Yes ? ".laz" : ".las")
+  , _statistics_lock(std::make_unique<std::mutex>())
 {
   if (input_attributes != output_attributes) {
     throw std::invalid_argument{
@@ -66,7 +77,7 @@ LASPersistence::LASPersistence(const std::string& work_dir,
 
 LASPersistence::~LASPersistence() {}
 
-void
+NodeStatistics
 LASPersistence::persist_points(PointBuffer const& points,
                                const AABB& bounds,
                                const std::string& node_name)
@@ -76,7 +87,7 @@ LASPersistence::persist_points(PointBuffer const& points,
 
   if (!laswriter) {
     std::cerr << "Could not create LAS writer for node " << node_name << std::endl;
-    return;
+    return {};
   }
 
   BOOST_SCOPE_EXIT(&laswriter)
@@ -95,7 +106,7 @@ LASPersistence::persist_points(PointBuffer const& points,
     } else {
       std::cerr << "Could not write LAS header for node " << node_name << std::endl;
     }
-    return;
+    return {};
   }
 
   const auto point_data_format =
@@ -135,8 +146,12 @@ LASPersistence::persist_points(PointBuffer const& points,
   las_header->x_scale_factor = las_header->y_scale_factor = las_header->z_scale_factor =
     compute_las_scale_from_bounds(bounds);
 
+  // Same as the templated version of persist_points: The node file is replaced
+  // once the temporary file is complete
   const auto file_path = concat(_work_dir, "/", node_name, _file_extension);
-  if (laszip_open_writer(laswriter, file_path.c_str(), (_compressed == Compressed::Yes))) {
+  const auto temporary_file_path = concat(file_path, ".tmp");
+  if (laszip_open_writer(
+        laswriter, temporary_file_path.c_str(), (_compressed == Compressed::Yes))) {
     char* las_error;
     if (!laszip_get_error(laswriter, &las_error)) {
       std::cerr << "Could not write LAS file for node " << node_name << " (" << las_error
@@ -144,13 +159,14 @@ LASPersistence::persist_points(PointBuffer const& points,
     } else {
       std::cerr << "Could not write LAS file for node " << node_name << std::endl;
     }
-    return;
+    return {};
   }
 
-  BOOST_SCOPE_EXIT(&laswriter)
+  BOOST_SCOPE_EXIT(&laswriter, &temporary_file_path, &file_path)
   {
     std::cout << "closing las writer\n";
     laszip_close_writer(laswriter);
+    replace_file(temporary_file_path, file_path);
   }
   BOOST_SCOPE_EXIT_END
 
@@ -162,7 +178,7 @@ LASPersistence::persist_points(PointBuffer const& points,
     } else {
       std::cerr << "Could not write LAS point for node " << node_name << std::endl;
     }
-    return;
+    return {};
   }
 
   const auto has_colors =
@@ -194,6 +210,7 @@ LASPersistence::persist_points(PointBuffer const& points,
   const auto has_user_data =
     (points.has_user_data() && has_attribute(_output_attributes, PointAttribute::UserData));
 
+  NodeStatisticsAccumulator statistics;
   for (const auto point_ref : points) {
     const auto pos = point_ref.position();
     laszip_F64 coordinates[3] = { pos.x, pos.y, pos.z };
@@ -205,7 +222,7 @@ LASPersistence::persist_points(PointBuffer const& points,
       } else {
         std::cerr << "Could not set coordinates for LAS point at node " << node_name << std::endl;
       }
-      return;
+      return {};
     }
 
     if (has_colors) {
@@ -219,10 +236,12 @@ LASPersistence::persist_points(PointBuffer const& points,
 
     if (has_intensities) {
       laspoint->intensity = *point_ref.intensity();
+      statistics.add_intensity(laspoint->intensity);
     }
 
     if (has_classifications) {
       laspoint->classification = *point_ref.classification();
+      statistics.add_classification(laspoint->classification);
     }
 
     if (has_edge_of_flight_lines) {
@@ -231,6 +250,7 @@ LASPersistence::persist_points(PointBuffer const& points,
 
     if (has_gps_times) {
       laspoint->gps_time = *point_ref.gps_time();
+      statistics.add_gps_time(laspoint->gps_time);
     }
 
     if (has_number_of_returns) {
@@ -265,9 +285,13 @@ LASPersistence::persist_points(PointBuffer const& points,
       } else {
         std::cerr << "Could not write LAS point for node " << node_name << std::endl;
       }
-      return;
+      return {};
     }
   }
+
+  auto node_statistics = statistics.statistics();
+  update_dataset_statistics(node_statistics);
+  return node_statistics;
 }
 
 void
@@ -286,4 +310,18 @@ LASPersistence::node_exists(const std::string& node_name) const
 {
   const auto file_path = concat(_work_dir, "/", node_name, _file_extension);
   return fs::exists(file_path);
+}
+
+NodeStatistics
+LASPersistence::dataset_statistics() const
+{
+  std::lock_guard guard{ *_statistics_lock };
+  return _dataset_statistics;
+}
+
+void
+LASPersistence::update_dataset_statistics(const NodeStatistics& node_statistics)
+{
+  std::lock_guard guard{ *_statistics_lock };
+  _dataset_statistics.merge(node_statistics);
 }
\ No newline at end of file
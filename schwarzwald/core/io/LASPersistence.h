@@ -4,17 +4,28 @@
 #include "io/LASFile.h"
 #include "laszip_api.h"
 #include "math/AABB.h"
+#include "pointcloud/NodeStatistics.h"
 #include "pointcloud/PointAttributes.h"
 #include "util/Definitions.h"
 #include "util/stuff.h"
 
 #include <boost/scope_exit.hpp>
 
+#include <memory>
+#include <mutex>
+
 struct SRSTransformHelper;
 
 double
 compute_las_scale_from_bounds(const AABB& bounds);
 
+/**
+ * Renames 'temporary_file_path' to 'file_path', replacing the file at
+ * 'file_path' atomically if it exists
+ */
+void
+replace_file(const std::string& temporary_file_path, const std::string& file_path);
+
 /**
  * Sink for writing LAS files
  */
@@ -26,24 +37,30 @@ struct LASPersistence
                  const PointAttributes& input_attributes,
                  const PointAttributes& output_attributes,
                  Compressed compressed = Compressed::No);
+  LASPersistence(LASPersistence&&) = default;
   ~LASPersistence();
 
+  /**
+   * Writes the given points to the LAS file of the given node. Returns the
+   * statistics of the written attributes, which are computed as part of the
+   * write pass
+   */
   template<typename Iter>
-  void persist_points(Iter points_begin,
-                      Iter points_end,
-                      const AABB& bounds,
-                      const std::string& node_name)
+  NodeStatistics persist_points(Iter points_begin,
+                                Iter points_end,
+                                const AABB& bounds,
+                                const std::string& node_name)
   {
     const auto points_count = std::distance(points_begin, points_end);
     if (!points_count)
-      return;
+      return {};
 
     laszip_POINTER laswriter = nullptr;
     laszip_create(&laswriter);
 
     if (!laswriter) {
       std::cerr << "Could not create LAS writer for node " << node_name << std::endl;
-      return;
+      return {};
     }
 
     BOOST_SCOPE_EXIT_TPL(&laswriter) { laszip_destroy(laswriter); }
@@ -58,7 +75,7 @@ struct LASPersistence
       } else {
         std::cerr << "Could not write LAS header for node " << node_name << std::endl;
       }
-      return;
+      return {};
     }
 
     const auto first_point = *points_begin;
@@ -130,8 +147,12 @@ struct LASPersistence
     las_header->x_scale_factor = las_header->y_scale_factor = las_header->z_scale_factor =
       compute_las_scale_from_bounds(bounds);
 
+    // The node is written to a temporary file that replaces the node file once
+    // it is closed, so that readers never see a partially written node
     const auto file_path = concat(_work_dir, "/", node_name, _file_extension);
-    if (laszip_open_writer(laswriter, file_path.c_str(), (_compressed == Compressed::Yes))) {
+    const auto temporary_file_path = concat(file_path, ".tmp");
+    if (laszip_open_writer(
+          laswriter, temporary_file_path.c_str(), (_compressed == Compressed::Yes))) {
       char* las_error;
       if (!laszip_get_error(laswriter, &las_error)) {
         std::cerr << "Could not write LAS file for node " << node_name << " (" << las_error
@@ -139,10 +160,14 @@ struct LASPersistence
       } else {
         std::cerr << "Could not write LAS file for node " << node_name << std::endl;
       }
-      return;
+      return {};
     }
 
-    BOOST_SCOPE_EXIT_TPL(&laswriter) { laszip_close_writer(laswriter); }
+    BOOST_SCOPE_EXIT_TPL(&laswriter, &temporary_file_path, &file_path)
+    {
+      laszip_close_writer(laswriter);
+      replace_file(temporary_file_path, file_path);
+    }
     BOOST_SCOPE_EXIT_END
 
     laszip_point* laspoint;
@@ -154,9 +179,10 @@ struct LASPersistence
       } else {
         std::cerr << "Could not write LAS point for node " << node_name << std::endl;
       }
-      return;
+      return {};
     }
 
+    NodeStatisticsAccumulator statistics;
     std::for_each(points_begin, points_end, [&](const auto& point_ref) {
       const auto pos = point_ref.position();
       laszip_F64 coordinates[3] = { pos.x, pos.y, pos.z };
@@ -188,10 +214,12 @@ struct LASPersistence
 
       if (has_intensities) {
         laspoint->intensity = *point_ref.intensity();
+        statistics.add_intensity(laspoint->intensity);
       }
 
       if (has_classifications) {
         laspoint->classification = *point_ref.classification();
+        statistics.add_classification(laspoint->classification);
       }
 
       if (has_edge_of_flight_lines) {
@@ -200,6 +228,7 @@ struct LASPersistence
 
       if (has_gps_times) {
         laspoint->gps_time = *point_ref.gps_time();
+        statistics.add_gps_time(laspoint->gps_time);
       }
 
       if (has_number_of_returns) {
@@ -237,9 +266,15 @@ struct LASPersistence
         return;
       }
     });
+
+    auto node_statistics = statistics.statistics();
+    update_dataset_statistics(node_statistics);
+    return node_statistics;
   }
 
-  void persist_points(PointBuffer const& points, const AABB& bounds, const std::string& node_name);
+  NodeStatistics persist_points(PointBuffer const& points,
+                                const AABB& bounds,
+                                const std::string& node_name);
 
   void retrieve_points(const std::string& node_name, PointBuffer& points);
 
@@ -247,10 +282,20 @@ struct LASPersistence
 
   inline bool is_lossless() const { return false; }
 
+  /**
+   * Returns the merged statistics of all nodes that have been written so far
+   */
+  NodeStatistics dataset_statistics() const;
+
 private:
+  void update_dataset_statistics(const NodeStatistics& node_statistics);
+
   std::string _work_dir;
   PointAttributes _input_attributes;
   PointAttributes _output_attributes;
   Compressed _compressed;
   std::string _file_extension;
+
+  std::unique_ptr<std::mutex> _statistics_lock;
+  NodeStatistics _dataset_statistics;
 };
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "datastructures/MortonIndex.h"
 #include "datastructures/PointBuffer.h"
 #include "math/AABB.h"
+#include "pointcloud/NodeStatistics.h"
 #include "pointcloud/PointAttributes.h"
 
 #include <mutex>
@@ -39,6 +40,9 @@ struct MemoryPersistence
 
   inline bool is_lossless() const { return true; }
 
+  // Statistics are not collected for in-memory points
+  inline NodeStatistics dataset_statistics() const { return {}; }
+
   const auto& get_points() const { return _points_cache; }
 
 private:
@@ -0,0 +1,280 @@
+#include "io/MeshoptVertexCodec.h"
+
+#include "util/stuff.h"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+constexpr static uint8_t VERTEX_HEADER = 0xA0;
+constexpr static size_t VERTEX_BLOCK_SIZE_BYTES = 8192;
+constexpr static size_t VERTEX_BLOCK_MAX_SIZE = 256;
+constexpr static size_t BYTE_GROUP_SIZE = 16;
+constexpr static size_t TAIL_MIN_SIZE = 32;
+
+/**
+ * Number of vertices per block, so that a block is at most 8KiB large
+ */
+static size_t
+vertex_block_size(size_t vertex_size)
+{
+  const auto block_size = (VERTEX_BLOCK_SIZE_BYTES / vertex_size) & ~(BYTE_GROUP_SIZE - 1);
+  return std::min(block_size, VERTEX_BLOCK_MAX_SIZE);
+}
+
+static size_t
+round_to_byte_groups(size_t count)
+{
+  return (count + BYTE_GROUP_SIZE - 1) & ~(BYTE_GROUP_SIZE - 1);
+}
+
+static void
+validate_vertex_size(size_t vertex_size)
+{
+  if (vertex_size == 0 || vertex_size > 256 || (vertex_size % 4) != 0) {
+    throw std::invalid_argument{ concat(
+      "Vertex size must be a multiple of 4 and at most 256 (is: ", vertex_size, ")") };
+  }
+}
+
+static uint8_t
+zigzag(uint8_t value)
+{
+  return static_cast<uint8_t>(((value & 0x80) ? 0xFF : 0x00) ^ (value << 1));
+}
+
+static uint8_t
+unzigzag(uint8_t value)
+{
+  return static_cast<uint8_t>(-(value & 1) ^ (value >> 1));
+}
+
+/**
+ * Maps the 2-bit group header to the number of bits per delta
+ */
+constexpr static std::array<size_t, 4> BITS_PER_MODE = { 0, 2, 4, 8 };
+
+static size_t
+encoded_group_size(const uint8_t* group, size_t bits)
+{
+  if (bits == 0) {
+    return std::all_of(group, group + BYTE_GROUP_SIZE, [](uint8_t value) { return value == 0; })
+             ? 0
+             : std::numeric_limits<size_t>::max();
+  }
+  if (bits == 8)
+    return BYTE_GROUP_SIZE;
+
+  // Values that don't fit are stored as a sentinel followed by an extra byte
+  const auto sentinel = static_cast<uint8_t>((1u << bits) - 1);
+  return (BYTE_GROUP_SIZE * bits / 8) +
+         std::count_if(
+           group, group + BYTE_GROUP_SIZE, [sentinel](uint8_t value) { return value >= sentinel; });
+}
+
+static void
+encode_group(const uint8_t* group, size_t bits, std::vector<std::byte>& encoded)
+{
+  if (bits == 0)
+    return;
+  if (bits == 8) {
+    std::transform(
+      group, group + BYTE_GROUP_SIZE, std::back_inserter(encoded), [](uint8_t value) {
+        return static_cast<std::byte>(value);
+      });
+    return;
+  }
+
+  const auto values_per_byte = 8 / bits;
+  const auto sentinel = static_cast<uint8_t>((1u << bits) - 1);
+  for (size_t idx = 0; idx < BYTE_GROUP_SIZE; idx += values_per_byte) {
+    uint8_t packed = 0;
+    for (size_t value_idx = 0; value_idx < values_per_byte; ++value_idx) {
+      packed = static_cast<uint8_t>(packed << bits);
+      packed |= std::min(group[idx + value_idx], sentinel);
+    }
+    encoded.push_back(static_cast<std::byte>(packed));
+  }
+  for (size_t idx = 0; idx < BYTE_GROUP_SIZE; ++idx) {
+    if (group[idx] >= sentinel) {
+      encoded.push_back(static_cast<std::byte>(group[idx]));
+    }
+  }
+}
+
+static void
+encode_bytes(const uint8_t* deltas, size_t count, std::vector<std::byte>& encoded)
+{
+  // Two header bits per group of 16 deltas, which select the bits per delta
+  const auto num_groups = count / BYTE_GROUP_SIZE;
+  const auto header_offset = encoded.size();
+  encoded.resize(encoded.size() + (num_groups + 3) / 4, std::byte{ 0 });
+
+  for (size_t group_idx = 0; group_idx < num_groups; ++group_idx) {
+    const auto group = deltas + group_idx * BYTE_GROUP_SIZE;
+
+    size_t best_mode = 3;
+    auto best_size = encoded_group_size(group, BITS_PER_MODE[best_mode]);
+    for (size_t mode = 0; mode < 3; ++mode) {
+      const auto size = encoded_group_size(group, BITS_PER_MODE[mode]);
+      if (size < best_size) {
+        best_mode = mode;
+        best_size = size;
+      }
+    }
+
+    encoded[header_offset + group_idx / 4] |=
+      static_cast<std::byte>(best_mode << ((group_idx % 4) * 2));
+    encode_group(group, BITS_PER_MODE[best_mode], encoded);
+  }
+}
+
+std::vector<std::byte>
+encode_vertex_buffer(gsl::span<const std::byte> vertices, size_t vertex_size)
+{
+  validate_vertex_size(vertex_size);
+  if (vertices.size() % vertex_size != 0) {
+    throw std::invalid_argument{ "Vertex data must be a multiple of the vertex size" };
+  }
+
+  const auto data = reinterpret_cast<const uint8_t*>(vertices.data());
+  const auto vertex_count = static_cast<size_t>(vertices.size()) / vertex_size;
+  const auto block_size = vertex_block_size(vertex_size);
+
+  std::vector<std::byte> encoded;
+  encoded.reserve(static_cast<size_t>(vertices.size()) + TAIL_MIN_SIZE + 1);
+  encoded.push_back(static_cast<std::byte>(VERTEX_HEADER));
+
+  std::array<uint8_t, 256> first_vertex = {};
+  if (vertex_count) {
+    std::copy(data, data + vertex_size, std::begin(first_vertex));
+  }
+  auto last_vertex = first_vertex;
+
+  // Deltas beyond the last vertex of a block are encoded as zeros, since the
+  // encoding works on full groups of 16 deltas
+  std::array<uint8_t, VERTEX_BLOCK_MAX_SIZE> deltas;
+  for (size_t block_begin = 0; block_begin < vertex_count; block_begin += block_size) {
+    const auto block_count = std::min(block_size, vertex_count - block_begin);
+    const auto block_data = data + block_begin * vertex_size;
+
+    for (size_t byte_idx = 0; byte_idx < vertex_size; ++byte_idx) {
+      deltas.fill(0);
+      auto previous = last_vertex[byte_idx];
+      for (size_t vertex_idx = 0; vertex_idx < block_count; ++vertex_idx) {
+        const auto current = block_data[vertex_idx * vertex_size + byte_idx];
+        deltas[vertex_idx] = zigzag(static_cast<uint8_t>(current - previous));
+        previous = current;
+      }
+      encode_bytes(deltas.data(), round_to_byte_groups(block_count), encoded);
+    }
+
+    const auto block_last_vertex = block_data + (block_count - 1) * vertex_size;
+    std::copy(block_last_vertex, block_last_vertex + vertex_size, std::begin(last_vertex));
+  }
+
+  // The first vertex is stored at the end, padded to a minimum size. This is
+  // the reference for the deltas of the first block
+  if (vertex_size < TAIL_MIN_SIZE) {
+    encoded.resize(encoded.size() + TAIL_MIN_SIZE - vertex_size, std::byte{ 0 });
+  }
+  std::transform(std::begin(first_vertex),
+                 std::begin(first_vertex) + vertex_size,
+                 std::back_inserter(encoded),
+                 [](uint8_t value) { return static_cast<std::byte>(value); });
+
+  return encoded;
+}
+
+std::vector<std::byte>
+decode_vertex_buffer(gsl::span<const std::byte> encoded_vertices,
+                     size_t vertex_count,
+                     size_t vertex_size)
+{
+  validate_vertex_size(vertex_size);
+
+  const auto data_begin = reinterpret_cast<const uint8_t*>(encoded_vertices.data());
+  const auto data_end = data_begin + encoded_vertices.size();
+  const auto tail_size = std::max(vertex_size, TAIL_MIN_SIZE);
+  if (static_cast<size_t>(encoded_vertices.size()) < 1 + tail_size) {
+    throw std::runtime_error{ "Encoded vertex buffer is too small" };
+  }
+  if (data_begin[0] != VERTEX_HEADER) {
+    throw std::runtime_error{ "Unsupported vertex buffer encoding" };
+  }
+
+  std::array<uint8_t, 256> last_vertex = {};
+  std::copy(data_end - vertex_size, data_end, std::begin(last_vertex));
+
+  // Everything before the tail is block data
+  const auto blocks_end = data_end - tail_size;
+  auto data = data_begin + 1;
+  const auto read_byte = [&data, blocks_end]() {
+    if (data >= blocks_end) {
+      throw std::runtime_error{ "Encoded vertex buffer is truncated" };
+    }
+    return *data++;
+  };
+
+  std::vector<std::byte> vertices(vertex_count * vertex_size);
+  const auto vertices_data = reinterpret_cast<uint8_t*>(vertices.data());
+  const auto block_size = vertex_block_size(vertex_size);
+
+  std::array<uint8_t, VERTEX_BLOCK_MAX_SIZE> deltas;
+  for (size_t block_begin = 0; block_begin < vertex_count; block_begin += block_size) {
+    const auto block_count = std::min(block_size, vertex_count - block_begin);
+    const auto block_data = vertices_data + block_begin * vertex_size;
+    const auto num_groups = round_to_byte_groups(block_count) / BYTE_GROUP_SIZE;
+
+    for (size_t byte_idx = 0; byte_idx < vertex_size; ++byte_idx) {
+      const auto header = data;
+      const auto header_size = (num_groups + 3) / 4;
+      if (static_cast<size_t>(blocks_end - data) < header_size) {
+        throw std::runtime_error{ "Encoded vertex buffer is truncated" };
+      }
+      data += header_size;
+
+      for (size_t group_idx = 0; group_idx < num_groups; ++group_idx) {
+        const auto mode = (header[group_idx / 4] >> ((group_idx % 4) * 2)) & 3;
+        const auto bits = BITS_PER_MODE[mode];
+        const auto group = deltas.data() + group_idx * BYTE_GROUP_SIZE;
+
+        if (bits == 0) {
+          std::fill(group, group + BYTE_GROUP_SIZE, uint8_t{ 0 });
+        } else if (bits == 8) {
+          std::generate(group, group + BYTE_GROUP_SIZE, read_byte);
+        } else {
+          const auto values_per_byte = 8 / bits;
+          const auto sentinel = static_cast<uint8_t>((1u << bits) - 1);
+          for (size_t idx = 0; idx < BYTE_GROUP_SIZE; idx += values_per_byte) {
+            const auto packed = read_byte();
+            for (size_t value_idx = 0; value_idx < values_per_byte; ++value_idx) {
+              const auto shift = 8 - bits * (value_idx + 1);
+              group[idx + value_idx] = static_cast<uint8_t>((packed >> shift) & sentinel);
+            }
+          }
+          for (size_t idx = 0; idx < BYTE_GROUP_SIZE; ++idx) {
+            if (group[idx] == sentinel) {
+              group[idx] = read_byte();
+            }
+          }
+        }
+      }
+
+      auto previous = last_vertex[byte_idx];
+      for (size_t vertex_idx = 0; vertex_idx < block_count; ++vertex_idx) {
+        previous = static_cast<uint8_t>(previous + unzigzag(deltas[vertex_idx]));
+        block_data[vertex_idx * vertex_size + byte_idx] = previous;
+      }
+    }
+
+    const auto block_last_vertex = block_data + (block_count - 1) * vertex_size;
+    std::copy(block_last_vertex, block_last_vertex + vertex_size, std::begin(last_vertex));
+  }
+
+  if (data != blocks_end) {
+    throw std::runtime_error{ "Encoded vertex buffer has trailing data" };
+  }
+
+  return vertices;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <gsl/gsl>
+#include <vector>
+
+/*
+ * Vertex attribute compression as specified by the EXT_meshopt_compression
+ * glTF extension (ATTRIBUTES mode, version 0):
+ * https://github.com/KhronosGroup/glTF/tree/main/extensions/2.0/Vendor/EXT_meshopt_compression
+ *
+ * Vertices are split into blocks of up to 256 vertices. Within a block, each
+ * byte of the vertex is delta-encoded against the same byte of the previous
+ * vertex and the zigzag-encoded deltas are stored in groups of 16 with 0, 2, 4
+ * or 8 bits per delta. Attributes that change smoothly between neighbouring
+ * vertices (such as Morton-ordered quantized positions) compress well, and
+ * decoding is a simple linear pass
+ */
+
+/**
+ * Encodes the given vertices, which are stored contiguously with 'vertex_size'
+ * bytes per vertex. 'vertex_size' has to be a multiple of 4 and at most 256
+ */
+std::vector<std::byte>
+encode_vertex_buffer(gsl::span<const std::byte> vertices, size_t vertex_size);
+
+/**
+ * Decodes 'vertex_count' vertices of 'vertex_size' bytes each from the given
+ * encoded data. Throws std::runtime_error if the data is malformed
+ */
+std::vector<std::byte>
+decode_vertex_buffer(gsl::span<const std::byte> encoded_vertices,
+                     size_t vertex_count,
+                     size_t vertex_size);
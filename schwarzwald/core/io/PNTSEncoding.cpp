@@ -0,0 +1,364 @@
+#include "io/PNTSEncoding.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+constexpr static double QUANTIZED_POSITION_MAX = std::numeric_limits<uint16_t>::max();
+constexpr static float OCT16P_MAX = std::numeric_limits<uint8_t>::max();
+
+// The AVX2 kernels address the coordinates of consecutive points with fixed
+// strides
+static_assert(sizeof(Vector3<double>) == 3 * sizeof(double));
+static_assert(sizeof(Vector3<float>) == 3 * sizeof(float));
+static_assert(sizeof(Vector3<uint8_t>) == 3);
+static_assert(sizeof(NORMAL_OCT16P) == 2);
+
+/**
+ * Factor that maps offsets within a quantized volume with the given scale to
+ * the quantized range. A scale of zero occurs for flat volumes, all positions
+ * are at the offset then
+ */
+static double
+inverse_quantization_scale(double scale)
+{
+  return (scale > 0) ? (QUANTIZED_POSITION_MAX / scale) : 0.0;
+}
+
+QuantizedVolume
+quantized_volume_for(gsl::span<const Vector3<double>> positions)
+{
+  if (positions.empty())
+    return {};
+
+  auto min = positions[0];
+  auto max = positions[0];
+  for (const auto& position : positions) {
+    min.x = std::min(min.x, position.x);
+    min.y = std::min(min.y, position.y);
+    min.z = std::min(min.z, position.z);
+    max.x = std::max(max.x, position.x);
+    max.y = std::max(max.y, position.y);
+    max.z = std::max(max.z, position.z);
+  }
+
+  return { min, max - min };
+}
+
+void
+quantize_positions(gsl::span<const Vector3<double>> positions,
+                   const QuantizedVolume& volume,
+                   gsl::span<QuantizedPosition> quantized_positions)
+{
+#ifdef __AVX2__
+  quantize_positions_avx2(positions, volume, quantized_positions);
+#else
+  quantize_positions_scalar(positions, volume, quantized_positions);
+#endif
+}
+
+void
+quantize_positions_scalar(gsl::span<const Vector3<double>> positions,
+                          const QuantizedVolume& volume,
+                          gsl::span<QuantizedPosition> quantized_positions)
+{
+  assert(quantized_positions.size() >= positions.size());
+
+  const auto inv_scale_x = inverse_quantization_scale(volume.scale.x);
+  const auto inv_scale_y = inverse_quantization_scale(volume.scale.y);
+  const auto inv_scale_z = inverse_quantization_scale(volume.scale.z);
+
+  const auto quantize = [](double value) {
+    return static_cast<uint16_t>(std::clamp(value + 0.5, 0.0, QUANTIZED_POSITION_MAX));
+  };
+
+  const auto count = static_cast<size_t>(positions.size());
+  for (size_t idx = 0; idx < count; ++idx) {
+    const auto& position = positions[idx];
+    quantized_positions[idx] = { quantize((position.x - volume.offset.x) * inv_scale_x),
+                                 quantize((position.y - volume.offset.y) * inv_scale_y),
+                                 quantize((position.z - volume.offset.z) * inv_scale_z) };
+  }
+}
+
+void
+dequantize_positions(gsl::span<const QuantizedPosition> quantized_positions,
+                     const QuantizedVolume& volume,
+                     gsl::span<Vector3<double>> positions)
+{
+  assert(positions.size() >= quantized_positions.size());
+
+  const auto step = volume.scale / QUANTIZED_POSITION_MAX;
+
+  const auto count = static_cast<size_t>(quantized_positions.size());
+  for (size_t idx = 0; idx < count; ++idx) {
+    const auto& quantized_position = quantized_positions[idx];
+    positions[idx] = { volume.offset.x + quantized_position.x * step.x,
+                       volume.offset.y + quantized_position.y * step.y,
+                       volume.offset.z + quantized_position.z * step.z };
+  }
+}
+
+void
+encode_rgb565(gsl::span<const Vector3<uint8_t>> colors, gsl::span<uint16_t> encoded_colors)
+{
+#ifdef __AVX2__
+  encode_rgb565_avx2(colors, encoded_colors);
+#else
+  encode_rgb565_scalar(colors, encoded_colors);
+#endif
+}
+
+void
+encode_rgb565_scalar(gsl::span<const Vector3<uint8_t>> colors,
+                     gsl::span<uint16_t> encoded_colors)
+{
+  assert(encoded_colors.size() >= colors.size());
+
+  const auto count = static_cast<size_t>(colors.size());
+  for (size_t idx = 0; idx < count; ++idx) {
+    const auto& color = colors[idx];
+    encoded_colors[idx] =
+      static_cast<uint16_t>(((color.x >> 3) << 11) | ((color.y >> 2) << 5) | (color.z >> 3));
+  }
+}
+
+void
+decode_rgb565(gsl::span<const uint16_t> encoded_colors, gsl::span<Vector3<uint8_t>> colors)
+{
+  assert(colors.size() >= encoded_colors.size());
+
+  // Replicating the high bits into the low bits maps the maximum 5- and 6-bit
+  // values to 255
+  const auto count = static_cast<size_t>(encoded_colors.size());
+  for (size_t idx = 0; idx < count; ++idx) {
+    const auto encoded = encoded_colors[idx];
+    const auto r = (encoded >> 11) & 0x1F;
+    const auto g = (encoded >> 5) & 0x3F;
+    const auto b = encoded & 0x1F;
+    colors[idx] = { static_cast<uint8_t>((r << 3) | (r >> 2)),
+                    static_cast<uint8_t>((g << 2) | (g >> 4)),
+                    static_cast<uint8_t>((b << 3) | (b >> 2)) };
+  }
+}
+
+static float
+sign_not_zero(float value)
+{
+  return (value >= 0.f) ? 1.f : -1.f;
+}
+
+void
+encode_normals_oct16p(gsl::span<const Vector3<float>> normals,
+                      gsl::span<NORMAL_OCT16P> encoded_normals)
+{
+#ifdef __AVX2__
+  encode_normals_oct16p_avx2(normals, encoded_normals);
+#else
+  encode_normals_oct16p_scalar(normals, encoded_normals);
+#endif
+}
+
+void
+encode_normals_oct16p_scalar(gsl::span<const Vector3<float>> normals,
+                             gsl::span<NORMAL_OCT16P> encoded_normals)
+{
+  assert(encoded_normals.size() >= normals.size());
+
+  const auto to_unorm8 = [](float value) {
+    return static_cast<uint8_t>(
+      std::clamp(value, -1.f, 1.f) * (0.5f * OCT16P_MAX) + (0.5f * OCT16P_MAX) + 0.5f);
+  };
+
+  // Projects the normal onto the octahedron and folds the lower hemisphere onto
+  // the upper one, see "A Survey of Efficient Representations for Independent
+  // Unit Vectors" (Cigolle et al. 2014). Both hemispheres are computed and
+  // selected to keep the loop free of branches
+  const auto count = static_cast<size_t>(normals.size());
+  for (size_t idx = 0; idx < count; ++idx) {
+    const auto& normal = normals[idx];
+    const auto l1_norm = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    const auto inv_l1_norm = (l1_norm > 0.f) ? (1.f / l1_norm) : 0.f;
+
+    const auto px = normal.x * inv_l1_norm;
+    const auto py = normal.y * inv_l1_norm;
+    const auto folded_x = (1.f - std::abs(py)) * sign_not_zero(px);
+    const auto folded_y = (1.f - std::abs(px)) * sign_not_zero(py);
+
+    const auto is_lower_hemisphere = normal.z < 0.f;
+    encoded_normals[idx] = { to_unorm8(is_lower_hemisphere ? folded_x : px),
+                             to_unorm8(is_lower_hemisphere ? folded_y : py) };
+  }
+}
+
+void
+decode_normals_oct16p(gsl::span<const NORMAL_OCT16P> encoded_normals,
+                      gsl::span<Vector3<float>> normals)
+{
+  assert(normals.size() >= encoded_normals.size());
+
+  const auto count = static_cast<size_t>(encoded_normals.size());
+  for (size_t idx = 0; idx < count; ++idx) {
+    const auto& encoded = encoded_normals[idx];
+    const auto x = encoded.x / OCT16P_MAX * 2.f - 1.f;
+    const auto y = encoded.y / OCT16P_MAX * 2.f - 1.f;
+    const auto z = 1.f - std::abs(x) - std::abs(y);
+
+    const auto is_lower_hemisphere = z < 0.f;
+    const auto unfolded_x = is_lower_hemisphere ? (1.f - std::abs(y)) * sign_not_zero(x) : x;
+    const auto unfolded_y = is_lower_hemisphere ? (1.f - std::abs(x)) * sign_not_zero(y) : y;
+
+    const auto length = std::sqrt(unfolded_x * unfolded_x + unfolded_y * unfolded_y + z * z);
+    normals[idx] = { unfolded_x / length, unfolded_y / length, z / length };
+  }
+}
+
+#ifdef __AVX2__
+
+void
+quantize_positions_avx2(gsl::span<const Vector3<double>> positions,
+                        const QuantizedVolume& volume,
+                        gsl::span<QuantizedPosition> quantized_positions)
+{
+  assert(quantized_positions.size() >= positions.size());
+
+  const auto half = _mm256_set1_pd(0.5);
+  const auto zero = _mm256_setzero_pd();
+  const auto max = _mm256_set1_pd(QUANTIZED_POSITION_MAX);
+  // Offsets of one coordinate of four consecutive positions, in doubles
+  const auto offsets = _mm256_setr_epi64x(0, 3, 6, 9);
+
+  // Quantizes one coordinate of four consecutive positions to four 32-bit
+  // integers. Clamps and truncates like the scalar kernel
+  const auto quantize = [=](const double* first_coordinate, __m256d offset, __m256d inv_scale) {
+    const auto coordinates = _mm256_i64gather_pd(first_coordinate, offsets, sizeof(double));
+    const auto scaled =
+      _mm256_add_pd(_mm256_mul_pd(_mm256_sub_pd(coordinates, offset), inv_scale), half);
+    return _mm256_cvttpd_epi32(_mm256_min_pd(_mm256_max_pd(scaled, zero), max));
+  };
+
+  // Quantizes one coordinate of eight consecutive positions to 16 bits
+  const auto quantize_block = [=](const double* first_coordinate, double offset, double scale) {
+    const auto offset_vec = _mm256_set1_pd(offset);
+    const auto inv_scale_vec = _mm256_set1_pd(inverse_quantization_scale(scale));
+    return _mm_packus_epi32(quantize(first_coordinate, offset_vec, inv_scale_vec),
+                            quantize(first_coordinate + 12, offset_vec, inv_scale_vec));
+  };
+
+  constexpr size_t BlockSize = 8;
+  alignas(16) uint16_t x[BlockSize];
+  alignas(16) uint16_t y[BlockSize];
+  alignas(16) uint16_t z[BlockSize];
+
+  const auto count = static_cast<size_t>(positions.size());
+  size_t idx = 0;
+  for (; idx + BlockSize <= count; idx += BlockSize) {
+    const double* first_coordinate = &positions.data()[idx].x;
+    _mm_store_si128(reinterpret_cast<__m128i*>(x),
+                    quantize_block(first_coordinate, volume.offset.x, volume.scale.x));
+    _mm_store_si128(reinterpret_cast<__m128i*>(y),
+                    quantize_block(first_coordinate + 1, volume.offset.y, volume.scale.y));
+    _mm_store_si128(reinterpret_cast<__m128i*>(z),
+                    quantize_block(first_coordinate + 2, volume.offset.z, volume.scale.z));
+    for (size_t lane = 0; lane < BlockSize; ++lane) {
+      quantized_positions[idx + lane] = { x[lane], y[lane], z[lane] };
+    }
+  }
+
+  quantize_positions_scalar(positions.subspan(idx), volume, quantized_positions.subspan(idx));
+}
+
+void
+encode_rgb565_avx2(gsl::span<const Vector3<uint8_t>> colors, gsl::span<uint16_t> encoded_colors)
+{
+  assert(encoded_colors.size() >= colors.size());
+
+  // Each lane loads the 4 bytes at the start of one color, i.e. its RGB values
+  // and the red value of the next color. To stay within the span, the last
+  // color is never part of a block
+  const auto offsets = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+  const auto red_mask = _mm256_set1_epi32(0xF8);
+  const auto green_mask = _mm256_set1_epi32(0x7E0);
+  const auto blue_mask = _mm256_set1_epi32(0x1F);
+
+  constexpr size_t BlockSize = 8;
+  const auto count = static_cast<size_t>(colors.size());
+  size_t idx = 0;
+  for (; idx + BlockSize < count; idx += BlockSize) {
+    const auto* first_color = reinterpret_cast<const int*>(&colors.data()[idx].x);
+    const auto rgb = _mm256_i32gather_epi32(first_color, offsets, 1);
+    const auto r = _mm256_slli_epi32(_mm256_and_si256(rgb, red_mask), 8);
+    const auto g = _mm256_and_si256(_mm256_srli_epi32(rgb, 5), green_mask);
+    const auto b = _mm256_and_si256(_mm256_srli_epi32(rgb, 19), blue_mask);
+    const auto encoded = _mm256_or_si256(_mm256_or_si256(r, g), b);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(encoded_colors.data() + idx),
+                     _mm_packus_epi32(_mm256_castsi256_si128(encoded),
+                                      _mm256_extracti128_si256(encoded, 1)));
+  }
+
+  encode_rgb565_scalar(colors.subspan(idx), encoded_colors.subspan(idx));
+}
+
+void
+encode_normals_oct16p_avx2(gsl::span<const Vector3<float>> normals,
+                           gsl::span<NORMAL_OCT16P> encoded_normals)
+{
+  assert(encoded_normals.size() >= normals.size());
+
+  // Offsets of one coordinate of eight consecutive normals, in floats
+  const auto offsets = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+  const auto sign_mask = _mm256_set1_ps(-0.f);
+  const auto zero = _mm256_setzero_ps();
+  const auto one = _mm256_set1_ps(1.f);
+  const auto minus_one = _mm256_set1_ps(-1.f);
+  const auto half = _mm256_set1_ps(0.5f);
+  const auto half_max = _mm256_set1_ps(0.5f * OCT16P_MAX);
+
+  const auto abs = [=](__m256 value) { return _mm256_andnot_ps(sign_mask, value); };
+  const auto sign_not_zero = [=](__m256 value) {
+    return _mm256_blendv_ps(minus_one, one, _mm256_cmp_ps(value, zero, _CMP_GE_OQ));
+  };
+  const auto to_unorm8 = [=](__m256 value) {
+    const auto clamped = _mm256_min_ps(_mm256_max_ps(value, minus_one), one);
+    return _mm256_cvttps_epi32(
+      _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(clamped, half_max), half_max), half));
+  };
+
+  constexpr size_t BlockSize = 8;
+  const auto count = static_cast<size_t>(normals.size());
+  size_t idx = 0;
+  for (; idx + BlockSize <= count; idx += BlockSize) {
+    const float* first_coordinate = &normals.data()[idx].x;
+    const auto x = _mm256_i32gather_ps(first_coordinate, offsets, sizeof(float));
+    const auto y = _mm256_i32gather_ps(first_coordinate + 1, offsets, sizeof(float));
+    const auto z = _mm256_i32gather_ps(first_coordinate + 2, offsets, sizeof(float));
+
+    const auto l1_norm = _mm256_add_ps(_mm256_add_ps(abs(x), abs(y)), abs(z));
+    const auto inv_l1_norm =
+      _mm256_and_ps(_mm256_div_ps(one, l1_norm), _mm256_cmp_ps(l1_norm, zero, _CMP_GT_OQ));
+
+    const auto px = _mm256_mul_ps(x, inv_l1_norm);
+    const auto py = _mm256_mul_ps(y, inv_l1_norm);
+    const auto folded_x = _mm256_mul_ps(_mm256_sub_ps(one, abs(py)), sign_not_zero(px));
+    const auto folded_y = _mm256_mul_ps(_mm256_sub_ps(one, abs(px)), sign_not_zero(py));
+
+    const auto is_lower_hemisphere = _mm256_cmp_ps(z, zero, _CMP_LT_OQ);
+    const auto encoded_x = to_unorm8(_mm256_blendv_ps(px, folded_x, is_lower_hemisphere));
+    const auto encoded_y = to_unorm8(_mm256_blendv_ps(py, folded_y, is_lower_hemisphere));
+
+    // A NORMAL_OCT16P is stored as 16 bits with x in the low byte
+    const auto encoded = _mm256_or_si256(encoded_x, _mm256_slli_epi32(encoded_y, 8));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(encoded_normals.data() + idx),
+                     _mm_packus_epi32(_mm256_castsi256_si128(encoded),
+                                      _mm256_extracti128_si256(encoded, 1)));
+  }
+
+  encode_normals_oct16p_scalar(normals.subspan(idx), encoded_normals.subspan(idx));
+}
+
+#endif
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "math/AABB.h"
+#include "math/Vector3.h"
+
+#include <cstdint>
+#include <gsl/gsl>
+
+/**
+ * Encodings for the per-point attributes in .pnts files
+ */
+enum class PNTSEncoding
+{
+  // Float positions (POSITION), 8-bit RGB colors (RGB) and float normals (NORMAL)
+  Default,
+  // 16-bit positions relative to the bounds of the points of each node
+  // (POSITION_QUANTIZED), 16-bit colors (RGB565) and 2-byte oct-encoded
+  // normals (NORMAL_OCT16P). This is lossy, but roughly halves the size of
+  // each tile
+  Compact
+};
+
+/**
+ * A position quantized to 16 bits per axis, as stored in the
+ * POSITION_QUANTIZED semantic of a .pnts file
+ */
+struct QuantizedPosition
+{
+  uint16_t x;
+  uint16_t y;
+  uint16_t z;
+};
+
+/**
+ * An oct-encoded unit vector, as stored in the NORMAL_OCT16P semantic of a
+ * .pnts file
+ */
+struct NORMAL_OCT16P
+{
+  NORMAL_OCT16P()
+    : x(0)
+    , y(0)
+  {}
+  NORMAL_OCT16P(uint8_t x, uint8_t y)
+    : x(x)
+    , y(y)
+  {}
+  uint8_t x;
+  uint8_t y;
+};
+
+/**
+ * The volume that quantized positions are relative to. This corresponds to the
+ * QUANTIZED_VOLUME_OFFSET and QUANTIZED_VOLUME_SCALE global semantics of a
+ * .pnts file
+ */
+struct QuantizedVolume
+{
+  Vector3<double> offset;
+  Vector3<double> scale;
+};
+
+/**
+ * Returns the quantized volume that tightly encloses the given positions
+ */
+QuantizedVolume
+quantized_volume_for(gsl::span<const Vector3<double>> positions);
+
+/*
+ * The following functions encode and decode whole columns of points. Each is a
+ * single branch-free loop over contiguous memory, so that the compiler can
+ * vectorize them. The spans for the results have to be at least as large as
+ * the input spans
+ */
+
+void
+quantize_positions(gsl::span<const Vector3<double>> positions,
+                   const QuantizedVolume& volume,
+                   gsl::span<QuantizedPosition> quantized_positions);
+
+void
+dequantize_positions(gsl::span<const QuantizedPosition> quantized_positions,
+                     const QuantizedVolume& volume,
+                     gsl::span<Vector3<double>> positions);
+
+void
+encode_rgb565(gsl::span<const Vector3<uint8_t>> colors, gsl::span<uint16_t> encoded_colors);
+
+void
+decode_rgb565(gsl::span<const uint16_t> encoded_colors, gsl::span<Vector3<uint8_t>> colors);
+
+void
+encode_normals_oct16p(gsl::span<const Vector3<float>> normals,
+                      gsl::span<NORMAL_OCT16P> encoded_normals);
+
+void
+decode_normals_oct16p(gsl::span<const NORMAL_OCT16P> encoded_normals,
+                      gsl::span<Vector3<float>> normals);
+
+/*
+ * Kernels of the encoding functions above. These use the AVX2 kernels if AVX2
+ * is enabled (SCHWARZWALD_ENABLE_AVX2) and the scalar kernels otherwise. The
+ * AVX2 kernels load one coordinate of a block of points into each register, so
+ * that they compute the encoding structure-of-arrays, and encode the points
+ * after the last full block with the scalar kernels. Both kernels produce
+ * identical results
+ */
+
+void
+quantize_positions_scalar(gsl::span<const Vector3<double>> positions,
+                          const QuantizedVolume& volume,
+                          gsl::span<QuantizedPosition> quantized_positions);
+
+void
+encode_rgb565_scalar(gsl::span<const Vector3<uint8_t>> colors,
+                     gsl::span<uint16_t> encoded_colors);
+
+void
+encode_normals_oct16p_scalar(gsl::span<const Vector3<float>> normals,
+                             gsl::span<NORMAL_OCT16P> encoded_normals);
+
+#ifdef __AVX2__
+void
+quantize_positions_avx2(gsl::span<const Vector3<double>> positions,
+                        const QuantizedVolume& volume,
+                        gsl::span<QuantizedPosition> quantized_positions);
+
+void
+encode_rgb565_avx2(gsl::span<const Vector3<uint8_t>> colors, gsl::span<uint16_t> encoded_colors);
+
+void
+encode_normals_oct16p_avx2(gsl::span<const Vector3<float>> normals,
+                           gsl::span<NORMAL_OCT16P> encoded_normals);
+#endif
@@ -81,27 +81,73 @@ readPNTSFile(const std::string& filepath, const PointAttributes& input_attribute
                           rtcCenterMember[1].GetDouble(),
                           rtcCenterMember[2].GetDouble() };
 
-  const auto& positionMember = featureTableJSONDocument.FindMember("POSITION")->value;
-  const auto positionByteOffset = positionMember.FindMember("byteOffset")->value.GetUint();
+  // Files written with PNTSEncoding::Compact store quantized positions, RGB565
+  // colors and oct-encoded normals, which are decoded here
+  const auto hasQuantizedPositions =
+    featureTableJSONDocument.HasMember("POSITION_QUANTIZED");
+  pntsFile.encoding = hasQuantizedPositions ? PNTSEncoding::Compact : PNTSEncoding::Default;
 
-  const auto positionsBegin =
-    reinterpret_cast<const Vector3<float>*>(featureTableBinaryBegin + positionByteOffset);
-  const auto positionsEnd = positionsBegin + pointsLength;
   std::vector<Vector3<double>> highpPositions;
-  highpPositions.reserve(pointsLength);
-  std::transform(
-    positionsBegin, positionsEnd, std::back_inserter(highpPositions), Vector3<float>::cast<double>);
+  if (hasQuantizedPositions) {
+    std::vector<QuantizedPosition> quantizedPositions;
+    extractFeatureArray<QuantizedPosition>(quantizedPositions,
+                                           "POSITION_QUANTIZED",
+                                           featureTableJSONDocument,
+                                           featureTableBinaryBegin,
+                                           pointsLength);
+
+    const auto& offsetMember = featureTableJSONDocument.FindMember("QUANTIZED_VOLUME_OFFSET")->value;
+    const auto& scaleMember = featureTableJSONDocument.FindMember("QUANTIZED_VOLUME_SCALE")->value;
+    const QuantizedVolume quantizedVolume{
+      { offsetMember[0].GetDouble(), offsetMember[1].GetDouble(), offsetMember[2].GetDouble() },
+      { scaleMember[0].GetDouble(), scaleMember[1].GetDouble(), scaleMember[2].GetDouble() }
+    };
+
+    highpPositions.resize(pointsLength);
+    dequantize_positions(quantizedPositions, quantizedVolume, highpPositions);
+  } else {
+    const auto& positionMember = featureTableJSONDocument.FindMember("POSITION")->value;
+    const auto positionByteOffset = positionMember.FindMember("byteOffset")->value.GetUint();
+
+    const auto positionsBegin =
+      reinterpret_cast<const Vector3<float>*>(featureTableBinaryBegin + positionByteOffset);
+    const auto positionsEnd = positionsBegin + pointsLength;
+    highpPositions.reserve(pointsLength);
+    std::transform(positionsBegin,
+                   positionsEnd,
+                   std::back_inserter(highpPositions),
+                   Vector3<float>::cast<double>);
+  }
 
   std::vector<Vector3<uint8_t>> colors;
   if (has_attribute(input_attributes, PointAttribute::RGB)) {
     extractFeatureArray<Vector3<uint8_t>>(
       colors, "RGB", featureTableJSONDocument, featureTableBinaryBegin, pointsLength);
+
+    std::vector<uint16_t> rgb565Colors;
+    extractFeatureArray<uint16_t>(
+      rgb565Colors, "RGB565", featureTableJSONDocument, featureTableBinaryBegin, pointsLength);
+    if (!rgb565Colors.empty()) {
+      colors.resize(rgb565Colors.size());
+      decode_rgb565(rgb565Colors, colors);
+    }
   }
 
   std::vector<Vector3<float>> normals;
-  // FEATURE Read normals from PNTS file
   if (has_attribute(input_attributes, PointAttribute::Normal)) {
-    throw std::runtime_error{ "Reading normals from .pnts files is not supported" };
+    extractFeatureArray<Vector3<float>>(
+      normals, "NORMAL", featureTableJSONDocument, featureTableBinaryBegin, pointsLength);
+
+    std::vector<NORMAL_OCT16P> encodedNormals;
+    extractFeatureArray<NORMAL_OCT16P>(encodedNormals,
+                                       "NORMAL_OCT16P",
+                                       featureTableJSONDocument,
+                                       featureTableBinaryBegin,
+                                       pointsLength);
+    if (!encodedNormals.empty()) {
+      normals.resize(encodedNormals.size());
+      decode_normals_oct16p(encodedNormals, normals);
+    }
   }
 
   std::vector<uint16_t> intensities;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "datastructures/PointBuffer.h"
+#include "io/PNTSEncoding.h"
 
 #include <optional>
 #include <stdint.h>
@@ -20,6 +21,7 @@ struct PNTSFile
 {
   PNTSHeader header;
   Vector3<double> rtc_center;
+  PNTSEncoding encoding;
   PointBuffer points;
 };
 
@@ -25,10 +25,15 @@ writeBinary(const T& obj, std::ofstream& stream)
 
 namespace {
 static attributes::PointAttributeBase::Ptr
-createPointAttributeCache(const PointAttribute& attribute, RGBMapping rgb_mapping)
+createPointAttributeCache(const PointAttribute& attribute,
+                          RGBMapping rgb_mapping,
+                          PNTSEncoding encoding)
 {
+  const auto compact = (encoding == PNTSEncoding::Compact);
   switch (attribute) {
     case PointAttribute::Position:
+      if (compact)
+        return std::make_unique<attributes::PositionQuantizedAttribute>();
       return std::make_unique<attributes::PositionAttribute>();
     case PointAttribute::RGB:
       switch (rgb_mapping) {
@@ -39,10 +44,16 @@ createPointAttributeCache(const PointAttribute& attribute, RGBMapping rgb_mappin
           return std::make_unique<attributes::RGBFromIntensityAttribute>(
             attributes::RGBFromIntensityAttribute::MappingType::Log);
         default:
+          if (compact)
+            return std::make_unique<attributes::RGB565Attribute>();
           return std::make_unique<attributes::RGBAttribute>();
       }
     case PointAttribute::Intensity:
       return std::make_unique<attributes::IntensityAttribute>();
+    case PointAttribute::Normal:
+      if (compact)
+        return std::make_unique<attributes::NormalOct16PAttribute>();
+      return std::make_unique<attributes::NormalAttribute>();
     case PointAttribute::Classification:
       return std::make_unique<attributes::ClassificationAttribute>();
     default:
@@ -53,11 +64,12 @@ createPointAttributeCache(const PointAttribute& attribute, RGBMapping rgb_mappin
 
 PNTSWriter::PNTSWriter(const std::string& filePath,
                        const PointAttributes& pointAttributes,
-                       RGBMapping rgb_mapping)
+                       RGBMapping rgb_mapping,
+                       PNTSEncoding encoding)
   : _filePath(filePath)
 {
   for (auto& desiredPointAttribute : pointAttributes) {
-    auto attributeCache = createPointAttributeCache(desiredPointAttribute, rgb_mapping);
+    auto attributeCache = createPointAttributeCache(desiredPointAttribute, rgb_mapping, encoding);
     if (!attributeCache) {
       std::cerr << "Could not create attribute cache for PointAttribute "
                 << util::to_string(desiredPointAttribute) << "! Attribute will be skipped..."
@@ -105,6 +117,16 @@ PNTSWriter::write_points(gsl::span<PointBuffer::PointReference> points)
   }
 }
 
+NodeStatistics
+PNTSWriter::statistics() const
+{
+  NodeStatistics statistics;
+  for (const auto& attribute : _featuretable.perPointAttributes) {
+    attribute->addStatistics(statistics);
+  }
+  return statistics;
+}
+
 void
 PNTSWriter::flush(const Vector3<double>& localCenter)
 {
@@ -179,6 +201,7 @@ PNTSWriter::createFeatureTableBlob(const Vector3<double>& localCenter) // create
   uint32_t currentAttributeOffset = 0;
 
   for (auto& perPointAttribute : _featuretable.perPointAttributes) {
+    perPointAttribute->finishExtraction();
     const auto attributeBytesRange = perPointAttribute->getBinaryDataRange();
     const auto attributeByteSize = static_cast<uint32_t>(attributeBytesRange.size());
 
@@ -205,6 +228,8 @@ PNTSWriter::createFeatureTableBlob(const Vector3<double>& localCenter) // create
     attributeDescription.attributeName = perPointAttribute->getAttributeNameForJSON();
     attributeDescriptions.push_back(attributeDescription);
 
+    perPointAttribute->addGlobalSemantics(jsonHeader);
+
     currentAttributeOffset = alignedOffset + attributeByteSize;
   }
 
@@ -229,8 +254,6 @@ PNTSWriter::createFeatureTableBlob(const Vector3<double>& localCenter) // create
               startInBinaryBody);
   }
 
-  // FEATURE Global attributes for the JSON header
-
   StringBuffer jsonBuffer;
   Writer<StringBuffer> writer(jsonBuffer);
   jsonHeader.Accept(writer);
@@ -286,15 +309,14 @@ transform_pnts_file_coordinates(const std::string& file_path,
     position += pnts_file->rtc_center;
   }
 
-  transform_helper.transformPositionsTo(TargetSRS::CesiumWorld,
-                                        gsl::make_span(pnts_file->points.positions()));
+  transform_helper.transformPositionsTo(TargetSRS::CesiumWorld, pnts_file->points.positions());
 
   Vector3<double> local_center;
   if (recenter == Recenter::Yes) {
     local_center = setOriginToSmallestPoint(pnts_file->points.positions());
   }
 
-  PNTSWriter writer{ file_path, points_attributes, RGBMapping::None };
+  PNTSWriter writer{ file_path, points_attributes, RGBMapping::None, pnts_file->encoding };
   writer.write_points(pnts_file->points);
   writer.flush(local_center);
 }
@@ -359,14 +381,44 @@ attributes::PositionAttribute::getAlignmentRequirement() const
 void
 attributes::PositionQuantizedAttribute::extractFromPoints(const PointBuffer& points)
 {
-  // FEATURE Support quantized positions
+  _positions.insert(_positions.end(), points.positions().begin(), points.positions().end());
 }
 
 void
 attributes::PositionQuantizedAttribute::extractFromPoints(
   gsl::span<PointBuffer::PointReference> points)
 {
-  // FEATURE Support quantized positions
+  _positions.reserve(_positions.size() + points.size());
+  std::transform(points.begin(),
+                 points.end(),
+                 std::back_inserter(_positions),
+                 [](const auto& point_reference) { return point_reference.position(); });
+}
+
+void
+attributes::PositionQuantizedAttribute::finishExtraction()
+{
+  _quantizedVolume = quantized_volume_for(_positions);
+  _quantizedPositions.resize(_positions.size());
+  quantize_positions(_positions, _quantizedVolume, _quantizedPositions);
+}
+
+void
+attributes::PositionQuantizedAttribute::addGlobalSemantics(Document& jsonHeader) const
+{
+  auto& jsonAllocator = jsonHeader.GetAllocator();
+
+  Value offsetArray{ kArrayType };
+  offsetArray.PushBack(_quantizedVolume.offset.x, jsonAllocator);
+  offsetArray.PushBack(_quantizedVolume.offset.y, jsonAllocator);
+  offsetArray.PushBack(_quantizedVolume.offset.z, jsonAllocator);
+  jsonHeader.AddMember("QUANTIZED_VOLUME_OFFSET", offsetArray, jsonAllocator);
+
+  Value scaleArray{ kArrayType };
+  scaleArray.PushBack(_quantizedVolume.scale.x, jsonAllocator);
+  scaleArray.PushBack(_quantizedVolume.scale.y, jsonAllocator);
+  scaleArray.PushBack(_quantizedVolume.scale.z, jsonAllocator);
+  jsonHeader.AddMember("QUANTIZED_VOLUME_SCALE", scaleArray, jsonAllocator);
 }
 
 std::string
@@ -378,14 +430,15 @@ attributes::PositionQuantizedAttribute::getAttributeNameForJSON() const
 gsl::span<const std::byte>
 attributes::PositionQuantizedAttribute::getBinaryDataRange() const
 {
-  // FEATURE Support quantized positions
-  return {};
+  const auto begin = reinterpret_cast<std::byte const*>(_quantizedPositions.data());
+  const auto end = begin + vector_byte_size(_quantizedPositions);
+  return { begin, end };
 }
 
 uint32_t
 attributes::PositionQuantizedAttribute::getAlignmentRequirement() const
 {
-  return uint32_t(); // FEATURE Support quantized positions
+  return 2u; // Quantized positions are stored as uint16 values
 }
 
 void
@@ -502,6 +555,64 @@ attributes::RGBAttribute::getAlignmentRequirement() const
   return 1u;
 }
 
+void
+attributes::RGB565Attribute::extractFromPoints(const PointBuffer& points)
+{
+  if (!points.count())
+    return;
+  if (!points.hasColors())
+    return;
+
+  const auto offset = _rgb565Colors.size();
+  _rgb565Colors.resize(offset + points.count());
+  encode_rgb565(points.rgbColors(), gsl::make_span(_rgb565Colors).subspan(offset));
+}
+
+void
+attributes::RGB565Attribute::extractFromPoints(gsl::span<PointBuffer::PointReference> points)
+{
+  if (!points.size())
+    return;
+  if (!points[0].rgbColor())
+    return;
+
+  // Gather the colors first, so that they can be encoded in a single pass
+  std::vector<Vector3<uint8_t>> colors;
+  colors.reserve(points.size());
+  std::transform(points.begin(),
+                 points.end(),
+                 std::back_inserter(colors),
+                 [](const auto& point_reference) -> Vector3<uint8_t> {
+                   const auto color = point_reference.rgbColor();
+                   assert(color != nullptr);
+                   return *color;
+                 });
+
+  const auto offset = _rgb565Colors.size();
+  _rgb565Colors.resize(offset + colors.size());
+  encode_rgb565(colors, gsl::make_span(_rgb565Colors).subspan(offset));
+}
+
+std::string
+attributes::RGB565Attribute::getAttributeNameForJSON() const
+{
+  return "RGB565";
+}
+
+gsl::span<const std::byte>
+attributes::RGB565Attribute::getBinaryDataRange() const
+{
+  const auto begin = reinterpret_cast<std::byte const*>(_rgb565Colors.data());
+  const auto end = begin + vector_byte_size(_rgb565Colors);
+  return { begin, end };
+}
+
+uint32_t
+attributes::RGB565Attribute::getAlignmentRequirement() const
+{
+  return 2u;
+}
+
 #pragma region RGBFromIntensityAttribute
 
 attributes::RGBFromIntensityAttribute::RGBFromIntensityAttribute(MappingType mapping_type)
@@ -582,6 +693,113 @@ attributes::RGBFromIntensityAttribute::getAlignmentRequirement() const
 }
 #pragma endregion
 
+void
+attributes::NormalAttribute::extractFromPoints(const PointBuffer& points)
+{
+  if (!points.count())
+    return;
+  if (!points.hasNormals())
+    return;
+
+  _normals.insert(_normals.end(), points.normals().begin(), points.normals().end());
+}
+
+void
+attributes::NormalAttribute::extractFromPoints(gsl::span<PointBuffer::PointReference> points)
+{
+  if (!points.size())
+    return;
+  if (!points[0].normal())
+    return;
+
+  _normals.reserve(_normals.size() + points.size());
+  std::transform(points.begin(),
+                 points.end(),
+                 std::back_inserter(_normals),
+                 [](const auto& point_reference) -> Vector3<float> {
+                   const auto normal = point_reference.normal();
+                   assert(normal != nullptr);
+                   return *normal;
+                 });
+}
+
+std::string
+attributes::NormalAttribute::getAttributeNameForJSON() const
+{
+  return "NORMAL";
+}
+
+gsl::span<const std::byte>
+attributes::NormalAttribute::getBinaryDataRange() const
+{
+  const auto begin = reinterpret_cast<std::byte const*>(_normals.data());
+  const auto end = begin + vector_byte_size(_normals);
+  return { begin, end };
+}
+
+uint32_t
+attributes::NormalAttribute::getAlignmentRequirement() const
+{
+  return 4u; // Normals are stored as float values
+}
+
+void
+attributes::NormalOct16PAttribute::extractFromPoints(const PointBuffer& points)
+{
+  if (!points.count())
+    return;
+  if (!points.hasNormals())
+    return;
+
+  const auto offset = _encodedNormals.size();
+  _encodedNormals.resize(offset + points.count());
+  encode_normals_oct16p(points.normals(), gsl::make_span(_encodedNormals).subspan(offset));
+}
+
+void
+attributes::NormalOct16PAttribute::extractFromPoints(gsl::span<PointBuffer::PointReference> points)
+{
+  if (!points.size())
+    return;
+  if (!points[0].normal())
+    return;
+
+  std::vector<Vector3<float>> normals;
+  normals.reserve(points.size());
+  std::transform(points.begin(),
+                 points.end(),
+                 std::back_inserter(normals),
+                 [](const auto& point_reference) -> Vector3<float> {
+                   const auto normal = point_reference.normal();
+                   assert(normal != nullptr);
+                   return *normal;
+                 });
+
+  const auto offset = _encodedNormals.size();
+  _encodedNormals.resize(offset + normals.size());
+  encode_normals_oct16p(normals, gsl::make_span(_encodedNormals).subspan(offset));
+}
+
+std::string
+attributes::NormalOct16PAttribute::getAttributeNameForJSON() const
+{
+  return "NORMAL_OCT16P";
+}
+
+gsl::span<const std::byte>
+attributes::NormalOct16PAttribute::getBinaryDataRange() const
+{
+  const auto begin = reinterpret_cast<std::byte const*>(_encodedNormals.data());
+  const auto end = begin + vector_byte_size(_encodedNormals);
+  return { begin, end };
+}
+
+uint32_t
+attributes::NormalOct16PAttribute::getAlignmentRequirement() const
+{
+  return 1u;
+}
+
 void
 attributes::IntensityAttribute::extractFromPoints(const PointBuffer& points)
 {
@@ -590,7 +808,11 @@ attributes::IntensityAttribute::extractFromPoints(const PointBuffer& points)
   if (!points.hasIntensities())
     return;
 
-  _intensities.insert(_intensities.end(), points.intensities().begin(), points.intensities().end());
+  _intensities.reserve(_intensities.size() + points.count());
+  for (const auto intensity : points.intensities()) {
+    _intensities.push_back(intensity);
+    _statistics.add_intensity(intensity);
+  }
 }
 
 void
@@ -605,13 +827,20 @@ attributes::IntensityAttribute::extractFromPoints(gsl::span<PointBuffer::PointRe
   std::transform(points.begin(),
                  points.end(),
                  std::back_inserter(_intensities),
-                 [](const auto& point_reference) -> uint16_t {
+                 [this](const auto& point_reference) -> uint16_t {
                    const auto intensity = point_reference.intensity();
                    assert(intensity != nullptr);
+                   _statistics.add_intensity(*intensity);
                    return *intensity;
                  });
 }
 
+void
+attributes::IntensityAttribute::addStatistics(NodeStatistics& statistics) const
+{
+  statistics.merge(_statistics.statistics());
+}
+
 std::string
 attributes::IntensityAttribute::getAttributeNameForJSON() const
 {
@@ -640,8 +869,11 @@ attributes::ClassificationAttribute::extractFromPoints(const PointBuffer& points
   if (!points.hasClassifications())
     return;
 
-  _classifications.insert(
-    _classifications.end(), points.classifications().begin(), points.classifications().end());
+  _classifications.reserve(_classifications.size() + points.count());
+  for (const auto classification : points.classifications()) {
+    _classifications.push_back(classification);
+    _statistics.add_classification(classification);
+  }
 }
 
 void
@@ -657,13 +889,20 @@ attributes::ClassificationAttribute::extractFromPoints(
   std::transform(points.begin(),
                  points.end(),
                  std::back_inserter(_classifications),
-                 [](const auto& point_reference) -> uint16_t {
+                 [this](const auto& point_reference) -> uint16_t {
                    const auto classification = point_reference.classification();
                    assert(classification != nullptr);
+                   _statistics.add_classification(*classification);
                    return *classification;
                  });
 }
 
+void
+attributes::ClassificationAttribute::addStatistics(NodeStatistics& statistics) const
+{
+  statistics.merge(_statistics.statistics());
+}
+
 std::string
 attributes::ClassificationAttribute::getAttributeNameForJSON() const
 {
@@ -9,8 +9,10 @@
 #include <vector>
 
 #include "datastructures/PointBuffer.h"
+#include "io/PNTSEncoding.h"
 #include "math/AABB.h"
 #include "math/Vector3.h"
+#include "pointcloud/NodeStatistics.h"
 #include "pointcloud/Point.h"
 #include "pointcloud/PointAttributes.h"
 
@@ -53,15 +55,6 @@ struct RGB
   uint8_t G;
   uint8_t B;
 };
-struct NORMAL_OCT16P
-{
-  NORMAL_OCT16P(uint8_t x, uint8_t y)
-    : x(x)
-    , y(y)
-  {}
-  uint8_t x;
-  uint8_t y;
-};
 
 namespace attributes {
 
@@ -95,6 +88,22 @@ struct PointAttributeBase
   /// Returns the number of entries for this attribute
   /// </summary>
   virtual size_t getNumEntries() const = 0;
+  /// <summary>
+  /// Called once after all points have been extracted, before the binary data
+  /// is written. Attributes whose encoding depends on all points (e.g.
+  /// quantized positions) encode their data here
+  /// </summary>
+  virtual void finishExtraction() {}
+  /// <summary>
+  /// Adds the global semantics that this attribute depends on to the JSON
+  /// header of the feature table
+  /// </summary>
+  virtual void addGlobalSemantics(rapidjson::Document&) const {}
+  /// <summary>
+  /// Merges the statistics of the extracted values into 'statistics'.
+  /// Attributes that NodeStatistics covers accumulate them while extracting
+  /// </summary>
+  virtual void addStatistics(NodeStatistics&) const {}
 };
 
 /// <summary>
@@ -123,6 +132,11 @@ private:
   std::vector<Vector3<float>> _positions;
 };
 
+/**
+ * Positions quantized to 16 bits per axis, relative to the bounds of all
+ * positions in the tile. The positions are only quantized once all points have
+ * been extracted, since the bounds are not known before
+ */
 struct PositionQuantizedAttribute : PointAttributeBase
 {
   void extractFromPoints(const PointBuffer& points) override;
@@ -130,10 +144,14 @@ struct PositionQuantizedAttribute : PointAttributeBase
   std::string getAttributeNameForJSON() const override;
   gsl::span<const std::byte> getBinaryDataRange() const override;
   uint32_t getAlignmentRequirement() const override;
-  size_t getNumEntries() const override { return _quantizedPositions.size(); }
+  size_t getNumEntries() const override { return _positions.size(); }
+  void finishExtraction() override;
+  void addGlobalSemantics(rapidjson::Document& jsonHeader) const override;
 
 private:
-  std::vector<NORMAL_OCT16P> _quantizedPositions;
+  std::vector<Vector3<double>> _positions;
+  std::vector<QuantizedPosition> _quantizedPositions;
+  QuantizedVolume _quantizedVolume;
 };
 
 struct RGBAAttribute : PointAttributeBase
@@ -162,6 +180,22 @@ private:
   std::vector<RGB> _rgbColors;
 };
 
+/**
+ * RGB colors with 5 bits for red and blue and 6 bits for green
+ */
+struct RGB565Attribute : PointAttributeBase
+{
+  void extractFromPoints(const PointBuffer& points) override;
+  void extractFromPoints(gsl::span<PointBuffer::PointReference> points) override;
+  std::string getAttributeNameForJSON() const override;
+  gsl::span<const std::byte> getBinaryDataRange() const override;
+  uint32_t getAlignmentRequirement() const override;
+  size_t getNumEntries() const override { return _rgb565Colors.size(); }
+
+private:
+  std::vector<uint16_t> _rgb565Colors;
+};
+
 /**
  * RGB values created from intensity values
  */
@@ -187,6 +221,35 @@ private:
   std::function<RGB(uint16_t)> _mapping_func;
 };
 
+struct NormalAttribute : PointAttributeBase
+{
+  void extractFromPoints(const PointBuffer& points) override;
+  void extractFromPoints(gsl::span<PointBuffer::PointReference> points) override;
+  std::string getAttributeNameForJSON() const override;
+  gsl::span<const std::byte> getBinaryDataRange() const override;
+  uint32_t getAlignmentRequirement() const override;
+  size_t getNumEntries() const override { return _normals.size(); }
+
+private:
+  std::vector<Vector3<float>> _normals;
+};
+
+/**
+ * Normals encoded as two bytes using octahedron encoding
+ */
+struct NormalOct16PAttribute : PointAttributeBase
+{
+  void extractFromPoints(const PointBuffer& points) override;
+  void extractFromPoints(gsl::span<PointBuffer::PointReference> points) override;
+  std::string getAttributeNameForJSON() const override;
+  gsl::span<const std::byte> getBinaryDataRange() const override;
+  uint32_t getAlignmentRequirement() const override;
+  size_t getNumEntries() const override { return _encodedNormals.size(); }
+
+private:
+  std::vector<NORMAL_OCT16P> _encodedNormals;
+};
+
 struct IntensityAttribute : PointAttributeBase
 {
   void extractFromPoints(const PointBuffer& points) override;
@@ -195,9 +258,11 @@ struct IntensityAttribute : PointAttributeBase
   gsl::span<const std::byte> getBinaryDataRange() const override;
   uint32_t getAlignmentRequirement() const override;
   size_t getNumEntries() const override { return _intensities.size(); }
+  void addStatistics(NodeStatistics& statistics) const override;
 
 private:
   std::vector<uint16_t> _intensities;
+  NodeStatisticsAccumulator _statistics;
 };
 
 struct ClassificationAttribute : PointAttributeBase
@@ -208,12 +273,14 @@ struct ClassificationAttribute : PointAttributeBase
   gsl::span<const std::byte> getBinaryDataRange() const override;
   uint32_t getAlignmentRequirement() const override;
   size_t getNumEntries() const override { return _classifications.size(); }
+  void addStatistics(NodeStatistics& statistics) const override;
 
 private:
   std::vector<uint8_t> _classifications;
+  NodeStatisticsAccumulator _statistics;
 };
 
-// FEATURE Implement other point attributes (normals, batch_id etc.)
+// FEATURE Implement other point attributes (batch_id etc.)
 
 } // namespace attributes
 
@@ -237,13 +304,20 @@ class PNTSWriter
 public:
   PNTSWriter(const std::string& filePath,
              const PointAttributes& pointAttributes,
-             RGBMapping rgb_mapping);
+             RGBMapping rgb_mapping,
+             PNTSEncoding encoding = PNTSEncoding::Default);
   ~PNTSWriter();
 
   void write_points(const PointBuffer& points);
 
   void write_points(gsl::span<PointBuffer::PointReference> points);
 
+  /**
+   * Statistics of the attributes of all points written so far. They are
+   * accumulated while the attributes are extracted from the points
+   */
+  NodeStatistics statistics() const;
+
   void flush(const Vector3<double>& localCenter);
 
   void close();
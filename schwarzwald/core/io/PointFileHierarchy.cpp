@@ -0,0 +1,18 @@
+#include "io/PointFileHierarchy.h"
+
+#include <algorithm>
+
+void
+sort_nodes_spatially(std::vector<PointFileNode>& nodes)
+{
+  // OctreeNodeIndex compares nodes by their common levels, so a node and its
+  // descendants are equivalent. Ordering these by their levels puts each node
+  // before its children
+  std::sort(std::begin(nodes), std::end(nodes), [](const auto& l, const auto& r) {
+    if (l.index < r.index)
+      return true;
+    if (r.index < l.index)
+      return false;
+    return l.index.levels() < r.index.levels();
+  });
+}
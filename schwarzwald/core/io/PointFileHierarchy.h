@@ -0,0 +1,46 @@
+#pragma once
+
+#include "datastructures/OctreeNodeIndex.h"
+#include "math/AABB.h"
+
+#include <vector>
+
+/**
+ * A node of the octree of a spatially organized point file
+ */
+struct PointFileNode
+{
+  OctreeNodeIndex64 index;
+  size_t points_count;
+  /**
+   * Index of the first point of the node in the file. Only used by formats that
+   * store all nodes in a single file (COPC)
+   */
+  size_t first_point;
+};
+
+/**
+ * The octree of a spatially organized point file (COPC, EPT). The points of
+ * such a file are read node by node in the order of 'nodes', so that
+ * consecutive points are close to each other
+ */
+struct PointFileHierarchy
+{
+  /**
+   * Cubic bounds of the root node
+   */
+  AABB root_bounds;
+  /**
+   * All nodes that contain points, sorted with 'sort_nodes_spatially'
+   */
+  std::vector<PointFileNode> nodes;
+};
+
+/**
+ * Sorts the given nodes in depth-first order, so that the nodes of each subtree
+ * are consecutive and each node comes before its children. Reading the nodes in
+ * this order yields points from few subtrees at a time, except for the few
+ * nodes at the top of the octree
+ */
+void
+sort_nodes_spatially(std::vector<PointFileNode>& nodes);
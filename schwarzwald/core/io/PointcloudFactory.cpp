@@ -8,9 +8,24 @@ open_point_file(const std::experimental::filesystem::path &path) {
   const auto extension_as_lower =
       boost::algorithm::to_lower_copy(path.extension().string());
 
+  if (is_ept_dataset(path)) {
+    try {
+      return {PointFile{EPTFile{path}}};
+    } catch (const std::exception &ex) {
+      const auto reason =
+          (boost::format("Could not open EPT dataset %1%") % path.string())
+              .str();
+      return tl::make_unexpected(util::chain_error(ex, reason));
+    }
+  }
+
   if (extension_as_lower == ".las" || extension_as_lower == ".laz") {
     try {
-      return {PointFile{LASFile{path, LASFile::OpenMode::Read}}};
+      LASFile las_file{path, LASFile::OpenMode::Read};
+      if (is_copc_file(las_file.get_metadata())) {
+        return {PointFile{COPCFile{std::move(las_file)}}};
+      }
+      return {PointFile{std::move(las_file)}};
     } catch (const std::exception &ex) {
       const auto reason =
           (boost::format("Could not open file %1%") % path.string()).str();
@@ -35,4 +50,29 @@ bool file_format_is_supported(const std::string &format) {
                       [&format_as_lower](auto supported_format) {
                         return format_as_lower == supported_format;
                       }) != std::end(SUPPORTED_FORMATS);
-}
\ No newline at end of file
+}
+
+std::vector<std::experimental::filesystem::path>
+find_source_files_in_directory(const std::experimental::filesystem::path &directory) {
+  if (fs::is_regular_file(directory / "ept.json")) {
+    return {directory / "ept.json"};
+  }
+
+  std::vector<fs::path> source_files;
+  fs::recursive_directory_iterator directory_iter{directory};
+  for (; directory_iter != fs::recursive_directory_iterator{};
+       directory_iter++) {
+    const auto &dir_entry = directory_iter->path();
+    if (fs::is_directory(dir_entry) &&
+        fs::is_regular_file(dir_entry / "ept.json")) {
+      source_files.push_back(dir_entry / "ept.json");
+      directory_iter.disable_recursion_pending();
+      continue;
+    }
+    if (!fs::is_regular_file(dir_entry))
+      continue;
+
+    source_files.push_back(dir_entry);
+  }
+  return source_files;
+}
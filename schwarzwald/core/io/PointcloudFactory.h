@@ -1,5 +1,7 @@
 #pragma once
 
+#include "COPCFile.h"
+#include "EPTFile.h"
 #include "LASFile.h"
 #include "util/Error.h"
 
@@ -7,17 +9,63 @@
 #include <experimental/filesystem>
 #include <system_error>
 #include <variant>
+#include <vector>
 
-using PointFile = std::variant<LASFile>; // and more files
+using PointFile = std::variant<LASFile, COPCFile, EPTFile>; // and more files
+
+namespace detail {
+template<typename PointFileVariant>
+struct PointFileCursorFor;
+
+template<typename... Files>
+struct PointFileCursorFor<std::variant<Files...>>
+{
+  using type = std::variant<typename Files::const_iterator...>;
+};
+} // namespace detail
+
+/**
+ * Read position in a PointFile, i.e. the const_iterator of one of the types of
+ * PointFile. A cursor always has the iterator type of the file that it belongs
+ * to (see 'visit_with_cursor')
+ */
+using PointFileCursor = typename detail::PointFileCursorFor<PointFile>::type;
 
 /**
- * Open the given pointcloud file
+ * Calls 'visitor' with the typed file of the given PointFile and the typed
+ * cursor of that file
+ */
+template<typename Cursor, typename Visitor>
+decltype(auto)
+visit_with_cursor(const PointFile& point_file, Cursor& cursor, Visitor&& visitor)
+{
+  return std::visit(
+    [&cursor, &visitor](const auto& typed_file) -> decltype(auto) {
+      using File = std::decay_t<decltype(typed_file)>;
+      return visitor(typed_file, std::get<typename File::const_iterator>(cursor));
+    },
+    point_file);
+}
+
+/**
+ * Open the given pointcloud file. LAS/LAZ files with a COPC hierarchy are
+ * opened as COPCFile, 'ept.json' files as EPTFile
  */
 tl::expected<PointFile, util::ErrorChain>
 open_point_file(const std::experimental::filesystem::path &path);
 
 /**
  * Returns true if the given file format (as returned by
- * std::filesystem::path::extension()) is valid or not
+ * std::filesystem::path::extension()) is valid or not. EPT datasets are
+ * recognized by their file name instead, see 'is_ept_dataset'
+ */
+bool file_format_is_supported(const std::string &format);
+
+/**
+ * Returns all files in the given directory and its subdirectories that can be
+ * sources of the tiler. An EPT dataset is a single source, so for a directory
+ * that contains an 'ept.json' file, only that file is returned and the node
+ * files of the dataset are not
  */
-bool file_format_is_supported(const std::string &format);
\ No newline at end of file
+std::vector<std::experimental::filesystem::path>
+find_source_files_in_directory(const std::experimental::filesystem::path &directory);
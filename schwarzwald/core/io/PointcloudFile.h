@@ -35,6 +35,14 @@ template<typename File>
 AABB
 get_bounds(File const& f);
 
+/**
+ * Bounds of all points in the file, calculated from the points themselves
+ * instead of the file header. This reads all points of the file
+ */
+template<typename File>
+AABB
+get_exact_bounds(File const& f);
+
 template<typename File>
 Vector3<double>
 get_offset(File const& f);
@@ -47,6 +55,20 @@ template<typename File>
 bool
 has_attribute(File const& f, PointAttribute const& attribute);
 
+/**
+ * Size of a single point record in the file, in bytes
+ */
+template<typename File>
+uint32_t
+get_point_record_length(File const& f);
+
+/**
+ * Is the point data in the file compressed?
+ */
+template<typename File>
+bool
+is_compressed(File const& f);
+
 template<typename File, typename OutIter>
 bool
 has_all_attributes(File const& f,
@@ -95,6 +117,13 @@ get_bounds(std::variant<FileTypes...> const& f)
   return std::visit([](auto& typed_file) { return get_bounds(typed_file); }, f);
 }
 
+template<typename... FileTypes>
+AABB
+get_exact_bounds(std::variant<FileTypes...> const& f)
+{
+  return std::visit([](auto& typed_file) { return get_exact_bounds(typed_file); }, f);
+}
+
 template<typename... FileTypes>
 Vector3<double>
 get_offset(std::variant<FileTypes...> const& f)
@@ -109,6 +138,20 @@ get_point_count(std::variant<FileTypes...> const& f)
   return std::visit([](auto& typed_file) { return get_point_count(typed_file); }, f);
 }
 
+template<typename... FileTypes>
+uint32_t
+get_point_record_length(std::variant<FileTypes...> const& f)
+{
+  return std::visit([](auto& typed_file) { return get_point_record_length(typed_file); }, f);
+}
+
+template<typename... FileTypes>
+bool
+is_compressed(std::variant<FileTypes...> const& f)
+{
+  return std::visit([](auto& typed_file) { return is_compressed(typed_file); }, f);
+}
+
 template<typename... FileTypes>
 bool
 has_attribute(std::variant<FileTypes...> const& f, PointAttribute const& attribute)
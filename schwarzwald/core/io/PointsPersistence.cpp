@@ -8,8 +8,10 @@ make_persistence(OutputFormat format,
                  const PointAttributes& input_attributes,
                  const PointAttributes& output_attributes,
                  RGBMapping rgb_mapping,
+                 PNTSEncoding pnts_encoding,
                  float spacing,
-                 const AABB& bounds)
+                 const AABB& bounds,
+                 const std::optional<AABB>& bounding_volume_limits)
 {
   switch (format) {
     case OutputFormat::BIN:
@@ -24,7 +26,20 @@ make_persistence(OutputFormat format,
                                                           output_attributes,
                                                           rgb_mapping,
                                                           spacing,
-                                                          bounds.getCenter() } };
+                                                          bounds.getCenter(),
+                                                          pnts_encoding,
+                                                          TileContentFormat::PNTS,
+                                                          bounding_volume_limits } };
+    case OutputFormat::CZM_3DTILES_GLB:
+      return PointsPersistence{ Cesium3DTilesPersistence{ output_directory,
+                                                          input_attributes,
+                                                          output_attributes,
+                                                          rgb_mapping,
+                                                          spacing,
+                                                          bounds.getCenter(),
+                                                          PNTSEncoding::Default,
+                                                          TileContentFormat::GLB,
+                                                          bounding_volume_limits } };
     case OutputFormat::LAS:
       return PointsPersistence{ LASPersistence{
         output_directory, input_attributes, output_attributes } };
@@ -42,6 +57,25 @@ make_persistence(OutputFormat format,
   }
 }
 
+PointsPersistence
+make_staging_persistence(PointsPersistence persistence,
+                         const PointAttributes& input_attributes,
+                         std::optional<unit::byte> memory_budget,
+                         uint32_t thread_count,
+                         PointOrder point_order,
+                         std::shared_ptr<AttributeStore> attribute_store)
+{
+  if (!memory_budget)
+    return persistence;
+  return PointsPersistence{ StagingPersistence{
+    std::make_unique<PointsPersistence>(std::move(persistence)),
+    input_attributes,
+    *memory_budget,
+    thread_count,
+    point_order,
+    std::move(attribute_store) } };
+}
+
 PointAttributes
 supported_output_attributes_for_format(OutputFormat format)
 {
@@ -49,6 +83,7 @@ supported_output_attributes_for_format(OutputFormat format)
     case OutputFormat::BIN:
       return BinaryPersistence::supported_output_attributes();
     case OutputFormat::CZM_3DTILES:
+    case OutputFormat::CZM_3DTILES_GLB:
       return Cesium3DTilesPersistence::supported_output_attributes();
     case OutputFormat::ENTWINE_LAS:
     case OutputFormat::ENTWINE_LAZ:
@@ -7,6 +7,7 @@
 #include "EntwinePersistence.h"
 #include "LASPersistence.h"
 #include "MemoryPersistence.h"
+#include "StagingPersistence.h"
 
 struct PointsPersistence
 {
@@ -52,6 +53,40 @@ struct PointsPersistence
     return std::visit([&](auto& impl) { return impl.is_lossless(); }, _impl);
   }
 
+  /**
+   * Does this persistence bring the points of each node into the point order of
+   * the output itself? Only the StagingPersistence does, when it encodes the
+   * staged nodes
+   */
+  inline bool applies_point_order() const
+  {
+    return std::holds_alternative<StagingPersistence>(_impl);
+  }
+
+  /**
+   * Returns the merged attribute statistics of all nodes that have been
+   * persisted so far
+   */
+  inline NodeStatistics dataset_statistics() const
+  {
+    return std::visit([&](auto& impl) { return impl.dataset_statistics(); }, _impl);
+  }
+
+  /**
+   * Writes all nodes that are still staged in memory to their final location
+   * and updates the files that list the nodes (the EPT hierarchy). Only the
+   * StagingPersistence holds back nodes and only the EntwinePersistence writes
+   * such files, for all other persistences this does nothing
+   */
+  inline void flush()
+  {
+    if (auto staging_persistence = std::get_if<StagingPersistence>(&_impl)) {
+      staging_persistence->flush();
+    } else if (auto entwine_persistence = std::get_if<EntwinePersistence>(&_impl)) {
+      entwine_persistence->write_hierarchy();
+    }
+  }
+
   template<typename T>
   T& get()
   {
@@ -69,13 +104,15 @@ private:
                Cesium3DTilesPersistence,
                LASPersistence,
                MemoryPersistence,
-               EntwinePersistence>
+               EntwinePersistence,
+               StagingPersistence>
     _impl;
 };
 
 /**
  * Factory function for creating a PointsPersistence for the given format and
- * parameters
+ * parameters. 'bounding_volume_limits' are only used by the 3D Tiles formats,
+ * see 'Cesium3DTilesPersistence'
  */
 PointsPersistence
 make_persistence(OutputFormat format,
@@ -83,8 +120,24 @@ make_persistence(OutputFormat format,
                  const PointAttributes& input_attributes,
                  const PointAttributes& output_attributes,
                  RGBMapping rgb_mapping,
+                 PNTSEncoding pnts_encoding,
                  float spacing,
-                 const AABB& bounds);
+                 const AABB& bounds,
+                 const std::optional<AABB>& bounding_volume_limits = std::nullopt);
+
+/**
+ * Stages the nodes of the given persistence in memory using up to 'memory_budget'
+ * bytes, see 'StagingPersistence'. The staged nodes are encoded with 'thread_count'
+ * threads and in the given point order. Without a memory budget, the given
+ * persistence is returned as is
+ */
+PointsPersistence
+make_staging_persistence(PointsPersistence persistence,
+                         const PointAttributes& input_attributes,
+                         std::optional<unit::byte> memory_budget,
+                         uint32_t thread_count,
+                         PointOrder point_order,
+                         std::shared_ptr<AttributeStore> attribute_store = nullptr);
 
 /**
  * Returns the set of point attributes supported by the given output format
@@ -0,0 +1,369 @@
+#include "io/StagingPersistence.h"
+
+#include "io/AttributeStore.h"
+#include "io/PointsPersistence.h"
+#include "threading/Parallel.h"
+
+#include <taskflow/taskflow.hpp>
+
+constexpr size_t NUM_SHARDS = 64;
+
+StagingPersistence::StagingPersistence(std::unique_ptr<PointsPersistence> backend,
+                                       const PointAttributes& input_attributes,
+                                       unit::byte memory_budget,
+                                       uint32_t thread_count,
+                                       PointOrder point_order,
+                                       std::shared_ptr<AttributeStore> attribute_store)
+  : _backend(std::move(backend))
+  , _input_attributes(input_attributes)
+  , _attribute_store(std::move(attribute_store))
+  , _memory_budget(static_cast<size_t>(memory_budget.value()))
+  , _thread_count(std::max(1u, thread_count))
+  , _point_order(point_order)
+  , _counters(std::make_unique<Counters>())
+{
+  if (!_backend) {
+    throw std::invalid_argument{ "StagingPersistence requires a backend persistence" };
+  }
+
+  std::copy_if(std::begin(_input_attributes),
+               std::end(_input_attributes),
+               std::inserter(_staged_attributes, std::end(_staged_attributes)),
+               [this](PointAttribute attribute) {
+                 return !_attribute_store ||
+                        !has_attribute(_attribute_store->deferred_attributes(), attribute);
+               });
+
+  _shards.reserve(NUM_SHARDS);
+  for (size_t idx = 0; idx < NUM_SHARDS; ++idx) {
+    _shards.push_back(std::make_unique<Shard>());
+  }
+}
+
+StagingPersistence::~StagingPersistence()
+{
+  // Moved-from instances have no backend
+  if (_backend) {
+    flush();
+  }
+}
+
+StagingPersistence::StagingPersistence(StagingPersistence&&) = default;
+
+StagingPersistence&
+StagingPersistence::operator=(StagingPersistence&& other)
+{
+  // Staged nodes must not get lost when this persistence is overwritten
+  if (_backend) {
+    flush();
+  }
+
+  _backend = std::move(other._backend);
+  _input_attributes = std::move(other._input_attributes);
+  _attribute_store = std::move(other._attribute_store);
+  _staged_attributes = std::move(other._staged_attributes);
+  _memory_budget = other._memory_budget;
+  _thread_count = other._thread_count;
+  _point_order = other._point_order;
+  _shards = std::move(other._shards);
+  _counters = std::move(other._counters);
+  return *this;
+}
+
+void
+StagingPersistence::persist_points(PointBuffer const& points,
+                                   const AABB& bounds,
+                                   const std::string& node_name)
+{
+  stage_node(points, bounds, node_name);
+}
+
+void
+StagingPersistence::retrieve_points(const std::string& node_name, PointBuffer& points)
+{
+  auto& shard = shard_for(node_name);
+  {
+    std::unique_lock shard_lock{ shard.lock };
+    shard.wait_until_not_spilling(shard_lock, node_name);
+    const auto staged_node = shard.nodes.find(node_name);
+    if (staged_node != std::end(shard.nodes)) {
+      staged_node->second.last_access = _counters->access_clock++;
+      points = staged_node->second.points;
+      points.make_positions_global();
+      points.apply_schema(_staged_attributes);
+      return;
+    }
+  }
+
+  // Nodes are written to the backend before they are removed from their shard,
+  // so a node that is not staged is either spilled or does not exist
+  _backend->retrieve_points(node_name, points);
+  if (!_attribute_store || points.empty())
+    return;
+
+  // The deferred attributes of spilled nodes are still in the store, so the
+  // points only need their IDs back
+  {
+    std::lock_guard _{ shard.lock };
+    const auto spilled_point_ids = shard.spilled_point_ids.find(node_name);
+    if (spilled_point_ids != std::end(shard.spilled_point_ids) &&
+        spilled_point_ids->second.size() == points.count()) {
+      points.apply_schema(_staged_attributes);
+      points.assign_point_ids(0);
+      std::copy(std::begin(spilled_point_ids->second),
+                std::end(spilled_point_ids->second),
+                points.point_ids().begin());
+      return;
+    }
+  }
+
+  // Nodes that were written by 'flush' have all their attributes, so their
+  // deferred attributes are stored again to get IDs for their points
+  _attribute_store->store(points);
+}
+
+bool
+StagingPersistence::node_exists(const std::string& node_name) const
+{
+  auto& shard = shard_for(node_name);
+  {
+    std::unique_lock shard_lock{ shard.lock };
+    shard.wait_until_not_spilling(shard_lock, node_name);
+    if (shard.nodes.find(node_name) != std::end(shard.nodes))
+      return true;
+  }
+  return _backend->node_exists(node_name);
+}
+
+bool
+StagingPersistence::is_lossless() const
+{
+  return _backend->is_lossless();
+}
+
+NodeStatistics
+StagingPersistence::dataset_statistics() const
+{
+  return _backend->dataset_statistics();
+}
+
+void
+StagingPersistence::flush()
+{
+  std::vector<std::pair<std::string, StagedNode>> staged_nodes;
+  for (auto& shard : _shards) {
+    std::unique_lock shard_lock{ shard->lock };
+    shard->spill_finished.wait(shard_lock, [&shard] { return shard->spilling_nodes.empty(); });
+    for (auto& entry : shard->nodes) {
+      staged_nodes.emplace_back(entry.first, std::move(entry.second));
+    }
+    shard->nodes.clear();
+    shard->spilled_point_ids.clear();
+  }
+  _counters->staged_bytes = 0;
+
+  if (!staged_nodes.empty()) {
+    // Each node is encoded exactly once, so this is where all the work of the
+    // backend happens
+    tf::Taskflow taskflow;
+    parallel::for_each(
+      std::begin(staged_nodes),
+      std::end(staged_nodes),
+      [this](auto& staged_node) {
+        apply_point_order(staged_node.second);
+        write_to_backend(staged_node.second, staged_node.first);
+      },
+      taskflow,
+      _thread_count);
+
+    tf::Executor executor{ _thread_count };
+    executor.run(taskflow).wait();
+  }
+
+  // Spilled nodes are written to the backend without a flush, so the backend is
+  // flushed even if no nodes were staged
+  _backend->flush();
+}
+
+size_t
+StagingPersistence::staged_bytes() const
+{
+  return _counters->staged_bytes;
+}
+
+StagingPersistence::Shard&
+StagingPersistence::shard_for(const std::string& node_name) const
+{
+  return *_shards[std::hash<std::string>{}(node_name) % _shards.size()];
+}
+
+void
+StagingPersistence::stage_node(PointBuffer points,
+                               const AABB& bounds,
+                               const std::string& node_name)
+{
+  // Staged nodes are stored relative to their bounds, which halves the memory
+  // of their positions. This is only done for lossy backends, as lossless
+  // backends have to reproduce the exact positions
+  if (!_backend->is_lossless() && PointBuffer::local_positions_are_precise(bounds.extent())) {
+    points.make_positions_local(bounds.min);
+  }
+
+  const auto byte_size = points.content_byte_size();
+
+  auto& shard = shard_for(node_name);
+  {
+    std::unique_lock shard_lock{ shard.lock };
+    // Otherwise the finished spill would record the point IDs of the old node
+    shard.wait_until_not_spilling(shard_lock, node_name);
+    auto& staged_node = shard.nodes[node_name];
+    // Nodes are overwritten, just like the files of the backends
+    const auto spilled_point_ids = shard.spilled_point_ids.find(node_name);
+    if (spilled_point_ids != std::end(shard.spilled_point_ids)) {
+      _counters->staged_bytes -= spilled_point_ids->second.size() * sizeof(uint64_t);
+      shard.spilled_point_ids.erase(spilled_point_ids);
+    }
+    _counters->staged_bytes -= staged_node.byte_size;
+    staged_node.points = std::move(points);
+    staged_node.bounds = bounds;
+    staged_node.byte_size = byte_size;
+    staged_node.last_access = _counters->access_clock++;
+    _counters->staged_bytes += byte_size;
+  }
+
+  evict_until_within_budget();
+}
+
+size_t
+StagingPersistence::resident_bytes() const
+{
+  return _counters->staged_bytes +
+         (_attribute_store ? _attribute_store->resident_bytes() : size_t{ 0 });
+}
+
+void
+StagingPersistence::evict_until_within_budget()
+{
+  // The deferred attributes are only read once more, when their nodes are
+  // written, while staged nodes are read and rewritten many times. So the
+  // attributes are spilled first
+  if (_attribute_store) {
+    const auto current_bytes = resident_bytes();
+    if (current_bytes > _memory_budget) {
+      _attribute_store->spill(current_bytes - _memory_budget);
+    }
+  }
+
+  // Shards are evicted round-robin, which approximates a global LRU order
+  // without having to lock all shards at once
+  size_t empty_shards_in_a_row = 0;
+  while (resident_bytes() > _memory_budget + _counters->claimed_eviction_bytes &&
+         empty_shards_in_a_row < _shards.size()) {
+    auto& shard = *_shards[_counters->next_shard_to_evict++ % _shards.size()];
+    if (evict_from_shard(shard)) {
+      empty_shards_in_a_row = 0;
+    } else {
+      ++empty_shards_in_a_row;
+    }
+  }
+}
+
+bool
+StagingPersistence::evict_from_shard(Shard& shard)
+{
+  decltype(shard.nodes)::node_type evicted_node;
+  {
+    std::lock_guard _{ shard.lock };
+    if (shard.nodes.empty())
+      return false;
+
+    const auto least_recently_used =
+      std::min_element(std::begin(shard.nodes), std::end(shard.nodes), [](const auto& l, const auto& r) {
+        return l.second.last_access < r.second.last_access;
+      });
+
+    // Concurrent evictions see the same excess over the budget, so each one
+    // claims the bytes that it frees. A node is only spilled if the excess
+    // remains after all claims
+    const auto byte_size = least_recently_used->second.byte_size;
+    auto claimed_bytes = _counters->claimed_eviction_bytes.load();
+    do {
+      if (resident_bytes() <= _memory_budget + claimed_bytes)
+        return false;
+    } while (!_counters->claimed_eviction_bytes.compare_exchange_weak(claimed_bytes,
+                                                                      claimed_bytes + byte_size));
+
+    shard.spilling_nodes.insert(least_recently_used->first);
+    evicted_node = shard.nodes.extract(least_recently_used);
+  }
+
+  const auto& node_name = evicted_node.key();
+  auto& staged_node = evicted_node.mapped();
+  const auto finish_spill = [&](std::vector<uint64_t>* spilled_point_ids) {
+    {
+      std::lock_guard _{ shard.lock };
+      if (spilled_point_ids) {
+        _counters->staged_bytes += spilled_point_ids->size() * sizeof(uint64_t);
+        shard.spilled_point_ids[node_name] = std::move(*spilled_point_ids);
+      }
+      shard.spilling_nodes.erase(node_name);
+    }
+    // The bytes leave 'staged_bytes' before their claim is released, so that
+    // other evictions never see them as excess
+    _counters->staged_bytes -= staged_node.byte_size;
+    _counters->claimed_eviction_bytes -= staged_node.byte_size;
+    shard.spill_finished.notify_all();
+  };
+
+  // The encoding is the expensive part of spilling, so it happens without
+  // holding the lock of the shard. Only accesses to this node wait for it
+  try {
+    // The point IDs are kept in the order in which the points are written, so
+    // that reading the node back finds the deferred attributes that are already
+    // in the store
+    apply_point_order(staged_node);
+    std::vector<uint64_t> spilled_point_ids;
+    const auto keep_point_ids = _attribute_store && staged_node.points.has_point_ids();
+    if (keep_point_ids) {
+      const auto point_ids = staged_node.points.point_ids();
+      spilled_point_ids.assign(point_ids.begin(), point_ids.end());
+    }
+
+    write_to_backend(staged_node, node_name);
+    finish_spill(keep_point_ids ? &spilled_point_ids : nullptr);
+  } catch (...) {
+    // The node is lost, but threads that wait for it must not block forever
+    finish_spill(nullptr);
+    throw;
+  }
+  return true;
+}
+
+void
+StagingPersistence::Shard::wait_until_not_spilling(std::unique_lock<std::mutex>& shard_lock,
+                                                   const std::string& node_name)
+{
+  spill_finished.wait(shard_lock, [&] { return spilling_nodes.count(node_name) == 0; });
+}
+
+void
+StagingPersistence::apply_point_order(StagedNode& staged_node) const
+{
+  auto& points = staged_node.points;
+  points.make_positions_global();
+  if (_point_order == PointOrder::Morton)
+    return;
+
+  std::vector<PointBuffer::PointReference> ordered_points{ std::begin(points), std::end(points) };
+  order_points_in_node(ordered_points, staged_node.bounds, _point_order);
+  points = PointBuffer{ gsl::make_span(ordered_points) };
+}
+
+void
+StagingPersistence::write_to_backend(StagedNode& staged_node, const std::string& node_name)
+{
+  if (_attribute_store) {
+    _attribute_store->gather(staged_node.points);
+  }
+  _backend->persist_points(staged_node.points, staged_node.bounds, node_name);
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include "datastructures/PointBuffer.h"
+#include "math/AABB.h"
+#include "pointcloud/NodeStatistics.h"
+#include "pointcloud/PointAttributes.h"
+#include "tiling/PointOrder.h"
+#include "types/Units.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+struct AttributeStore;
+struct PointsPersistence;
+
+/**
+ * Persistence that stages nodes in memory and writes each node to a backend
+ * persistence (e.g. LAS or 3D Tiles) only once. During tiling, nodes are
+ * written, read back and rewritten many times, which is cheap in memory but
+ * expensive for the file formats of the backends.
+ *
+ * The staged nodes are distributed over a number of shards with separate locks,
+ * so that concurrent tiling tasks rarely contend. If the staged nodes exceed
+ * the memory budget, the least recently used nodes of a shard are spilled to
+ * the backend. Spilled nodes are encoded outside of the lock of their shard,
+ * only accesses to the node that is being spilled wait for it. Calling 'flush'
+ * encodes all remaining nodes to the backend in parallel, using 'thread_count'
+ * threads.
+ *
+ * Nodes are staged in the Morton order that tiling works on, so reading them
+ * back does not have to sort them again. Only the points that are written to
+ * the backend are brought into 'point_order'.
+ *
+ * With an AttributeStore, the staged nodes only contain the attributes that
+ * tiling needs and the IDs of their points. The deferred attributes are
+ * gathered from the store right before a node is written to the backend. The
+ * attributes in memory of the store count towards the memory budget and are
+ * spilled before any staged nodes. Spilled nodes keep the IDs of their points,
+ * so reading them back does not store their attributes again
+ */
+struct StagingPersistence
+{
+  StagingPersistence(std::unique_ptr<PointsPersistence> backend,
+                     const PointAttributes& input_attributes,
+                     unit::byte memory_budget,
+                     uint32_t thread_count,
+                     PointOrder point_order,
+                     std::shared_ptr<AttributeStore> attribute_store = nullptr);
+  ~StagingPersistence();
+
+  StagingPersistence(const StagingPersistence&) = delete;
+  StagingPersistence(StagingPersistence&&);
+  StagingPersistence& operator=(const StagingPersistence&) = delete;
+  StagingPersistence& operator=(StagingPersistence&&);
+
+  template<typename Iter>
+  void persist_points(Iter points_begin,
+                      Iter points_end,
+                      const AABB& bounds,
+                      const std::string& node_name)
+  {
+    // Copies all attributes column by column, instead of pushing each point
+    // into the staged buffer
+    std::vector<PointBuffer::PointReference> point_references{ points_begin, points_end };
+    stage_node(PointBuffer{ gsl::make_span(point_references) }, bounds, node_name);
+  }
+
+  void persist_points(PointBuffer const& points, const AABB& bounds, const std::string& node_name);
+
+  void retrieve_points(const std::string& node_name, PointBuffer& points);
+
+  bool node_exists(const std::string& node_name) const;
+
+  /**
+   * Spilled nodes are read back from the backend, so this is only lossless if
+   * the backend is lossless
+   */
+  bool is_lossless() const;
+
+  /**
+   * Statistics of the backend. These are only complete after calling 'flush'
+   */
+  NodeStatistics dataset_statistics() const;
+
+  /**
+   * Writes all staged nodes to the backend in parallel, clears the staging area
+   * and flushes the backend. This is called automatically on destruction, but
+   * has to be called explicitly before accessing 'dataset_statistics'
+   */
+  void flush();
+
+  /**
+   * Number of bytes of all currently staged nodes
+   */
+  size_t staged_bytes() const;
+
+private:
+  struct StagedNode
+  {
+    PointBuffer points;
+    AABB bounds;
+    size_t byte_size = 0;
+    uint64_t last_access = 0;
+  };
+
+  struct Shard
+  {
+    std::mutex lock;
+    std::unordered_map<std::string, StagedNode> nodes;
+    /**
+     * Point IDs of the nodes that were spilled to the backend, in the order in
+     * which the points were written
+     */
+    std::unordered_map<std::string, std::vector<uint64_t>> spilled_point_ids;
+    /**
+     * Names of the nodes that are currently written to the backend by an
+     * eviction. These nodes are neither in 'nodes' nor complete in the backend
+     */
+    std::unordered_set<std::string> spilling_nodes;
+    std::condition_variable spill_finished;
+
+    /**
+     * Waits until the given node is not being spilled, so that it is either
+     * staged or in the backend
+     */
+    void wait_until_not_spilling(std::unique_lock<std::mutex>& shard_lock,
+                                 const std::string& node_name);
+  };
+
+  struct Counters
+  {
+    std::atomic<size_t> staged_bytes;
+    std::atomic<uint64_t> access_clock;
+    std::atomic<size_t> next_shard_to_evict;
+    /**
+     * Bytes of the nodes that are currently being spilled. These still count
+     * towards 'staged_bytes', but are already on their way out of memory
+     */
+    std::atomic<size_t> claimed_eviction_bytes;
+  };
+
+  Shard& shard_for(const std::string& node_name) const;
+  void stage_node(PointBuffer points, const AABB& bounds, const std::string& node_name);
+  /**
+   * Number of bytes that count towards the memory budget
+   */
+  size_t resident_bytes() const;
+  void evict_until_within_budget();
+  /**
+   * Spills the least recently used node of the given shard to the backend.
+   * Returns false if the shard has no nodes or if the nodes that other threads
+   * are spilling already free enough memory
+   */
+  bool evict_from_shard(Shard& shard);
+  /**
+   * Brings the points of the given node from the Morton order in which they are
+   * staged into the point order of the output, with global positions
+   */
+  void apply_point_order(StagedNode& staged_node) const;
+  /**
+   * Writes the given node to the backend, after 'apply_point_order'
+   */
+  void write_to_backend(StagedNode& staged_node, const std::string& node_name);
+
+  std::unique_ptr<PointsPersistence> _backend;
+  PointAttributes _input_attributes;
+  std::shared_ptr<AttributeStore> _attribute_store;
+  /**
+   * Attributes of the points that are staged and retrieved, i.e. the input
+   * attributes without the deferred attributes
+   */
+  PointAttributes _staged_attributes;
+  size_t _memory_budget;
+  uint32_t _thread_count;
+  PointOrder _point_order;
+
+  std::vector<std::unique_ptr<Shard>> _shards;
+  std::unique_ptr<Counters> _counters;
+};
@@ -65,6 +65,16 @@ static Value write_tileset(const Tileset &tileset, Alloc &alloc,
   content.AddMember("uri", content_uri, alloc);
   root.AddMember("content", content, alloc);
 
+  // Attribute statistics of the tile content, so that clients can skip tiles
+  // without fetching them. Tiles that reference external tilesets have the
+  // statistics in the root tile of the external tileset
+  if (remaining_levels != 0 && !tileset.statistics.empty()) {
+    Value extras{kObjectType};
+    extras.AddMember("statistics",
+                     node_statistics_to_json(tileset.statistics, alloc), alloc);
+    root.AddMember("extras", extras, alloc);
+  }
+
   // Write children, if there are any. Skip writing children if at max level
   if (tileset.children.empty() || remaining_levels == 0)
     return root;
@@ -23,50 +23,44 @@ PointSource::read_next(size_t count, const PointAttributes& attributes)
   if (!_current_file)
     return std::nullopt;
 
-  return std::visit(
-    [this, count, &attributes](auto& typed_file) -> std::optional<PointBuffer> {
-      const auto& metadata = pc::metadata(typed_file);
-      auto point_buffer = std::visit(
-        [this, count, &attributes, &typed_file, &metadata](
-          auto& typed_file_cursor) -> PointBuffer {
-          PointBuffer point_buffer;
-          try {
-            typed_file_cursor = pc::read_points(
-              typed_file_cursor, count, metadata, attributes, point_buffer);
-          } catch (const std::exception& ex) {
-            if (_errors_to_ignore & util::IgnoreErrors::CorruptedFiles) {
-              // Drop this file, move on to next file
-              util::write_log((boost::format("Could not read points from "
-                                             "file %1%\n\tcaused by: %2%\n") %
-                               _file_cursor->string() % ex.what())
-                                .str());
-              typed_file_cursor = std::cend(typed_file);
-            } else {
-              throw util::chain_error(
-                ex,
-                (boost::format("Could not read points from file %1%") %
-                 _file_cursor->string())
-                  .str());
-            }
-          }
+  auto point_buffer = visit_with_cursor(
+    *_current_file,
+    *_current_file_cursor,
+    [this, count, &attributes](const auto& typed_file, auto& typed_file_cursor) -> PointBuffer {
+      PointBuffer point_buffer;
+      try {
+        typed_file_cursor = pc::read_points(
+          typed_file_cursor, count, pc::metadata(typed_file), attributes, point_buffer);
+      } catch (const std::exception& ex) {
+        if (_errors_to_ignore & util::IgnoreErrors::CorruptedFiles) {
+          // Drop this file, move on to next file
+          util::write_log((boost::format("Could not read points from "
+                                         "file %1%\n\tcaused by: %2%\n") %
+                           _file_cursor->string() % ex.what())
+                            .str());
+          typed_file_cursor = std::cend(typed_file);
+        } else {
+          throw util::chain_error(
+            ex,
+            (boost::format("Could not read points from file %1%") % _file_cursor->string())
+              .str());
+        }
+      }
 
-          // If at end of current file, move to next file
-          if (typed_file_cursor == std::cend(typed_file)) {
-            move_to_next_file();
-          }
+      // If at end of current file, move to next file
+      if (typed_file_cursor == std::cend(typed_file)) {
+        move_to_next_file();
+      }
 
-          return point_buffer;
-        },
-        *_current_file_cursor);
+      return point_buffer;
+    });
 
-      // Apply all transformations
-      for (auto& transformation : _transformations) {
-        transformation(point_buffer);
-      }
+  // Apply all transformations
+  for (auto& transformation : _transformations) {
+    transformation(point_buffer);
+  }
 
-      return { std::move(point_buffer) };
-    },
-    *_current_file);
+  return { std::move(point_buffer) };
 }
 
 void
@@ -83,13 +77,13 @@ PointSource::try_open_file(std::vector<fs::path>::const_iterator file_cursor)
 
   return open_point_file(*file_cursor)
     .map([this](PointFile point_file) mutable {
-      return std::visit(
-        [this](auto& typed_file) mutable {
-          _current_file_cursor = { std::cbegin(typed_file) };
-          _current_file = { std::move(typed_file) };
-          return true;
-        },
-        point_file);
+      // The cursor is created once the file is at its final location, since
+      // the cursors of some file types refer to their file
+      _current_file = std::move(point_file);
+      _current_file_cursor = std::visit(
+        [](const auto& typed_file) -> PointFileCursor { return std::cbegin(typed_file); },
+        *_current_file);
+      return true;
     })
     .or_else([this](const util::ErrorChain& error_chain) {
       if (_errors_to_ignore & util::IgnoreErrors::InaccessibleFiles) {
@@ -336,15 +330,12 @@ bool
 MultiReaderPointSource::point_file_entry_is_at_end(
   const PointFileEntry& point_file_entry) const
 {
-  return std::visit(
-    [&point_file_entry](const auto& typed_file) {
-      return std::visit(
-        [&typed_file](const auto& cursor) {
-          return cursor == std::cend(typed_file);
-        },
-        point_file_entry.cursor);
-    },
-    point_file_entry.point_file);
+  return visit_with_cursor(
+    point_file_entry.point_file,
+    point_file_entry.cursor,
+    [](const auto& typed_file, const auto& cursor) {
+      return cursor == std::cend(typed_file);
+    });
 }
 
 std::optional<PointBuffer>
@@ -352,49 +343,44 @@ MultiReaderPointSource::PointSourceHandle::read_next(
   size_t count,
   const PointAttributes& point_attributes)
 {
-  // The std::visit syntax makes me want to cry
-  return std::visit(
-    [count, &point_attributes, this](auto& typed_cursor) {
-      return std::visit(
-        [count, &point_attributes, &typed_cursor, this](
-          auto& typed_file) -> std::optional<PointBuffer> {
-          PointBuffer point_buffer;
-          try {
-            typed_cursor = pc::read_points(typed_cursor,
-                                           count,
-                                           pc::metadata(typed_file),
-                                           point_attributes,
-                                           point_buffer);
-          } catch (const std::exception& ex) {
-            if (_multi_reader_source->_errors_to_ignore &
-                util::IgnoreErrors::CorruptedFiles) {
-              // Log error and move this file to end, we assume that the file is
-              // dead now
-              util::write_log((boost::format("Could not read points from "
-                                             "file %1%\n\tcaused by: %2%\n") %
-                               pc::source(typed_file) % ex.what())
-                                .str());
-              typed_cursor = std::cend(typed_file);
-              return std::nullopt;
-            } else {
-              throw util::chain_error(
-                ex,
-                (boost::format("Could not read points from file %1%") %
-                 pc::source(typed_file))
-                  .str());
-            }
-          }
+  return visit_with_cursor(
+    _point_file_entry->point_file,
+    _point_file_entry->cursor,
+    [count, &point_attributes, this](const auto& typed_file,
+                                     auto& typed_cursor) -> std::optional<PointBuffer> {
+      PointBuffer point_buffer;
+      try {
+        typed_cursor = pc::read_points(typed_cursor,
+                                       count,
+                                       pc::metadata(typed_file),
+                                       point_attributes,
+                                       point_buffer);
+      } catch (const std::exception& ex) {
+        if (_multi_reader_source->_errors_to_ignore &
+            util::IgnoreErrors::CorruptedFiles) {
+          // Log error and move this file to end, we assume that the file is
+          // dead now
+          util::write_log((boost::format("Could not read points from "
+                                         "file %1%\n\tcaused by: %2%\n") %
+                           pc::source(typed_file) % ex.what())
+                            .str());
+          typed_cursor = std::cend(typed_file);
+          return std::nullopt;
+        } else {
+          throw util::chain_error(
+            ex,
+            (boost::format("Could not read points from file %1%") %
+             pc::source(typed_file))
+              .str());
+        }
+      }
 
-          for (auto& transformation : _multi_reader_source->_transformations) {
-            transformation(
-              { std::begin(point_buffer), std::end(point_buffer) });
-          }
+      for (auto& transformation : _multi_reader_source->_transformations) {
+        transformation({ std::begin(point_buffer), std::end(point_buffer) });
+      }
 
-          return { std::move(point_buffer) };
-        },
-        _point_file_entry->point_file);
-    },
-    _point_file_entry->cursor);
+      return { std::move(point_buffer) };
+    });
 }
 
 PointBuffer::PointIterator
@@ -402,59 +388,55 @@ MultiReaderPointSource::PointSourceHandle::read_next_into(
   util::Range<PointBuffer::PointIterator> point_range,
   const PointAttributes& point_attributes)
 {
-  return std::visit(
-    [point_range, &point_attributes, this](auto& typed_cursor) {
-      return std::visit(
-        [point_range, &point_attributes, &typed_cursor, this](
-          auto& typed_file) -> PointBuffer::PointIterator {
-          PointBuffer::PointIterator new_end_of_point_range =
-            std::begin(point_range);
-          try {
-            auto [_new_file_iter, _new_out_iter] =
-              pc::read_points_into(typed_cursor,
-                                   std::cend(typed_file),
-                                   pc::metadata(typed_file),
-                                   point_attributes,
-                                   point_range);
-
-            for (auto point_ref : point_range) {
-              auto point_src_id = point_ref.point_source_id();
-              if (point_src_id != nullptr) {
-                *point_src_id = static_cast<uint16_t>(_point_file_entry->file_index);
-              }
-            }
-
-            typed_cursor = _new_file_iter;
-            new_end_of_point_range = _new_out_iter;
-          } catch (const std::exception& ex) {
-            if (_multi_reader_source->_errors_to_ignore &
-                util::IgnoreErrors::CorruptedFiles) {
-              // Log error and move this file to end, we assume that the file is
-              // dead now
-              util::write_log((boost::format("Could not read points from "
-                                             "file %1%\n\tcaused by: %2%\n") %
-                               pc::source(typed_file) % ex.what())
-                                .str());
-              typed_cursor = std::cend(typed_file);
-              return std::begin(point_range);
-            } else {
-              throw util::chain_error(
-                ex,
-                (boost::format("Could not read points from file %1%") %
-                 pc::source(typed_file))
-                  .str());
-            }
+  return visit_with_cursor(
+    _point_file_entry->point_file,
+    _point_file_entry->cursor,
+    [point_range, &point_attributes, this](
+      const auto& typed_file, auto& typed_cursor) -> PointBuffer::PointIterator {
+      PointBuffer::PointIterator new_end_of_point_range = std::begin(point_range);
+      try {
+        auto [_new_file_iter, _new_out_iter] =
+          pc::read_points_into(typed_cursor,
+                               std::cend(typed_file),
+                               pc::metadata(typed_file),
+                               point_attributes,
+                               point_range);
+
+        for (auto point_ref : point_range) {
+          auto point_src_id = point_ref.point_source_id();
+          if (point_src_id != nullptr) {
+            *point_src_id = static_cast<uint16_t>(_point_file_entry->file_index);
           }
+        }
+
+        typed_cursor = _new_file_iter;
+        new_end_of_point_range = _new_out_iter;
+      } catch (const std::exception& ex) {
+        if (_multi_reader_source->_errors_to_ignore &
+            util::IgnoreErrors::CorruptedFiles) {
+          // Log error and move this file to end, we assume that the file is
+          // dead now
+          util::write_log((boost::format("Could not read points from "
+                                         "file %1%\n\tcaused by: %2%\n") %
+                           pc::source(typed_file) % ex.what())
+                            .str());
+          typed_cursor = std::cend(typed_file);
+          return std::begin(point_range);
+        } else {
+          throw util::chain_error(
+            ex,
+            (boost::format("Could not read points from file %1%") %
+             pc::source(typed_file))
+              .str());
+        }
+      }
 
-          for (auto& transformation : _multi_reader_source->_transformations) {
-            transformation({ std::begin(point_range), new_end_of_point_range });
-          }
+      for (auto& transformation : _multi_reader_source->_transformations) {
+        transformation({ std::begin(point_range), new_end_of_point_range });
+      }
 
-          return new_end_of_point_range;
-        },
-        _point_file_entry->point_file);
-    },
-    _point_file_entry->cursor);
+      return new_end_of_point_range;
+    });
 }
 
 MultiReaderPointSource::PointSourceHandle::PointSourceHandle(
@@ -469,19 +451,12 @@ MultiReaderPointSource::PointFileEntry::PointFileEntry(
   const fs::path& file_path,
   size_t file_index)
   : point_file(std::move(file))
+  , cursor(std::visit(
+      [](const auto& typed_file) -> PointFileCursor { return std::cbegin(typed_file); },
+      point_file))
   , available(true)
   , file_path(file_path)
   , file_index(file_index)
-{
-  // Get an iterator to the start of the file and store it
-  //( std::variant syntax is so nasty :( )
-  std::visit(
-    [this](auto& typed_file_cursor) {
-      std::visit([&typed_file_cursor](
-                   const auto& file) { typed_file_cursor = std::begin(file); },
-                 point_file);
-    },
-    cursor);
-}
+{}
 
 #pragma endregion
\ No newline at end of file
@@ -26,10 +26,6 @@ struct PointSource
   void add_transformation(Transform transform);
 
 private:
-  // TODO We can create this type through some meta-programming from the
-  // PointFile type
-  using CurrentFileCursor = std::variant<typename LASFile::const_iterator>;
-
   bool try_open_file(std::vector<fs::path>::const_iterator file_cursor);
   bool move_to_next_file();
 
@@ -39,7 +35,7 @@ private:
   std::vector<fs::path>::const_iterator _file_cursor;
 
   std::optional<PointFile> _current_file;
-  std::optional<CurrentFileCursor> _current_file_cursor;
+  std::optional<PointFileCursor> _current_file_cursor;
 
   std::vector<Transform> _transformations;
 };
@@ -67,13 +63,6 @@ struct MultiReaderPointSource
   using Transform =
     std::function<void(util::Range<PointBuffer::PointIterator>)>;
 
-  // TODO HACK Storing the file types as variants and then storing a SEPARATE
-  // variant for the iterators won't compile with more than one type in the
-  // variants, as we have to do a double-visit on both variants I don't how to
-  // change this code at the moment, maybe we can get rid of the variants by
-  // using some regular polymorphism?
-  using PointFileCursor = std::variant<typename LASFile::const_iterator>;
-
   struct PointFileEntry
   {
     PointFileEntry(PointFile point_file,
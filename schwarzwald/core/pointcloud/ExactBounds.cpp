@@ -0,0 +1,110 @@
+#include "pointcloud/ExactBounds.h"
+
+#include "util/stuff.h"
+
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+#include <rapidjson/document.h>
+
+namespace rj = rapidjson;
+
+constexpr static uint32_t EXACT_BOUNDS_CACHE_VERSION = 2;
+
+static int64_t
+last_write_time_ticks(const fs::path& file_path)
+{
+  return static_cast<int64_t>(fs::last_write_time(file_path).time_since_epoch().count());
+}
+
+static std::string
+absolute_path_string(const fs::path& file_path)
+{
+  return fs::absolute(file_path).string();
+}
+
+fs::path
+exact_bounds_cache_path(const fs::path& cache_directory, const fs::path& file_path)
+{
+  // Different paths may have the same hash, so the cache file also stores the
+  // path and is only used if the path matches
+  std::stringstream name;
+  name << std::hex << std::setw(16) << std::setfill('0')
+       << std::hash<std::string>{}(absolute_path_string(file_path)) << ".bounds.json";
+  return cache_directory / name.str();
+}
+
+std::optional<AABB>
+read_cached_exact_bounds(const fs::path& cache_directory, const fs::path& file_path)
+{
+  std::ifstream stream{ exact_bounds_cache_path(cache_directory, file_path) };
+  if (!stream.is_open())
+    return std::nullopt;
+
+  const std::string json{ std::istreambuf_iterator<char>{ stream }, {} };
+  rj::Document document;
+  if (document.Parse<0>(json.c_str()).HasParseError() || !document.IsObject())
+    return std::nullopt;
+
+  const auto is_uint = [&document](const char* name) {
+    return document.HasMember(name) && document[name].IsUint64();
+  };
+  const auto is_vector = [&document](const char* name) {
+    if (!document.HasMember(name) || !document[name].IsArray() || document[name].Size() != 3)
+      return false;
+    const auto& array = document[name];
+    return array[0].IsNumber() && array[1].IsNumber() && array[2].IsNumber();
+  };
+  if (!is_uint("version") || !document.HasMember("path") || !document["path"].IsString() ||
+      !is_uint("file_size") || !document.HasMember("last_write_time") ||
+      !document["last_write_time"].IsInt64() || !is_vector("min") || !is_vector("max"))
+    return std::nullopt;
+
+  // A modified file invalidates the cache
+  std::error_code ec;
+  const auto file_size = fs::file_size(file_path, ec);
+  if (ec || document["version"].GetUint64() != EXACT_BOUNDS_CACHE_VERSION ||
+      document["path"].GetString() != absolute_path_string(file_path) ||
+      document["file_size"].GetUint64() != file_size ||
+      document["last_write_time"].GetInt64() != last_write_time_ticks(file_path))
+    return std::nullopt;
+
+  const auto& min = document["min"];
+  const auto& max = document["max"];
+  return AABB{ { min[0].GetDouble(), min[1].GetDouble(), min[2].GetDouble() },
+               { max[0].GetDouble(), max[1].GetDouble(), max[2].GetDouble() } };
+}
+
+void
+write_cached_exact_bounds(const fs::path& cache_directory,
+                          const fs::path& file_path,
+                          const AABB& bounds)
+{
+  fs::create_directories(cache_directory);
+
+  rj::Document document;
+  document.SetObject();
+  auto& allocator = document.GetAllocator();
+
+  const auto to_json = [&allocator](const Vector3<double>& vector) {
+    rj::Value array{ rj::kArrayType };
+    array.PushBack(vector.x, allocator);
+    array.PushBack(vector.y, allocator);
+    array.PushBack(vector.z, allocator);
+    return array;
+  };
+
+  document.AddMember("version", EXACT_BOUNDS_CACHE_VERSION, allocator);
+  const auto path = absolute_path_string(file_path);
+  document.AddMember(
+    "path", rj::Value{ path.c_str(), static_cast<rj::SizeType>(path.size()), allocator }, allocator);
+  document.AddMember(
+    "file_size", static_cast<uint64_t>(fs::file_size(file_path)), allocator);
+  document.AddMember("last_write_time", last_write_time_ticks(file_path), allocator);
+  document.AddMember("min", to_json(bounds.min), allocator);
+  document.AddMember("max", to_json(bounds.max), allocator);
+
+  write_json_to_file(document, exact_bounds_cache_path(cache_directory, file_path));
+}
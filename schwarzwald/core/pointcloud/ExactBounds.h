@@ -0,0 +1,33 @@
+#pragma once
+
+#include "math/AABB.h"
+#include "util/Definitions.h"
+
+#include <optional>
+
+/**
+ * Path of the file in 'cache_directory' that caches the exact bounds of the
+ * given point cloud file. The name of the cache file is derived from the
+ * absolute path of the point cloud file, so that the input directories are
+ * never written to
+ */
+fs::path
+exact_bounds_cache_path(const fs::path& cache_directory, const fs::path& file_path);
+
+/**
+ * Reads the cached exact bounds of the given point cloud file from the given
+ * cache directory. Returns nothing if there is no cache for this path or if the
+ * file was modified after the cache was written
+ */
+std::optional<AABB>
+read_cached_exact_bounds(const fs::path& cache_directory, const fs::path& file_path);
+
+/**
+ * Caches the exact bounds of the given point cloud file in the given cache
+ * directory, together with the path, size and modification time of the file.
+ * Throws if the cache can't be written
+ */
+void
+write_cached_exact_bounds(const fs::path& cache_directory,
+                          const fs::path& file_path,
+                          const AABB& bounds);
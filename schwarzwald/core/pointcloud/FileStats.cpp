@@ -2,14 +2,34 @@
 
 #include <boost/format.hpp>
 
+#include <cmath>
+#include <limits>
+
+/**
+ * Cubic bounds with the same side length as 'AABB::cubic()', but with the
+ * bottom at the bottom of 'bounds'
+ */
+static AABB
+cubic_bounds_anchored_at_bottom(const AABB& bounds)
+{
+  auto cubic_bounds = bounds.cubic();
+  const auto side_length = cubic_bounds.extent().z;
+  cubic_bounds.min.z = bounds.min.z;
+  cubic_bounds.max.z = bounds.min.z + side_length;
+  return cubic_bounds;
+}
+
 DatasetMetadata::DatasetMetadata()
   : _total_points_count(0)
+  , _use_quadtree_levels(false)
 {}
 
 void
 DatasetMetadata::add_file_metadata(const fs::path& file_path,
                                    size_t points_count,
-                                   const AABB& bounds)
+                                   const AABB& bounds,
+                                   uint32_t point_record_length,
+                                   bool is_compressed)
 {
   const auto iter_to_metadata = _metadata_per_file.find(file_path);
   if (iter_to_metadata != std::end(_metadata_per_file)) {
@@ -21,10 +41,14 @@ DatasetMetadata::add_file_metadata(const fs::path& file_path,
   auto& common_metadata = _metadata_per_file[file_path];
   common_metadata.points_count = points_count;
   common_metadata.bounds = bounds;
+  common_metadata.point_record_length = point_record_length;
+  common_metadata.is_compressed = is_compressed;
 
   _total_points_count += points_count;
   _total_bounds_tight.update(bounds);
-  _total_bounds_cubic = _total_bounds_tight.cubic();
+  _total_bounds_cubic = _use_quadtree_levels
+                          ? cubic_bounds_anchored_at_bottom(_total_bounds_tight)
+                          : _total_bounds_tight.cubic();
 }
 
 AABB
@@ -34,4 +58,25 @@ DatasetMetadata::total_bounds_cubic_at_origin() const
     _total_bounds_cubic.min - _total_bounds_cubic.getCenter(),
     _total_bounds_cubic.max - _total_bounds_cubic.getCenter(),
   };
-}
\ No newline at end of file
+}
+void
+DatasetMetadata::use_quadtree_levels()
+{
+  _use_quadtree_levels = true;
+  if (_total_points_count) {
+    _total_bounds_cubic = cubic_bounds_anchored_at_bottom(_total_bounds_tight);
+  }
+}
+
+uint32_t
+DatasetMetadata::quadtree_levels() const
+{
+  if (!_use_quadtree_levels || !_total_points_count)
+    return 0;
+
+  const auto height = _total_bounds_tight.extent().z;
+  const auto side_length = _total_bounds_cubic.extent().z;
+  if (height <= 0)
+    return std::numeric_limits<uint32_t>::max();
+  return static_cast<uint32_t>(std::max(0.0, std::floor(std::log2(side_length / height))));
+}
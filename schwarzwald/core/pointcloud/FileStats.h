@@ -15,6 +15,14 @@ struct CommonMetadata
 {
   size_t points_count;
   AABB bounds;
+  /**
+   * Size of a single point record in bytes
+   */
+  uint32_t point_record_length;
+  /**
+   * Is the point data compressed (e.g. LAZ)?
+   */
+  bool is_compressed;
 };
 
 /**
@@ -45,6 +53,21 @@ struct DatasetMetadata
    */
   AABB total_bounds_cubic_at_origin() const;
 
+  /**
+   * Anchors the cubic bounds at the bottom of the tight bounds instead of
+   * centering them vertically. For flat datasets, all points then fall into the
+   * lower octants of the first levels, so these levels only split the data in X
+   * and Y like a quadtree would, and Z is subdivided once the nodes are about as
+   * high as the data. With centered bounds, the data straddles the vertical
+   * center of the root node, which doubles the number of nodes on all levels
+   */
+  void use_quadtree_levels();
+  /**
+   * Number of levels below the root that don't subdivide the dataset in Z
+   * because the nodes on these levels are still higher than the dataset
+   */
+  uint32_t quadtree_levels() const;
+
   /**
    * Returns the CommonMetadata of all files
    */
@@ -52,11 +75,16 @@ struct DatasetMetadata
   /**
    * Adds metadata for the given file
    */
-  void add_file_metadata(const fs::path& file_path, size_t points_count, const AABB& bounds);
+  void add_file_metadata(const fs::path& file_path,
+                         size_t points_count,
+                         const AABB& bounds,
+                         uint32_t point_record_length,
+                         bool is_compressed);
 
 private:
   size_t _total_points_count;
   AABB _total_bounds_tight;
   AABB _total_bounds_cubic;
+  bool _use_quadtree_levels;
   std::unordered_map<fs::path, CommonMetadata, util::PathHash> _metadata_per_file;
 };
\ No newline at end of file
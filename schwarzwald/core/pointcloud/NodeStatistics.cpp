@@ -0,0 +1,112 @@
+#include "pointcloud/NodeStatistics.h"
+
+#include "util/stuff.h"
+
+namespace rj = rapidjson;
+
+template<typename T>
+static void
+merge_range(std::optional<AttributeRange<T>>& target,
+            const std::optional<AttributeRange<T>>& source)
+{
+  if (!source)
+    return;
+  if (!target) {
+    target = source;
+  } else {
+    target->update(*source);
+  }
+}
+
+void
+NodeStatistics::merge(const NodeStatistics& other)
+{
+  merge_range(intensity, other.intensity);
+  merge_range(gps_time, other.gps_time);
+
+  if (other.classification_histogram.empty())
+    return;
+
+  std::vector<ClassificationCount> merged;
+  merged.reserve(classification_histogram.size() + other.classification_histogram.size());
+
+  auto left = std::begin(classification_histogram);
+  auto right = std::begin(other.classification_histogram);
+  while (left != std::end(classification_histogram) ||
+         right != std::end(other.classification_histogram)) {
+    if (right == std::end(other.classification_histogram) ||
+        (left != std::end(classification_histogram) &&
+         left->classification < right->classification)) {
+      merged.push_back(*left++);
+    } else if (left == std::end(classification_histogram) ||
+               right->classification < left->classification) {
+      merged.push_back(*right++);
+    } else {
+      merged.push_back({ left->classification, left->count + right->count });
+      ++left;
+      ++right;
+    }
+  }
+
+  classification_histogram = std::move(merged);
+}
+
+NodeStatisticsAccumulator::NodeStatisticsAccumulator()
+  : _classification_counts({})
+  , _has_classifications(false)
+{}
+
+NodeStatistics
+NodeStatisticsAccumulator::statistics() const
+{
+  NodeStatistics statistics;
+  statistics.intensity = _intensity;
+  statistics.gps_time = _gps_time;
+
+  if (_has_classifications) {
+    for (size_t classification = 0; classification < _classification_counts.size();
+         ++classification) {
+      const auto count = _classification_counts[classification];
+      if (!count)
+        continue;
+      statistics.classification_histogram.push_back(
+        { static_cast<uint8_t>(classification), count });
+    }
+  }
+
+  return statistics;
+}
+
+template<typename T>
+static rj::Value
+range_to_json(const AttributeRange<T>& range, rj::Document::AllocatorType& allocator)
+{
+  rj::Value value{ rj::kArrayType };
+  value.PushBack(range.min, allocator);
+  value.PushBack(range.max, allocator);
+  return value;
+}
+
+rj::Value
+node_statistics_to_json(const NodeStatistics& statistics, rj::Document::AllocatorType& allocator)
+{
+  rj::Value value{ rj::kObjectType };
+
+  if (statistics.intensity) {
+    value.AddMember("intensity", range_to_json(*statistics.intensity, allocator), allocator);
+  }
+  if (statistics.gps_time) {
+    value.AddMember("gps_time", range_to_json(*statistics.gps_time, allocator), allocator);
+  }
+  if (!statistics.classification_histogram.empty()) {
+    rj::Value histogram{ rj::kObjectType };
+    for (const auto& entry : statistics.classification_histogram) {
+      histogram.AddMember(rj_string(std::to_string(entry.classification), allocator),
+                          rj::Value{ entry.count },
+                          allocator);
+    }
+    value.AddMember("classification", histogram, allocator);
+  }
+
+  return value;
+}
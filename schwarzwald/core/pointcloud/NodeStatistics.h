@@ -0,0 +1,153 @@
+#pragma once
+
+#include "pointcloud/PointAttributes.h"
+
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <rapidjson/document.h>
+#include <vector>
+
+/**
+ * Minimum and maximum value of a point attribute
+ */
+template<typename T>
+struct AttributeRange
+{
+  T min;
+  T max;
+
+  void update(T value)
+  {
+    min = std::min(min, value);
+    max = std::max(max, value);
+  }
+
+  void update(const AttributeRange& other)
+  {
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+  }
+};
+
+/**
+ * Number of points with a specific classification
+ */
+struct ClassificationCount
+{
+  uint8_t classification;
+  uint64_t count;
+};
+
+/**
+ * Attribute statistics of the points in a single node. Clients can use these
+ * to decide whether a node has to be fetched for a query (e.g. "all ground
+ * points" or "points within this time range") without reading the node. All
+ * members are empty if the corresponding attribute was not written for the node
+ */
+struct NodeStatistics
+{
+  std::optional<AttributeRange<uint16_t>> intensity;
+  std::optional<AttributeRange<double>> gps_time;
+  /**
+   * Number of points per classification, sorted by classification. Only
+   * classifications that occur in the node are stored
+   */
+  std::vector<ClassificationCount> classification_histogram;
+
+  bool empty() const
+  {
+    return !intensity && !gps_time && classification_histogram.empty();
+  }
+
+  /**
+   * Merges the statistics of another node into these statistics
+   */
+  void merge(const NodeStatistics& other);
+};
+
+/**
+ * Accumulates NodeStatistics point by point. This is meant to be fused into the
+ * loop that writes the points of a node, so that computing the statistics does
+ * not require an additional pass over the points
+ */
+struct NodeStatisticsAccumulator
+{
+  NodeStatisticsAccumulator();
+
+  void add_intensity(uint16_t intensity)
+  {
+    if (_intensity) {
+      _intensity->update(intensity);
+    } else {
+      _intensity = AttributeRange<uint16_t>{ intensity, intensity };
+    }
+  }
+
+  void add_gps_time(double gps_time)
+  {
+    if (_gps_time) {
+      _gps_time->update(gps_time);
+    } else {
+      _gps_time = AttributeRange<double>{ gps_time, gps_time };
+    }
+  }
+
+  void add_classification(uint8_t classification)
+  {
+    ++_classification_counts[classification];
+    _has_classifications = true;
+  }
+
+  NodeStatistics statistics() const;
+
+private:
+  std::optional<AttributeRange<uint16_t>> _intensity;
+  std::optional<AttributeRange<double>> _gps_time;
+  std::array<uint64_t, 256> _classification_counts;
+  bool _has_classifications;
+};
+
+/**
+ * Computes the statistics of the given range of points for all attributes that
+ * are contained in 'attributes'. Use this only if there is no write pass into
+ * which the NodeStatisticsAccumulator can be fused
+ */
+template<typename Iter>
+NodeStatistics
+compute_node_statistics(Iter points_begin, Iter points_end, const PointAttributes& attributes)
+{
+  if (points_begin == points_end)
+    return {};
+
+  const auto first_point = *points_begin;
+  const auto has_intensities = ((first_point.intensity() != nullptr) &&
+                                has_attribute(attributes, PointAttribute::Intensity));
+  const auto has_classifications = ((first_point.classification() != nullptr) &&
+                                    has_attribute(attributes, PointAttribute::Classification));
+  const auto has_gps_times =
+    ((first_point.gps_time() != nullptr) && has_attribute(attributes, PointAttribute::GPSTime));
+
+  NodeStatisticsAccumulator accumulator;
+  std::for_each(points_begin, points_end, [&](const auto& point_ref) {
+    if (has_intensities) {
+      accumulator.add_intensity(*point_ref.intensity());
+    }
+    if (has_classifications) {
+      accumulator.add_classification(*point_ref.classification());
+    }
+    if (has_gps_times) {
+      accumulator.add_gps_time(*point_ref.gps_time());
+    }
+  });
+  return accumulator.statistics();
+}
+
+/**
+ * Converts the given NodeStatistics into a JSON object of the form:
+ *   { "intensity": [min, max], "gps_time": [min, max], "classification": { "2": count, ... } }
+ * Members for attributes without statistics are omitted
+ */
+rapidjson::Value
+node_statistics_to_json(const NodeStatistics& statistics,
+                        rapidjson::Document::AllocatorType& allocator);
@@ -12,6 +12,7 @@
 
 #include "datastructures/SparseGrid.h"
 #include "math/Vector3.h"
+#include "pointcloud/NodeStatistics.h"
 #include "pointcloud/PointAttributes.h"
 #include "util/Transformation.h"
 
@@ -97,6 +98,8 @@ public:
 
   Vector3<double> localCenter;
 
+  NodeStatistics statistics; // Written to the 'extras' of the tile
+
   Tileset() = default;
   Tileset(std::string name)
     : name(std::move(name))
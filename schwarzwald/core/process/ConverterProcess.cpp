@@ -512,8 +512,7 @@ convert_to_pnts_file(const std::string& source_folder,
 
   PointBuffer source_data;
   persistence->retrieve_points(node_name, source_data);
-  transformation.transformPositionsTo(TargetSRS::CesiumWorld,
-                                      gsl::make_span(source_data.positions()));
+  transformation.transformPositionsTo(TargetSRS::CesiumWorld, source_data.positions());
   auto local_offset_to_world = setOriginToSmallestPoint(source_data.positions());
 
   std::vector<PointBuffer::PointReference> point_references;
@@ -0,0 +1,97 @@
+#include "process/PreviewWriter.h"
+
+#include "io/AttributeStore.h"
+#include "tiling/OctreeAlgorithms.h"
+#include "util/stuff.h"
+
+#include <utility>
+#include <vector>
+
+PreviewWriter::PreviewWriter(fs::path preview_directory,
+                             uint32_t levels,
+                             const AABB& root_bounds,
+                             PersistenceFactory make_persistence,
+                             MetadataWriter write_metadata,
+                             const AttributeStore* attribute_store)
+  : _preview_directory(std::move(preview_directory))
+  , _levels(levels)
+  , _root_bounds(root_bounds)
+  , _make_persistence(std::move(make_persistence))
+  , _write_metadata(std::move(write_metadata))
+  , _attribute_store(attribute_store)
+{}
+
+size_t
+PreviewWriter::publish(PointsPersistence& source)
+{
+  const auto staging_directory = concat(_preview_directory.string(), ".tmp");
+  fs::remove_all(staging_directory);
+  fs::create_directories(staging_directory);
+
+  size_t preview_points_count = 0;
+  {
+    // The preview persistence writes its own metadata (e.g. the tilesets or
+    // the EPT hierarchy) when it is destroyed
+    auto preview_persistence = _make_persistence(staging_directory);
+
+    // Nodes are copied level by level, so parents are always written before
+    // their children
+    std::vector<std::pair<std::string, AABB>> current_level{ { "r", _root_bounds } };
+    for (uint32_t level = 0; level < _levels && !current_level.empty(); ++level) {
+      std::vector<std::pair<std::string, AABB>> next_level;
+      for (const auto& [node_name, node_bounds] : current_level) {
+        if (!source.node_exists(node_name))
+          continue;
+
+        PointBuffer points;
+        source.retrieve_points(node_name, points);
+        if (points.empty())
+          continue;
+
+        if (_attribute_store) {
+          _attribute_store->gather(points);
+        }
+        points.make_positions_global();
+
+        preview_persistence.persist_points(points, node_bounds, node_name);
+        preview_points_count += points.count();
+
+        for (uint8_t octant = 0; octant < 8; ++octant) {
+          next_level.emplace_back(concat(node_name, static_cast<char>('0' + octant)),
+                                  get_octant_bounds(octant, node_bounds));
+        }
+      }
+      current_level = std::move(next_level);
+    }
+  }
+
+  if (!preview_points_count) {
+    fs::remove_all(staging_directory);
+    return 0;
+  }
+
+  if (_write_metadata) {
+    _write_metadata(staging_directory, preview_points_count);
+  }
+
+  // Directories can't be replaced atomically, so the previous preview is moved
+  // out of the way first. Viewers only see a missing preview between the two
+  // renames, never a partial one
+  const auto previous_directory = concat(_preview_directory.string(), ".old");
+  fs::remove_all(previous_directory);
+  if (fs::exists(_preview_directory)) {
+    fs::rename(_preview_directory, previous_directory);
+  }
+  fs::rename(staging_directory, _preview_directory);
+  fs::remove_all(previous_directory);
+
+  return preview_points_count;
+}
+
+void
+PreviewWriter::remove()
+{
+  fs::remove_all(_preview_directory);
+  fs::remove_all(concat(_preview_directory.string(), ".tmp"));
+  fs::remove_all(concat(_preview_directory.string(), ".old"));
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "io/PointsPersistence.h"
+#include "math/AABB.h"
+#include "util/Definitions.h"
+
+#include <functional>
+
+struct AttributeStore;
+
+/**
+ * Publishes the top levels of an octree that is still being tiled as a
+ * separate, complete output in the same format. Each call to 'publish' copies
+ * the current nodes of the top levels into a new preview, so that the data can
+ * be viewed long before tiling has finished. Later previews contain the nodes
+ * that were updated by the batches in between
+ */
+struct PreviewWriter
+{
+  /**
+   * Creates the persistence that writes the preview into the given directory
+   */
+  using PersistenceFactory = std::function<PointsPersistence(const fs::path&)>;
+  /**
+   * Writes the metadata files of a preview (e.g. ept.json) with the given
+   * number of points into the given directory
+   */
+  using MetadataWriter = std::function<void(const fs::path&, size_t)>;
+
+  /**
+   * Creates a PreviewWriter that writes the top 'levels' levels of an octree
+   * with the given root bounds to 'preview_directory'. If the nodes of the
+   * octree have deferred attributes, they are gathered from 'attribute_store'
+   */
+  PreviewWriter(fs::path preview_directory,
+                uint32_t levels,
+                const AABB& root_bounds,
+                PersistenceFactory make_persistence,
+                MetadataWriter write_metadata,
+                const AttributeStore* attribute_store = nullptr);
+
+  /**
+   * Publishes the top levels of the octree in 'source' as the new preview. The
+   * preview is written to a temporary directory first and then replaces the
+   * previous preview, so that viewers never see a partially written preview.
+   * Returns the number of points in the preview
+   */
+  size_t publish(PointsPersistence& source);
+
+  /**
+   * Removes the preview, e.g. once the final output is complete
+   */
+  void remove();
+
+  const fs::path& preview_directory() const { return _preview_directory; }
+
+private:
+  fs::path _preview_directory;
+  uint32_t _levels;
+  AABB _root_bounds;
+  PersistenceFactory _make_persistence;
+  MetadataWriter _write_metadata;
+  const AttributeStore* _attribute_store;
+};
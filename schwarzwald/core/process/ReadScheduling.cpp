@@ -0,0 +1,155 @@
+#include "process/ReadScheduling.h"
+
+#include <algorithm>
+#include <boost/format.hpp>
+#include <optional>
+
+// Decompressing LAZ is several times slower than reading uncompressed LAS
+constexpr double COMPRESSED_READ_COST_FACTOR = 4.0;
+// Number of slices per thread that a batch is split into. More slices balance
+// the threads better, but split files into more ReadCommands
+constexpr size_t SLICES_PER_THREAD = 8;
+
+ReadCostModel::ReadCostModel(const DatasetMetadata& dataset_metadata)
+  : _total_measured_seconds(0)
+  , _total_measured_estimated_cost(0)
+  , _lock(std::make_unique<std::mutex>())
+{
+  for (const auto& [file_path, metadata] : dataset_metadata.get_all_files_metadata()) {
+    const auto estimated_cost =
+      std::max(1.0, static_cast<double>(metadata.point_record_length)) *
+      (metadata.is_compressed ? COMPRESSED_READ_COST_FACTOR : 1.0);
+    _cost_per_file[file_path] = { estimated_cost, 0, 0 };
+  }
+}
+
+double
+ReadCostModel::cost_per_point(const fs::path& file_path) const
+{
+  std::lock_guard _{ *_lock };
+  const auto file_cost = _cost_per_file.find(file_path);
+  if (file_cost == std::end(_cost_per_file)) {
+    throw std::invalid_argument{
+      (boost::format("No read cost for file %1%") % file_path.string()).str()
+    };
+  }
+
+  const auto& cost = file_cost->second;
+  if (cost.measured_points) {
+    return cost.measured_seconds / cost.measured_points;
+  }
+  if (_total_measured_estimated_cost > 0) {
+    return cost.estimated_cost_per_point * (_total_measured_seconds / _total_measured_estimated_cost);
+  }
+  return cost.estimated_cost_per_point;
+}
+
+void
+ReadCostModel::record_read(const fs::path& file_path,
+                           size_t points_count,
+                           std::chrono::nanoseconds duration)
+{
+  if (!points_count)
+    return;
+
+  const auto seconds = std::chrono::duration<double>{ duration }.count();
+
+  std::lock_guard _{ *_lock };
+  auto& cost = _cost_per_file[file_path];
+  cost.measured_seconds += seconds;
+  cost.measured_points += points_count;
+
+  _total_measured_seconds += seconds;
+  _total_measured_estimated_cost += cost.estimated_cost_per_point * points_count;
+}
+
+ReadSchedule
+schedule_read_commands(std::deque<ReadCommand>& remaining_read_commands,
+                       uint32_t num_threads,
+                       size_t max_points,
+                       const ReadCostModel& cost_model)
+{
+  ReadSchedule schedule;
+  schedule.read_commands_per_thread.resize(num_threads);
+  schedule.points_count = 0;
+
+  if (!num_threads || !max_points)
+    return schedule;
+
+  struct PendingCommand
+  {
+    ReadCommand command;
+    double cost_per_point;
+  };
+
+  std::vector<PendingCommand> pending_commands;
+  pending_commands.reserve(remaining_read_commands.size());
+  for (const auto& command : remaining_read_commands) {
+    if (!command.to_read_count)
+      continue;
+    pending_commands.push_back({ command, cost_model.cost_per_point(*command.file_path) });
+  }
+  std::stable_sort(std::begin(pending_commands),
+                   std::end(pending_commands),
+                   [](const PendingCommand& l, const PendingCommand& r) {
+                     return (l.command.to_read_count * l.cost_per_point) >
+                            (r.command.to_read_count * r.cost_per_point);
+                   });
+
+  const auto points_per_slice = std::max(size_t{ 1 }, max_points / (num_threads * SLICES_PER_THREAD));
+
+  std::vector<double> cost_per_thread(num_threads, 0.0);
+  std::vector<std::optional<size_t>> command_per_thread(num_threads);
+  std::vector<bool> thread_is_done(num_threads, false);
+  size_t next_unassigned_command = 0;
+  auto remaining_points = max_points;
+
+  while (remaining_points) {
+    // The thread with the least cost so far gets the next slice
+    std::optional<uint32_t> next_thread;
+    for (uint32_t thread = 0; thread < num_threads; ++thread) {
+      if (thread_is_done[thread])
+        continue;
+      if (!next_thread || cost_per_thread[thread] < cost_per_thread[*next_thread]) {
+        next_thread = thread;
+      }
+    }
+    if (!next_thread)
+      break;
+
+    auto& current_command = command_per_thread[*next_thread];
+    if (!current_command || !pending_commands[*current_command].command.to_read_count) {
+      if (next_unassigned_command == pending_commands.size()) {
+        thread_is_done[*next_thread] = true;
+        continue;
+      }
+      current_command = next_unassigned_command++;
+    }
+
+    auto& pending_command = pending_commands[*current_command];
+    const auto slice_size =
+      std::min({ points_per_slice, pending_command.command.to_read_count, remaining_points });
+
+    auto& commands_of_thread = schedule.read_commands_per_thread[*next_thread];
+    if (!commands_of_thread.empty() &&
+        commands_of_thread.back().file_path == pending_command.command.file_path) {
+      commands_of_thread.back().to_read_count += slice_size;
+    } else {
+      commands_of_thread.push_back({ pending_command.command.file_path, slice_size });
+    }
+
+    cost_per_thread[*next_thread] += slice_size * pending_command.cost_per_point;
+    pending_command.command.to_read_count -= slice_size;
+    remaining_points -= slice_size;
+    schedule.points_count += slice_size;
+  }
+
+  remaining_read_commands.clear();
+  for (const auto& pending_command : pending_commands) {
+    if (!pending_command.command.to_read_count)
+      continue;
+    remaining_read_commands.push_back(pending_command.command);
+  }
+
+  return schedule;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "pointcloud/FileStats.h"
+#include "util/Definitions.h"
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Abstract command for reading points from a file.
+ */
+struct ReadCommand
+{
+  const fs::path* file_path;
+  size_t to_read_count;
+};
+
+/**
+ * Estimates the time it takes to read a single point from each file of a
+ * dataset. Before a file has been read from, the estimate is based on the point
+ * record length and on whether the file is compressed. Once points have been
+ * read, the measured throughput of the file is used instead
+ */
+struct ReadCostModel
+{
+  explicit ReadCostModel(const DatasetMetadata& dataset_metadata);
+
+  /**
+   * Estimated cost of reading a single point from the given file. Costs of
+   * different files are comparable, their unit is not meaningful
+   */
+  double cost_per_point(const fs::path& file_path) const;
+
+  /**
+   * Records that reading 'points_count' points from the given file took
+   * 'duration'. This is safe to call from multiple threads
+   */
+  void record_read(const fs::path& file_path,
+                   size_t points_count,
+                   std::chrono::nanoseconds duration);
+
+private:
+  struct FileCost
+  {
+    double estimated_cost_per_point;
+    double measured_seconds;
+    size_t measured_points;
+  };
+
+  std::unordered_map<fs::path, FileCost, util::PathHash> _cost_per_file;
+  // Conversion from the estimated cost into seconds, calibrated from all
+  // measured reads so far. This keeps measured and estimated costs comparable
+  double _total_measured_seconds;
+  double _total_measured_estimated_cost;
+  std::unique_ptr<std::mutex> _lock;
+};
+
+/**
+ * Read commands for each read thread of a single batch
+ */
+struct ReadSchedule
+{
+  std::vector<std::vector<ReadCommand>> read_commands_per_thread;
+  size_t points_count;
+};
+
+/**
+ * Distributes at most 'max_points' points from 'remaining_read_commands' onto
+ * 'num_threads' read threads so that all threads finish at about the same time.
+ * This is a longest-processing-time-first schedule: Files are taken in order of
+ * decreasing remaining cost and each slice of a file goes to the thread with
+ * the least total cost so far. A file is only ever read by one thread per
+ * batch. The scheduled points are removed from 'remaining_read_commands'
+ */
+ReadSchedule
+schedule_read_commands(std::deque<ReadCommand>& remaining_read_commands,
+                       uint32_t num_threads,
+                       size_t max_points,
+                       const ReadCostModel& cost_model);
@@ -0,0 +1,569 @@
+#include "process/Retiler.h"
+
+#include "io/PointcloudFactory.h"
+#include "io/PointcloudFile.h"
+#include "tiling/OctreeAlgorithms.h"
+#include "tiling/TilingAlgorithms.h"
+#include "util/Definitions.h"
+#include "util/stuff.h"
+
+#include <debug/ProgressReporter.h>
+#include <terminal/stdout_helper.h>
+#include <types/type_util.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <rapidjson/document.h>
+#include <unordered_set>
+
+namespace rj = rapidjson;
+
+/**
+ * Start nodes deeper than this level give no further parallelism, but make the
+ * reconstruction of the upper levels more expensive
+ */
+constexpr static uint32_t MAX_LEVEL_OF_START_NODES = 6;
+
+static bool
+is_las_node_file(const fs::path& file_path)
+{
+  const auto extension = file_path.extension().string();
+  return extension == ".las" || extension == ".laz";
+}
+
+TiledOutput
+read_tiled_output(const fs::path& directory)
+{
+  const auto properties_path = directory / "properties.json";
+  std::ifstream stream{ properties_path };
+  if (!stream.is_open()) {
+    throw std::invalid_argument{ concat(
+      "Could not open ",
+      properties_path.string(),
+      ". Re-tiling requires the output directory of a previous tiler run") };
+  }
+
+  const std::string json{ std::istreambuf_iterator<char>{ stream }, {} };
+  rj::Document document;
+  if (document.Parse<0>(json.c_str()).HasParseError() || !document.IsObject() ||
+      !document.HasMember("source_properties") || !document["source_properties"].IsObject()) {
+    throw std::runtime_error{ concat("Could not parse ", properties_path.string()) };
+  }
+
+  const auto& source_properties = document["source_properties"];
+  const auto is_vector = [](const rj::Value& value) {
+    return value.IsArray() && value.Size() == 3 && value[0].IsNumber() && value[1].IsNumber() &&
+           value[2].IsNumber();
+  };
+  if (!source_properties.HasMember("bounds") || !source_properties["bounds"].IsObject() ||
+      !source_properties["bounds"].HasMember("min") ||
+      !is_vector(source_properties["bounds"]["min"]) ||
+      !source_properties["bounds"].HasMember("max") ||
+      !is_vector(source_properties["bounds"]["max"]) ||
+      !source_properties.HasMember("root_spacing") ||
+      !source_properties["root_spacing"].IsNumber() ||
+      !source_properties.HasMember("processed_points") ||
+      !source_properties["processed_points"].IsUint64()) {
+    throw std::runtime_error{ concat(
+      properties_path.string(), " is missing the bounds, root spacing or number of points") };
+  }
+
+  TiledOutput tiled_output;
+  tiled_output.directory = directory;
+
+  const auto& min = source_properties["bounds"]["min"];
+  const auto& max = source_properties["bounds"]["max"];
+  tiled_output.bounds = { { min[0].GetDouble(), min[1].GetDouble(), min[2].GetDouble() },
+                          { max[0].GetDouble(), max[1].GetDouble(), max[2].GetDouble() } };
+  tiled_output.spacing_at_root = static_cast<float>(source_properties["root_spacing"].GetDouble());
+  tiled_output.points_count = source_properties["processed_points"].GetUint64();
+
+  if (source_properties.HasMember("reconstructed_levels") &&
+      source_properties["reconstructed_levels"].IsUint()) {
+    tiled_output.reconstructed_levels = source_properties["reconstructed_levels"].GetUint();
+  } else {
+    util::write_log(concat("warning: ",
+                           properties_path.string(),
+                           " does not contain the number of reconstructed levels. Points of "
+                           "reconstructed nodes will be tiled more than once\n"));
+    tiled_output.reconstructed_levels = 0;
+  }
+
+  // Entwine outputs store their nodes as 'D-X-Y-Z' files in the 'ept-data'
+  // subdirectory, LAS outputs store them as 'r...' files in the directory itself
+  const auto ept_data_directory = directory / "ept-data";
+  const auto is_entwine = fs::is_directory(ept_data_directory);
+  const auto nodes_directory = is_entwine ? ept_data_directory : directory;
+  const auto naming_convention =
+    is_entwine ? MortonIndexNamingConvention::Entwine : MortonIndexNamingConvention::Potree;
+
+  for (const auto& entry : fs::directory_iterator{ nodes_directory }) {
+    const auto& file_path = entry.path();
+    if (!fs::is_regular_file(file_path) || !is_las_node_file(file_path))
+      continue;
+
+    const auto node_name = file_path.stem().string();
+    if (!is_entwine && (node_name.empty() || node_name.front() != 'r'))
+      continue;
+
+    const auto node_index = OctreeNodeIndex64::from_string(node_name, naming_convention);
+    if (!node_index)
+      continue;
+    tiled_output.nodes.push_back({ *node_index, file_path });
+  }
+
+  if (tiled_output.nodes.empty()) {
+    throw std::invalid_argument{ concat(
+      "Found no LAS/LAZ nodes in ",
+      directory.string(),
+      ". Re-tiling requires the output of a previous tiler run with one of the output formats "
+      "LAS, LAZ, ENTWINE_LAS or ENTWINE_LAZ that was not partitioned by classification") };
+  }
+
+  std::sort(std::begin(tiled_output.nodes),
+            std::end(tiled_output.nodes),
+            [](const auto& l, const auto& r) {
+              if (l.index.levels() != r.index.levels())
+                return l.index.levels() < r.index.levels();
+              return l.index.index() < r.index.index();
+            });
+
+  return tiled_output;
+}
+
+/**
+ * Relative tolerance for comparing the bounds of nodes of different octrees
+ */
+constexpr static double ALIGNMENT_TOLERANCE = 1e-6;
+
+static std::optional<int64_t>
+as_integer(double value)
+{
+  const auto rounded = std::round(value);
+  if (std::abs(value - rounded) > ALIGNMENT_TOLERANCE)
+    return std::nullopt;
+  return static_cast<int64_t>(rounded);
+}
+
+AABB
+calculate_common_root_cube(const std::vector<AABB>& cubes)
+{
+  if (cubes.empty()) {
+    throw std::invalid_argument{ "Can't calculate the common root cube of zero cubes" };
+  }
+
+  AABB hull;
+  for (const auto& cube : cubes) {
+    hull.update(cube);
+  }
+  hull.makeCubic();
+
+  // Express all cubes in cells of the smallest cube. Each cube has to span 2^N
+  // cells, and all cubes have to be nodes of one octree on this grid
+  const auto& smallest_cube = *std::min_element(
+    std::begin(cubes), std::end(cubes), [](const AABB& l, const AABB& r) {
+      return l.extent().x < r.extent().x;
+    });
+  const auto cell_size = smallest_cube.extent().x;
+
+  const auto as_array = [](const Vector3<double>& vector) {
+    return std::array<double, 3>{ vector.x, vector.y, vector.z };
+  };
+  struct CubeInCells
+  {
+    std::array<int64_t, 3> first_cell;
+    int64_t cells_per_axis;
+  };
+  std::vector<CubeInCells> cubes_in_cells;
+  for (const auto& cube : cubes) {
+    const auto cells_per_axis = as_integer(cube.extent().x / cell_size);
+    if (!cells_per_axis || (*cells_per_axis & (*cells_per_axis - 1)))
+      return hull;
+
+    CubeInCells cube_in_cells;
+    cube_in_cells.cells_per_axis = *cells_per_axis;
+    const auto min = as_array(cube.min);
+    const auto min_of_smallest_cube = as_array(smallest_cube.min);
+    for (size_t axis = 0; axis < 3; ++axis) {
+      const auto first_cell = as_integer((min[axis] - min_of_smallest_cube[axis]) / cell_size);
+      if (!first_cell)
+        return hull;
+      cube_in_cells.first_cell[axis] = *first_cell;
+    }
+    cubes_in_cells.push_back(cube_in_cells);
+  }
+
+  // The root of the octree has to start at the same offset (modulo its side
+  // length) as each cube, which is only possible if the cubes agree with the
+  // largest cube
+  const auto positive_modulo = [](int64_t value, int64_t divisor) {
+    return ((value % divisor) + divisor) % divisor;
+  };
+  const auto& largest_cube = *std::max_element(
+    std::begin(cubes_in_cells), std::end(cubes_in_cells), [](const auto& l, const auto& r) {
+      return l.cells_per_axis < r.cells_per_axis;
+    });
+  std::array<int64_t, 3> first_cell_of_root;
+  int64_t required_cells_per_axis = largest_cube.cells_per_axis;
+  for (size_t axis = 0; axis < 3; ++axis) {
+    int64_t first_cell = std::numeric_limits<int64_t>::max();
+    int64_t last_cell = std::numeric_limits<int64_t>::min();
+    for (const auto& cube : cubes_in_cells) {
+      if (positive_modulo(cube.first_cell[axis] - largest_cube.first_cell[axis],
+                          cube.cells_per_axis))
+        return hull;
+      first_cell = std::min(first_cell, cube.first_cell[axis]);
+      last_cell = std::max(last_cell, cube.first_cell[axis] + cube.cells_per_axis - 1);
+    }
+    first_cell_of_root[axis] =
+      first_cell -
+      positive_modulo(first_cell - largest_cube.first_cell[axis], largest_cube.cells_per_axis);
+    required_cells_per_axis =
+      std::max(required_cells_per_axis, last_cell - first_cell_of_root[axis] + 1);
+  }
+
+  auto cells_per_axis = largest_cube.cells_per_axis;
+  while (cells_per_axis < required_cells_per_axis) {
+    cells_per_axis *= 2;
+  }
+  if (cells_per_axis > (int64_t{ 1 } << OctreeNodeIndex64::MAX_LEVELS))
+    return hull;
+
+  const Vector3<double> min{ smallest_cube.min.x + first_cell_of_root[0] * cell_size,
+                             smallest_cube.min.y + first_cell_of_root[1] * cell_size,
+                             smallest_cube.min.z + first_cell_of_root[2] * cell_size };
+  return { min, min + Vector3<double>{ cells_per_axis * cell_size } };
+}
+
+std::optional<OctreeNodeIndex64>
+find_node_with_bounds(const AABB& node_bounds, const AABB& root_bounds)
+{
+  const auto root_side_length = root_bounds.extent().x;
+  const auto side_length = node_bounds.extent().x;
+  const auto levels = as_integer(std::log2(root_side_length / side_length));
+  if (!levels || *levels < 0 || *levels > OctreeNodeIndex64::MAX_LEVELS)
+    return std::nullopt;
+
+  const auto cell_x = as_integer((node_bounds.min.x - root_bounds.min.x) / side_length);
+  const auto cell_y = as_integer((node_bounds.min.y - root_bounds.min.y) / side_length);
+  const auto cell_z = as_integer((node_bounds.min.z - root_bounds.min.z) / side_length);
+  const auto cells_per_axis = int64_t{ 1 } << *levels;
+  const auto is_valid_cell = [cells_per_axis](const std::optional<int64_t>& cell) {
+    return cell && *cell >= 0 && *cell < cells_per_axis;
+  };
+  if (!is_valid_cell(cell_x) || !is_valid_cell(cell_y) || !is_valid_cell(cell_z))
+    return std::nullopt;
+
+  OctreeNodeIndex64 node_index;
+  for (auto bit = *levels - 1; bit >= 0; --bit) {
+    const auto octant = static_cast<uint8_t>(
+      ((*cell_z >> bit) & 1) | (((*cell_y >> bit) & 1) << 1) | (((*cell_x >> bit) & 1) << 2));
+    node_index = node_index.child(octant);
+  }
+  return node_index;
+}
+
+Retiler::Retiler(std::vector<TiledOutput> sources,
+                 TilerMetaParameters meta_parameters,
+                 SamplingStrategy sampling_strategy,
+                 ProgressReporter* progress_reporter,
+                 PointsPersistence& persistence,
+                 const PointAttributes& input_attributes)
+  : _sources(std::move(sources))
+  , _meta_parameters(meta_parameters)
+  , _sampling_strategy(std::move(sampling_strategy))
+  , _progress_reporter(progress_reporter)
+  , _input_attributes(input_attributes)
+{
+  if (meta_parameters.tiling_strategy != TilingStrategy::Fast) {
+    throw std::invalid_argument{ "Re-tiling requires the fast tiling strategy" };
+  }
+  if (_sources.empty()) {
+    throw std::invalid_argument{ "Re-tiling requires at least one tiled output" };
+  }
+
+  std::vector<AABB> root_cubes;
+  for (const auto& source : _sources) {
+    root_cubes.push_back(source.bounds);
+  }
+  _root_cube = calculate_common_root_cube(root_cubes);
+  for (const auto& source : _sources) {
+    _roots_of_sources.push_back(find_node_with_bounds(source.bounds, _root_cube));
+  }
+
+  const auto center = _root_cube.getCenter();
+  _bounds = meta_parameters.shift_points_to_origin
+              ? AABB{ _root_cube.min - center, _root_cube.max - center }
+              : _root_cube;
+
+  _concurrency = total_thread_count(meta_parameters.thread_count);
+
+  _level_of_start_nodes = select_level_of_start_nodes();
+
+  _tiling_algorithm = std::make_unique<TilingAlgorithmV3>(
+    _sampling_strategy, _progress_reporter, persistence, _meta_parameters, fs::path{});
+  _tiling_algorithm->set_level_of_start_nodes(_level_of_start_nodes);
+}
+
+Retiler::~Retiler() {}
+
+size_t
+Retiler::run()
+{
+  const auto aligned_sources_count =
+    std::count_if(std::begin(_roots_of_sources),
+                  std::end(_roots_of_sources),
+                  [](const auto& root) { return root.has_value(); });
+  util::write_log(concat("Re-tiling ",
+                         _sources.size(),
+                         " tiled output(s) (",
+                         aligned_sources_count,
+                         " aligned to the new octree) with start nodes on level ",
+                         _level_of_start_nodes,
+                         "\n"));
+
+  const auto nodes_to_read = collect_nodes_to_read();
+
+  tf::Executor executor{ _concurrency };
+  size_t points_read = 0;
+  for (auto batch_begin = std::cbegin(nodes_to_read); batch_begin != std::cend(nodes_to_read);) {
+    const auto batch_end = select_next_batch(batch_begin, std::cend(nodes_to_read));
+    const auto batch_points_count =
+      std::accumulate(batch_begin, batch_end, size_t{ 0 }, [](auto accum, const auto& node) {
+        return accum + node.points_count;
+      });
+
+    tile_batch(batch_begin, batch_end, batch_points_count, executor);
+
+    points_read += batch_points_count;
+    batch_begin = batch_end;
+  }
+
+  _tiling_algorithm->finalize(_bounds);
+
+  return points_read;
+}
+
+uint32_t
+Retiler::reconstructed_levels() const
+{
+  return _tiling_algorithm->reconstructed_levels();
+}
+
+OctreeNodeIndex64
+Retiler::index_in_octree(size_t source, const TiledOutput::Node& node) const
+{
+  // Nodes of aligned sources are nodes of the new octree, their keys are
+  // prefixed with the key of the root of the source
+  const auto& root_of_source = _roots_of_sources[source];
+  if (root_of_source &&
+      root_of_source->levels() + node.index.levels() <= OctreeNodeIndex64::MAX_LEVELS) {
+    auto index = *root_of_source;
+    for (uint32_t level = 1; level <= node.index.levels(); ++level) {
+      index = index.child(node.index.octant_at_level(level));
+    }
+    return index;
+  }
+
+  // Otherwise, the node is in the deepest node of the new octree that contains
+  // both of its corners
+  const auto node_bounds = get_bounds_from_node_index(node.index, _sources[source].bounds);
+  const auto inset = node_bounds.extent().x * ALIGNMENT_TOLERANCE;
+  const auto index_of_corner = [this](const Vector3<double>& corner) {
+    const Vector3<double> clamped_corner{
+      std::min(_root_cube.max.x, std::max(_root_cube.min.x, corner.x)),
+      std::min(_root_cube.max.y, std::max(_root_cube.min.y, corner.y)),
+      std::min(_root_cube.max.z, std::max(_root_cube.min.z, corner.z))
+    };
+    return OctreeNodeIndex64{ calculate_morton_index<OctreeNodeIndex64::MAX_LEVELS>(
+      clamped_corner, _root_cube) };
+  };
+  const auto min_corner = index_of_corner(node_bounds.min + inset);
+  const auto max_corner = index_of_corner(node_bounds.max - Vector3<double>{ inset });
+  auto levels = OctreeNodeIndex64::MAX_LEVELS;
+  while (levels > 0 &&
+         !(min_corner.parent_at_level(levels) == max_corner.parent_at_level(levels))) {
+    --levels;
+  }
+  return min_corner.parent_at_level(levels);
+}
+
+uint32_t
+Retiler::select_level_of_start_nodes() const
+{
+  // Start nodes have to be below the root, which V3 always reconstructs. If
+  // possible, they are also below all reconstructed nodes of the sources, so
+  // that each start node contains whole subtrees of the sources
+  auto min_level = 1u;
+  uint32_t max_node_level = 0;
+  std::vector<OctreeNodeIndex64> node_indices;
+  for (size_t source = 0; source < _sources.size(); ++source) {
+    if (const auto& root_of_source = _roots_of_sources[source]) {
+      min_level =
+        std::max(min_level, root_of_source->levels() + _sources[source].reconstructed_levels);
+    }
+    for (const auto& node : _sources[source].nodes) {
+      node_indices.push_back(index_in_octree(source, node));
+      max_node_level = std::max(max_node_level, node_indices.back().levels());
+    }
+  }
+  min_level = std::min(min_level, MAX_LEVEL_OF_START_NODES);
+  const auto max_level = std::max(min_level, std::min(MAX_LEVEL_OF_START_NODES, max_node_level));
+
+  // The shallowest level with enough subtrees to keep all threads busy
+  for (auto level = min_level; level < max_level; ++level) {
+    std::unordered_set<OctreeNodeIndex64> subtrees;
+    for (const auto& node_index : node_indices) {
+      if (node_index.levels() >= level) {
+        subtrees.insert(node_index.parent_at_level(level));
+      }
+    }
+    if (subtrees.size() >= _concurrency)
+      return level;
+  }
+  return max_level;
+}
+
+std::vector<Retiler::NodeToRead>
+Retiler::collect_nodes_to_read() const
+{
+  std::vector<NodeToRead> nodes_to_read;
+  for (size_t source = 0; source < _sources.size(); ++source) {
+    for (const auto& node : _sources[source].nodes) {
+      if (node.index.levels() < _sources[source].reconstructed_levels)
+        continue;
+
+      auto point_file = open_point_file(node.file);
+      if (!point_file) {
+        throw util::chain_error(point_file.error(),
+                                concat("Could not open node file ", node.file.string()));
+      }
+      const auto points_count = pc::get_point_count(*point_file);
+      if (!points_count)
+        continue;
+
+      const auto node_index = index_in_octree(source, node);
+      const auto unit = (node_index.levels() >= _level_of_start_nodes)
+                          ? node_index.parent_at_level(_level_of_start_nodes)
+                          : node_index;
+      nodes_to_read.push_back({ &node, points_count, node_index, unit });
+    }
+  }
+
+  // Nodes above the start nodes contain points of several start nodes and are
+  // read first. All other nodes are grouped by their start node, which also
+  // puts overlapping nodes of different sources into the same batch
+  const auto first_node_in_start_node = std::stable_partition(
+    std::begin(nodes_to_read), std::end(nodes_to_read), [this](const NodeToRead& node) {
+      return node.index_in_octree.levels() < _level_of_start_nodes;
+    });
+  std::stable_sort(first_node_in_start_node,
+                   std::end(nodes_to_read),
+                   [](const NodeToRead& l, const NodeToRead& r) {
+                     return l.unit.index() < r.unit.index();
+                   });
+
+  return nodes_to_read;
+}
+
+std::vector<Retiler::NodeToRead>::const_iterator
+Retiler::select_next_batch(std::vector<NodeToRead>::const_iterator begin,
+                           std::vector<NodeToRead>::const_iterator end) const
+{
+  const auto max_batch_size = _meta_parameters.internal_cache_size;
+  size_t batch_size = 0;
+  auto iter = begin;
+  while (iter != end) {
+    const auto unit_end = std::find_if(
+      iter, end, [&unit = iter->unit](const NodeToRead& node) { return !(node.unit == unit); });
+    const auto unit_size =
+      std::accumulate(iter, unit_end, size_t{ 0 }, [](auto accum, const auto& node) {
+        return accum + node.points_count;
+      });
+    if (batch_size + unit_size <= max_batch_size) {
+      batch_size += unit_size;
+      iter = unit_end;
+      continue;
+    }
+
+    // A unit that does not fit into this batch starts the next batch, unless
+    // it does not fit into any batch. Then it is split between its node files
+    if (batch_size)
+      break;
+    while (iter != unit_end && (!batch_size || batch_size + iter->points_count <= max_batch_size)) {
+      batch_size += iter->points_count;
+      ++iter;
+    }
+    break;
+  }
+  return iter;
+}
+
+void
+Retiler::read_node_into(const TiledOutput::Node& node,
+                        util::Range<PointBuffer::PointIterator> point_range) const
+{
+  auto point_file = open_point_file(node.file);
+  if (!point_file) {
+    throw util::chain_error(point_file.error(),
+                            concat("Could not open node file ", node.file.string()));
+  }
+
+  std::visit(
+    [this, &node, point_range](const auto& typed_file) {
+      const auto read_result = pc::read_points_into(std::cbegin(typed_file),
+                                                    std::cend(typed_file),
+                                                    pc::metadata(typed_file),
+                                                    _input_attributes,
+                                                    point_range);
+      if (read_result.second != std::end(point_range)) {
+        throw std::runtime_error{ concat(
+          "Node file ", node.file.string(), " contains fewer points than its header states") };
+      }
+    },
+    *point_file);
+
+  // Same as the Tiler: Points are shifted to the center of the root node
+  if (_meta_parameters.shift_points_to_origin) {
+    shift_and_truncate_positions(point_range, _root_cube.getCenter());
+  }
+}
+
+void
+Retiler::tile_batch(std::vector<NodeToRead>::const_iterator begin,
+                    std::vector<NodeToRead>::const_iterator end,
+                    size_t points_count,
+                    tf::Executor& executor)
+{
+  PointBuffer points{ points_count, _input_attributes };
+
+  tf::Taskflow read_taskflow;
+  size_t offset = 0;
+  for (auto iter = begin; iter != end; ++iter) {
+    const auto& node = *iter;
+    read_taskflow
+      .emplace([this, &node, &points, offset]() {
+        read_node_into(*node.node,
+                       { std::begin(points) + offset,
+                         std::begin(points) + offset + node.points_count });
+        if (_progress_reporter) {
+          _progress_reporter->increment_progress<size_t>(progress::LOADING, node.points_count);
+        }
+      })
+      .name(concat("read_", node.node->file.filename().string()));
+    offset += node.points_count;
+  }
+  executor.run(read_taskflow).get();
+
+  const auto num_indexing_threads = num_indexing_tasks_for_batch(_concurrency, points.count());
+
+  tf::Taskflow tiling_taskflow;
+  _tiling_algorithm->build_execution_graph(
+    { std::begin(points), std::end(points) }, _bounds, num_indexing_threads, tiling_taskflow);
+  executor.run(tiling_taskflow).get();
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include "datastructures/OctreeNodeIndex.h"
+#include "datastructures/PointBuffer.h"
+#include "io/PointsPersistence.h"
+#include "math/AABB.h"
+#include "pointcloud/PointAttributes.h"
+#include "process/Tiler.h"
+#include "tiling/Sampling.h"
+
+#include <containers/Range.h>
+
+#include <experimental/filesystem>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <taskflow/taskflow.hpp>
+
+namespace fs = std::experimental::filesystem;
+
+struct ProgressReporter;
+struct TilingAlgorithmV3;
+
+/**
+ * The output of a previous tiler run, used as the source for re-tiling. Only
+ * outputs with LAS/LAZ nodes (output formats LAS, LAZ, ENTWINE_LAS and
+ * ENTWINE_LAZ) are supported, since only these store all attributes of the
+ * points at full precision
+ */
+struct TiledOutput
+{
+  struct Node
+  {
+    OctreeNodeIndex64 index;
+    fs::path file;
+  };
+
+  fs::path directory;
+  /**
+   * Cubic bounds of the root node
+   */
+  AABB bounds;
+  float spacing_at_root;
+  size_t points_count;
+  /**
+   * Number of levels at the top of the octree whose nodes contain copies of the
+   * points in deeper nodes, see 'TilingAlgorithmBase::reconstructed_levels'
+   */
+  uint32_t reconstructed_levels;
+  std::vector<Node> nodes;
+};
+
+/**
+ * Reads the 'properties.json' file and finds the node files of the output of
+ * a previous tiler run in the given directory
+ */
+TiledOutput
+read_tiled_output(const fs::path& directory);
+
+/**
+ * Calculates the root bounds of an octree that contains all of the given
+ * cubic root bounds. If all cubes lie on the grid of the smallest cube (i.e.
+ * their side lengths are the side length of the smallest cube times a power of
+ * two and they are aligned to their own side length on this grid), the result
+ * is a cube on this grid, so that each of the cubes is a node of the new
+ * octree. Otherwise, this is the cubic hull of all cubes
+ */
+AABB
+calculate_common_root_cube(const std::vector<AABB>& cubes);
+
+/**
+ * Returns the index of the node in the octree with the given root bounds whose
+ * bounds are the given bounds, or std::nullopt if there is no such node
+ */
+std::optional<OctreeNodeIndex64>
+find_node_with_bounds(const AABB& node_bounds, const AABB& root_bounds);
+
+/**
+ * Tiles the points of one or more previous tiler outputs again with new
+ * parameters (spacing, points per node, sampling strategy, output format etc.),
+ * without reading and indexing the original source files. Several outputs are
+ * merged into a single octree.
+ *
+ * The previous octrees are already partitioned spatially, so all nodes below a
+ * node of a previous octree form an independent unit of work. The units are
+ * the start nodes of the 'FAST' tiling strategy (TilingAlgorithmV3) in the new
+ * octree. Each batch reads the node files of whole units, so the points of a
+ * start node are sorted only together with the points of the same unit, and
+ * overlapping nodes of different outputs are merged in the same batch. The
+ * nodes above the start nodes are rebuilt from their children at the end.
+ * Nodes of the previous octrees that were reconstructed from their children
+ * are skipped, since their points are copies
+ */
+struct Retiler
+{
+  Retiler(std::vector<TiledOutput> sources,
+          TilerMetaParameters meta_parameters,
+          SamplingStrategy sampling_strategy,
+          ProgressReporter* progress_reporter,
+          PointsPersistence& persistence,
+          const PointAttributes& input_attributes);
+  ~Retiler();
+
+  /**
+   * Run the re-tiling. Returns the total number of points that were processed
+   */
+  size_t run();
+
+  /**
+   * Number of levels at the top of the new octree whose nodes were
+   * reconstructed from their children
+   */
+  uint32_t reconstructed_levels() const;
+
+  /**
+   * Bounds of the root node of the octree
+   */
+  const AABB& bounds() const { return _bounds; }
+
+  /**
+   * Bounds of the root node of the octree, before the points are shifted to
+   * the origin (see 'TilerMetaParameters::shift_points_to_origin')
+   */
+  const AABB& root_cube() const { return _root_cube; }
+
+private:
+  struct NodeToRead
+  {
+    const TiledOutput::Node* node;
+    size_t points_count;
+    /**
+     * The smallest node in the new octree that contains this node
+     */
+    OctreeNodeIndex64 index_in_octree;
+    /**
+     * The start node in the new octree that contains the points of this node,
+     * or 'index_in_octree' if this node is above the level of the start nodes
+     */
+    OctreeNodeIndex64 unit;
+  };
+
+  OctreeNodeIndex64 index_in_octree(size_t source, const TiledOutput::Node& node) const;
+  uint32_t select_level_of_start_nodes() const;
+  std::vector<NodeToRead> collect_nodes_to_read() const;
+  std::vector<NodeToRead>::const_iterator select_next_batch(
+    std::vector<NodeToRead>::const_iterator begin,
+    std::vector<NodeToRead>::const_iterator end) const;
+  void read_node_into(const TiledOutput::Node& node,
+                      util::Range<PointBuffer::PointIterator> point_range) const;
+  void tile_batch(std::vector<NodeToRead>::const_iterator begin,
+                  std::vector<NodeToRead>::const_iterator end,
+                  size_t points_count,
+                  tf::Executor& executor);
+
+  std::vector<TiledOutput> _sources;
+  /**
+   * The node in the new octree for the root node of each source, if the root
+   * node of the source is aligned to the new octree
+   */
+  std::vector<std::optional<OctreeNodeIndex64>> _roots_of_sources;
+  TilerMetaParameters _meta_parameters;
+  SamplingStrategy _sampling_strategy;
+  ProgressReporter* _progress_reporter;
+  const PointAttributes& _input_attributes;
+
+  AABB _root_cube;
+  AABB _bounds;
+  uint32_t _concurrency;
+  uint32_t _level_of_start_nodes;
+
+  std::unique_ptr<TilingAlgorithmV3> _tiling_algorithm;
+};
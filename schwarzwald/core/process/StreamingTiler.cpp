@@ -0,0 +1,221 @@
+#include "process/StreamingTiler.h"
+
+#include "tiling/TilingAlgorithms.h"
+#include "util/stuff.h"
+
+#include <algorithm>
+#include <gsl/gsl>
+#include <vector>
+
+/**
+ * The start nodes are on a fixed level, since the extent of the points is not
+ * known in advance. This is deep enough that the points of a batch from a moving
+ * sensor spread over several start nodes, while the nodes above the start nodes
+ * that are reconstructed after each batch stay few
+ */
+constexpr static uint32_t LEVEL_OF_START_NODES = 4;
+
+StreamingTiler::StreamingTiler(const AABB& bounds,
+                               TilerMetaParameters meta_parameters,
+                               SamplingStrategy sampling_strategy,
+                               StreamingBudgets budgets,
+                               ProgressReporter* progress_reporter,
+                               PointsPersistence& persistence,
+                               const PointAttributes& input_attributes,
+                               FlushCallback on_flush)
+  : _stream_bounds(bounds)
+  , _root_cube(bounds.cubic())
+  , _meta_parameters(meta_parameters)
+  , _sampling_strategy(std::move(sampling_strategy))
+  , _budgets(budgets)
+  , _persistence(persistence)
+  , _input_attributes(input_attributes)
+  , _on_flush(std::move(on_flush))
+  , _pending_points(0, input_attributes)
+  , _dropped_points_count(0)
+  , _tiled_points_count(0)
+  , _stopping(false)
+{
+  if (meta_parameters.tiling_strategy != TilingStrategy::Fast) {
+    throw std::invalid_argument{ "Streaming requires the fast tiling strategy" };
+  }
+  if (!meta_parameters.batch_read_size) {
+    throw std::invalid_argument{ "Streaming requires a batch size greater than zero" };
+  }
+
+  const auto center = _root_cube.getCenter();
+  _bounds = meta_parameters.shift_points_to_origin
+              ? AABB{ _root_cube.min - center, _root_cube.max - center }
+              : _root_cube;
+
+  _concurrency = total_thread_count(meta_parameters.thread_count);
+
+  _tiling_algorithm = std::make_unique<TilingAlgorithmV3>(
+    _sampling_strategy, progress_reporter, _persistence, _meta_parameters, fs::path{});
+  _tiling_algorithm->set_level_of_start_nodes(LEVEL_OF_START_NODES);
+  _executor = std::make_unique<tf::Executor>(_concurrency);
+
+  _background_thread = std::thread{ [this]() { run_background_thread(); } };
+}
+
+StreamingTiler::~StreamingTiler()
+{
+  stop();
+}
+
+void
+StreamingTiler::insert(PointBuffer points)
+{
+  std::vector<PointBuffer::PointReference> points_inside;
+  points_inside.reserve(points.count());
+  for (auto point_ref : points) {
+    if (_stream_bounds.isInside(point_ref.position())) {
+      points_inside.push_back(point_ref);
+    }
+  }
+  const auto dropped_points_count = points.count() - points_inside.size();
+
+  std::unique_lock lock{ _lock };
+  _state_changed.wait(lock, [this]() {
+    return _error || _stopping || _pending_points.count() < 2 * _meta_parameters.batch_read_size;
+  });
+  if (_error) {
+    std::rethrow_exception(_error);
+  }
+  if (_stopping) {
+    throw std::runtime_error{ "Can't insert points after streaming has finished" };
+  }
+
+  if (dropped_points_count) {
+    _pending_points.append_buffer(PointBuffer{ gsl::make_span(points_inside) });
+  } else {
+    _pending_points.append_buffer(points);
+  }
+  _dropped_points_count += dropped_points_count;
+  lock.unlock();
+
+  _state_changed.notify_all();
+}
+
+size_t
+StreamingTiler::finish()
+{
+  stop();
+
+  std::lock_guard lock{ _lock };
+  if (_error) {
+    std::rethrow_exception(_error);
+  }
+  return _tiled_points_count;
+}
+
+size_t
+StreamingTiler::dropped_points_count() const
+{
+  std::lock_guard lock{ _lock };
+  return _dropped_points_count;
+}
+
+uint32_t
+StreamingTiler::reconstructed_levels() const
+{
+  return _tiling_algorithm->reconstructed_levels();
+}
+
+void
+StreamingTiler::run_background_thread()
+{
+  try {
+    auto last_flush_time = std::chrono::steady_clock::now();
+    size_t points_since_last_flush = 0;
+    while (true) {
+      PointBuffer batch{ 0, _input_attributes };
+      bool stopping;
+      {
+        // A batch is tiled once it is full, once the flush interval has passed
+        // while there are points that are not flushed yet, or at the end
+        std::unique_lock lock{ _lock };
+        while (!_stopping && _pending_points.count() < _meta_parameters.batch_read_size) {
+          if (!points_since_last_flush && _pending_points.empty()) {
+            _state_changed.wait(lock);
+            continue;
+          }
+          if (_state_changed.wait_until(lock, last_flush_time + _budgets.flush_interval) ==
+              std::cv_status::timeout)
+            break;
+        }
+        std::swap(batch, _pending_points);
+        stopping = _stopping;
+      }
+      // Inserting threads might wait for the pending points to be taken
+      _state_changed.notify_all();
+
+      if (!batch.empty()) {
+        tile_batch(batch);
+        points_since_last_flush += batch.count();
+      }
+
+      const auto now = std::chrono::steady_clock::now();
+      const auto flush_is_due =
+        stopping || (points_since_last_flush &&
+                     ((now - last_flush_time) >= _budgets.flush_interval ||
+                      points_since_last_flush >= _budgets.max_points_per_flush));
+      if (flush_is_due) {
+        flush();
+        last_flush_time = std::chrono::steady_clock::now();
+        points_since_last_flush = 0;
+      }
+
+      if (stopping)
+        return;
+    }
+  } catch (...) {
+    {
+      std::lock_guard lock{ _lock };
+      _error = std::current_exception();
+    }
+    _state_changed.notify_all();
+  }
+}
+
+void
+StreamingTiler::tile_batch(PointBuffer& points)
+{
+  // Same as the Tiler: Points are shifted to the center of the root node
+  if (_meta_parameters.shift_points_to_origin) {
+    shift_and_truncate_positions({ std::begin(points), std::end(points) }, _root_cube.getCenter());
+  }
+
+  const auto num_indexing_threads = num_indexing_tasks_for_batch(_concurrency, points.count());
+
+  tf::Taskflow tiling_taskflow;
+  _tiling_algorithm->build_execution_graph(
+    { std::begin(points), std::end(points) }, _bounds, num_indexing_threads, tiling_taskflow);
+  _executor->run(tiling_taskflow).get();
+
+  _tiling_algorithm->reconstruct_updated_nodes(_bounds);
+  _tiled_points_count += points.count();
+}
+
+void
+StreamingTiler::flush()
+{
+  _persistence.flush();
+  if (_on_flush) {
+    _on_flush(_tiled_points_count);
+  }
+}
+
+void
+StreamingTiler::stop()
+{
+  {
+    std::lock_guard lock{ _lock };
+    _stopping = true;
+  }
+  _state_changed.notify_all();
+
+  if (_background_thread.joinable()) {
+    _background_thread.join();
+  }
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "datastructures/PointBuffer.h"
+#include "io/PointsPersistence.h"
+#include "math/AABB.h"
+#include "pointcloud/PointAttributes.h"
+#include "process/Tiler.h"
+#include "tiling/Sampling.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <taskflow/taskflow.hpp>
+
+struct ProgressReporter;
+struct TilingAlgorithmV3;
+
+/**
+ * Budgets for writing the nodes that a StreamingTiler updated to the output
+ */
+struct StreamingBudgets
+{
+  /**
+   * Maximum time between inserting points and flushing the nodes that contain
+   * them, not counting the time it takes to tile and write the points
+   */
+  std::chrono::milliseconds flush_interval;
+  /**
+   * The updated nodes are also flushed once this many points were tiled since
+   * the last flush
+   */
+  size_t max_points_per_flush;
+};
+
+/**
+ * Tiles points that arrive continuously (e.g. from a mobile mapping sensor)
+ * into an octree with fixed bounds, while the octree is being read. The root
+ * node of the octree is the cubic hull of these bounds.
+ *
+ * Inserted points are collected by a background thread and tiled as a batch of
+ * the 'FAST' tiling strategy (TilingAlgorithmV3) once a batch is full or the
+ * flush interval has passed. After each batch, the nodes above the start nodes
+ * that received points are reconstructed, so that the octree always has all
+ * levels. The persistence is flushed after the batch if one of the budgets is
+ * exceeded, which writes the updated nodes and (for Entwine output) the
+ * hierarchy files of the updated subtrees. Node files are replaced atomically,
+ * so that viewers always see complete nodes
+ */
+struct StreamingTiler
+{
+  /**
+   * Called after each flush with the number of points in the octree, e.g. to
+   * write the metadata files of the output
+   */
+  using FlushCallback = std::function<void(size_t)>;
+
+  StreamingTiler(const AABB& bounds,
+                 TilerMetaParameters meta_parameters,
+                 SamplingStrategy sampling_strategy,
+                 StreamingBudgets budgets,
+                 ProgressReporter* progress_reporter,
+                 PointsPersistence& persistence,
+                 const PointAttributes& input_attributes,
+                 FlushCallback on_flush = {});
+  ~StreamingTiler();
+
+  /**
+   * Queues the given points for tiling. Points outside of the bounds given on
+   * construction are dropped, even if they are inside of the root node. If
+   * tiling falls behind and two batches of points are pending, this blocks
+   * until the next batch has been taken. Errors of the background thread are
+   * rethrown here
+   */
+  void insert(PointBuffer points);
+
+  /**
+   * Tiles all pending points, flushes the persistence and stops the background
+   * thread. Returns the number of points in the octree
+   */
+  size_t finish();
+
+  /**
+   * Number of inserted points that were dropped because they were outside of
+   * the bounds
+   */
+  size_t dropped_points_count() const;
+
+  /**
+   * Number of levels at the top of the octree whose nodes were reconstructed
+   * from their children
+   */
+  uint32_t reconstructed_levels() const;
+
+  /**
+   * Bounds of the root node of the octree
+   */
+  const AABB& bounds() const { return _bounds; }
+
+private:
+  void run_background_thread();
+  void tile_batch(PointBuffer& points);
+  void flush();
+  void stop();
+
+  // Bounds of the points, which the output metadata states as the bounds of
+  // the data (e.g. 'boundsConforming' in 'ept.json')
+  AABB _stream_bounds;
+  AABB _root_cube;
+  AABB _bounds;
+  TilerMetaParameters _meta_parameters;
+  SamplingStrategy _sampling_strategy;
+  StreamingBudgets _budgets;
+  PointsPersistence& _persistence;
+  PointAttributes _input_attributes;
+  FlushCallback _on_flush;
+
+  uint32_t _concurrency;
+  std::unique_ptr<TilingAlgorithmV3> _tiling_algorithm;
+  std::unique_ptr<tf::Executor> _executor;
+
+  mutable std::mutex _lock;
+  std::condition_variable _state_changed;
+  PointBuffer _pending_points;
+  size_t _dropped_points_count;
+  size_t _tiled_points_count;
+  bool _stopping;
+  std::exception_ptr _error;
+
+  std::thread _background_thread;
+};
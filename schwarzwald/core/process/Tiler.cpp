@@ -2,6 +2,7 @@
 
 #include "containers/Range.h"
 #include "datastructures/PointBuffer.h"
+#include "io/AttributeStore.h"
 #include "io/PNTSReader.h"
 #include "io/PNTSWriter.h"
 #include "io/TileSetWriter.h"
@@ -157,6 +158,38 @@ journal_read_commands(const std::vector<std::vector<ReadCommand>>& read_commands
   journal->add_record_untyped(ss.str());
 }
 
+uint32_t
+total_thread_count(const ThreadConfig& thread_config)
+{
+  const auto num_threads = std::visit(
+    overloaded{ [](const FixedThreadCount& thread_count) {
+                 return thread_count.num_threads_for_reading +
+                        thread_count.num_threads_for_indexing;
+               },
+                [](const AdaptiveThreadCount& thread_count) { return thread_count.num_threads; } },
+    thread_config);
+  return std::max(1u, num_threads);
+}
+
+uint32_t
+num_indexing_tasks_for_batch(size_t concurrency, size_t points_count)
+{
+  return static_cast<uint32_t>(std::min(concurrency, points_count));
+}
+
+void
+shift_and_truncate_positions(util::Range<PointBuffer::PointIterator> points,
+                             const Vector3<double>& center)
+{
+  for (auto point_ref : points) {
+    auto position = point_ref.position() - center;
+    position.x = static_cast<float>(position.x);
+    position.y = static_cast<float>(position.y);
+    position.z = static_cast<float>(position.z);
+    point_ref.set_position(position);
+  }
+}
+
 Tiler::Tiler(DatasetMetadata dataset_metadata,
              TilerMetaParameters meta_parameters,
              SamplingStrategy sampling_strategy,
@@ -164,7 +197,9 @@ Tiler::Tiler(DatasetMetadata dataset_metadata,
              MultiReaderPointSource point_source,
              PointsPersistence& persistence,
              const PointAttributes& input_attributes,
-             fs::path output_directory)
+             fs::path output_directory,
+             std::optional<PartitionedOutput> partitioned_output,
+             AttributeStore* attribute_store)
   : _dataset_metadata(std::move(dataset_metadata))
   , _meta_parameters(meta_parameters)
   , _sampling_strategy(std::move(sampling_strategy))
@@ -173,6 +208,8 @@ Tiler::Tiler(DatasetMetadata dataset_metadata,
   , _persistence(persistence)
   , _input_attributes(input_attributes)
   , _output_directory(std::move(output_directory))
+  , _attribute_store(attribute_store)
+  , _read_cost_model(_dataset_metadata)
   , _producers(0)
   , _consumers(1)
 {
@@ -188,18 +225,45 @@ Tiler::Tiler(DatasetMetadata dataset_metadata,
 
   switch (meta_parameters.tiling_strategy) {
     case TilingStrategy::Accurate:
+      if (partitioned_output) {
+        throw std::invalid_argument{
+          "Partitioning points by classification requires the fast tiling strategy"
+        };
+      }
       _tiling_algorithm = std::make_unique<TilingAlgorithmV1>(
         _sampling_strategy, _progress_reporter, _persistence, _meta_parameters);
       break;
     case TilingStrategy::Fast:
-      _tiling_algorithm = std::make_unique<TilingAlgorithmV3>(
-        _sampling_strategy, _progress_reporter, _persistence, _meta_parameters, _output_directory);
+      _tiling_algorithm = std::make_unique<TilingAlgorithmV3>(_sampling_strategy,
+                                                              _progress_reporter,
+                                                              _persistence,
+                                                              _meta_parameters,
+                                                              _output_directory,
+                                                              std::move(partitioned_output));
       break;
   }
 }
 
 Tiler::~Tiler() {}
 
+std::vector<size_t>
+Tiler::points_per_partition() const
+{
+  return _tiling_algorithm->points_per_partition();
+}
+
+uint32_t
+Tiler::reconstructed_levels() const
+{
+  return _tiling_algorithm->reconstructed_levels();
+}
+
+void
+Tiler::on_batch_finished(BatchFinishedCallback callback)
+{
+  _batch_finished_callback = std::move(callback);
+}
+
 size_t
 Tiler::run()
 {
@@ -279,6 +343,11 @@ Tiler::run()
     if (last_run) {
       break;
     }
+
+    if (_batch_finished_callback) {
+      _batch_finished_callback(
+        [this]() { _tiling_algorithm->reconstruct_updated_nodes(_bounds); });
+    }
   }
 
   _tiling_algorithm->finalize(_bounds);
@@ -296,71 +365,14 @@ Tiler::build_execution_graph_for_reading(tf::Taskflow& tf,
   auto start_task =
     tf.emplace([this]() { _begin_read_cycle_time = std::chrono::high_resolution_clock::now(); });
 
-  adjust_read_thread_count(num_read_threads);
-
-  size_t num_read_points_in_current_batch = 0;
-  const auto total_max_points_in_batch = _meta_parameters.internal_cache_size;
-  const auto max_points_per_thread = total_max_points_in_batch / num_read_threads;
-
-  std::vector<std::vector<ReadCommand>> read_commands_per_read_thread;
-  read_commands_per_read_thread.resize(num_read_threads);
-
-  std::vector<size_t> remaining_points_to_read_per_thread;
-  remaining_points_to_read_per_thread.resize(num_read_threads);
-  std::generate_n(std::begin(remaining_points_to_read_per_thread),
-                  num_read_threads,
-                  [max_points_per_thread]() { return max_points_per_thread; });
-
-  // Take as many ReadCommands as we can for a thread, then move onto the next
-  // thread
-
-  for (uint32_t thread_idx = 0; thread_idx < num_read_threads; ++thread_idx) {
-    auto& next_read_command_cur_thread = _next_read_commands_per_thread[thread_idx];
-    auto& scheduled_read_commands_cur_thread = read_commands_per_read_thread[thread_idx];
-    auto& remaining_points_to_read_cur_thread = remaining_points_to_read_per_thread[thread_idx];
-
-    // Schedule commands for this thread until we either scheduled enough points
-    // to read, or we run out of ReadCommands
-    while (remaining_points_to_read_cur_thread) {
-      if (next_read_command_cur_thread.to_read_count == 0) {
-        if (_remaining_read_commands.empty()) {
-          // Distribute the remaining points that could not be read by this
-          // thread evenly to the remaining threads
-          auto remaining_points = remaining_points_to_read_per_thread[thread_idx];
-          const auto remaining_threads = num_read_threads - thread_idx;
-          if (remaining_points && remaining_threads) {
-            for (uint32_t next_thread_idx = thread_idx + 1; next_thread_idx < num_read_threads;
-                 ++next_thread_idx) {
-              const auto remainder_for_this_thread = (next_thread_idx == num_read_threads - 1)
-                                                       ? remaining_points
-                                                       : (remaining_points / remaining_threads);
-              remaining_points_to_read_per_thread[next_thread_idx] += remainder_for_this_thread;
-              remaining_points -= remainder_for_this_thread;
-            }
-          }
-          break;
-        }
-        next_read_command_cur_thread = _remaining_read_commands.front();
-        _remaining_read_commands.pop_front();
-
-        // Ignore empty files
-        if (next_read_command_cur_thread.to_read_count == 0) {
-          continue;
-        }
-      }
-
-      // Take as many points as we can
-      const auto points_to_read_from_cur_file =
-        std::min(remaining_points_to_read_cur_thread, next_read_command_cur_thread.to_read_count);
-      scheduled_read_commands_cur_thread.push_back(
-        { next_read_command_cur_thread.file_path, points_to_read_from_cur_file });
-
-      remaining_points_to_read_cur_thread -= points_to_read_from_cur_file;
-      next_read_command_cur_thread.to_read_count -= points_to_read_from_cur_file;
-
-      num_read_points_in_current_batch += points_to_read_from_cur_file;
-    }
-  }
+  // Files differ in how expensive their points are to read (compression,
+  // record length, local or remote storage), so we balance the estimated cost
+  // instead of the number of points per thread
+  auto [read_commands_per_read_thread, num_read_points_in_current_batch] =
+    schedule_read_commands(_remaining_read_commands,
+                           std::max(1u, num_read_threads),
+                           _meta_parameters.internal_cache_size,
+                           _read_cost_model);
 
   if (global_config().is_journaling_enabled) {
     journal_read_commands(read_commands_per_read_thread);
@@ -420,25 +432,6 @@ Tiler::build_execution_graph_for_reading(tf::Taskflow& tf,
   return true;
 }
 
-void
-Tiler::adjust_read_thread_count(size_t num_read_threads)
-{
-  if (num_read_threads == _next_read_commands_per_thread.size())
-    return;
-
-  if (num_read_threads > _next_read_commands_per_thread.size()) {
-    _next_read_commands_per_thread.resize(num_read_threads);
-    return;
-  }
-
-  // Shrink and put back read commands into _remaining_read_commands
-  _remaining_read_commands.insert(std::begin(_remaining_read_commands),
-                                  std::begin(_next_read_commands_per_thread) + num_read_threads,
-                                  std::end(_next_read_commands_per_thread));
-
-  _next_read_commands_per_thread.resize(num_read_threads);
-}
-
 void
 Tiler::create_read_commands()
 {
@@ -446,14 +439,12 @@ Tiler::create_read_commands()
   // points. In build_execution_graph_for_reading, we will slice off points from
   // these ReadCommands. Once a ReadCommand has zero points left, it is finished
 
-  std::transform(std::begin(_dataset_metadata.get_all_files_metadata()),
-                 std::end(_dataset_metadata.get_all_files_metadata()),
-                 std::back_inserter(_remaining_read_commands),
-                 [](const auto& kv) -> ReadCommand {
-                   const auto& file_path = kv.first;
-                   const auto& metadata = kv.second;
-                   return { &file_path, metadata.points_count };
-                 });
+  for (const auto& [file_path, metadata] : _dataset_metadata.get_all_files_metadata()) {
+    // Ignore empty files
+    if (!metadata.points_count)
+      continue;
+    _remaining_read_commands.push_back({ &file_path, metadata.points_count });
+  }
 }
 
 void
@@ -471,11 +462,15 @@ Tiler::execute_read_commands(const std::vector<ReadCommand>& read_commands,
                                   .str() };
     }
 
+    const auto read_start = std::chrono::high_resolution_clock::now();
     const auto new_read_destination_start = next_file->read_next_into(
       { read_destination_start, read_destination_start + read_command.to_read_count },
       _input_attributes);
     const auto num_points_read =
       static_cast<size_t>(std::distance(read_destination_start, new_read_destination_start));
+    _read_cost_model.record_read(*read_command.file_path,
+                                 num_points_read,
+                                 std::chrono::high_resolution_clock::now() - read_start);
     assert(num_points_read == read_command.to_read_count);
     read_destination_start = new_read_destination_start;
 
@@ -492,8 +487,7 @@ Tiler::max_read_parallelism() const
 {
   // Calculate the total number of remaining files, which equals the maximum
   // parallelism for reading that we can sustain
-  return gsl::narrow<uint32_t>(_next_read_commands_per_thread.size() +
-                               _remaining_read_commands.size());
+  return gsl::narrow<uint32_t>(_remaining_read_commands.size());
 }
 
 void
@@ -544,7 +538,15 @@ void
 Tiler::swap_point_buffers(size_t produced_points_count)
 {
   _consumers.wait();
-  std::swap(_points_cache_for_producers, _points_cache_for_consumers);
+  if (_attribute_store) {
+    // Only the positions, the attributes that tiling needs and the point IDs
+    // are indexed. The producer buffer keeps all attributes, since it is
+    // refilled in the next read cycle
+    _points_cache_for_consumers =
+      _attribute_store->store(_points_cache_for_producers, produced_points_count);
+  } else {
+    std::swap(_points_cache_for_producers, _points_cache_for_consumers);
+  }
   _produced_points_count = produced_points_count;
   //_points_cache_for_producers.clear();
   _producers.notify();
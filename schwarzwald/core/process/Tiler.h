@@ -6,7 +6,11 @@
 #include "point_source/PointSource.h"
 #include "pointcloud/FileStats.h"
 #include "pointcloud/PointAttributes.h"
+#include "process/ReadScheduling.h"
+#include "tiling/ClassificationPartitioning.h"
+#include "tiling/PointOrder.h"
 #include "tiling/Sampling.h"
+#include "types/Units.h"
 #include "util/Definitions.h"
 #include "util/Transformation.h"
 #include <reflection/StaticReflection.h>
@@ -15,12 +19,15 @@
 
 #include <atomic>
 #include <deque>
+#include <functional>
 #include <gsl/gsl>
+#include <optional>
 #include <string>
 #include <thread>
 
 #include <taskflow/taskflow.hpp>
 
+struct AttributeStore;
 struct ProgressReporter;
 struct TilingAlgorithmBase;
 struct ThroughputSampler;
@@ -72,15 +79,47 @@ struct TilerMetaParameters
   bool create_journal;
   TilingStrategy tiling_strategy;
   std::variant<FixedThreadCount, AdaptiveThreadCount> thread_count;
+  bool estimate_normals;
+  PointOrder point_order;
+  /**
+   * Memory budget for the occupancies of the interior nodes, which are kept
+   * between batches. Unlimited if not set
+   */
+  std::optional<unit::byte> node_occupancy_cache_size;
 };
 
 /**
- * Abstract command for reading points from a file.
+ * Total number of threads of the given thread configuration, which is at least 1
+ */
+uint32_t
+total_thread_count(const ThreadConfig& thread_config);
+
+/**
+ * Number of indexing tasks for a batch of 'points_count' points on 'concurrency'
+ * threads. Each indexing task needs at least one point
+ */
+uint32_t
+num_indexing_tasks_for_batch(size_t concurrency, size_t points_count);
+
+/**
+ * Shifts the given points by '-center' and truncates their positions to 32-bit,
+ * so that they can be persisted losslessly in formats with 32-bit positions
+ */
+void
+shift_and_truncate_positions(util::Range<PointBuffer::PointIterator> points,
+                             const Vector3<double>& center);
+
+/**
+ * Output for tiling the points of each classification group into a separate
+ * octree
  */
-struct ReadCommand
+struct PartitionedOutput
 {
-  const fs::path* file_path;
-  size_t to_read_count;
+  ClassificationPartitioning partitioning;
+  /**
+   * One persistence for each group in 'partitioning', in the same order
+   */
+  std::vector<PointsPersistence*> persistences;
 };
 
 struct Tiler
@@ -92,7 +131,9 @@ struct Tiler
         MultiReaderPointSource point_source,
         PointsPersistence& persistence,
         const PointAttributes& input_attributes,
-        fs::path output_directory);
+        fs::path output_directory,
+        std::optional<PartitionedOutput> partitioned_output = std::nullopt,
+        AttributeStore* attribute_store = nullptr);
   ~Tiler();
 
   /**
@@ -100,6 +141,40 @@ struct Tiler
    */
   size_t run();
 
+  /**
+   * Number of points in each octree when tiling with a PartitionedOutput
+   */
+  std::vector<size_t> points_per_partition() const;
+
+  /**
+   * Number of levels at the top of the octree(s) whose nodes were
+   * reconstructed from their children, see
+   * 'TilingAlgorithmBase::reconstructed_levels'
+   */
+  uint32_t reconstructed_levels() const;
+
+  /**
+   * Callback for 'on_batch_finished'. Nodes that the tiling algorithm only
+   * writes at the end (e.g. the top levels of the 'Fast' strategy) are only
+   * brought up to date when the callback calls 'reconstruct_updated_nodes'.
+   * This is expensive, so callbacks should only call it right before they
+   * read these nodes
+   */
+  using BatchFinishedCallback =
+    std::function<void(const std::function<void()>& reconstruct_updated_nodes)>;
+
+  /**
+   * Sets a callback that is invoked after each batch except the last one,
+   * while no tiling tasks are running. The callback can safely read the nodes
+   * that have been tiled so far
+   */
+  void on_batch_finished(BatchFinishedCallback callback);
+
+  /**
+   * Bounds of the root node of the octree(s)
+   */
+  const AABB& bounds() const { return _bounds; }
+
 private:
   void swap_point_buffers(size_t produced_points_count);
 
@@ -114,7 +189,6 @@ private:
                                           ThroughputSampler& throughput_sampler);
 
   void create_read_commands();
-  void adjust_read_thread_count(size_t num_read_threads);
   uint32_t max_read_parallelism() const;
 
   void estimate_read_throughput(ThroughputSampler& sampler, size_t num_points_in_last_cycle) const;
@@ -131,14 +205,16 @@ private:
 
   const PointAttributes& _input_attributes;
   fs::path _output_directory;
+  AttributeStore* _attribute_store;
 
   PointBuffer _points_cache_for_producers, _points_cache_for_consumers;
   size_t _produced_points_count;
 
   std::deque<ReadCommand> _remaining_read_commands;
-  std::vector<ReadCommand> _next_read_commands_per_thread;
+  ReadCostModel _read_cost_model;
 
   std::unique_ptr<TilingAlgorithmBase> _tiling_algorithm;
+  BatchFinishedCallback _batch_finished_callback;
 
   Semaphore _producers, _consumers;
 
@@ -9,11 +9,17 @@
 #include <rapidjson/writer.h>
 
 #include "Tiler.h"
+#include "io/AttributeStore.h"
 #include "io/BinaryPersistence.h"
 #include "io/Cesium3DTilesPersistence.h"
+#include "io/EPTFile.h"
 #include "io/EntwinePersistence.h"
 #include "io/LASFile.h"
 #include "io/LASPersistence.h"
+#include "pointcloud/ExactBounds.h"
+#include "process/PreviewWriter.h"
+#include "process/Retiler.h"
+#include "process/StreamingTiler.h"
 #include "point_source/PointSource.h"
 #include "util/Config.h"
 #include "util/Stats.h"
@@ -25,14 +31,18 @@
 #include <debug/ThroughputCounter.h>
 #include <terminal/stdout_helper.h>
 
+#include <atomic>
 #include <boost/format.hpp>
 #include <chrono>
 #include <fstream>
 #include <iomanip>
+#include <limits>
 #include <map>
 #include <math.h>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <unordered_set>
 #include <vector>
 
 #include "io/TileSetWriter.h"
@@ -40,12 +50,64 @@
 namespace rj = rapidjson;
 
 constexpr auto PROCESS_COUNT = 1'000'000;
+// Previews are published at most this often, so that copying the top levels of
+// the octrees does not slow down tiling noticeably
+constexpr auto MIN_TIME_BETWEEN_PREVIEWS = std::chrono::seconds{ 60 };
+// How often the stream directory is checked for new point files
+constexpr auto STREAM_POLL_INTERVAL = std::chrono::milliseconds{ 200 };
+// Streaming ends once this file exists in the stream directory
+constexpr auto END_OF_STREAM_FILE_NAME = "end_of_stream";
+// Share of the cache size for the occupancies of the interior nodes. They take
+// about 8 bytes per selected point, while staged nodes take all attributes of
+// all points, so this fits the occupancies of the upper levels that all
+// batches sample again
+constexpr auto NODE_OCCUPANCY_SHARE_OF_CACHE_SIZE = 0.25;
+
+static bool
+is_3dtiles_format(OutputFormat output_format)
+{
+  return output_format == OutputFormat::CZM_3DTILES ||
+         output_format == OutputFormat::CZM_3DTILES_GLB;
+}
+
+static bool
+is_entwine_format(OutputFormat output_format)
+{
+  return output_format == OutputFormat::ENTWINE_LAS ||
+         output_format == OutputFormat::ENTWINE_LAZ;
+}
+
+/**
+ * Creates the contents of the ept.json file for the given output, without the
+ * number of points. 'bounds' are the cubic bounds of the octree and
+ * 'conforming_bounds' the tight bounds of the points
+ */
+static EptJson
+make_ept_json(OutputFormat output_format,
+              const PointAttributes& output_attributes,
+              float spacing,
+              const AABB& bounds,
+              const AABB& conforming_bounds)
+{
+  EptJson ept_json;
+  ept_json.bounds = bounds;
+  ept_json.conforming_bounds = conforming_bounds;
+  ept_json.data_type = (output_format == OutputFormat::ENTWINE_LAZ)
+                         ? EntwineFormat::LAZ
+                         : EntwineFormat::LAS;
+  ept_json.hierarchy_type = "json";
+  ept_json.schema = point_attributes_to_ept_schema(output_attributes);
+  ept_json.span = spacing;
+  // ept_json.srs = ...;
+  ept_json.version = "1.0.0";
+  return ept_json;
+}
 
 /// <summary>
 /// Verify that output directory is valid
 /// </summary>
 static void
-prepare_output_directory(const std::string& output_directory)
+prepare_output_directory(const std::string& output_directory, const fs::path& cache_directory)
 {
   if (fs::exists(output_directory)) {
     // TODO We could add a progress bar here!
@@ -63,6 +125,10 @@ prepare_output_directory(const std::string& output_directory)
         }
         continue;
       }
+      // Caches are meant to survive between runs
+      std::error_code ec;
+      if (fs::equivalent(entry, cache_directory, ec))
+        continue;
 
       fs::remove_all(entry);
     }
@@ -76,6 +142,9 @@ static void
 write_properties_json(const std::string& output_directory,
                       const AABB& bounds,
                       float root_spacing,
+                      uint32_t reconstructed_levels,
+                      const NodeStatistics& attribute_statistics,
+                      const std::vector<ClassificationGroup>& classification_groups,
                       const PerformanceStats& perf)
 {
   rj::Document document;
@@ -111,11 +180,63 @@ write_properties_json(const std::string& output_directory,
     source_props.AddMember("root_spacing", root_spacing, alloc);
   }
 
+  // Levels whose nodes contain copies of the points in deeper nodes. Re-tiling
+  // skips these nodes to not read any point twice
+  {
+    source_props.AddMember("reconstructed_levels", reconstructed_levels, alloc);
+  }
+
   // Point stats
   {
     source_props.AddMember("processed_points", perf.points_processed, alloc);
   }
 
+  // Attribute statistics. Points can be contained in more than one node (e.g.
+  // for reconstructed interior nodes), so summing up the classification counts
+  // of all nodes does not give the number of points per class. We only write
+  // which classes occur in the dataset
+  if (!attribute_statistics.empty()) {
+    rj::Value statistics(rj::kObjectType);
+    if (attribute_statistics.intensity) {
+      rj::Value intensity(rj::kArrayType);
+      intensity.PushBack(attribute_statistics.intensity->min, alloc);
+      intensity.PushBack(attribute_statistics.intensity->max, alloc);
+      statistics.AddMember("intensity", intensity, alloc);
+    }
+    if (attribute_statistics.gps_time) {
+      rj::Value gps_time(rj::kArrayType);
+      gps_time.PushBack(attribute_statistics.gps_time->min, alloc);
+      gps_time.PushBack(attribute_statistics.gps_time->max, alloc);
+      statistics.AddMember("gps_time", gps_time, alloc);
+    }
+    if (!attribute_statistics.classification_histogram.empty()) {
+      rj::Value classifications(rj::kArrayType);
+      for (const auto& entry : attribute_statistics.classification_histogram) {
+        classifications.PushBack(entry.classification, alloc);
+      }
+      statistics.AddMember("classifications", classifications, alloc);
+    }
+
+    source_props.AddMember("attribute_statistics", statistics, alloc);
+  }
+
+  // Classification groups, if each group was tiled into its own octree
+  if (!classification_groups.empty()) {
+    rj::Value partitions(rj::kArrayType);
+    for (const auto& group : classification_groups) {
+      rj::Value classifications(rj::kArrayType);
+      for (auto classification : group.classifications) {
+        classifications.PushBack(classification, alloc);
+      }
+
+      rj::Value partition(rj::kObjectType);
+      partition.AddMember("name", rj_string(group.name, alloc), alloc);
+      partition.AddMember("classifications", classifications, alloc);
+      partitions.PushBack(partition, alloc);
+    }
+    source_props.AddMember("classification_partitions", partitions, alloc);
+  }
+
   // Performance stats
   {
     perf_stats.AddMember(
@@ -179,7 +300,7 @@ static bool
 check_if_file_format_is_supported(const fs::path& file,
                                   util::IgnoreErrors errors_to_ignore)
 {
-  if (file_format_is_supported(file.extension()))
+  if (is_ept_dataset(file) || file_format_is_supported(file.extension()))
     return true;
 
   if (errors_to_ignore & util::IgnoreErrors::UnsupportedFileFormat) {
@@ -196,6 +317,64 @@ check_if_file_format_is_supported(const fs::path& file,
   throw std::runtime_error{ reason };
 }
 
+static uint32_t
+calculate_max_depth(uint32_t max_depth_argument)
+{
+  // TODO max_depth parameter with uint32_t max results in only root level
+  // being created...
+  return (max_depth_argument <= 0) ? (100u) : max_depth_argument;
+}
+
+/**
+ * Returns the point files in the given stream directory that were not ingested
+ * yet, in the order in which they arrived
+ */
+static std::vector<fs::path>
+find_new_stream_files(const fs::path& stream_directory,
+                      const std::unordered_set<std::string>& ingested_files)
+{
+  std::vector<std::pair<fs::file_time_type, fs::path>> new_files;
+  for (const auto& entry : fs::directory_iterator{ stream_directory }) {
+    const auto& file = entry.path();
+    if (!fs::is_regular_file(file) || !file_format_is_supported(file.extension()) ||
+        ingested_files.count(file.string()))
+      continue;
+    new_files.emplace_back(fs::last_write_time(file), file);
+  }
+  std::sort(std::begin(new_files), std::end(new_files));
+
+  std::vector<fs::path> files;
+  for (auto& new_file : new_files) {
+    files.push_back(std::move(new_file.second));
+  }
+  return files;
+}
+
+/**
+ * Reads all points of the given file with the given attributes
+ */
+static PointBuffer
+read_stream_file(const fs::path& file, const PointAttributes& attributes)
+{
+  auto point_file = open_point_file(file);
+  if (!point_file) {
+    throw util::chain_error(point_file.error(), concat("Could not open stream file ", file.string()));
+  }
+
+  PointBuffer points{ pc::get_point_count(*point_file), attributes };
+  std::visit(
+    [&points, &attributes](const auto& typed_file) {
+      pc::read_points_into(std::cbegin(typed_file),
+                           std::cend(typed_file),
+                           pc::metadata(typed_file),
+                           attributes,
+                           util::Range<PointBuffer::PointIterator>{ std::begin(points),
+                                                                    std::end(points) });
+    },
+    *point_file);
+  return points;
+}
+
 TilerProcess::TilerProcess(Arguments const& args)
   : _args(args)
   , _ui(&_ui_state)
@@ -211,15 +390,9 @@ TilerProcess::prepare()
       continue;
 
     if (fs::is_directory(source)) {
-      fs::recursive_directory_iterator directory_iter{ source };
-      for (; directory_iter != fs::recursive_directory_iterator{};
-           directory_iter++) {
-        const auto& dir_entry = directory_iter->path();
-        if (!fs::is_regular_file(dir_entry))
-          continue;
-
-        source_files.push_back(dir_entry);
-      }
+      const auto files_in_directory = find_source_files_in_directory(source);
+      source_files.insert(
+        std::end(source_files), std::begin(files_in_directory), std::end(files_in_directory));
     } else if (fs::is_regular_file(source)) {
       source_files.push_back(source);
     }
@@ -247,7 +420,7 @@ TilerProcess::prepare()
   util::write_log(concat(
     "Writing the following point attributes: ", attributesDescription, "\n"));
 
-  prepare_output_directory(_args.output_directory);
+  prepare_output_directory(_args.output_directory, _args.cache_directory);
 }
 
 void
@@ -293,12 +466,15 @@ TilerProcess::determine_input_and_output_attributes()
 
   _input_attributes = std::move(input_attributes);
 
+  const auto sources_have_classifications =
+    has_attribute(_input_attributes, PointAttribute::Classification);
+
   // Output attributes are dependent on the attributes that the desired output
   // format supports, and on whether or not one of the input attributes should
   // be converted to RGB
   auto output_attributes = _input_attributes;
   // TODO 3D Tiles is the only format supporting RGB remapping at the moment
-  if (_args.output_format == OutputFormat::CZM_3DTILES) {
+  if (is_3dtiles_format(_args.output_format)) {
     switch (_args.rgb_mapping) {
       case RGBMapping::FromIntensityLinear:
       case RGBMapping::FromIntensityLogarithmic:
@@ -308,6 +484,9 @@ TilerProcess::determine_input_and_output_attributes()
         break;
     }
   }
+  if (_args.estimate_normals) {
+    output_attributes.insert(PointAttribute::Normal);
+  }
 
   const auto supported_output_attributes =
     supported_output_attributes_for_format(_args.output_format);
@@ -347,6 +526,36 @@ TilerProcess::determine_input_and_output_attributes()
   }
 
   _output_attributes = std::move(supported_attributes);
+
+  // Estimated normals are computed during indexing, so the points that we read
+  // need storage for them even though the source files don't contain normals
+  if (_args.estimate_normals) {
+    if (has_attribute(_output_attributes, PointAttribute::Normal)) {
+      _input_attributes.insert(PointAttribute::Normal);
+    } else {
+      util::write_log(concat("warning: Output format ",
+                             util::to_string(_args.output_format),
+                             " does not support normals, so no normals will be estimated!\n"));
+    }
+  }
+
+  // Partitioning by classification happens during indexing, so we have to read
+  // the classifications even if the output format does not store them
+  if (_args.partition_by_classification) {
+    if (!sources_have_classifications) {
+      throw std::runtime_error{
+        "Partitioning by classification requires input files with classifications"
+      };
+    }
+    _input_attributes.insert(PointAttribute::Classification);
+  }
+
+  if (_args.pnts_encoding == PNTSEncoding::Compact &&
+      _args.output_format != OutputFormat::CZM_3DTILES) {
+    util::write_log(concat("warning: The compact encoding only applies to 3D Tiles, output format ",
+                           util::to_string(_args.output_format),
+                           " will use its regular encoding!\n"));
+  }
 }
 
 DatasetMetadata
@@ -355,11 +564,18 @@ TilerProcess::calculate_dataset_metadata(
 {
   DatasetMetadata dataset_metadata;
 
-  for (const auto& source : _args.sources) {
+  const auto exact_bounds = _args.exact_bounds
+                              ? calculate_exact_bounds()
+                              : std::vector<std::optional<AABB>>(_args.sources.size());
+
+  for (size_t source_idx = 0; source_idx < _args.sources.size(); ++source_idx) {
+    const auto& source = _args.sources[source_idx];
+    const auto& exact_bounds_of_source = exact_bounds[source_idx];
     open_point_file(source)
-      .map([&dataset_metadata, srs_transform, &source](
+      .map([&dataset_metadata, srs_transform, &source, &exact_bounds_of_source](
              const PointFile& point_file) {
-        auto bounds = pc::get_bounds(point_file);
+        auto bounds = exact_bounds_of_source ? *exact_bounds_of_source
+                                             : pc::get_bounds(point_file);
         auto point_count = pc::get_point_count(point_file);
 
         if (srs_transform) {
@@ -367,7 +583,11 @@ TilerProcess::calculate_dataset_metadata(
                                           gsl::make_span(&bounds, 1));
         }
 
-        dataset_metadata.add_file_metadata(source, point_count, bounds);
+        dataset_metadata.add_file_metadata(source,
+                                           point_count,
+                                           bounds,
+                                           pc::get_point_record_length(point_file),
+                                           pc::is_compressed(point_file));
       })
       .or_else([this, source](const auto& err) {
         if (_args.errors_to_ignore & util::IgnoreErrors::InaccessibleFiles) {
@@ -383,9 +603,82 @@ TilerProcess::calculate_dataset_metadata(
       });
   }
 
+  if (_args.quadtree) {
+    dataset_metadata.use_quadtree_levels();
+  }
+
   return dataset_metadata;
 }
 
+/**
+ * Calculates the exact bounds of all source files from their points, with one
+ * task per file. The node files of EPT datasets are read by subtasks of the task
+ * of the dataset, so that the thread count limits these reads as well. The
+ * bounds of each file are cached in the cache directory, so
+ * that later runs only read the files that changed. Files that can't be read get
+ * no exact bounds, errors for these files are handled when the dataset
+ * metadata is calculated
+ */
+std::vector<std::optional<AABB>>
+TilerProcess::calculate_exact_bounds() const
+{
+  std::vector<std::optional<AABB>> exact_bounds(_args.sources.size());
+  std::atomic<size_t> cached_files_count = 0;
+
+  tf::Taskflow taskflow;
+  for (size_t source_idx = 0; source_idx < _args.sources.size(); ++source_idx) {
+    taskflow.emplace([this, source_idx, &exact_bounds, &cached_files_count](tf::Subflow& subflow) {
+      const auto& source = _args.sources[source_idx];
+      if ((exact_bounds[source_idx] = read_cached_exact_bounds(_args.cache_directory, source))) {
+        ++cached_files_count;
+        return;
+      }
+
+      try {
+        open_point_file(source).map(
+          [&exact_bounds, &subflow, source_idx](const PointFile& point_file) {
+            if (const auto ept_file = std::get_if<EPTFile>(&point_file)) {
+              exact_bounds[source_idx] = ept_exact_bounds(*ept_file, subflow);
+            } else {
+              exact_bounds[source_idx] = pc::get_exact_bounds(point_file);
+            }
+          });
+      } catch (const std::exception& ex) {
+        util::write_log(concat("warning: Can't calculate exact bounds of file ",
+                               source.string(),
+                               ", using the bounds from its header\ncaused by: ",
+                               ex.what(),
+                               "\n"));
+        return;
+      }
+
+      if (!exact_bounds[source_idx])
+        return;
+
+      try {
+        write_cached_exact_bounds(_args.cache_directory, source, *exact_bounds[source_idx]);
+      } catch (const std::exception& ex) {
+        util::write_log(concat("warning: Can't cache exact bounds of file ",
+                               source.string(),
+                               "\ncaused by: ",
+                               ex.what(),
+                               "\n"));
+      }
+    });
+  }
+
+  tf::Executor executor{ total_thread_count(_args.thread_config) };
+  executor.run(taskflow).wait();
+
+  util::write_log(concat("Calculated exact bounds of ",
+                         _args.sources.size(),
+                         " files (",
+                         cached_files_count.load(),
+                         " cached)\n"));
+
+  return exact_bounds;
+}
+
 std::variant<FixedThreadCount, AdaptiveThreadCount>
 TilerProcess::calculate_actual_thread_counts(
   const DatasetMetadata& dataset_metadata) const
@@ -488,6 +781,25 @@ TilerProcess::check_for_missing_point_attributes(
   }
 }
 
+PointAttributes
+TilerProcess::calculate_persisted_input_attributes() const
+{
+  if (!_args.partition_by_classification)
+    return _input_attributes;
+
+  // Classifications are read for partitioning even if they are not written, so
+  // the persistence only gets the input attributes that are also written
+  PointAttributes persisted_input_attributes;
+  std::copy_if(std::begin(_input_attributes),
+               std::end(_input_attributes),
+               std::inserter(persisted_input_attributes,
+                             std::end(persisted_input_attributes)),
+               [this](PointAttribute attribute) {
+                 return has_attribute(_output_attributes, attribute);
+               });
+  return persisted_input_attributes;
+}
+
 SamplingStrategy
 TilerProcess::make_sampling_strategy() const
 {
@@ -515,16 +827,11 @@ TilerProcess::make_sampling_strategy() const
                                  .str() };
 }
 
-Tiler
-TilerProcess::make_tiler(
+TilerMetaParameters
+TilerProcess::make_tiler_meta_parameters(
   bool shift_points_to_center,
   uint32_t max_depth,
-  std::variant<FixedThreadCount, AdaptiveThreadCount> thread_count,
-  SRSTransformHelper const* srs_transform,
-  DatasetMetadata dataset_metadata,
-  SamplingStrategy sampling_strategy,
-  ProgressReporter* progress_reporter,
-  PointsPersistence& persistence) const
+  std::variant<FixedThreadCount, AdaptiveThreadCount> thread_count) const
 {
   TilerMetaParameters tiler_meta_parameters;
   tiler_meta_parameters.spacing_at_root = _args.spacing;
@@ -535,6 +842,39 @@ TilerProcess::make_tiler(
   tiler_meta_parameters.batch_read_size = _args.max_batch_read_size;
   tiler_meta_parameters.shift_points_to_origin = shift_points_to_center;
   tiler_meta_parameters.thread_count = thread_count;
+  tiler_meta_parameters.estimate_normals =
+    _args.estimate_normals && has_attribute(_output_attributes, PointAttribute::Normal);
+  tiler_meta_parameters.point_order = _args.point_order;
+  if (_args.cache_size) {
+    tiler_meta_parameters.node_occupancy_cache_size =
+      *_args.cache_size * NODE_OCCUPANCY_SHARE_OF_CACHE_SIZE;
+  }
+  return tiler_meta_parameters;
+}
+
+std::optional<unit::byte>
+TilerProcess::staging_cache_size() const
+{
+  if (!_args.cache_size)
+    return std::nullopt;
+  return *_args.cache_size * (1.0 - NODE_OCCUPANCY_SHARE_OF_CACHE_SIZE);
+}
+
+Tiler
+TilerProcess::make_tiler(
+  bool shift_points_to_center,
+  uint32_t max_depth,
+  std::variant<FixedThreadCount, AdaptiveThreadCount> thread_count,
+  SRSTransformHelper const* srs_transform,
+  DatasetMetadata dataset_metadata,
+  SamplingStrategy sampling_strategy,
+  ProgressReporter* progress_reporter,
+  PointsPersistence& persistence,
+  std::optional<PartitionedOutput> partitioned_output,
+  AttributeStore* attribute_store) const
+{
+  const auto tiler_meta_parameters =
+    make_tiler_meta_parameters(shift_points_to_center, max_depth, thread_count);
 
   MultiReaderPointSource point_source{ _args.sources, _args.errors_to_ignore };
   point_source.add_transformation(
@@ -551,11 +891,11 @@ TilerProcess::make_tiler(
       // guaranteeing lossless persistence
       if (shift_points_to_center) {
         for (auto point_ref : points) {
-          auto& position = point_ref.position();
-          position -= cubic_bounds.getCenter();
+          auto position = point_ref.position() - cubic_bounds.getCenter();
           position.x = static_cast<float>(position.x);
           position.y = static_cast<float>(position.y);
           position.z = static_cast<float>(position.z);
+          point_ref.set_position(position);
         }
       }
     });
@@ -563,12 +903,23 @@ TilerProcess::make_tiler(
   return { std::move(dataset_metadata), tiler_meta_parameters,
            sampling_strategy,           progress_reporter,
            std::move(point_source),     persistence,
-           _input_attributes,           _args.output_directory };
+           _input_attributes,           _args.output_directory,
+           std::move(partitioned_output),
+           attribute_store };
 }
 
 void
 TilerProcess::run()
 {
+  if (_args.retile) {
+    run_retiling();
+    return;
+  }
+  if (_args.stream) {
+    run_streaming();
+    return;
+  }
+
   const auto prepare_start = std::chrono::high_resolution_clock::now();
 
   prepare();
@@ -584,6 +935,7 @@ TilerProcess::run()
 
   const auto total_points_count = dataset_metadata.total_points_count();
   const auto cubic_bounds = dataset_metadata.total_bounds_cubic();
+  const auto tight_bounds = dataset_metadata.total_bounds_tight();
   if (!total_points_count) {
     throw std::runtime_error{ "Found no points to process" };
   }
@@ -594,6 +946,15 @@ TilerProcess::run()
     concat("Bounds:\n", dataset_metadata.total_bounds_tight(), "\n"));
   util::write_log(
     concat("Bounds (cubic):\n", dataset_metadata.total_bounds_cubic(), "\n"));
+  if (_args.quadtree) {
+    const auto quadtree_levels = dataset_metadata.quadtree_levels();
+    util::write_log(
+      (quadtree_levels == std::numeric_limits<uint32_t>::max())
+        ? std::string{ "Using quadtree levels: The dataset is flat, Z is never subdivided\n" }
+        : concat("Using quadtree levels: The first ",
+                 quadtree_levels,
+                 " levels below the root don't subdivide Z\n"));
+  }
 
   if (_args.diagonal_fraction != 0) {
     _args.spacing =
@@ -611,22 +972,100 @@ TilerProcess::run()
   progress_reporter.register_progress_counter<size_t>(progress::INDEXING,
                                                       total_points_count);
 
-  auto persistence = make_persistence(_args.output_format,
-                                      _args.output_directory,
-                                      _input_attributes,
-                                      _output_attributes,
-                                      _args.rgb_mapping,
-                                      _args.spacing,
-                                      dataset_metadata.total_bounds_cubic());
-  const auto shift_points_to_center =
-    (_args.output_format == OutputFormat::CZM_3DTILES);
-
-  const auto max_depth =
-    (_args.max_depth <= 0)
-      ? (100u)
-      : static_cast<uint32_t>(
-          _args.max_depth); // TODO max_depth parameter with uint32_t max
-                            // results in only root level being created...
+  const auto persisted_input_attributes = calculate_persisted_input_attributes();
+
+  // When partitioning by classification, each classification group gets its
+  // own octree with its own persistence in a subdirectory of the output
+  // directory
+  std::optional<ClassificationPartitioning> partitioning;
+  std::vector<fs::path> octree_directories;
+  if (_args.partition_by_classification) {
+    partitioning = ClassificationPartitioning{ default_classification_groups() };
+    for (const auto& group : partitioning->groups()) {
+      octree_directories.push_back(_args.output_directory / group.name);
+      fs::create_directories(octree_directories.back());
+    }
+  } else {
+    octree_directories.push_back(_args.output_directory);
+  }
+
+  // With a cache size, nodes are staged in memory and each node is written to
+  // the output format only once. The cache is shared evenly between all octrees
+  if (const auto staging_size = staging_cache_size()) {
+    util::write_log(concat("Staging nodes in memory, using up to ",
+                           unit::format_with_binary_prefix(staging_size->value()),
+                           "B\n"));
+  }
+
+  // With deferred attributes, tiling only works on the positions and the
+  // attributes that tiling itself reads or writes. All other attributes are
+  // kept in an AttributeStore and gathered when the staged nodes are written
+  std::shared_ptr<AttributeStore> attribute_store;
+  if (_args.defer_attributes) {
+    if (!_args.cache_size) {
+      throw std::runtime_error{ "Deferring point attributes requires a cache size" };
+    }
+
+    auto deferred_attributes = persisted_input_attributes;
+    deferred_attributes.erase(PointAttribute::Position);
+    if (_args.estimate_normals) {
+      deferred_attributes.erase(PointAttribute::Normal);
+    }
+    if (partitioning) {
+      deferred_attributes.erase(PointAttribute::Classification);
+    }
+    util::write_log(concat("Deferring point attributes ",
+                           print_attributes(deferred_attributes),
+                           " until the nodes are written\n"));
+    // Deferred attributes that exceed the cache size are spilled to a file in
+    // the output directory, which is removed once tiling is done
+    attribute_store = std::make_shared<AttributeStore>(
+      deferred_attributes, fs::path{ _args.output_directory } / "deferred_attributes.tmp");
+  }
+
+  // In quadtree mode, the 3D Tiles bounding volumes are clipped to the dataset
+  // so that they are as flat as the dataset and not as high as the cubic nodes
+  const auto bounding_volume_limits =
+    _args.quadtree ? std::optional<AABB>{ tight_bounds } : std::nullopt;
+
+  std::vector<PointsPersistence> persistences;
+  persistences.reserve(octree_directories.size());
+  for (const auto& octree_directory : octree_directories) {
+    auto octree_persistence = make_persistence(_args.output_format,
+                                               octree_directory,
+                                               persisted_input_attributes,
+                                               _output_attributes,
+                                               _args.rgb_mapping,
+                                               _args.pnts_encoding,
+                                               _args.spacing,
+                                               dataset_metadata.total_bounds_cubic(),
+                                               bounding_volume_limits);
+    // The memory budget is shared by the octrees of all partitions
+    const auto staging_size = staging_cache_size();
+    const auto memory_budget =
+      staging_size ? std::optional<unit::byte>{ *staging_size /
+                                                static_cast<double>(octree_directories.size()) }
+                   : std::nullopt;
+    persistences.push_back(make_staging_persistence(std::move(octree_persistence),
+                                                    persisted_input_attributes,
+                                                    memory_budget,
+                                                    total_thread_count(_args.thread_config),
+                                                    _args.point_order,
+                                                    attribute_store));
+  }
+  auto& persistence = persistences.front();
+
+  std::optional<PartitionedOutput> partitioned_output;
+  if (partitioning) {
+    std::vector<PointsPersistence*> partition_persistences;
+    for (auto& partition_persistence : persistences) {
+      partition_persistences.push_back(&partition_persistence);
+    }
+    partitioned_output = PartitionedOutput{ *partitioning, std::move(partition_persistences) };
+  }
+  const auto shift_points_to_center = is_3dtiles_format(_args.output_format);
+
+  const auto max_depth = calculate_max_depth(_args.max_depth);
 
   util::write_log(concat("Using ", _args.sampling_strategy, " sampling\n"));
   auto sampling_strategy = make_sampling_strategy();
@@ -638,7 +1077,69 @@ TilerProcess::run()
                           std::move(dataset_metadata),
                           std::move(sampling_strategy),
                           &progress_reporter,
-                          persistence);
+                          persistence,
+                          std::move(partitioned_output),
+                          attribute_store.get());
+
+  // With progressive output, the top levels of each octree are published as a
+  // preview in the 'preview' subdirectory of the octree, so that the data can
+  // be viewed while tiling is still running. The previews are removed once the
+  // final output is complete
+  std::vector<PreviewWriter> preview_writers;
+  if (_args.progressive_levels) {
+    for (const auto& octree_directory : octree_directories) {
+      auto make_preview_persistence =
+        [this, &persisted_input_attributes, cubic_bounds, bounding_volume_limits](
+          const fs::path& directory) {
+          return make_persistence(_args.output_format,
+                                  directory,
+                                  persisted_input_attributes,
+                                  _output_attributes,
+                                  _args.rgb_mapping,
+                                  _args.pnts_encoding,
+                                  _args.spacing,
+                                  cubic_bounds,
+                                  bounding_volume_limits);
+        };
+      auto write_preview_metadata = [this, cubic_bounds, tight_bounds](
+                                      const fs::path& directory, size_t points_count) {
+        if (!is_entwine_format(_args.output_format))
+          return;
+        auto ept_json = make_ept_json(
+          _args.output_format, _output_attributes, _args.spacing, cubic_bounds, tight_bounds);
+        ept_json.points = points_count;
+        write_ept_json(directory / "ept.json", ept_json);
+      };
+      preview_writers.emplace_back(octree_directory / "preview",
+                                   _args.progressive_levels,
+                                   tiler.bounds(),
+                                   std::move(make_preview_persistence),
+                                   std::move(write_preview_metadata),
+                                   attribute_store.get());
+    }
+
+    auto last_preview_time = std::optional<std::chrono::steady_clock::time_point>{};
+    tiler.on_batch_finished([&preview_writers, &persistences, last_preview_time](
+                              const std::function<void()>& reconstruct_updated_nodes) mutable {
+      const auto now = std::chrono::steady_clock::now();
+      if (last_preview_time && (now - *last_preview_time) < MIN_TIME_BETWEEN_PREVIEWS)
+        return;
+
+      // Only batches that publish a preview pay for the reconstruction
+      reconstruct_updated_nodes();
+
+      size_t preview_points_count = 0;
+      for (size_t octree = 0; octree < preview_writers.size(); ++octree) {
+        preview_points_count += preview_writers[octree].publish(persistences[octree]);
+      }
+      if (!preview_points_count)
+        return;
+
+      last_preview_time = now;
+      util::write_log(
+        concat("Published preview with ", preview_points_count, " points\n"));
+    });
+  }
 
   TerminalUIAsyncRenderer ui_renderer{ _ui };
 
@@ -661,24 +1162,35 @@ TilerProcess::run()
   stats.indexing_duration = indexing_duration;
   stats.points_processed = total_points_count;
 
-  write_properties_json(
-    _args.output_directory, cubic_bounds, _args.spacing, stats);
-
-  if (_args.output_format == OutputFormat::ENTWINE_LAS ||
-      _args.output_format == OutputFormat::ENTWINE_LAZ) {
-    EptJson ept_json;
-    ept_json.bounds = cubic_bounds;
-    ept_json.conforming_bounds = cubic_bounds;
-    ept_json.data_type = (_args.output_format == OutputFormat::ENTWINE_LAZ)
-                           ? EntwineFormat::LAZ
-                           : EntwineFormat::LAS;
-    ept_json.hierarchy_type = "json";
-    ept_json.points = num_processed_points;
-    ept_json.schema = point_attributes_to_ept_schema(_output_attributes);
-    ept_json.span = _args.spacing;
-    // ept_json.srs = ...;
-    ept_json.version = "1.0.0";
-    write_ept_json(_args.output_directory / "ept.json", ept_json);
+  for (auto& preview_writer : preview_writers) {
+    preview_writer.remove();
+  }
+
+  NodeStatistics dataset_statistics;
+  for (auto& octree_persistence : persistences) {
+    octree_persistence.flush();
+    dataset_statistics.merge(octree_persistence.dataset_statistics());
+  }
+
+  write_properties_json(_args.output_directory,
+                        cubic_bounds,
+                        _args.spacing,
+                        tiler.reconstructed_levels(),
+                        dataset_statistics,
+                        partitioning ? partitioning->groups()
+                                     : std::vector<ClassificationGroup>{},
+                        stats);
+
+  if (is_entwine_format(_args.output_format)) {
+    auto ept_json = make_ept_json(
+      _args.output_format, _output_attributes, _args.spacing, cubic_bounds, tight_bounds);
+
+    const auto points_per_octree = tiler.points_per_partition();
+    for (size_t octree = 0; octree < octree_directories.size(); ++octree) {
+      ept_json.points =
+        partitioning ? points_per_octree.at(octree) : num_processed_points;
+      write_ept_json(octree_directories[octree] / "ept.json", ept_json);
+    }
   }
 
   const auto total_indexed_count =
@@ -697,3 +1209,328 @@ TilerProcess::run()
                       .str());
   }
 }
+
+void
+TilerProcess::run_retiling()
+{
+  const auto prepare_start = std::chrono::high_resolution_clock::now();
+
+  if (_args.partition_by_classification) {
+    throw std::invalid_argument{ "Re-tiling does not support partitioning by classification" };
+  }
+  if (_args.defer_attributes) {
+    throw std::invalid_argument{ "Re-tiling does not support deferring point attributes" };
+  }
+  if (_args.progressive_levels) {
+    throw std::invalid_argument{ "Re-tiling does not support progressive output" };
+  }
+  if (_args.source_projection) {
+    util::write_log("warning: Ignoring the source projection, the points of a previous tiler "
+                    "output are already transformed\n");
+  }
+
+  // Each source directory is the output of a previous tiler run. Several
+  // outputs are merged into a single octree
+  std::vector<TiledOutput> sources;
+  for (const auto& source_directory : _args.sources) {
+    if (!fs::is_directory(source_directory)) {
+      throw std::invalid_argument{ concat(
+        "Re-tiling requires directories with the output of a previous tiler run, but ",
+        source_directory.string(),
+        " is not a directory") };
+    }
+    if (fs::exists(_args.output_directory) &&
+        fs::equivalent(source_directory, _args.output_directory)) {
+      throw std::invalid_argument{
+        "Re-tiling requires an output directory that is different from the source directories"
+      };
+    }
+    sources.push_back(read_tiled_output(source_directory));
+  }
+
+  // The node files are the source files, so that the attributes are
+  // determined from them like from regular source files
+  _args.sources.clear();
+  size_t total_points_count = 0;
+  std::vector<AABB> root_cubes_of_sources;
+  AABB bounds_of_sources;
+  for (const auto& source : sources) {
+    for (const auto& node : source.nodes) {
+      _args.sources.push_back(node.file);
+    }
+    total_points_count += source.points_count;
+    root_cubes_of_sources.push_back(source.bounds);
+    bounds_of_sources.update(source.bounds);
+
+    util::write_log(concat("Re-tiling ",
+                           source.points_count,
+                           " points from ",
+                           source.directory.string(),
+                           "\n"));
+  }
+  determine_input_and_output_attributes();
+
+  const auto attributesDescription = print_attributes(_output_attributes);
+  util::write_log(concat(
+    "Writing the following point attributes: ", attributesDescription, "\n"));
+
+  prepare_output_directory(_args.output_directory, _args.cache_directory);
+
+  const auto cubic_bounds = calculate_common_root_cube(root_cubes_of_sources);
+  util::write_log(concat("Bounds (cubic):\n", cubic_bounds, "\n"));
+
+  if (_args.diagonal_fraction != 0) {
+    _args.spacing = (float)(cubic_bounds.extent().length() / _args.diagonal_fraction);
+    util::write_log(
+      concat("Spacing calculated from diagonal: ", _args.spacing, "\n"));
+  }
+
+  auto& progress_reporter = _ui_state.get_progress_reporter();
+  progress_reporter.register_progress_counter<size_t>(progress::LOADING,
+                                                      total_points_count);
+  progress_reporter.register_progress_counter<size_t>(progress::INDEXING,
+                                                      total_points_count);
+
+  const auto persisted_input_attributes = calculate_persisted_input_attributes();
+
+  if (const auto staging_size = staging_cache_size()) {
+    util::write_log(concat("Staging nodes in memory, using up to ",
+                           unit::format_with_binary_prefix(staging_size->value()),
+                           "B\n"));
+  }
+
+  auto persistence = make_staging_persistence(make_persistence(_args.output_format,
+                                                               _args.output_directory,
+                                                               persisted_input_attributes,
+                                                               _output_attributes,
+                                                               _args.rgb_mapping,
+                                                               _args.pnts_encoding,
+                                                               _args.spacing,
+                                                               cubic_bounds),
+                                              persisted_input_attributes,
+                                              staging_cache_size(),
+                                              total_thread_count(_args.thread_config),
+                                              _args.point_order);
+
+  util::write_log(concat("Using ", _args.sampling_strategy, " sampling\n"));
+
+  Retiler retiler{ std::move(sources),
+                   make_tiler_meta_parameters(is_3dtiles_format(_args.output_format),
+                                              calculate_max_depth(_args.max_depth),
+                                              _args.thread_config),
+                   make_sampling_strategy(),
+                   &progress_reporter,
+                   persistence,
+                   _input_attributes };
+
+  TerminalUIAsyncRenderer ui_renderer{ _ui };
+
+  const auto prepare_end = std::chrono::high_resolution_clock::now();
+  const auto indexing_start = prepare_end;
+
+  const auto num_processed_points = retiler.run();
+
+  const auto indexing_end = std::chrono::high_resolution_clock::now();
+
+  PerformanceStats stats;
+  stats.prepare_duration =
+    std::chrono::duration_cast<std::chrono::milliseconds>(prepare_end - prepare_start);
+  stats.indexing_duration =
+    std::chrono::duration_cast<std::chrono::milliseconds>(indexing_end - indexing_start);
+  stats.points_processed = num_processed_points;
+
+  persistence.flush();
+
+  write_properties_json(_args.output_directory,
+                        cubic_bounds,
+                        _args.spacing,
+                        retiler.reconstructed_levels(),
+                        persistence.dataset_statistics(),
+                        {},
+                        stats);
+
+  // The tight bounds of the original datasets are not part of the tiler
+  // outputs, so the root bounds of the sources are the conforming bounds
+  if (is_entwine_format(_args.output_format)) {
+    auto ept_json = make_ept_json(
+      _args.output_format, _output_attributes, _args.spacing, cubic_bounds, bounds_of_sources);
+    ept_json.points = num_processed_points;
+    write_ept_json(_args.output_directory / "ept.json", ept_json);
+  }
+
+  util::write_log((boost::format("Re-tiling finished - Indexed %1% points") %
+                   progress_reporter.get_progress<size_t>(progress::INDEXING))
+                    .str());
+}
+
+void
+TilerProcess::run_streaming()
+{
+  const auto prepare_start = std::chrono::high_resolution_clock::now();
+
+  if (_args.retile) {
+    throw std::invalid_argument{ "Streaming can't be combined with re-tiling" };
+  }
+  if (_args.partition_by_classification) {
+    throw std::invalid_argument{ "Streaming does not support partitioning by classification" };
+  }
+  if (_args.defer_attributes) {
+    throw std::invalid_argument{ "Streaming does not support deferring point attributes" };
+  }
+  if (_args.progressive_levels) {
+    throw std::invalid_argument{
+      "Streaming does not support progressive output, the output itself is updated while tiling"
+    };
+  }
+  if (_args.source_projection) {
+    throw std::invalid_argument{ "Streaming does not support a source projection" };
+  }
+  // Only these formats can be extended node by node, the 3D Tiles formats write
+  // their tilesets once at the end
+  if (!is_entwine_format(_args.output_format) && _args.output_format != OutputFormat::LAS &&
+      _args.output_format != OutputFormat::LAZ) {
+    throw std::invalid_argument{
+      "Streaming requires one of the output formats LAS, LAZ, ENTWINE_LAS or ENTWINE_LAZ"
+    };
+  }
+  if (!_args.stream_bounds) {
+    throw std::invalid_argument{ "Streaming requires the bounds of the octree" };
+  }
+  if (_args.sources.size() != 1 || !fs::is_directory(_args.sources.front())) {
+    throw std::invalid_argument{ "Streaming requires a single source directory" };
+  }
+  const auto stream_directory = _args.sources.front();
+  if (fs::exists(_args.output_directory) &&
+      fs::equivalent(stream_directory, _args.output_directory)) {
+    throw std::invalid_argument{
+      "Streaming requires an output directory that is different from the source directory"
+    };
+  }
+
+  // All files of a stream come from the same sensor, so the attributes are
+  // determined from the first file
+  const auto end_of_stream_file = stream_directory / END_OF_STREAM_FILE_NAME;
+  util::write_log(concat("Waiting for point files in ", stream_directory.string(), "\n"));
+  std::unordered_set<std::string> ingested_files;
+  auto new_files = find_new_stream_files(stream_directory, ingested_files);
+  while (new_files.empty()) {
+    if (fs::exists(end_of_stream_file)) {
+      throw std::runtime_error{ "The stream ended before any point files arrived" };
+    }
+    std::this_thread::sleep_for(STREAM_POLL_INTERVAL);
+    new_files = find_new_stream_files(stream_directory, ingested_files);
+  }
+  _args.sources = { new_files.front() };
+  determine_input_and_output_attributes();
+
+  const auto attributesDescription = print_attributes(_output_attributes);
+  util::write_log(concat(
+    "Writing the following point attributes: ", attributesDescription, "\n"));
+
+  prepare_output_directory(_args.output_directory, _args.cache_directory);
+
+  const auto tight_bounds = *_args.stream_bounds;
+  auto cubic_bounds = tight_bounds;
+  cubic_bounds.makeCubic();
+  util::write_log(concat("Bounds (cubic):\n", cubic_bounds, "\n"));
+
+  if (_args.diagonal_fraction != 0) {
+    _args.spacing = (float)(cubic_bounds.extent().length() / _args.diagonal_fraction);
+    util::write_log(
+      concat("Spacing calculated from diagonal: ", _args.spacing, "\n"));
+  }
+
+  const auto persisted_input_attributes = calculate_persisted_input_attributes();
+
+  if (const auto staging_size = staging_cache_size()) {
+    util::write_log(concat("Staging nodes in memory, using up to ",
+                           unit::format_with_binary_prefix(staging_size->value()),
+                           "B\n"));
+  }
+
+  auto persistence = make_staging_persistence(make_persistence(_args.output_format,
+                                                               _args.output_directory,
+                                                               persisted_input_attributes,
+                                                               _output_attributes,
+                                                               _args.rgb_mapping,
+                                                               _args.pnts_encoding,
+                                                               _args.spacing,
+                                                               cubic_bounds),
+                                              persisted_input_attributes,
+                                              staging_cache_size(),
+                                              total_thread_count(_args.thread_config),
+                                              _args.point_order);
+
+  // The ept.json file is written with each flush, so that viewers can open the
+  // output while it is growing
+  auto write_metadata = [this, cubic_bounds, tight_bounds](size_t points_count) {
+    util::write_log(concat("Flushed octree with ", points_count, " points\n"));
+    if (!is_entwine_format(_args.output_format))
+      return;
+    auto ept_json = make_ept_json(
+      _args.output_format, _output_attributes, _args.spacing, cubic_bounds, tight_bounds);
+    ept_json.points = points_count;
+    write_ept_json(_args.output_directory / "ept.json", ept_json);
+  };
+
+  util::write_log(concat("Using ", _args.sampling_strategy, " sampling\n"));
+
+  StreamingTiler tiler{ tight_bounds,
+                        make_tiler_meta_parameters(
+                          false, calculate_max_depth(_args.max_depth), _args.thread_config),
+                        make_sampling_strategy(),
+                        { std::chrono::seconds{ _args.stream_flush_interval },
+                          _args.stream_flush_points },
+                        nullptr,
+                        persistence,
+                        _input_attributes,
+                        std::move(write_metadata) };
+
+  const auto prepare_end = std::chrono::high_resolution_clock::now();
+  const auto indexing_start = prepare_end;
+
+  // The end of the stream is checked before looking for new files, so that all
+  // files that arrived before the end of the stream are ingested
+  while (true) {
+    const auto stream_has_ended = fs::exists(end_of_stream_file);
+    for (const auto& file : find_new_stream_files(stream_directory, ingested_files)) {
+      tiler.insert(read_stream_file(file, _input_attributes));
+      ingested_files.insert(file.string());
+    }
+    if (stream_has_ended)
+      break;
+    std::this_thread::sleep_for(STREAM_POLL_INTERVAL);
+  }
+
+  const auto num_processed_points = tiler.finish();
+
+  const auto indexing_end = std::chrono::high_resolution_clock::now();
+
+  PerformanceStats stats;
+  stats.prepare_duration =
+    std::chrono::duration_cast<std::chrono::milliseconds>(prepare_end - prepare_start);
+  stats.indexing_duration =
+    std::chrono::duration_cast<std::chrono::milliseconds>(indexing_end - indexing_start);
+  stats.points_processed = num_processed_points;
+
+  write_properties_json(_args.output_directory,
+                        cubic_bounds,
+                        _args.spacing,
+                        tiler.reconstructed_levels(),
+                        persistence.dataset_statistics(),
+                        {},
+                        stats);
+
+  const auto dropped_points_count = tiler.dropped_points_count();
+  if (dropped_points_count) {
+    util::write_log(
+      (boost::format("Streaming finished with warnings - Indexed %1% points from %2% files (%3% "
+                     "points were outside of the bounds)") %
+       num_processed_points % ingested_files.size() % dropped_points_count)
+        .str());
+  } else {
+    util::write_log((boost::format("Streaming finished - Indexed %1% points from %2% files") %
+                     num_processed_points % ingested_files.size())
+                      .str());
+  }
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "io/PNTSEncoding.h"
 #include "io/PointReader.h"
 #include "math/AABB.h"
 #include "pointcloud/FileStats.h"
@@ -15,6 +16,7 @@
 #include <string>
 #include <vector>
 
+struct AttributeStore;
 struct SRSTransformHelper;
 
 struct TilerProcess
@@ -32,6 +34,7 @@ struct TilerProcess
     size_t max_batch_read_size;
     OutputFormat output_format;
     RGBMapping rgb_mapping;
+    PNTSEncoding pnts_encoding;
     std::string sampling_strategy;
     std::string executable_path;
     std::optional<std::string> source_projection;
@@ -41,6 +44,23 @@ struct TilerProcess
     util::IgnoreErrors errors_to_ignore;
     TilingStrategy tiling_strategy;
     ThreadConfig thread_config;
+    bool estimate_normals;
+    bool partition_by_classification;
+    bool defer_attributes;
+    bool exact_bounds;
+    /**
+     * Directory for caches that are reused by later runs, e.g. the exact bounds
+     * of the source files. Defaults to 'cache' in the output directory
+     */
+    fs::path cache_directory;
+    bool quadtree;
+    bool retile;
+    bool stream;
+    std::optional<AABB> stream_bounds;
+    uint32_t stream_flush_interval;
+    size_t stream_flush_points;
+    uint32_t progressive_levels;
+    PointOrder point_order;
   };
 
   explicit TilerProcess(Arguments const& args);
@@ -67,14 +87,27 @@ private:
   TerminalUI _ui;
 
   void prepare();
+  void run_retiling();
+  void run_streaming();
   void cleanUp();
   DatasetMetadata calculate_dataset_metadata(const SRSTransformHelper* transform);
+  std::vector<std::optional<AABB>> calculate_exact_bounds() const;
   std::variant<FixedThreadCount, AdaptiveThreadCount> calculate_actual_thread_counts(
     const DatasetMetadata& dataset_metadata) const;
 
   void check_for_missing_point_attributes(const PointAttributes& required_attributes) const;
   void determine_input_and_output_attributes();
+  PointAttributes calculate_persisted_input_attributes() const;
   SamplingStrategy make_sampling_strategy() const;
+  TilerMetaParameters make_tiler_meta_parameters(
+    bool shift_points_to_center,
+    uint32_t max_depth,
+    std::variant<FixedThreadCount, AdaptiveThreadCount> thread_count) const;
+  /**
+   * Part of the cache size for staging nodes, the rest is for the occupancies
+   * of the interior nodes
+   */
+  std::optional<unit::byte> staging_cache_size() const;
   Tiler make_tiler(bool shift_points_to_center,
                    uint32_t max_depth,
                    std::variant<FixedThreadCount, AdaptiveThreadCount> thread_count,
@@ -82,5 +115,7 @@ private:
                    DatasetMetadata dataset_metadata,
                    SamplingStrategy sampling_strategy,
                    ProgressReporter* progress_reporter,
-                   PointsPersistence& persistence) const;
+                   PointsPersistence& persistence,
+                   std::optional<PartitionedOutput> partitioned_output,
+                   AttributeStore* attribute_store) const;
 };
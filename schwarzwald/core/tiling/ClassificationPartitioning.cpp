@@ -0,0 +1,94 @@
+#include "tiling/ClassificationPartitioning.h"
+
+#include "util/stuff.h"
+
+#include <numeric>
+
+std::vector<ClassificationGroup>
+default_classification_groups()
+{
+  return { { "ground", { 2, 8 } },
+           { "vegetation", { 3, 4, 5 } },
+           { "buildings", { 6 } },
+           { "water", { 9 } },
+           { "other", {} } };
+}
+
+ClassificationPartitioning::ClassificationPartitioning(std::vector<ClassificationGroup> groups)
+  : _groups(std::move(groups))
+{
+  if (_groups.empty()) {
+    throw std::invalid_argument{ "ClassificationPartitioning requires at least one group" };
+  }
+
+  const auto catch_all_group =
+    std::find_if(std::begin(_groups), std::end(_groups), [](const ClassificationGroup& group) {
+      return group.classifications.empty();
+    });
+  if (catch_all_group != std::end(_groups) &&
+      std::find_if(std::next(catch_all_group), std::end(_groups), [](const auto& group) {
+        return group.classifications.empty();
+      }) != std::end(_groups)) {
+    throw std::invalid_argument{
+      "ClassificationPartitioning supports at most one group without classifications"
+    };
+  }
+
+  const auto default_group = static_cast<uint32_t>(
+    (catch_all_group != std::end(_groups)) ? std::distance(std::begin(_groups), catch_all_group)
+                                           : _groups.size() - 1);
+  _group_per_classification.fill(default_group);
+
+  std::array<bool, 256> is_assigned = {};
+  for (uint32_t group_index = 0; group_index < _groups.size(); ++group_index) {
+    for (auto classification : _groups[group_index].classifications) {
+      if (is_assigned[classification]) {
+        throw std::invalid_argument{ concat("Classification ",
+                                            static_cast<uint32_t>(classification),
+                                            " is part of more than one classification group") };
+      }
+      is_assigned[classification] = true;
+      _group_per_classification[classification] = group_index;
+    }
+  }
+}
+
+std::vector<util::Range<std::vector<IndexedPoint64>::iterator>>
+ClassificationPartitioning::partition(
+  util::Range<std::vector<IndexedPoint64>::iterator> points) const
+{
+  // Stable counting sort by group index. This touches every point exactly
+  // twice, compared to O(n log n) for sorting by group
+  std::vector<uint32_t> group_per_point;
+  group_per_point.reserve(points.size());
+  std::vector<size_t> group_offsets(_groups.size() + 1, 0);
+  for (const auto& point : points) {
+    const auto group = group_of(point);
+    group_per_point.push_back(group);
+    ++group_offsets[group + 1];
+  }
+  std::partial_sum(std::begin(group_offsets), std::end(group_offsets), std::begin(group_offsets));
+
+  std::vector<util::Range<std::vector<IndexedPoint64>::iterator>> group_ranges;
+  group_ranges.reserve(_groups.size());
+  for (size_t group = 0; group < _groups.size(); ++group) {
+    group_ranges.push_back({ std::begin(points) + group_offsets[group],
+                             std::begin(points) + group_offsets[group + 1] });
+  }
+
+  // All points in a single group, nothing to reorder
+  if (std::any_of(std::begin(group_ranges), std::end(group_ranges), [&points](const auto& range) {
+        return range.size() == points.size();
+      })) {
+    return group_ranges;
+  }
+
+  std::vector<IndexedPoint64> unpartitioned_points{ std::begin(points), std::end(points) };
+  auto next_position_per_group = group_offsets;
+  for (size_t idx = 0; idx < unpartitioned_points.size(); ++idx) {
+    const auto group = group_per_point[idx];
+    *(std::begin(points) + next_position_per_group[group]++) = unpartitioned_points[idx];
+  }
+
+  return group_ranges;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "containers/Range.h"
+#include "tiling/Sampling.h"
+
+#include <array>
+#include <string>
+#include <vector>
+
+/**
+ * A group of LAS classifications that are tiled into the same octree
+ */
+struct ClassificationGroup
+{
+  /**
+   * Name of the group, which is also the name of the output directory of the
+   * octree for this group
+   */
+  std::string name;
+  /**
+   * All classifications that belong to this group. If empty, this group
+   * contains all classifications that are not part of any other group
+   */
+  std::vector<uint8_t> classifications;
+};
+
+/**
+ * The default classification groups, based on the standard ASPRS
+ * classifications:
+ *
+ * -  ground (2: Ground, 8: Model Key-point)
+ * -  vegetation (3, 4, 5: Low, Medium and High Vegetation)
+ * -  buildings (6: Building)
+ * -  water (9: Water)
+ * -  other (everything else)
+ */
+std::vector<ClassificationGroup>
+default_classification_groups();
+
+/**
+ * Assigns each point to a classification group, so that the points of each
+ * group can be tiled into a separate octree. Consumers that only need a single
+ * group (e.g. only ground points) then only have to fetch the data of this
+ * group
+ */
+struct ClassificationPartitioning
+{
+  /**
+   * Creates a partitioning from the given groups. Each classification can only
+   * be in one group and there must be at most one group without
+   * classifications, which catches all remaining classifications. If there is
+   * no such group, points with classifications that are not in any group are
+   * put into the last group
+   */
+  explicit ClassificationPartitioning(std::vector<ClassificationGroup> groups);
+
+  const std::vector<ClassificationGroup>& groups() const { return _groups; }
+  size_t size() const { return _groups.size(); }
+
+  /**
+   * Returns the index of the group that the given classification belongs to
+   */
+  uint32_t group_of(uint8_t classification) const { return _group_per_classification[classification]; }
+
+  /**
+   * Returns the index of the group that the given point belongs to. Points
+   * without a classification are treated as class 0 (Created, never classified)
+   */
+  uint32_t group_of(const IndexedPoint64& point) const
+  {
+    const auto classification = point.point_reference.classification();
+    return group_of(classification ? *classification : uint8_t{ 0 });
+  }
+
+  /**
+   * Reorders the given range of points so that the points of each group are
+   * contiguous and returns the subrange for each group, indexed by the group
+   * index. The relative order of the points within a group is preserved, so a
+   * range sorted by Morton index yields Morton-sorted group ranges
+   */
+  std::vector<util::Range<std::vector<IndexedPoint64>::iterator>> partition(
+    util::Range<std::vector<IndexedPoint64>::iterator> points) const;
+
+private:
+  std::vector<ClassificationGroup> _groups;
+  std::array<uint32_t, 256> _group_per_classification;
+};
@@ -17,6 +17,11 @@ struct NodeStructure
   int32_t level;
   float max_spacing;
   uint32_t max_depth;
+  /**
+   * Index of the classification group (and thus the octree) that this node
+   * belongs to, if points are partitioned by classification
+   */
+  uint32_t partition = 0;
 };
 
 using NodeData = std::vector<IndexedPoint64>;
@@ -0,0 +1,292 @@
+#include "tiling/NormalEstimation.h"
+
+#include "algorithms/Algorithm.h"
+#include "datastructures/OctreeNodeIndex.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <optional>
+
+namespace {
+
+using IndexedPointsIter = std::vector<IndexedPoint64>::iterator;
+
+const Vector3<float> DEFAULT_NORMAL{ 0.f, 0.f, 1.f };
+
+Vector3<double>
+cross(const Vector3<double>& l, const Vector3<double>& r)
+{
+  return { l.y * r.z - l.z * r.y, l.z * r.x - l.x * r.z, l.x * r.y - l.y * r.x };
+}
+
+/**
+ * Returns the eigenvector belonging to the smallest eigenvalue of the given
+ * symmetric 3x3 matrix. Uses the closed-form solution for the eigenvalues of
+ * symmetric 3x3 matrices, which is a lot faster than an iterative solver and
+ * precise enough for fitting tangent planes
+ */
+std::optional<Vector3<double>>
+smallest_eigenvector(const std::array<double, 6>& cov)
+{
+  const auto [a00, a01, a02, a11, a12, a22] = cov;
+
+  const auto p1 = a01 * a01 + a02 * a02 + a12 * a12;
+  const auto q = (a00 + a11 + a22) / 3;
+  const auto p2 =
+    (a00 - q) * (a00 - q) + (a11 - q) * (a11 - q) + (a22 - q) * (a22 - q) + 2 * p1;
+  const auto p = std::sqrt(p2 / 6);
+  if (p <= std::numeric_limits<double>::epsilon()) {
+    // Isotropic neighbourhood, there is no preferred direction
+    return std::nullopt;
+  }
+
+  const auto b00 = (a00 - q) / p, b11 = (a11 - q) / p, b22 = (a22 - q) / p;
+  const auto b01 = a01 / p, b02 = a02 / p, b12 = a12 / p;
+  const auto det_b = b00 * (b11 * b22 - b12 * b12) - b01 * (b01 * b22 - b12 * b02) +
+                     b02 * (b01 * b12 - b11 * b02);
+  const auto r = std::clamp(det_b / 2, -1.0, 1.0);
+  const auto phi = std::acos(r) / 3;
+  const auto smallest_eigenvalue = q + 2 * p * std::cos(phi + (2 * M_PI / 3));
+
+  // The eigenvector is orthogonal to all rows of (A - lambda * I), so the cross
+  // product of any two linearly independent rows gives us the eigenvector. We
+  // take the largest cross product for numerical stability
+  const Vector3<double> row0{ a00 - smallest_eigenvalue, a01, a02 };
+  const Vector3<double> row1{ a01, a11 - smallest_eigenvalue, a12 };
+  const Vector3<double> row2{ a02, a12, a22 - smallest_eigenvalue };
+
+  const std::array<Vector3<double>, 3> candidates = { cross(row0, row1),
+                                                      cross(row0, row2),
+                                                      cross(row1, row2) };
+  const auto largest_candidate =
+    std::max_element(std::begin(candidates),
+                     std::end(candidates),
+                     [](const auto& l, const auto& r) { return l.length() < r.length(); });
+  const auto length = largest_candidate->length();
+  if (length <= std::numeric_limits<double>::epsilon()) {
+    return std::nullopt;
+  }
+  return *largest_candidate / length;
+}
+
+/**
+ * Level of the Morton cells that are used for the neighbour cell lookup. Point
+ * clouds mostly sample surfaces, so the number of points per cell grows with
+ * 4^level instead of 8^level. We pick the level at which a cell contains about
+ * as many points as the search window
+ */
+uint32_t
+neighbour_cell_level(size_t num_points, uint32_t search_window)
+{
+  const auto points_per_window = static_cast<double>(std::max(search_window, 1u)) * 2;
+  const auto ratio = static_cast<double>(num_points) / points_per_window;
+  if (ratio <= 1) {
+    return 1;
+  }
+  const auto level = static_cast<uint32_t>(std::round(std::log2(ratio) / 2));
+  return std::clamp(level, 1u, MortonIndex64Levels);
+}
+
+/**
+ * Finds the subranges of 'sorted_points' that belong to the 27 Morton cells
+ * surrounding (and including) the cell 'cell_index'
+ */
+void
+find_neighbour_cell_ranges(const OctreeNodeIndex64& cell_index,
+                           util::Range<IndexedPointsIter> sorted_points,
+                           std::vector<util::Range<IndexedPointsIter>>& cell_ranges)
+{
+  cell_ranges.clear();
+
+  const auto level = cell_index.levels();
+  const auto cells_per_axis = int64_t{ 1 } << level;
+  const auto cell_size_in_morton_order = uint64_t{ 1 } << (3 * (MortonIndex64Levels - level));
+  const auto grid_index = cell_index.to_grid_index();
+
+  for (int64_t dx = -1; dx <= 1; ++dx) {
+    for (int64_t dy = -1; dy <= 1; ++dy) {
+      for (int64_t dz = -1; dz <= 1; ++dz) {
+        const auto x = static_cast<int64_t>(grid_index.x) + dx;
+        const auto y = static_cast<int64_t>(grid_index.y) + dy;
+        const auto z = static_cast<int64_t>(grid_index.z) + dz;
+        if (x < 0 || y < 0 || z < 0 || x >= cells_per_axis || y >= cells_per_axis ||
+            z >= cells_per_axis) {
+          continue;
+        }
+
+        const auto neighbour_index = OctreeNodeIndex64::from_grid_index(
+          { static_cast<uint64_t>(x), static_cast<uint64_t>(y), static_cast<uint64_t>(z) },
+          level);
+        const auto cell_begin = neighbour_index.to_static_morton_index().get();
+        const auto cell_end = cell_begin + cell_size_in_morton_order;
+
+        const auto range_begin =
+          std::lower_bound(std::begin(sorted_points),
+                           std::end(sorted_points),
+                           cell_begin,
+                           [](const IndexedPoint64& point, uint64_t morton_index) {
+                             return point.morton_index.get() < morton_index;
+                           });
+        const auto range_end =
+          std::lower_bound(range_begin,
+                           std::end(sorted_points),
+                           cell_end,
+                           [](const IndexedPoint64& point, uint64_t morton_index) {
+                             return point.morton_index.get() < morton_index;
+                           });
+        if (range_begin == range_end)
+          continue;
+
+        cell_ranges.push_back({ range_begin, range_end });
+      }
+    }
+  }
+}
+
+} // namespace
+
+Vector3<float>
+estimate_normal_from_points(gsl::span<const Vector3<double>> points)
+{
+  if (points.size() < 3) {
+    return DEFAULT_NORMAL;
+  }
+
+  Vector3<double> centroid;
+  for (const auto& point : points) {
+    centroid += point;
+  }
+  centroid = centroid / static_cast<double>(points.size());
+
+  // Upper triangle of the covariance matrix in row-major order
+  std::array<double, 6> covariance = {};
+  for (const auto& point : points) {
+    const auto diff = point - centroid;
+    covariance[0] += diff.x * diff.x;
+    covariance[1] += diff.x * diff.y;
+    covariance[2] += diff.x * diff.z;
+    covariance[3] += diff.y * diff.y;
+    covariance[4] += diff.y * diff.z;
+    covariance[5] += diff.z * diff.z;
+  }
+
+  const auto normal = smallest_eigenvector(covariance);
+  if (!normal) {
+    return DEFAULT_NORMAL;
+  }
+
+  // We don't know the sensor position, so we orient all normals towards
+  // positive Z, which is correct for airborne scans and most terrestrial scans
+  const auto sign = (normal->z < 0) ? -1.0 : 1.0;
+  return { static_cast<float>(sign * normal->x),
+           static_cast<float>(sign * normal->y),
+           static_cast<float>(sign * normal->z) };
+}
+
+void
+estimate_normals(util::Range<IndexedPointsIter> sorted_points,
+                 util::Range<IndexedPointsIter> points_to_process,
+                 const NormalEstimationParameters& parameters)
+{
+  if (points_to_process.size() == 0)
+    return;
+  if (!points_to_process.first().point_reference.normal())
+    return;
+
+  const auto window = static_cast<ptrdiff_t>(parameters.search_window);
+  const auto k = static_cast<size_t>(std::max(parameters.k_neighbours, 3u));
+  const auto cell_level = neighbour_cell_level(sorted_points.size(), parameters.search_window);
+  const auto cell_shift = 3 * (MortonIndex64Levels - cell_level);
+
+  struct Candidate
+  {
+    double squared_distance;
+    IndexedPointsIter point;
+  };
+  std::vector<Candidate> candidates;
+  std::vector<Vector3<double>> neighbourhood;
+  std::vector<util::Range<IndexedPointsIter>> cell_ranges;
+  std::optional<uint64_t> current_cell;
+
+  for (auto iter = std::begin(points_to_process); iter != std::end(points_to_process); ++iter) {
+    const auto& position = iter->point_reference.position();
+
+    // Points are sorted, so consecutive points mostly share the same cell and
+    // we only have to search for the neighbour cells when the cell changes
+    const auto cell = iter->morton_index.get() >> cell_shift;
+    if (!current_cell || *current_cell != cell) {
+      current_cell = cell;
+      find_neighbour_cell_ranges(
+        OctreeNodeIndex64{ iter->morton_index, cell_level }, sorted_points, cell_ranges);
+    }
+
+    candidates.clear();
+
+    // Window around the point in Morton order
+    const auto window_begin =
+      std::begin(sorted_points) +
+      std::max(ptrdiff_t{ 0 }, std::distance(std::begin(sorted_points), iter) - window);
+    const auto window_end =
+      iter + std::min(window + 1, std::distance(iter, std::end(sorted_points)));
+    for (auto candidate = window_begin; candidate != window_end; ++candidate) {
+      candidates.push_back(
+        { position.squaredDistanceTo(candidate->point_reference.position()), candidate });
+    }
+
+    // Points from the neighbouring cells. Large cells are subsampled with a
+    // fixed stride so that we get an even spatial coverage of the cell
+    for (const auto& cell_range : cell_ranges) {
+      const auto cell_points = static_cast<ptrdiff_t>(cell_range.size());
+      const auto stride = std::max(ptrdiff_t{ 1 }, cell_points / std::max(window, ptrdiff_t{ 1 }));
+      for (ptrdiff_t idx = 0; idx < cell_points; idx += stride) {
+        const auto candidate = std::begin(cell_range) + idx;
+        // Skip points that we already have from the window
+        if (candidate >= window_begin && candidate < window_end)
+          continue;
+        candidates.push_back(
+          { position.squaredDistanceTo(candidate->point_reference.position()), candidate });
+      }
+    }
+
+    const auto num_neighbours = std::min(k, candidates.size());
+    std::nth_element(std::begin(candidates),
+                     std::begin(candidates) + (num_neighbours - 1),
+                     std::end(candidates),
+                     [](const Candidate& l, const Candidate& r) {
+                       return l.squared_distance < r.squared_distance;
+                     });
+
+    neighbourhood.clear();
+    std::transform(std::begin(candidates),
+                   std::begin(candidates) + num_neighbours,
+                   std::back_inserter(neighbourhood),
+                   [](const Candidate& candidate) -> Vector3<double> {
+                     return candidate.point->point_reference.position();
+                   });
+
+    *iter->point_reference.normal() = estimate_normal_from_points(neighbourhood);
+  }
+}
+
+void
+estimate_normals_parallel(util::Range<IndexedPointsIter> sorted_points,
+                          const NormalEstimationParameters& parameters,
+                          size_t concurrency,
+                          tf::Subflow& subflow)
+{
+  if (sorted_points.size() <= concurrency) {
+    estimate_normals(sorted_points, sorted_points, parameters);
+    return;
+  }
+
+  const auto chunks =
+    split_range_into_chunks(concurrency, std::begin(sorted_points), std::end(sorted_points));
+  for (const auto& [chunk_begin, chunk_end] : chunks) {
+    subflow
+      .emplace([sorted_points, chunk_begin = chunk_begin, chunk_end = chunk_end, parameters]() {
+        estimate_normals(sorted_points, { chunk_begin, chunk_end }, parameters);
+      })
+      .name("estimate_normals");
+  }
+}
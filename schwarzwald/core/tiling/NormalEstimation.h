@@ -0,0 +1,63 @@
+#pragma once
+
+#include "containers/Range.h"
+#include "math/Vector3.h"
+#include "tiling/Sampling.h"
+
+#include <gsl/gsl>
+#include <taskflow/taskflow.hpp>
+#include <vector>
+
+/**
+ * Parameters for estimating point normals from the local neighbourhood of each
+ * point
+ */
+struct NormalEstimationParameters
+{
+  /**
+   * Number of nearest neighbours that are used for fitting the tangent plane
+   * of a point
+   */
+  uint32_t k_neighbours = 12;
+  /**
+   * Number of points to the left and right of a point in Morton order that
+   * are considered as candidates for the nearest neighbours. The same number
+   * of candidates is taken from each neighbouring Morton cell
+   */
+  uint32_t search_window = 32;
+};
+
+/**
+ * Estimates the normal of the tangent plane through the given points using a
+ * principal component analysis of their covariance matrix. The normal is the
+ * eigenvector belonging to the smallest eigenvalue and is oriented so that it
+ * points towards positive Z. Returns (0,0,1) if there are less than three
+ * points
+ */
+Vector3<float>
+estimate_normal_from_points(gsl::span<const Vector3<double>> points);
+
+/**
+ * Estimates normals for all points in 'points_to_process' from their k nearest
+ * neighbours within 'sorted_points'. 'sorted_points' must be sorted by Morton
+ * index and 'points_to_process' must be a subrange of 'sorted_points'. The
+ * nearest neighbours are searched for in a window around each point in Morton
+ * order, as well as in the neighbouring Morton cells, which cover the jumps of
+ * the Z-order curve. Results are written to the 'normal()' attribute of each
+ * point, points without normals are skipped
+ */
+void
+estimate_normals(util::Range<std::vector<IndexedPoint64>::iterator> sorted_points,
+                 util::Range<std::vector<IndexedPoint64>::iterator> points_to_process,
+                 const NormalEstimationParameters& parameters);
+
+/**
+ * Estimates normals for all points in the given Morton-sorted range by
+ * splitting it into 'concurrency' chunks that are processed in parallel as
+ * tasks of 'subflow'
+ */
+void
+estimate_normals_parallel(util::Range<std::vector<IndexedPoint64>::iterator> sorted_points,
+                          const NormalEstimationParameters& parameters,
+                          size_t concurrency,
+                          tf::Subflow& subflow);
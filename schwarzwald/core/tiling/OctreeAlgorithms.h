@@ -58,18 +58,34 @@ uint8_t
 get_octant(const Vector3<double>& position, const AABB& bounds);
 
 /**
- * Calculates the MortonIndex for a given position starting from 'node_bounds'
- * as root node
+ * Scale that maps offsets from the minimum corner of a box with the given
+ * extent to a grid with 'cells_per_axis' cells along each axis. Axes without a
+ * positive extent, e.g. of the bounds of flat or single points, get a scale of
+ * zero, so that all offsets map to the first cell along them instead of NaN
  */
-template<unsigned int MaxLevels>
+inline Vector3<double>
+grid_scale_for_extent(const Vector3<double>& extent, double cells_per_axis)
+{
+  const auto scale_for_axis = [cells_per_axis](double axis_extent) {
+    return (axis_extent > 0) ? (cells_per_axis / axis_extent) : 0.0;
+  };
+  return { scale_for_axis(extent.x), scale_for_axis(extent.y), scale_for_axis(extent.z) };
+}
+
+/**
+ * Calculates the MortonIndex for a position given as an offset to the minimum
+ * corner of 'node_bounds', starting from 'node_bounds' as root node. This works
+ * directly on local positions of a PointBuffer whose origin is 'node_bounds.min'
+ */
+template<unsigned int MaxLevels, typename T>
 MortonIndex<MaxLevels>
-calculate_morton_index(const Vector3<double>& position, const AABB& node_bounds)
+calculate_morton_index_from_offset(const Vector3<T>& offset_to_min, const AABB& node_bounds)
 {
   using DataType_t = typename MortonIndex<MaxLevels>::Store_t;
   // Normalize bounds and position to [0;2^MaxLevels-1]
-  const auto normalized_scale = (std::pow(2, MaxLevels) / node_bounds.extent());
+  const auto normalized_scale = grid_scale_for_extent(node_bounds.extent(), std::pow(2, MaxLevels));
   const auto normalized_point =
-    (position - node_bounds.min).multiply_component_wise(normalized_scale);
+    Vector3<T>::template cast<double>(offset_to_min).multiply_component_wise(normalized_scale);
   // Ensure that points right on the edge of the bounds don't overflow
   const auto bits_x = std::min(static_cast<DataType_t>(normalized_point.x),
                                static_cast<DataType_t>((1 << MaxLevels) - 1));
@@ -86,6 +102,17 @@ calculate_morton_index(const Vector3<double>& position, const AABB& node_bounds)
   return MortonIndex<MaxLevels>{ static_cast<DataType_t>(key_val) };
 }
 
+/**
+ * Calculates the MortonIndex for a given position starting from 'node_bounds'
+ * as root node
+ */
+template<unsigned int MaxLevels>
+MortonIndex<MaxLevels>
+calculate_morton_index(const Vector3<double>& position, const AABB& node_bounds)
+{
+  return calculate_morton_index_from_offset<MaxLevels>(position - node_bounds.min, node_bounds);
+}
+
 template<unsigned int MaxLevels>
 MortonIndex<MaxLevels>
 calculate_morton_index_naive(const Vector3<double>& position,
@@ -153,7 +180,7 @@ index_point(PointBuffer::PointReference point,
     return !bounds.isInside(position);
   };
 
-  auto& position = point.position();
+  auto position = point.position();
   if (is_outlier(position, bounds)) {
 
     if (outlier_points_behaviour == OutlierPointsBehaviour::Abort) {
@@ -167,6 +194,7 @@ index_point(PointBuffer::PointReference point,
     position.x = std::min(bounds.max.x, std::max(bounds.min.x, position.x));
     position.y = std::min(bounds.max.y, std::max(bounds.min.y, position.y));
     position.z = std::min(bounds.max.z, std::max(bounds.min.z, position.z));
+    point.set_position(position);
   }
 
   return IndexedPoint<MaxLevels>{
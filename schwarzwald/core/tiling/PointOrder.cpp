@@ -0,0 +1,185 @@
+#include "tiling/PointOrder.h"
+
+#include "tiling/OctreeAlgorithms.h"
+#include "util/stuff.h"
+
+#include <algorithm>
+#include <array>
+#include <tuple>
+
+constexpr static uint32_t HILBERT_BITS_PER_AXIS = 21;
+
+/**
+ * Converts the coordinates of a cell into the 'transposed' form of its Hilbert
+ * index, where the bits of the index are distributed over the three axes (J.
+ * Skilling, "Programming the Hilbert curve", 2004)
+ */
+static void
+axes_to_transposed_hilbert_index(std::array<uint32_t, 3>& axes)
+{
+  constexpr uint32_t highest_bit = 1u << (HILBERT_BITS_PER_AXIS - 1);
+
+  // Inverse undo of the rotations and reflections of each level
+  for (uint32_t bit = highest_bit; bit > 1; bit >>= 1) {
+    const auto lower_bits = bit - 1;
+    for (size_t axis = 0; axis < axes.size(); ++axis) {
+      if (axes[axis] & bit) {
+        axes[0] ^= lower_bits;
+      } else {
+        const auto swapped_bits = (axes[0] ^ axes[axis]) & lower_bits;
+        axes[0] ^= swapped_bits;
+        axes[axis] ^= swapped_bits;
+      }
+    }
+  }
+
+  // Gray encode
+  for (size_t axis = 1; axis < axes.size(); ++axis) {
+    axes[axis] ^= axes[axis - 1];
+  }
+  uint32_t flipped_bits = 0;
+  for (uint32_t bit = highest_bit; bit > 1; bit >>= 1) {
+    if (axes.back() & bit) {
+      flipped_bits ^= bit - 1;
+    }
+  }
+  for (auto& axis : axes) {
+    axis ^= flipped_bits;
+  }
+}
+
+uint64_t
+calculate_hilbert_key(const Vector3<double>& position, const AABB& bounds)
+{
+  constexpr auto max_cell = (uint64_t{ 1 } << HILBERT_BITS_PER_AXIS) - 1;
+  const auto normalized_scale =
+    grid_scale_for_extent(bounds.extent(), std::pow(2, HILBERT_BITS_PER_AXIS));
+  const auto normalized_position =
+    (position - bounds.min).multiply_component_wise(normalized_scale);
+  const auto to_cell = [max_cell](double normalized_coordinate) {
+    return static_cast<uint32_t>(
+      std::clamp(normalized_coordinate, 0.0, static_cast<double>(max_cell)));
+  };
+
+  std::array<uint32_t, 3> axes = { to_cell(normalized_position.x),
+                                   to_cell(normalized_position.y),
+                                   to_cell(normalized_position.z) };
+  axes_to_transposed_hilbert_index(axes);
+
+  // The transposed index stores the most significant bit of each level in the
+  // first axis, so interleaving the axes gives the index
+  return (expand_bits_by_3(uint64_t{ axes[0] }) << 2) |
+         (expand_bits_by_3(uint64_t{ axes[1] }) << 1) | expand_bits_by_3(uint64_t{ axes[2] });
+}
+
+/**
+ * Reverses the order of the octants of the given Morton index, so that the
+ * octant of the deepest level becomes the most significant one
+ */
+static uint64_t
+reverse_octants(uint64_t morton_index)
+{
+  uint64_t reversed_index = 0;
+  for (uint32_t level = 0; level < MortonIndex64Levels; ++level) {
+    reversed_index = (reversed_index << 3) | (morton_index & 0b111);
+    morton_index >>= 3;
+  }
+  return reversed_index;
+}
+
+/**
+ * Sorts the given points into LOD prefix order (see PointOrder::LODPrefix)
+ */
+static void
+order_points_by_lod_prefix(std::vector<PointBuffer::PointReference>& points,
+                           const AABB& node_bounds)
+{
+  struct LODKey
+  {
+    uint32_t level;
+    uint64_t reversed_morton_index;
+    size_t point_index;
+
+    bool operator<(const LODKey& other) const
+    {
+      return std::tie(level, reversed_morton_index, point_index) <
+             std::tie(other.level, other.reversed_morton_index, other.point_index);
+    }
+  };
+
+  std::vector<std::pair<uint64_t, size_t>> morton_indices;
+  morton_indices.reserve(points.size());
+  for (size_t idx = 0; idx < points.size(); ++idx) {
+    morton_indices.emplace_back(
+      calculate_morton_index<MortonIndex64Levels>(points[idx].position(), node_bounds).get(),
+      idx);
+  }
+  std::sort(std::begin(morton_indices), std::end(morton_indices));
+
+  // In Morton order, a point is the first point of its cell on all levels below
+  // the levels that it shares with its predecessor. Points with the same Morton
+  // index as their predecessor come after all others
+  std::vector<LODKey> keys;
+  keys.reserve(points.size());
+  for (size_t idx = 0; idx < morton_indices.size(); ++idx) {
+    const auto morton_index = morton_indices[idx].first;
+    uint32_t level = 0;
+    if (idx > 0) {
+      const auto differing_bits = morton_index ^ morton_indices[idx - 1].first;
+      uint32_t shared_levels = MortonIndex64Levels;
+      for (uint32_t shared_level = 0; shared_level < MortonIndex64Levels; ++shared_level) {
+        const auto shift = 3 * (MortonIndex64Levels - shared_level - 1);
+        if ((differing_bits >> shift) & 0b111) {
+          shared_levels = shared_level;
+          break;
+        }
+      }
+      level = shared_levels + 1;
+    }
+    keys.push_back({ level, reverse_octants(morton_index), morton_indices[idx].second });
+  }
+  std::sort(std::begin(keys), std::end(keys));
+
+  std::vector<PointBuffer::PointReference> ordered_points;
+  ordered_points.reserve(points.size());
+  for (const auto& key : keys) {
+    ordered_points.push_back(points[key.point_index]);
+  }
+  points = std::move(ordered_points);
+}
+
+void
+order_points_in_node(std::vector<PointBuffer::PointReference>& points,
+                     const AABB& node_bounds,
+                     PointOrder point_order)
+{
+  if (point_order == PointOrder::LODPrefix) {
+    order_points_by_lod_prefix(points, node_bounds);
+    return;
+  }
+
+  const auto calculate_key = [&](const PointBuffer::PointReference& point) -> uint64_t {
+    switch (point_order) {
+      case PointOrder::Hilbert:
+        return calculate_hilbert_key(point.position(), node_bounds);
+      case PointOrder::Morton:
+      default:
+        return calculate_morton_index<MortonIndex64Levels>(point.position(), node_bounds).get();
+    }
+  };
+
+  // Calculate the keys once instead of in each comparison
+  std::vector<std::pair<uint64_t, size_t>> keys;
+  keys.reserve(points.size());
+  for (size_t idx = 0; idx < points.size(); ++idx) {
+    keys.emplace_back(calculate_key(points[idx]), idx);
+  }
+  std::sort(std::begin(keys), std::end(keys));
+
+  std::vector<PointBuffer::PointReference> ordered_points;
+  ordered_points.reserve(points.size());
+  for (const auto& key : keys) {
+    ordered_points.push_back(points[key.second]);
+  }
+  points = std::move(ordered_points);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "datastructures/PointBuffer.h"
+#include "math/AABB.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Order of the points inside each persisted node. The nodes themselves are
+ * always addressed by their Morton index
+ */
+enum class PointOrder
+{
+  /**
+   * Order along the Z-order curve, which is the order that tiling produces
+   */
+  Morton,
+  /**
+   * Order along a Hilbert curve. Consecutive points on a Hilbert curve are
+   * always close to each other, while the Z-order curve has large jumps
+   * between its quadrants. This keeps the deltas between consecutive points
+   * small, which makes compressed node files (e.g. LAZ) smaller
+   */
+  Hilbert,
+  /**
+   * Order in which each prefix of the points is a spatially uniform subsample
+   * of the node. The node is divided like an octree, and the points are sorted
+   * by the level at which they are the first point in their cell, which is the
+   * selection of the grid-based sampling strategies applied recursively. Within
+   * a level, points are sorted by their bit-reversed Morton index, so that
+   * their cells are spread over the whole node. Clients can read only the
+   * first points of a node (e.g. with a range request on an uncompressed file)
+   * for a coarser version of the node
+   */
+  LODPrefix
+};
+
+/**
+ * Calculates the key of the given position on a 3D Hilbert curve through
+ * 'bounds', with 21 bits per axis. Positions outside of 'bounds' are clamped
+ * to the bounds
+ */
+uint64_t
+calculate_hilbert_key(const Vector3<double>& position, const AABB& bounds);
+
+/**
+ * Sorts the given points of a node with the given bounds into the given order
+ */
+void
+order_points_in_node(std::vector<PointBuffer::PointReference>& points,
+                     const AABB& node_bounds,
+                     PointOrder point_order);
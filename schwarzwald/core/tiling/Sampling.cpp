@@ -59,4 +59,14 @@ required_morton_index_depth(const SamplingStrategy& sampling_strategy,
         return static_cast<uint32_t>(node_level + levels);
       } },
     sampling_strategy);
-}
\ No newline at end of file
+}
+
+bool
+samples_one_point_per_grid_cell(const SamplingStrategy& sampling_strategy)
+{
+  return std::visit(
+    overloaded{ [](const PoissonDiskSampling&) { return false; },
+                [](const AdaptivePoissonDiskSampling&) { return false; },
+                [](const auto&) { return true; } },
+    sampling_strategy);
+}
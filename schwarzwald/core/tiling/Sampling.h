@@ -7,6 +7,9 @@
 #include "datastructures/SparseGrid.h"
 #include "math/AABB.h"
 
+#include <types/type_util.h>
+
+#include <memory>
 #include <random>
 #include <unordered_set>
 #include <variant>
@@ -180,6 +183,63 @@ enum class SamplingBehaviour
   AlwaysAdhereToMinSpacing
 };
 
+/**
+ * Occupancy of an interior node that has been sampled with a minimum spacing.
+ * It is kept between batches, so that the points of later batches only have to
+ * be tested against the occupancy instead of sampling them again together with
+ * all previously selected points of the node
+ */
+struct NodeOccupancy
+{
+  /**
+   * Sorted indices of all grid cells that contain a selected point, for the
+   * sampling strategies that take one point per grid cell
+   */
+  std::vector<uint64_t> occupied_cells;
+  /**
+   * All selected points, for the sampling strategies that take points with a
+   * minimum distance
+   */
+  std::unique_ptr<SparseGrid> min_distance_grid;
+
+  size_t content_byte_size() const
+  {
+    return occupied_cells.capacity() * sizeof(uint64_t) +
+           (min_distance_grid ? min_distance_grid->content_byte_size() : 0);
+  }
+};
+
+/**
+ * The level in the octree of the grid cells that RandomSortedGridSampling and
+ * GridCenterSampling take one point from, for a node at the given level.
+ * Returns -1 if the grid has only a single cell
+ */
+inline int32_t
+grid_cell_level_for_node(int32_t node_level,
+                         const AABB& root_bounds,
+                         float spacing_at_root)
+{
+  const auto spacing_at_this_node =
+    spacing_at_root / std::pow(2, node_level + 1);
+  // candidate_level_in_octree is the last level in the octree at which the
+  // node sidelength is >= spacing we use floor() here because this guarantees
+  // that we always get a node with sidelength
+  // >= spacing. Sadly this means that there might be edge cases where the
+  // spacing is just a bit too large to fit into a node (e.g. sidelength = 2,
+  // spacing = 2.1) If we don't want that, we could use round() which resolves
+  // these cases while at the same time dropping the guarantee for >= spacing.
+  // Also, round(log(...)) might not split fair. If there are sidelengths 4
+  // and 2, we would expect that spacing >= 3 rounds to node with sidelength
+  // 4, while < 3 rounds to 2. However, log_2(4/2.9)~=0.464, which will still
+  // round to the larger node
+  return std::max(
+    -1,
+    (int)std::floor(std::log2f(root_bounds.extent().x / spacing_at_this_node)) -
+      1); // the root node (whole octree) is level '-1', so level 0 has a
+          // sidelength of half the max octree, hence we have to subtract one
+          // here
+}
+
 /**
  * Sampling strategy that partitions a node into an even grid and takes the
  * first point to fall into each grid cell
@@ -207,26 +267,8 @@ struct RandomSortedGridSampling
       }
     }
 
-    const auto spacing_at_this_node =
-      spacing_at_root / std::pow(2, node_level + 1);
-    // candidate_level_in_octree is the last level in the octree at which the
-    // node sidelength is >= spacing we use floor() here because this guarantees
-    // that we always get a node with sidelength
-    // >= spacing. Sadly this means that there might be edge cases where the
-    // spacing is just a bit too large to fit into a node (e.g. sidelength = 2,
-    // spacing = 2.1) If we don't want that, we could use round() which resolves
-    // these cases while at the same time dropping the guarantee for >= spacing.
-    // Also, round(log(...)) might not split fair. If there are sidelengths 4
-    // and 2, we would expect that spacing >= 3 rounds to node with sidelength
-    // 4, while < 3 rounds to 2. However, log_2(4/2.9)~=0.464, which will still
-    // round to the larger node
     const auto candidate_level_in_octree =
-      std::max(-1,
-               (int)std::floor(
-                 std::log2f(root_bounds.extent().x / spacing_at_this_node)) -
-                 1); // the root node (whole octree) is level '-1', so level
-                     // 0 has a sidelength of half the max octree, hence we
-                     // have to subtract one here
+      grid_cell_level_for_node(node_level, root_bounds, spacing_at_root);
     auto partition_point = begin;
 
     const auto stable_partition_at_level = [&](int level) {
@@ -334,13 +376,8 @@ struct GridCenterSampling
       }
     }
 
-    const auto spacing_at_this_node =
-      spacing_at_root / std::pow(2, node_level + 1);
     const auto candidate_level_in_octree =
-      std::max(-1,
-               (int)std::floor(
-                 std::log2f(root_bounds.extent().x / spacing_at_this_node)) -
-                 1);
+      grid_cell_level_for_node(node_level, root_bounds, spacing_at_root);
     auto partition_point = begin;
 
     if (candidate_level_in_octree == -1) {
@@ -501,10 +538,7 @@ struct AdaptivePoissonDiskSampling
     const auto spacing_at_this_node =
       spacing_at_root / std::pow(2, node_level + 1);
     const auto candidate_level_in_octree =
-      std::max(-1,
-               (int)std::floor(
-                 std::log2f(root_bounds.extent().x / spacing_at_this_node)) -
-                 1);
+      grid_cell_level_for_node(node_level, root_bounds, spacing_at_root);
     auto partition_point = begin;
 
     if (candidate_level_in_octree == -1) {
@@ -536,6 +570,11 @@ struct AdaptivePoissonDiskSampling
       });
   }
 
+  float density_at_level(int32_t node_level) const
+  {
+    return _density_per_level(node_level);
+  }
+
 private:
   size_t _max_points_per_node;
   std::function<float(int32_t)> _density_per_level;
@@ -753,6 +792,26 @@ struct JitteredSampling
       });
   }
 
+  /**
+   * The level in the octree of the permutation grid cells that this strategy
+   * takes one point from, for the given node
+   */
+  template<unsigned int MaxLevels>
+  uint32_t grid_level_for_node(MortonIndex<MaxLevels> node_key,
+                               int32_t node_level,
+                               const AABB& root_bounds,
+                               float spacing_at_root) const
+  {
+    const AABB bounds_at_this_node =
+      get_bounds_from_morton_index(node_key, root_bounds, node_level + 1);
+    const auto spacing_at_this_node =
+      spacing_at_root / std::pow(2, node_level + 1);
+    const auto actual_cell_count = get_prev_power_of_two(static_cast<uint32_t>(
+      bounds_at_this_node.extent().x / spacing_at_this_node));
+    return static_cast<uint32_t>(node_level) +
+           static_cast<uint32_t>(std::log2(actual_cell_count));
+  }
+
 private:
   size_t _max_points_per_node;
   std::default_random_engine _rnd;
@@ -820,6 +879,275 @@ sample_points(SamplingStrategy& sampling_strategy,
     sampling_strategy);
 }
 
+/**
+ * Index of the grid cell at 'cell_level' that the given point falls into. A
+ * 'cell_level' of -1 means that the grid has only a single cell
+ */
+template<unsigned int MaxLevels>
+uint64_t
+grid_cell_of(const IndexedPoint<MaxLevels>& point, int32_t cell_level)
+{
+  if (cell_level < 0)
+    return 0;
+  return static_cast<uint64_t>(
+    point.morton_index.truncate_to_level(static_cast<uint32_t>(cell_level))
+      .get());
+}
+
+/**
+ * Returns the sorted indices of the grid cells at 'cell_level' that the given
+ * sorted range of points falls into
+ */
+template<typename Iter>
+std::vector<uint64_t>
+occupied_grid_cells(Iter begin, Iter end, int32_t cell_level)
+{
+  std::vector<uint64_t> cells;
+  cells.reserve(static_cast<size_t>(std::distance(begin, end)));
+  std::transform(
+    begin, end, std::back_inserter(cells), [cell_level](const auto& point) {
+      return grid_cell_of(point, cell_level);
+    });
+  cells.erase(std::unique(std::begin(cells), std::end(cells)), std::end(cells));
+  return cells;
+}
+
+/**
+ * Sample points for a node that has been sampled before, using a sampling
+ * strategy that takes one point per grid cell. Points in cells that are
+ * already occupied are rejected right away, the remaining points are sampled
+ * by the strategy and the cells of the selected points are added to
+ * 'occupancy'
+ */
+template<typename Strategy, typename Iter, unsigned int MaxLevels>
+Iter
+sample_unoccupied_grid_cells(Strategy& strategy,
+                             Iter begin,
+                             Iter end,
+                             MortonIndex<MaxLevels> node_key,
+                             int32_t node_level,
+                             const AABB& root_bounds,
+                             float spacing_at_root,
+                             int32_t cell_level,
+                             NodeOccupancy& occupancy)
+{
+  auto& occupied_cells = occupancy.occupied_cells;
+  const auto unoccupied_end =
+    std::stable_partition(begin, end, [&](const auto& point) {
+      return !std::binary_search(std::begin(occupied_cells),
+                                 std::end(occupied_cells),
+                                 grid_cell_of(point, cell_level));
+    });
+
+  const auto partition_point =
+    strategy.sample_points(begin,
+                           unoccupied_end,
+                           node_key,
+                           node_level,
+                           root_bounds,
+                           spacing_at_root,
+                           SamplingBehaviour::AlwaysAdhereToMinSpacing);
+
+  const auto newly_occupied_cells =
+    occupied_grid_cells(begin, partition_point, cell_level);
+  const auto previously_occupied_count = occupied_cells.size();
+  occupied_cells.insert(std::end(occupied_cells),
+                        std::begin(newly_occupied_cells),
+                        std::end(newly_occupied_cells));
+  std::inplace_merge(std::begin(occupied_cells),
+                     std::begin(occupied_cells) + previously_occupied_count,
+                     std::end(occupied_cells));
+
+  // Both the rejected points from unoccupied cells and the points from occupied
+  // cells are sorted, merging them keeps the remaining points sorted so that
+  // they can be split up into the child nodes
+  std::inplace_merge(partition_point, unoccupied_end, end);
+  return partition_point;
+}
+
+/**
+ * Does the given sampling strategy take at most one point from each cell of a
+ * regular grid, independent of all other grid cells? If so, disjoint ranges of
+ * grid cells of a node can be sampled concurrently
+ */
+bool
+samples_one_point_per_grid_cell(const SamplingStrategy& sampling_strategy);
+
+/**
+ * The level of the grid cells that the given sampling strategy takes one point
+ * from, for the given node. Only meaningful for sampling strategies for which
+ * 'samples_one_point_per_grid_cell' is true
+ */
+template<unsigned int MaxLevels>
+int32_t
+sampling_grid_cell_level(const SamplingStrategy& sampling_strategy,
+                         MortonIndex<MaxLevels> node_key,
+                         int32_t node_level,
+                         const AABB& root_bounds,
+                         float spacing_at_root)
+{
+  return std::visit(
+    overloaded{ [&](const JitteredSampling& strategy) {
+                 return static_cast<int32_t>(strategy.grid_level_for_node(
+                   node_key, node_level, root_bounds, spacing_at_root));
+               },
+                [&](const auto&) {
+                  return grid_cell_level_for_node(
+                    node_level, root_bounds, spacing_at_root);
+                } },
+    sampling_strategy);
+}
+
+/**
+ * Splits the sorted range [begin, end) into at most 'max_chunks' consecutive
+ * chunks of similar size. Chunks end at grid cell boundaries at 'cell_level',
+ * so that the points of each grid cell are in a single chunk
+ */
+template<typename Iter>
+std::vector<std::pair<Iter, Iter>>
+split_at_grid_cells(Iter begin, Iter end, int32_t cell_level, size_t max_chunks)
+{
+  const auto num_points = static_cast<size_t>(std::distance(begin, end));
+  if (cell_level < 0 || max_chunks < 2 || num_points < max_chunks) {
+    return { { begin, end } };
+  }
+
+  const auto chunk_size = (num_points + max_chunks - 1) / max_chunks;
+  std::vector<std::pair<Iter, Iter>> chunks;
+  chunks.reserve(max_chunks);
+  for (auto chunk_begin = begin; chunk_begin != end;) {
+    if (static_cast<size_t>(std::distance(chunk_begin, end)) <= chunk_size) {
+      chunks.emplace_back(chunk_begin, end);
+      break;
+    }
+
+    // Extend the chunk up to the first point of the next grid cell
+    const auto last_cell = grid_cell_of(*(chunk_begin + chunk_size - 1), cell_level);
+    const auto chunk_end = std::partition_point(
+      chunk_begin + chunk_size, end, [last_cell, cell_level](const auto& point) {
+        return grid_cell_of(point, cell_level) <= last_cell;
+      });
+    chunks.emplace_back(chunk_begin, chunk_end);
+    chunk_begin = chunk_end;
+  }
+  return chunks;
+}
+
+/**
+ * Creates the occupancy of a node from the points that were selected for the
+ * node by 'sample_points' with a minimum spacing. [selected_begin,
+ * selected_end) has to be sorted
+ */
+template<typename Iter, unsigned int MaxLevels>
+NodeOccupancy
+make_node_occupancy(const SamplingStrategy& sampling_strategy,
+                    Iter selected_begin,
+                    Iter selected_end,
+                    MortonIndex<MaxLevels> node_key,
+                    int32_t node_level,
+                    const AABB& root_bounds,
+                    float spacing_at_root)
+{
+  const auto make_min_distance_grid = [&]() {
+    const auto bounds_at_this_node =
+      get_bounds_from_morton_index(node_key, root_bounds, node_level + 1);
+    const auto spacing_at_this_node =
+      spacing_at_root / std::pow(2, node_level + 1);
+    auto grid = std::make_unique<SparseGrid>(
+      bounds_at_this_node, static_cast<float>(spacing_at_this_node));
+    for (auto iter = selected_begin; iter != selected_end; ++iter) {
+      grid->addWithoutCheck(iter->point_reference.position());
+    }
+    return grid;
+  };
+
+  NodeOccupancy occupancy;
+  std::visit(
+    overloaded{
+      [&](const PoissonDiskSampling&) {
+        occupancy.min_distance_grid = make_min_distance_grid();
+      },
+      [&](const AdaptivePoissonDiskSampling&) {
+        occupancy.min_distance_grid = make_min_distance_grid();
+      },
+      [&](const auto&) {
+        occupancy.occupied_cells = occupied_grid_cells(
+          selected_begin,
+          selected_end,
+          sampling_grid_cell_level(
+            sampling_strategy, node_key, node_level, root_bounds, spacing_at_root));
+      } },
+    sampling_strategy);
+  return occupancy;
+}
+
+/**
+ * Sample points for a node that has been sampled before. Instead of sampling
+ * the new points together with all previously selected points, the new points
+ * are only tested against the occupancy of the node, which is updated with the
+ * newly selected points. Returns a partition point like 'sample_points', the
+ * points in [partition_point, end) stay sorted
+ */
+template<typename Iter, unsigned int MaxLevels>
+Iter
+sample_points_incrementally(SamplingStrategy& sampling_strategy,
+                            Iter begin,
+                            Iter end,
+                            MortonIndex<MaxLevels> node_key,
+                            int32_t node_level,
+                            const AABB& root_bounds,
+                            float spacing_at_root,
+                            NodeOccupancy& occupancy)
+{
+  return std::visit(
+    overloaded{
+      [&](PoissonDiskSampling&) {
+        return std::stable_partition(begin, end, [&](const auto& point) {
+          return occupancy.min_distance_grid->add(
+            point.point_reference.position());
+        });
+      },
+      [&](AdaptivePoissonDiskSampling& strategy) {
+        const auto nth_point = static_cast<uint32_t>(
+          std::round(1 / strategy.density_at_level(node_level)));
+        uint32_t point_counter = nth_point - 1;
+        return std::stable_partition(begin, end, [&](const auto& point) {
+          if (++point_counter == nth_point) {
+            point_counter = 0;
+            return occupancy.min_distance_grid->add(
+              point.point_reference.position());
+          }
+          return false;
+        });
+      },
+      [&](JitteredSampling& strategy) {
+        const auto grid_level = strategy.grid_level_for_node(
+          node_key, node_level, root_bounds, spacing_at_root);
+        return sample_unoccupied_grid_cells(strategy,
+                                            begin,
+                                            end,
+                                            node_key,
+                                            node_level,
+                                            root_bounds,
+                                            spacing_at_root,
+                                            static_cast<int32_t>(grid_level),
+                                            occupancy);
+      },
+      [&](auto& strategy) {
+        return sample_unoccupied_grid_cells(
+          strategy,
+          begin,
+          end,
+          node_key,
+          node_level,
+          root_bounds,
+          spacing_at_root,
+          grid_cell_level_for_node(node_level, root_bounds, spacing_at_root),
+          occupancy);
+      } },
+    sampling_strategy);
+}
+
 /**
  * Which level of Morton indices does the given sampling strategy require for
  * the given node level?
@@ -0,0 +1,101 @@
+#include "tiling/TaskGranularity.h"
+
+#include <algorithm>
+#include <limits>
+
+/**
+ * Minimum number of points per task until the granularity has been measured
+ */
+constexpr static size_t DEFAULT_MIN_POINTS_PER_TASK = 100'000;
+/**
+ * Bounds for the measured minimum number of points per task, so that a few
+ * outliers in the measurements can't spawn a task for every tiny node or
+ * prevent spawning tasks at all
+ */
+constexpr static size_t LOWEST_MIN_POINTS_PER_TASK = 1'000;
+constexpr static size_t HIGHEST_MIN_POINTS_PER_TASK = 10'000'000;
+/**
+ * The work of a task has to be at least this many times its overhead
+ */
+constexpr static double MIN_WORK_PER_TASK_OVERHEAD = 100;
+/**
+ * Nodes with fewer points are not measured, their time is dominated by noise
+ */
+constexpr static size_t MIN_POINTS_FOR_MEASUREMENT = 1'000;
+constexpr static size_t MIN_NODE_MEASUREMENTS = 8;
+/**
+ * Weight of a new measurement in the moving average of the time per point
+ */
+constexpr static double MEASUREMENT_WEIGHT = 0.1;
+/**
+ * No new tasks are spawned while there are this many pending tasks per worker
+ */
+constexpr static size_t MAX_PENDING_TASKS_PER_WORKER = 4;
+
+TaskGranularity::TaskGranularity()
+  : _concurrency(1)
+  , _task_overhead_in_seconds(std::numeric_limits<double>::infinity())
+  , _seconds_per_point(0)
+  , _num_node_measurements(0)
+{}
+
+void
+TaskGranularity::set_concurrency(size_t concurrency)
+{
+  _concurrency = std::max(size_t{ 1 }, concurrency);
+}
+
+void
+TaskGranularity::record_dispatch_latency(std::chrono::nanoseconds latency)
+{
+  const auto latency_in_seconds = std::chrono::duration<double>(latency).count();
+  auto task_overhead_in_seconds = _task_overhead_in_seconds.load();
+  while (latency_in_seconds < task_overhead_in_seconds &&
+         !_task_overhead_in_seconds.compare_exchange_weak(task_overhead_in_seconds,
+                                                          latency_in_seconds)) {
+  }
+}
+
+void
+TaskGranularity::record_node_duration(size_t points_count, std::chrono::nanoseconds duration)
+{
+  if (points_count < MIN_POINTS_FOR_MEASUREMENT)
+    return;
+
+  const auto seconds_per_point =
+    std::chrono::duration<double>(duration).count() / static_cast<double>(points_count);
+  // The average starts at zero, so the first measurement replaces it
+  auto average = _seconds_per_point.load();
+  while (!_seconds_per_point.compare_exchange_weak(
+    average,
+    (average > 0) ? (1 - MEASUREMENT_WEIGHT) * average + MEASUREMENT_WEIGHT * seconds_per_point
+                  : seconds_per_point)) {
+  }
+  ++_num_node_measurements;
+}
+
+size_t
+TaskGranularity::min_points_per_task() const
+{
+  const auto task_overhead_in_seconds = _task_overhead_in_seconds.load();
+  const auto seconds_per_point = _seconds_per_point.load();
+  if (_num_node_measurements < MIN_NODE_MEASUREMENTS ||
+      task_overhead_in_seconds == std::numeric_limits<double>::infinity() ||
+      seconds_per_point <= 0) {
+    return DEFAULT_MIN_POINTS_PER_TASK;
+  }
+
+  const auto min_points = MIN_WORK_PER_TASK_OVERHEAD * task_overhead_in_seconds / seconds_per_point;
+  return static_cast<size_t>(std::clamp(min_points,
+                                        static_cast<double>(LOWEST_MIN_POINTS_PER_TASK),
+                                        static_cast<double>(HIGHEST_MIN_POINTS_PER_TASK)));
+}
+
+bool
+TaskGranularity::should_spawn_task(size_t points_count, size_t pending_tasks) const
+{
+  if (points_count < min_points_per_task())
+    return false;
+
+  return pending_tasks < _concurrency * MAX_PENDING_TASKS_PER_WORKER;
+}
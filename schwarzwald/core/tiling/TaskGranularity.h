@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+/**
+ * Decides at runtime which nodes are worth their own task during tiling.
+ * Spawning a task only pays off if the work of the node is large compared to
+ * the overhead of dispatching the task, and both depend on the machine, the
+ * sampling strategy and the persistence. TaskGranularity therefore measures
+ * the dispatch latency of tasks and the time per point that tiling a node takes
+ * while tiling is running, and derives the minimum number of points per task
+ * from these measurements. Until enough measurements exist, a fixed default is
+ * used.
+ *
+ * To not flood the executor, no new tasks are spawned while there are already
+ * enough pending tasks for all workers. All member functions are thread-safe
+ * and lock-free, since they are called several times per node. The measurements
+ * are updated independently, which is precise enough for a heuristic
+ */
+struct TaskGranularity
+{
+  TaskGranularity();
+
+  /**
+   * Sets the number of workers that execute the tiling tasks
+   */
+  void set_concurrency(size_t concurrency);
+
+  /**
+   * Records the time between creating a task and the start of its execution
+   */
+  void record_dispatch_latency(std::chrono::nanoseconds latency);
+  /**
+   * Records the time it took to tile a single node with the given number of
+   * points, excluding the child nodes
+   */
+  void record_node_duration(size_t points_count, std::chrono::nanoseconds duration);
+
+  /**
+   * The minimum number of points that a task has to process
+   */
+  size_t min_points_per_task() const;
+  /**
+   * Should a node (or a group of nodes) with the given number of points be
+   * processed in a new task, given the number of tasks that are already
+   * pending?
+   */
+  bool should_spawn_task(size_t points_count, size_t pending_tasks) const;
+
+private:
+  std::atomic<size_t> _concurrency;
+  // Smallest dispatch latency that was observed, which is the latency of a task
+  // that did not have to wait for a free worker, i.e. the overhead of a task
+  std::atomic<double> _task_overhead_in_seconds;
+  // Exponential moving average of the time per point in a node
+  std::atomic<double> _seconds_per_point;
+  std::atomic<size_t> _num_node_measurements;
+};
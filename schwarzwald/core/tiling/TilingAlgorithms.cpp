@@ -4,13 +4,17 @@
 #include "containers/DestructuringIterator.h"
 #include "terminal/stdout_helper.h"
 #include "threading/Parallel.h"
+#include "tiling/NormalEstimation.h"
 #include "util/Config.h"
 #include "util/Stats.h"
 
 #include <debug/Journal.h>
 #include <logging/Journal.h>
 
+#include <chrono>
+#include <cmath>
 #include <mutex>
+#include <numeric>
 #include <set>
 
 /**
@@ -18,11 +22,13 @@
  * MortonIndex
  */
 constexpr static uint32_t MAX_OCTREE_LEVELS = 21;
-/**
- * The minimum number of points in a node needed in order for that node to be
- * processed asynchronously
- */
-constexpr static size_t MIN_POINTS_FOR_ASYNC_PROCESSING = 100'000;
+// Interior nodes with at least this many points are sampled by multiple tasks,
+// each of which samples at least MIN_POINTS_PER_SAMPLING_CHUNK points
+constexpr static size_t MIN_POINTS_FOR_PARALLEL_SAMPLING = 1'000'000;
+constexpr static size_t MIN_POINTS_PER_SAMPLING_CHUNK = 100'000;
+// Rough number of points that a node keeps during sampling, used to estimate
+// how many levels the points of a subtree pass through
+constexpr static double ESTIMATED_POINTS_PER_NODE = 10'000;
 
 static void
 journal_start_nodes(std::string start_nodes_as_graphviz)
@@ -43,6 +49,26 @@ journal_start_nodes(std::string start_nodes_as_graphviz)
 }
 
 #pragma region helper_functions
+/**
+ * Estimates the remaining work for tiling a subtree with the given number of
+ * points, starting at the given level. Every level of the subtree processes all
+ * points that were not taken by the levels above, and since the spacing halves
+ * with each level, each node takes roughly the same number of points. For the
+ * mostly 2.5D surfaces of LiDAR scans, a subtree thus is about log4(points /
+ * points per node) levels deep. The estimate is only used to order subtrees by
+ * their remaining work, so it does not have to be exact
+ */
+static double
+estimate_subtree_cost(size_t points_count, int32_t level, uint32_t max_depth)
+{
+  const auto points = static_cast<double>(points_count);
+  const auto expected_levels =
+    1.0 + std::log(std::max(1.0, points / ESTIMATED_POINTS_PER_NODE)) / std::log(4.0);
+  const auto remaining_levels =
+    std::max(1.0, static_cast<double>(static_cast<int64_t>(max_depth) - level));
+  return points * std::min(expected_levels, remaining_levels);
+}
+
 /**
  * Reads the cached points for the given node from disk and returns them as
  * IndexedPoints
@@ -58,6 +84,14 @@ read_pnts_from_disk(const octree::NodeStructure& node,
   if (!tmp_points.count())
     return {};
 
+  // Cached points are stored relative to their node, which halves the memory
+  // of their positions. Lossless persistences have to reproduce the exact
+  // positions, so they keep the absolute positions
+  if (!persistence.is_lossless() &&
+      PointBuffer::local_positions_are_precise(node.bounds.extent())) {
+    tmp_points.make_positions_local(node.bounds.min);
+  }
+
   auto& points = points_cache.emplace_points(std::move(tmp_points));
 
   /**
@@ -78,36 +112,74 @@ read_pnts_from_disk(const octree::NodeStructure& node,
   std::vector<IndexedPoint<MortonIndex64Levels>> indexed_points;
   indexed_points.reserve(points.count());
 
-  std::transform(
-    std::begin(points),
-    std::end(points),
-    std::back_inserter(indexed_points),
-    [&](const auto& point_ref) -> IndexedPoint64 {
-      auto idx = node.morton_index;
-      auto morton_index_starting_from_this_node =
-        calculate_morton_index<MAX_OCTREE_LEVELS>(point_ref.position(),
-                                                  node.bounds);
-
-      const auto start_level = static_cast<uint32_t>(node.level + 1);
-      for (auto level = start_level; level < MAX_OCTREE_LEVELS; ++level) {
-        idx.set_octant_at_level(
-          level,
-          morton_index_starting_from_this_node.get_octant_at_level(
-            level - start_level));
-      }
+  for (size_t point_idx = 0; point_idx < points.count(); ++point_idx) {
+    auto idx = node.morton_index;
+    // Local positions already are offsets to the minimum corner of the node
+    const auto morton_index_starting_from_this_node =
+      points.has_local_positions()
+        ? calculate_morton_index_from_offset<MAX_OCTREE_LEVELS>(
+            points.local_positions()[point_idx], node.bounds)
+        : calculate_morton_index<MAX_OCTREE_LEVELS>(points.positions()[point_idx],
+                                                    node.bounds);
+
+    const auto start_level = static_cast<uint32_t>(node.level + 1);
+    for (auto level = start_level; level < MAX_OCTREE_LEVELS; ++level) {
+      idx.set_octant_at_level(
+        level,
+        morton_index_starting_from_this_node.get_octant_at_level(
+          level - start_level));
+    }
 
-      return { point_ref, idx };
-    });
+    indexed_points.push_back({ points.get_point(point_idx), idx });
+  }
 
-  // If the Persistence is lossy, we have to sort, as FP inaccuracies might
-  // disturb the order of points
-  if (!persistence.is_lossless()) {
+  // If the Persistence is lossy, FP inaccuracies might disturb the order of
+  // points. The points might also be stored in a different order (see
+  // PointOrder)
+  if (!std::is_sorted(std::begin(indexed_points), std::end(indexed_points))) {
     std::sort(std::begin(indexed_points), std::end(indexed_points));
   }
 
   return indexed_points;
 }
 
+/**
+ * Reads the points of all child nodes of the given node into a single
+ * PointBuffer. The child nodes are read first, so that the buffer is allocated
+ * once with the combined size of all child nodes
+ */
+static PointBuffer
+read_child_nodes(const OctreeNodeIndex64& node_index, PointsPersistence& persistence)
+{
+  std::vector<PointBuffer> child_points;
+  child_points.reserve(8);
+  size_t total_points_count = 0;
+  for (uint8_t octant = 0; octant < 8; ++octant) {
+    const auto child_index = node_index.child(octant);
+    const auto node_name =
+      concat("r", OctreeNodeIndex64::to_string(child_index));
+
+    PointBuffer tmp;
+    persistence.retrieve_points(node_name, tmp);
+
+    if (tmp.empty())
+      continue;
+
+    total_points_count += tmp.count();
+    child_points.push_back(std::move(tmp));
+  }
+
+  if (child_points.empty())
+    return {};
+
+  auto data = std::move(child_points.front());
+  data.reserve(total_points_count);
+  for (size_t idx = 1; idx < child_points.size(); ++idx) {
+    data.append_buffer(child_points[idx]);
+  }
+  return data;
+}
+
 /**
  * Takes a sorted range of IndexedPoints and splits it up into up to eight
  * ranges, one for each child node. This method then returns the appropriate
@@ -195,10 +267,27 @@ TilingAlgorithmBase::TilingAlgorithmBase(SamplingStrategy& sampling_strategy,
   , _progress_reporter(progress_reporter)
   , _persistence(persistence)
   , _meta_parameters(meta_parameters)
-{}
+{
+  _node_occupancies.set_memory_budget(_meta_parameters.node_occupancy_cache_size);
+}
 
 TilingAlgorithmBase::~TilingAlgorithmBase() {}
 
+void
+TilingAlgorithmBase::finalize(const AABB& bounds)
+{
+  // No more points will be added to any node
+  _node_occupancies.clear();
+}
+
+PointsPersistence&
+TilingAlgorithmBase::persistence_for_partition(uint32_t partition)
+{
+  if (_partition_persistences.empty())
+    return _persistence;
+  return *_partition_persistences.at(partition);
+}
+
 /**
  * Tile the given node as a terminal node, i.e. take up to 'max_points_per_node'
  * points and persist them without any sampling
@@ -229,7 +318,8 @@ TilingAlgorithmBase::tile_terminal_node(octree::NodeData const& all_points,
         .str());
   }
 
-  _persistence.persist_points(
+  persist_node_points(
+    persistence_for_partition(node.partition),
     member_iterator(std::begin(all_points), &IndexedPoint64::point_reference),
     member_iterator(std::end(all_points), &IndexedPoint64::point_reference),
     node.bounds,
@@ -286,6 +376,30 @@ TilingAlgorithmBase::tile_internal_node(octree::NodeData& all_points,
                                   sampling_behaviour,
                                   _sampling_strategy);
 
+  return complete_internal_node(all_points,
+                                partition_point,
+                                node,
+                                root_node,
+                                previously_taken_points_count,
+                                sampling_behaviour);
+}
+
+/**
+ * Persists the points that were selected for an interior node, i.e. the points
+ * in [begin(all_points), partition_point), and returns the NodeTilingData for
+ * the child nodes from the remaining points
+ */
+std::vector<NodeTilingData>
+TilingAlgorithmBase::complete_internal_node(
+  octree::NodeData& all_points,
+  octree::NodeData::iterator partition_point,
+  octree::NodeStructure const& node,
+  octree::NodeStructure const& root_node,
+  size_t previously_taken_points_count,
+  SamplingBehaviour sampling_behaviour)
+{
+  const auto node_level_relative_to_root = node.level - (root_node.level + 1);
+
   const auto points_taken =
     static_cast<size_t>(std::distance(std::begin(all_points), partition_point));
 
@@ -327,12 +441,31 @@ TilingAlgorithmBase::tile_internal_node(octree::NodeData& all_points,
     }
   }
 
-  _persistence.persist_points(
+  persist_node_points(
+    persistence_for_partition(node.partition),
     member_iterator(std::begin(all_points), &IndexedPoint64::point_reference),
     member_iterator(partition_point, &IndexedPoint64::point_reference),
     node.bounds,
     node.name);
 
+  // Once the node has been sampled with a minimum spacing, the points of later
+  // batches are only tested against its occupancy (see
+  // 'tile_internal_node_incrementally')
+  const auto was_sampled =
+    sampling_behaviour == SamplingBehaviour::AlwaysAdhereToMinSpacing ||
+    partition_point != std::end(all_points);
+  if (was_sampled) {
+    _node_occupancies.emplace_occupancy(
+      node,
+      make_node_occupancy(_sampling_strategy,
+                          std::begin(all_points),
+                          partition_point,
+                          node.morton_index,
+                          node_level_relative_to_root,
+                          root_node.bounds,
+                          root_node.max_spacing));
+  }
+
   if (_progress_reporter) {
     // To correctly increment progress, we have to know how many points were
     // cached when we last hit this node. In the 'worst' case, we take all the
@@ -348,63 +481,92 @@ TilingAlgorithmBase::tile_internal_node(octree::NodeData& all_points,
     partition_point, std::end(all_points), node, root_node);
 }
 
+/**
+ * Tile the given node as an interior node that has been sampled with a minimum
+ * spacing in a previous batch. Only the new points are sampled against the
+ * occupancy of the node, the points that were selected previously are kept as
+ * they are and are not passed on to the child nodes again
+ */
+std::vector<NodeTilingData>
+TilingAlgorithmBase::tile_internal_node_incrementally(
+  octree::NodeData& new_points,
+  octree::NodeStructure const& node,
+  octree::NodeStructure const& root_node,
+  NodeOccupancy& occupancy)
+{
+  const auto node_level_relative_to_root = node.level - (root_node.level + 1);
+
+  const auto partition_point =
+    sample_points_incrementally(_sampling_strategy,
+                                std::begin(new_points),
+                                std::end(new_points),
+                                node.morton_index,
+                                node_level_relative_to_root,
+                                root_node.bounds,
+                                root_node.max_spacing,
+                                occupancy);
+
+  return complete_internal_node_incrementally(
+    new_points, partition_point, node, root_node);
+}
+
+/**
+ * Persists the points that were newly selected for an interior node that has
+ * been sampled before, i.e. the points in [begin(new_points), partition_point),
+ * together with the previously selected points of the node. Returns the
+ * NodeTilingData for the child nodes from the remaining points
+ */
+std::vector<NodeTilingData>
+TilingAlgorithmBase::complete_internal_node_incrementally(
+  octree::NodeData& new_points,
+  octree::NodeData::iterator partition_point,
+  octree::NodeStructure const& node,
+  octree::NodeStructure const& root_node)
+{
+  const auto newly_taken_points =
+    static_cast<size_t>(std::distance(std::begin(new_points), partition_point));
+
+  if (newly_taken_points > 0) {
+    // The persistences can't append to a node, so the node is written again
+    // with the previously selected points. These points are only copied, not
+    // indexed or sampled
+    auto& persistence = persistence_for_partition(node.partition);
+    PointBuffer previously_taken_points;
+    persistence.retrieve_points(node.name, previously_taken_points);
+
+    std::vector<PointBuffer::PointReference> points_of_this_node{
+      std::begin(previously_taken_points), std::end(previously_taken_points)
+    };
+    points_of_this_node.reserve(points_of_this_node.size() +
+                                newly_taken_points);
+    std::transform(std::begin(new_points),
+                   partition_point,
+                   std::back_inserter(points_of_this_node),
+                   [](const IndexedPoint64& indexed_point) {
+                     return indexed_point.point_reference;
+                   });
+
+    persist_node_points(persistence,
+                        std::begin(points_of_this_node),
+                        std::end(points_of_this_node),
+                        node.bounds,
+                        node.name);
+  }
+
+  if (_progress_reporter)
+    _progress_reporter->increment_progress(progress::INDEXING,
+                                           newly_taken_points);
+
+  return split_range_into_child_nodes(
+    partition_point, std::end(new_points), node, root_node);
+}
+
 std::vector<NodeTilingData>
 TilingAlgorithmBase::tile_node(octree::NodeData&& node_data,
                                const octree::NodeStructure& node_structure,
                                const octree::NodeStructure& root_node_structure,
                                tf::Subflow& subflow)
 {
-  const auto current_node_name =
-    concat(root_node_structure.name,
-           to_string(node_structure.morton_index, node_structure.level + 1));
-
-  auto cached_points = read_pnts_from_disk(
-    node_structure, root_node_structure.bounds, _points_cache, _persistence);
-
-  // const auto node_morton_index_str = node_structure.name.substr(1);
-  // for (auto& point : cached_points) {
-  //   if (!node_structure.bounds.isInside(point.point_reference.position())) {
-  //     throw std::runtime_error{
-  //       (boost::format("Cached point %1% is out of bounds @ node %2%") %
-  //        point.point_reference.position() % node_structure.bounds)
-  //         .str()
-  //     };
-  //   }
-  //   const auto point_morton_index_str = to_string(point.morton_index);
-  //   if (point_morton_index_str.rfind(node_morton_index_str, 0) != 0) {
-  //     throw std::runtime_error{
-  //       (boost::format("Cached point %1% has MortonIndex %2% but it does not
-  //       "
-  //                      "match the MortonIndex of the node: %3%") %
-  //        point.point_reference.position() % point_morton_index_str %
-  //        node_morton_index_str)
-  //         .str()
-  //     };
-  //   }
-  // }
-  // for (auto& point : node_data) {
-  //   if (!node_structure.bounds.isInside(point.point_reference.position())) {
-  //     throw std::runtime_error{
-  //       (boost::format("Current point %1% is out of bounds @ node %2%") %
-  //        point.point_reference.position() % node_structure.bounds)
-  //         .str()
-  //     };
-  //   }
-  //   const auto point_morton_index_str = to_string(point.morton_index);
-  //   if (point_morton_index_str.rfind(node_morton_index_str, 0) != 0) {
-  //     throw std::runtime_error{
-  //       (boost::format("Current point %1% has MortonIndex %2% but it does not
-  //       "
-  //                      "match the MortonIndex of the node: %3%") %
-  //        point.point_reference.position() % point_morton_index_str %
-  //        node_morton_index_str)
-  //         .str()
-  //     };
-  //   }
-  // }
-
-  const auto cached_points_count = cached_points.size();
-
   const auto node_level_to_sample_from = required_morton_index_depth(
     _sampling_strategy, node_structure.level, root_node_structure);
   const auto requires_deeper_morton_indices =
@@ -417,78 +579,88 @@ TilingAlgorithmBase::tile_node(octree::NodeData&& node_data,
   const auto max_level = gsl::narrow<int32_t>(
     std::min(MAX_OCTREE_LEVELS - 1, node_structure.max_depth));
 
-  if (!requires_deeper_morton_indices) {
-    if (node_level_to_sample_from >= max_level) {
-      const auto all_points_for_this_node = octree::merge_node_data_unsorted(
-        std::move(node_data), std::move(cached_points));
-      tile_terminal_node(
-        all_points_for_this_node, node_structure, cached_points_count);
-      return {};
-    }
-
-    auto all_points_for_this_node = octree::merge_node_data_sorted(
+  const auto is_terminal_node = requires_deeper_morton_indices
+                                  ? (node_structure.level >= max_level)
+                                  : (node_level_to_sample_from >= max_level);
+  if (is_terminal_node) {
+    auto cached_points =
+      read_pnts_from_disk(node_structure,
+                          root_node_structure.bounds,
+                          _points_cache,
+                          persistence_for_partition(node_structure.partition));
+    const auto cached_points_count = cached_points.size();
+
+    const auto all_points_for_this_node = octree::merge_node_data_unsorted(
       std::move(node_data), std::move(cached_points));
-    return tile_internal_node(all_points_for_this_node,
-                              node_structure,
-                              root_node_structure,
-                              cached_points_count);
-  } else {
-    if (node_structure.level >= max_level) {
-      const auto all_points_for_this_node = octree::merge_node_data_unsorted(
-        std::move(node_data), std::move(cached_points));
-      tile_terminal_node(
-        all_points_for_this_node, node_structure, cached_points_count);
-      return {};
-    }
-
-    if (node_level_to_sample_from >= static_cast<int32_t>(MAX_OCTREE_LEVELS)) {
+    tile_terminal_node(
+      all_points_for_this_node, node_structure, cached_points_count);
+    return {};
+  }
 
-      if (global_config().is_journaling_enabled) {
-        journal_string(
-          (boost::format("Recalculating Morton indices for deep node %1%%2%") %
-           root_node_structure.name % node_structure.name)
-            .str());
-      }
+  const auto is_new_root_node =
+    requires_deeper_morton_indices &&
+    (node_level_to_sample_from >= static_cast<int32_t>(MAX_OCTREE_LEVELS));
+
+  // If we are so deep that we exceed the capacity of the MortonIndex, we have
+  // to index our points again with the current node as new root node. We also
+  // have to carry the information that we have a new root over to the children
+  // so that the paths of the nodes are correct.
+
+  // Fun fact: We don't have to adjust the loaded indices because if we ever
+  // get to a node this deep again, the indices have been calculated with the
+  // new root the last time also, so everything is as it should be
+  auto root_node_for_sampling = root_node_structure;
+  if (is_new_root_node) {
+    if (global_config().is_journaling_enabled) {
+      journal_string(
+        (boost::format("Recalculating Morton indices for deep node %1%%2%") %
+         root_node_structure.name % node_structure.name)
+          .str());
+    }
 
-      // If we are so deep that we exceed the capacity of the MortonIndex,
-      // we have to index our points again with the current node as new root
-      // node. We also have to carry the information that we have a new root
-      // over to the children so that the paths of the nodes are correct.
-
-      // Fun fact: We don't have to adjust the loaded indices because if we
-      // ever get to a node this deep again, the indices have been
-      // calculated with the new root the last time also, so everything is
-      // as it should be
-      auto all_points_for_this_node = octree::merge_node_data_unsorted(
-        std::move(node_data), std::move(cached_points));
-
-      // Set this node as the new root node
-      auto new_root_node = node_structure;
-      new_root_node.max_depth = node_structure.max_depth - node_structure.level;
-
-      // Compute new indices based upon this node as root node
-      for (auto& indexed_point : all_points_for_this_node) {
-        indexed_point.morton_index = calculate_morton_index<MAX_OCTREE_LEVELS>(
-          indexed_point.point_reference.position(), new_root_node.bounds);
-      }
+    root_node_for_sampling = node_structure;
+    root_node_for_sampling.max_depth =
+      node_structure.max_depth - node_structure.level;
+  }
 
-      // Make sure everything is sorted again
-      std::sort(all_points_for_this_node.begin(),
-                all_points_for_this_node.end());
+  const auto index_relative_to_new_root = [&](octree::NodeData& points) {
+    if (!is_new_root_node)
+      return;
 
-      return tile_internal_node(all_points_for_this_node,
-                                node_structure,
-                                new_root_node,
-                                cached_points_count);
+    for (auto& indexed_point : points) {
+      indexed_point.morton_index = calculate_morton_index<MAX_OCTREE_LEVELS>(
+        indexed_point.point_reference.position(),
+        root_node_for_sampling.bounds);
     }
 
-    auto all_points_for_this_node = octree::merge_node_data_sorted(
-      std::move(node_data), std::move(cached_points));
-    return tile_internal_node(all_points_for_this_node,
-                              node_structure,
-                              root_node_structure,
-                              cached_points_count);
+    // Make sure everything is sorted again
+    std::sort(points.begin(), points.end());
+  };
+
+  if (const auto occupancy = _node_occupancies.find_occupancy(node_structure)) {
+    index_relative_to_new_root(node_data);
+    return tile_internal_node_incrementally(
+      node_data, node_structure, root_node_for_sampling, *occupancy);
   }
+
+  auto cached_points =
+    read_pnts_from_disk(node_structure,
+                        root_node_structure.bounds,
+                        _points_cache,
+                        persistence_for_partition(node_structure.partition));
+  const auto cached_points_count = cached_points.size();
+
+  auto all_points_for_this_node =
+    is_new_root_node ? octree::merge_node_data_unsorted(std::move(node_data),
+                                                        std::move(cached_points))
+                     : octree::merge_node_data_sorted(std::move(node_data),
+                                                      std::move(cached_points));
+  index_relative_to_new_root(all_points_for_this_node);
+
+  return tile_internal_node(all_points_for_this_node,
+                            node_structure,
+                            root_node_for_sampling,
+                            cached_points_count);
 }
 
 /**
@@ -503,61 +675,361 @@ TilingAlgorithmBase::do_tiling_for_node(
   const octree::NodeStructure& root_node_structure,
   tf::Subflow& subflow)
 {
+  if (can_sample_in_parallel(
+        node_data.size(), node_structure, root_node_structure)) {
+    tile_node_in_parallel(
+      std::move(node_data), node_structure, root_node_structure, subflow);
+    return;
+  }
+
+  const auto points_count = node_data.size();
+  const auto tiling_start = std::chrono::steady_clock::now();
   auto child_nodes = tile_node(
     std::move(node_data), node_structure, root_node_structure, subflow);
+  _task_granularity.record_node_duration(
+    points_count, std::chrono::steady_clock::now() - tiling_start);
+
+  tile_child_nodes(std::move(child_nodes), subflow);
+}
 
+/**
+ * Create the execution graph for tiling the given child nodes
+ */
+void
+TilingAlgorithmBase::tile_child_nodes(std::vector<NodeTilingData> child_nodes,
+                                      tf::Subflow& subflow)
+{
   if (child_nodes.empty())
     return;
 
-  // Create the execution graph for the child nodes. Only nodes with more than
-  // MIN_POINTS_FOR_ASYNC_PROCESSING points are processed as asynchronous tasks,
-  // the other nodes are processed synchronously right here. We sort the nodes
-  // descending by point count so that the async tasks are created first, which
-  // means that they can start processing while this method processes the
-  // synchronous nodes
+  // Nodes that are worth their own task (see TaskGranularity) are processed as
+  // asynchronous tasks, which are dispatched across the whole batch by their
+  // remaining cost. Smaller siblings are grouped into tasks of at least the
+  // minimum task size, and only the last group that is too small for a task is
+  // processed synchronously right here. We sort the nodes descending by point
+  // count so that the async tasks are created first, which means that they can
+  // start processing while this method processes the synchronous nodes
   std::sort(std::begin(child_nodes),
             std::end(child_nodes),
             [](const NodeTilingData& l, const NodeTilingData& r) {
               return r.points.size() < l.points.size();
             });
 
-  const auto iter_to_first_sync_node = std::partition_point(
-    std::begin(child_nodes),
-    std::end(child_nodes),
-    [](const NodeTilingData& node) {
-      return node.points.size() >= MIN_POINTS_FOR_ASYNC_PROCESSING;
-    });
+  const auto min_points_per_task = _task_granularity.min_points_per_task();
+
+  std::vector<NodeTilingData> sync_nodes;
+  size_t sync_points_count = 0;
+  double sync_nodes_cost = 0;
+  for (auto& child_node : child_nodes) {
+    const auto child_points_count = child_node.points.size();
+    const auto cost = estimate_subtree_cost(
+      child_points_count, child_node.node.level, child_node.node.max_depth);
+
+    // Create async tasks for tiling child nodes that have many points
+    if (_task_granularity.should_spawn_task(child_points_count,
+                                            _pending_subtrees.size())) {
+      const auto child_task_name =
+        (boost::format("%1% [%2%]") % child_node.node.name % child_points_count)
+          .str();
+      schedule_subtree(
+        cost,
+        [this, _child_node = std::move(child_node)](
+          tf::Subflow& sub_subflow) mutable {
+          do_tiling_for_node(std::move(_child_node.points),
+                             _child_node.node,
+                             _child_node.root_node,
+                             sub_subflow);
+        },
+        subflow,
+        child_task_name);
+      continue;
+    }
+
+    sync_points_count += child_points_count;
+    sync_nodes_cost += cost;
+    sync_nodes.push_back(std::move(child_node));
+    if (sync_points_count < min_points_per_task ||
+        !_task_granularity.should_spawn_task(sync_points_count,
+                                             _pending_subtrees.size()))
+      continue;
+
+    // Create a single async task for a group of sibling nodes with few points
+    const auto group_task_name =
+      (boost::format("%1% (+%2% siblings) [%3%]") % sync_nodes.front().node.name %
+       (sync_nodes.size() - 1) % sync_points_count)
+        .str();
+    schedule_subtree(
+      sync_nodes_cost,
+      [this, _nodes = std::move(sync_nodes)](tf::Subflow& sub_subflow) mutable {
+        for (auto& node : _nodes) {
+          do_tiling_for_node(
+            std::move(node.points), node.node, node.root_node, sub_subflow);
+        }
+      },
+      subflow,
+      group_task_name);
+    sync_nodes.clear();
+    sync_points_count = 0;
+    sync_nodes_cost = 0;
+  }
+
+  // Do tiling for the remaining child nodes that have few points
+  for (auto& child_node : sync_nodes) {
+    do_tiling_for_node(std::move(child_node.points),
+                       child_node.node,
+                       child_node.root_node,
+                       subflow);
+  }
+}
+
+/**
+ * Adds a task for tiling a subtree with the given estimated cost to 'subflow'.
+ * The task runs the most expensive subtree that is pending at the time it
+ * starts (see SubtreeQueue), so the task name only tells which subtree caused
+ * its creation
+ */
+tf::Task
+TilingAlgorithmBase::schedule_subtree(double cost,
+                                      SubtreeQueue::Job job,
+                                      tf::Subflow& subflow,
+                                      const std::string& task_name)
+{
+  _pending_subtrees.push(cost, std::move(job));
+  // The dispatch latency for TaskGranularity is the time between creating the
+  // task and the start of the task. The time that a subtree waits in
+  // '_pending_subtrees' also includes the time that other tasks run more
+  // expensive subtrees, which is no overhead of the task
+  return subflow
+    .emplace([this, created_time = std::chrono::steady_clock::now()](tf::Subflow& job_subflow) {
+      _task_granularity.record_dispatch_latency(std::chrono::steady_clock::now() - created_time);
+      auto most_expensive_job = _pending_subtrees.pop_most_expensive();
+      most_expensive_job(job_subflow);
+    })
+    .name(task_name);
+}
+
+/**
+ * Can the given node be sampled by multiple tasks? This is the case for
+ * interior nodes with many points that are sampled with a strategy that takes
+ * one point per grid cell. Terminal nodes and nodes that require Morton indices
+ * relative to a new root node are always tiled sequentially
+ */
+bool
+TilingAlgorithmBase::can_sample_in_parallel(
+  size_t points_count,
+  const octree::NodeStructure& node_structure,
+  const octree::NodeStructure& root_node_structure) const
+{
+  if (points_count < MIN_POINTS_FOR_PARALLEL_SAMPLING ||
+      !samples_one_point_per_grid_cell(_sampling_strategy))
+    return false;
+
+  const auto node_level_to_sample_from = required_morton_index_depth(
+    _sampling_strategy, node_structure.level, root_node_structure);
+  const auto max_level = gsl::narrow<int32_t>(
+    std::min(MAX_OCTREE_LEVELS - 1, node_structure.max_depth));
+  return node_level_to_sample_from < max_level;
+}
+
+namespace {
+/**
+ * State of an interior node that is sampled by multiple tasks. Each task
+ * samples one chunk of the sorted points of the node, the chunks end at grid
+ * cell boundaries so that they are independent of each other
+ */
+struct ParallelNodeSampling
+{
+  octree::NodeData points;
+  octree::NodeStructure node;
+  octree::NodeStructure root_node;
+  // Occupancy of the node if it has been sampled before, nullptr otherwise
+  std::shared_ptr<NodeOccupancy> occupancy;
+  size_t previously_taken_points_count = 0;
+  SamplingBehaviour sampling_behaviour =
+    SamplingBehaviour::TakeAllWhenCountBelowMaxPoints;
+  int32_t cell_level = -1;
+  std::vector<std::pair<octree::NodeData::iterator, octree::NodeData::iterator>>
+    chunks;
+  // Partition point of each chunk after sampling
+  std::vector<octree::NodeData::iterator> selected_ends;
+
+  /**
+   * Moves the selected points of all chunks to the front of 'points', followed
+   * by the remaining points of all chunks. Since the chunks are consecutive and
+   * keep both the selected and the remaining points sorted, this gives the same
+   * result as sampling all points at once. Returns the end of the selected
+   * points
+   */
+  octree::NodeData::iterator join_chunks()
+  {
+    octree::NodeData joined;
+    joined.reserve(points.size());
+    for (size_t idx = 0; idx < chunks.size(); ++idx) {
+      joined.insert(std::end(joined), chunks[idx].first, selected_ends[idx]);
+    }
+    const auto num_selected_points = joined.size();
+    for (size_t idx = 0; idx < chunks.size(); ++idx) {
+      joined.insert(std::end(joined), selected_ends[idx], chunks[idx].second);
+    }
 
-  // Create async tasks for tiling child nodes that have many points
-  std::for_each(std::begin(child_nodes),
-                iter_to_first_sync_node,
-                [this, &subflow](NodeTilingData& child_node) {
-                  const auto child_node_name = child_node.node.name;
-                  const auto child_points_count = child_node.points.size();
-                  const auto child_task_name =
-                    (boost::format("%1% [%2%]") % child_node_name %
-                     child_points_count)
-                      .str();
-                  subflow
-                    .emplace([this, _child_node = std::move(child_node)](
-                               tf::Subflow& sub_subflow) mutable {
-                      do_tiling_for_node(std::move(_child_node.points),
-                                         _child_node.node,
-                                         _child_node.root_node,
-                                         sub_subflow);
-                    })
-                    .name(child_task_name);
-                });
-
-  // Do tiling for child nodes that have few points
-  std::for_each(iter_to_first_sync_node,
-                std::end(child_nodes),
-                [this, &subflow](NodeTilingData& child_node) {
-                  do_tiling_for_node(std::move(child_node.points),
-                                     child_node.node,
-                                     child_node.root_node,
-                                     subflow);
-                });
+    points = std::move(joined);
+    chunks.clear();
+    selected_ends.clear();
+    return std::begin(points) + num_selected_points;
+  }
+};
+} // namespace
+
+/**
+ * Tile an interior node with many points by sampling disjoint ranges of its
+ * grid cells in parallel. The sampling tasks and the task that persists the
+ * selected points and tiles the child nodes are added to 'subflow', so the
+ * child nodes are processed as soon as the sampling of this node is done
+ */
+void
+TilingAlgorithmBase::tile_node_in_parallel(
+  octree::NodeData&& node_data,
+  const octree::NodeStructure& node_structure,
+  const octree::NodeStructure& root_node_structure,
+  tf::Subflow& subflow)
+{
+  auto sampling = std::make_shared<ParallelNodeSampling>();
+  sampling->node = node_structure;
+  sampling->root_node = root_node_structure;
+  sampling->occupancy = _node_occupancies.find_occupancy(node_structure);
+
+  if (sampling->occupancy) {
+    sampling->points = std::move(node_data);
+  } else {
+    auto cached_points =
+      read_pnts_from_disk(node_structure,
+                          root_node_structure.bounds,
+                          _points_cache,
+                          persistence_for_partition(node_structure.partition));
+    sampling->previously_taken_points_count = cached_points.size();
+    sampling->points = octree::merge_node_data_sorted(std::move(node_data),
+                                                      std::move(cached_points));
+    sampling->sampling_behaviour =
+      (sampling->previously_taken_points_count > 0)
+        ? SamplingBehaviour::AlwaysAdhereToMinSpacing
+        : SamplingBehaviour::TakeAllWhenCountBelowMaxPoints;
+
+    // If all points are taken, there is nothing to sample
+    if (sampling->sampling_behaviour ==
+          SamplingBehaviour::TakeAllWhenCountBelowMaxPoints &&
+        sampling->points.size() <= _meta_parameters.max_points_per_node) {
+      tile_child_nodes(complete_internal_node(sampling->points,
+                                              std::end(sampling->points),
+                                              node_structure,
+                                              root_node_structure,
+                                              sampling->previously_taken_points_count,
+                                              sampling->sampling_behaviour),
+                       subflow);
+      return;
+    }
+  }
+
+  const auto node_level_relative_to_root =
+    node_structure.level - (root_node_structure.level + 1);
+  sampling->cell_level =
+    sampling_grid_cell_level(_sampling_strategy,
+                             node_structure.morton_index,
+                             node_level_relative_to_root,
+                             root_node_structure.bounds,
+                             root_node_structure.max_spacing);
+
+  const auto max_chunks =
+    std::min<size_t>(total_thread_count(_meta_parameters.thread_count),
+                     sampling->points.size() / MIN_POINTS_PER_SAMPLING_CHUNK);
+  sampling->chunks = split_at_grid_cells(std::begin(sampling->points),
+                                         std::end(sampling->points),
+                                         sampling->cell_level,
+                                         max_chunks);
+  sampling->selected_ends.resize(sampling->chunks.size());
+
+  auto complete_task =
+    subflow
+      .emplace([this, sampling](tf::Subflow& child_subflow) {
+        const auto partition_point = sampling->join_chunks();
+
+        if (!sampling->occupancy) {
+          tile_child_nodes(
+            complete_internal_node(sampling->points,
+                                   partition_point,
+                                   sampling->node,
+                                   sampling->root_node,
+                                   sampling->previously_taken_points_count,
+                                   sampling->sampling_behaviour),
+            child_subflow);
+          return;
+        }
+
+        // The selected points of all chunks are sorted, so the newly occupied
+        // cells can be merged into the occupancy at once
+        auto& occupied_cells = sampling->occupancy->occupied_cells;
+        const auto newly_occupied_cells = occupied_grid_cells(
+          std::begin(sampling->points), partition_point, sampling->cell_level);
+        const auto previously_occupied_count = occupied_cells.size();
+        occupied_cells.insert(std::end(occupied_cells),
+                              std::begin(newly_occupied_cells),
+                              std::end(newly_occupied_cells));
+        std::inplace_merge(std::begin(occupied_cells),
+                           std::begin(occupied_cells) + previously_occupied_count,
+                           std::end(occupied_cells));
+
+        tile_child_nodes(complete_internal_node_incrementally(sampling->points,
+                                                              partition_point,
+                                                              sampling->node,
+                                                              sampling->root_node),
+                         child_subflow);
+      })
+      .name(concat(node_structure.name, " [", sampling->points.size(), "]"));
+
+  for (size_t chunk_idx = 0; chunk_idx < sampling->chunks.size(); ++chunk_idx) {
+    auto sample_task =
+      subflow
+        .emplace([this, sampling, chunk_idx, node_level_relative_to_root]() {
+          const auto [chunk_begin, chunk_end] = sampling->chunks[chunk_idx];
+          const auto& node = sampling->node;
+          const auto& root_node = sampling->root_node;
+
+          if (!sampling->occupancy) {
+            sampling->selected_ends[chunk_idx] =
+              filter_points_for_octree_node(chunk_begin,
+                                            chunk_end,
+                                            node.morton_index,
+                                            node_level_relative_to_root,
+                                            root_node.bounds,
+                                            root_node.max_spacing,
+                                            SamplingBehaviour::AlwaysAdhereToMinSpacing,
+                                            _sampling_strategy);
+            return;
+          }
+
+          // Each chunk is only tested against the occupied cells in its own
+          // range, the occupancy of the node is updated once all chunks are done
+          const auto& occupied_cells = sampling->occupancy->occupied_cells;
+          NodeOccupancy chunk_occupancy;
+          chunk_occupancy.occupied_cells.assign(
+            std::lower_bound(std::begin(occupied_cells),
+                             std::end(occupied_cells),
+                             grid_cell_of(*chunk_begin, sampling->cell_level)),
+            std::upper_bound(std::begin(occupied_cells),
+                             std::end(occupied_cells),
+                             grid_cell_of(*(chunk_end - 1), sampling->cell_level)));
+          sampling->selected_ends[chunk_idx] =
+            sample_points_incrementally(_sampling_strategy,
+                                        chunk_begin,
+                                        chunk_end,
+                                        node.morton_index,
+                                        node_level_relative_to_root,
+                                        root_node.bounds,
+                                        root_node.max_spacing,
+                                        chunk_occupancy);
+        })
+        .name(concat(node_structure.name, "_sample_", chunk_idx));
+    sample_task.precede(complete_task);
+  }
 }
 
 #pragma endregion
@@ -584,6 +1056,7 @@ TilingAlgorithmV1::build_execution_graph(
   _root_node_points.clear();
   _root_node_points.resize(points.size());
   _points_cache.clear();
+  _task_granularity.set_concurrency(num_indexing_threads);
 
   auto indexing_tasks = parallel::transform(
     std::begin(points),
@@ -597,11 +1070,25 @@ TilingAlgorithmV1::build_execution_graph(
     num_indexing_threads,
     "calc_morton_indices");
 
-  auto sort_task =
-    tf.emplace([this]() {
-        std::sort(_root_node_points.begin(), _root_node_points.end());
+  auto sort_tasks = parallel::sort(std::begin(_root_node_points),
+                                   std::end(_root_node_points),
+                                   tf,
+                                   num_indexing_threads,
+                                   "sort");
+
+  // Normals are estimated on the sorted points, because the neighbourhood
+  // search relies on the Morton order
+  auto normals_task =
+    tf.emplace([this, num_indexing_threads](tf::Subflow& subflow) {
+        if (!_meta_parameters.estimate_normals)
+          return;
+        estimate_normals_parallel(
+          { std::begin(_root_node_points), std::end(_root_node_points) },
+          {},
+          num_indexing_threads,
+          subflow);
       })
-      .name("sort");
+      .name("estimate_normals");
 
   octree::NodeStructure root_node;
   root_node.bounds = bounds;
@@ -619,8 +1106,9 @@ TilingAlgorithmV1::build_execution_graph(
       })
       .name(concat(root_node.name, " [", _root_node_points.size(), "]"));
 
-  indexing_tasks.second.precede(sort_task);
-  sort_task.precede(process_task);
+  indexing_tasks.second.precede(sort_tasks.first);
+  sort_tasks.second.precede(normals_task);
+  normals_task.precede(process_task);
 
   return { indexing_tasks.first, process_task };
 }
@@ -659,6 +1147,7 @@ TilingAlgorithmV2::build_execution_graph(
   _root_node_points.clear();
   _root_node_points.resize(points.size());
   _points_cache.clear();
+  _task_granularity.set_concurrency(num_indexing_threads);
   _indexed_points_ranges.clear();
   _indexed_points_ranges.resize(num_indexing_threads);
 
@@ -681,6 +1170,13 @@ TilingAlgorithmV2::build_execution_graph(
       index_and_sort_points({ points_begin, points_end },
                             { indexed_points_begin, indexed_points_end },
                             bounds);
+      // Each task only sees its own chunk of the batch, so the neighbourhoods
+      // for the normals are restricted to this chunk
+      if (_meta_parameters.estimate_normals) {
+        estimate_normals({ indexed_points_begin, indexed_points_end },
+                         { indexed_points_begin, indexed_points_end },
+                         {});
+      }
       task_output = split_indexed_points_into_subranges(
         { indexed_points_begin, indexed_points_end }, num_indexing_threads);
     },
@@ -711,7 +1207,18 @@ TilingAlgorithmV2::build_execution_graph(
           parent = parent.parent();
         }
 
-        new_tiling_tasks.push_back(subflow.emplace(
+        const auto num_points = std::accumulate(
+          std::begin(*node),
+          std::end(*node),
+          size_t{ 0 },
+          [](auto accum, const auto& range) { return accum + range.size(); });
+        const auto cost =
+          estimate_subtree_cost(num_points,
+                                static_cast<int32_t>(node.index().levels()) - 1,
+                                _meta_parameters.max_depth);
+
+        new_tiling_tasks.push_back(schedule_subtree(
+          cost,
           [this, bounds, index = node.index(), _data = std::move(*node)](
             tf::Subflow& subsubflow) {
             auto process_data = prepare_range_for_tiling(_data, index, bounds);
@@ -720,7 +1227,9 @@ TilingAlgorithmV2::build_execution_graph(
                                process_data.node,
                                process_data.root_node,
                                subsubflow);
-          }));
+          },
+          subflow,
+          OctreeNodeIndex64::to_string(node.index())));
       }
 
       const auto reconstruct_task = subflow.emplace(
@@ -1121,20 +1630,7 @@ TilingAlgorithmV2::reconstruct_single_node(const OctreeNodeIndex64& node_index,
   // OctreeNodeIndex64::to_string(node_index));
 
   // 1) Read data of direct child nodes
-  PointBuffer data;
-  for (uint8_t octant = 0; octant < 8; ++octant) {
-    const auto child_index = node_index.child(octant);
-    const auto node_name =
-      concat("r", OctreeNodeIndex64::to_string(child_index));
-
-    PointBuffer tmp;
-    _persistence.retrieve_points(node_name, tmp);
-
-    if (tmp.empty())
-      continue;
-
-    data.append_buffer(tmp);
-  }
+  auto data = read_child_nodes(node_index, _persistence);
 
   // 2) Calculate morton indices for child data
   std::vector<IndexedPoint64> indexed_points;
@@ -1145,6 +1641,11 @@ TilingAlgorithmV2::reconstruct_single_node(const OctreeNodeIndex64& node_index,
                                   root_bounds,
                                   OutlierPointsBehaviour::ClampToBounds);
 
+  // The child nodes might be stored in a different order (see PointOrder)
+  if (!std::is_sorted(std::begin(indexed_points), std::end(indexed_points))) {
+    std::sort(std::begin(indexed_points), std::end(indexed_points));
+  }
+
   // 3) Data is sorted, so we can sample directly
   const auto morton_index_for_node = node_index.to_static_morton_index();
   const auto selected_points_end =
@@ -1164,7 +1665,8 @@ TilingAlgorithmV2::reconstruct_single_node(const OctreeNodeIndex64& node_index,
   // TOOD For 3D Tiles, reconstructed nodes should have their children be
   // 'REPLACE' instead of 'ADD'
 
-  _persistence.persist_points(
+  persist_node_points(
+    _persistence,
     member_iterator(std::begin(indexed_points),
                     &IndexedPoint64::point_reference),
     member_iterator(selected_points_end, &IndexedPoint64::point_reference),
@@ -1196,13 +1698,27 @@ TilingAlgorithmV3::TilingAlgorithmV3(SamplingStrategy& sampling_strategy,
                                      ProgressReporter* progress_reporter,
                                      PointsPersistence& persistence,
                                      TilerMetaParameters meta_parameters,
-                                     const fs::path& output_dir)
+                                     const fs::path& output_dir,
+                                     std::optional<PartitionedOutput> partitioned_output)
   : TilingAlgorithmBase(sampling_strategy,
                         progress_reporter,
                         persistence,
                         meta_parameters)
   , _output_dir(output_dir)
-{}
+{
+  if (partitioned_output) {
+    if (partitioned_output->persistences.size() !=
+        partitioned_output->partitioning.size()) {
+      throw std::invalid_argument{
+        "PartitionedOutput requires one persistence per classification group"
+      };
+    }
+    _partitioning = std::move(partitioned_output->partitioning);
+    _partition_persistences = std::move(partitioned_output->persistences);
+  }
+  _points_per_partition.resize(num_partitions(), 0);
+  _updated_start_nodes.resize(num_partitions());
+}
 
 std::pair<tf::Task, tf::Task>
 TilingAlgorithmV3::build_execution_graph(
@@ -1224,8 +1740,12 @@ TilingAlgorithmV3::build_execution_graph(
   _root_node_points.clear();
   _root_node_points.resize(points.size());
   _points_cache.clear();
+  _task_granularity.set_concurrency(num_indexing_threads);
   _indexed_points_ranges.clear();
-  _indexed_points_ranges.resize(num_indexing_threads);
+  _indexed_points_ranges.resize(num_partitions());
+  for (auto& ranges_of_partition : _indexed_points_ranges) {
+    ranges_of_partition.resize(num_indexing_threads);
+  }
 
   if (!_level_of_start_nodes.has_value()) {
     return build_execution_graph_for_first_iteration(
@@ -1239,12 +1759,80 @@ TilingAlgorithmV3::build_execution_graph(
 void
 TilingAlgorithmV3::finalize(const AABB& bounds)
 {
+  TilingAlgorithmBase::finalize(bounds);
+
   if (!_level_of_start_nodes.has_value()) {
     // build_execution_graph_for_first_iteration was never run, i.e. we never
     // processed any points
     return;
   }
-  reconstruct_left_out_nodes(bounds);
+  for (uint32_t partition = 0; partition < num_partitions(); ++partition) {
+    reconstruct_left_out_nodes(bounds, partition);
+  }
+}
+
+std::vector<size_t>
+TilingAlgorithmV3::points_per_partition() const
+{
+  if (!_partitioning)
+    return {};
+  return _points_per_partition;
+}
+
+uint32_t
+TilingAlgorithmV3::reconstructed_levels() const
+{
+  return static_cast<uint32_t>(_level_of_start_nodes.value_or(0));
+}
+
+void
+TilingAlgorithmV3::reconstruct_updated_nodes(const AABB& bounds)
+{
+  if (!_level_of_start_nodes.has_value())
+    return;
+
+  for (uint32_t partition = 0; partition < num_partitions(); ++partition) {
+    reconstruct_ancestors(_updated_start_nodes[partition], bounds, partition);
+    _updated_start_nodes[partition].clear();
+  }
+}
+
+void
+TilingAlgorithmV3::set_level_of_start_nodes(size_t level)
+{
+  if (level == 0) {
+    throw std::invalid_argument{ "The level of the start nodes must be at least 1" };
+  }
+  _level_of_start_nodes = level;
+}
+
+size_t
+TilingAlgorithmV3::num_partitions() const
+{
+  return _partitioning ? _partitioning->size() : 1;
+}
+
+std::vector<util::Range<TilingAlgorithmV3::IndexedPointsIter>>
+TilingAlgorithmV3::partition_indexed_points(
+  util::Range<IndexedPointsIter> indexed_points) const
+{
+  if (!_partitioning)
+    return { indexed_points };
+  return _partitioning->partition(indexed_points);
+}
+
+std::string
+TilingAlgorithmV3::start_node_task_name(const OctreeNodeIndex64& node_index,
+                                        uint32_t partition,
+                                        size_t num_points) const
+{
+  const auto node_name =
+    (boost::format("r%1% [%2%]") % OctreeNodeIndex64::to_string(node_index) %
+     num_points)
+      .str();
+  if (!_partitioning)
+    return node_name;
+  return concat(_partitioning->groups()[partition].name, "/", node_name);
 }
 
 std::pair<tf::Task, tf::Task>
@@ -1284,46 +1872,87 @@ TilingAlgorithmV3::build_execution_graph_for_first_iteration(
     num_indexing_threads,
     "index_points");
 
+  auto sort_task =
+    tf.emplace([this]() {
+        std::sort(std::begin(_root_node_points), std::end(_root_node_points));
+      })
+      .name("sort");
+
+  auto normals_task =
+    tf.emplace([this, num_indexing_threads](tf::Subflow& subflow) {
+        if (!_meta_parameters.estimate_normals)
+          return;
+        estimate_normals_parallel(
+          { std::begin(_root_node_points), std::end(_root_node_points) },
+          {},
+          num_indexing_threads,
+          subflow);
+      })
+      .name("estimate_normals");
+
   auto sort_estimate_get_start_node =
     tf.emplace([this, bounds, num_indexing_threads](tf::Subflow& subflow) {
         util::Range<IndexedPointsIter> indexed_points{
           std::begin(_root_node_points), std::end(_root_node_points)
         };
-        indexed_points.sort();
 
+        // Partitioning keeps the Morton order within each partition, so each
+        // partition can be split into start nodes independently
+        const auto partitions = partition_indexed_points(indexed_points);
+
+        // All octrees share the same start node level, which we estimate from
+        // the largest partition
+        const auto largest_partition = std::max_element(
+          std::begin(partitions),
+          std::end(partitions),
+          [](const auto& l, const auto& r) { return l.size() < r.size(); });
         _level_of_start_nodes = estimate_start_node_level_in_octree(
-          indexed_points, num_indexing_threads);
+          *largest_partition, num_indexing_threads);
 
         if (global_config().is_journaling_enabled) {
           journal_string(
             concat("Level of start nodes: ", *_level_of_start_nodes));
         }
 
-        auto start_nodes = split_indexed_points_into_subranges(
-          indexed_points, *_level_of_start_nodes);
+        for (uint32_t partition = 0; partition < partitions.size();
+             ++partition) {
+          if (partitions[partition].size() == 0)
+            continue;
 
-        if (global_config().is_journaling_enabled) {
-          journal_start_nodes(start_nodes.to_graphviz([](const auto& node) {
-            std::stringstream ss;
-            ss << OctreeNodeIndex64::to_string(node.index()) << " - "
-               << node->size();
-            return ss.str();
-          }));
-        }
+          _points_per_partition[partition] += partitions[partition].size();
 
-        for (auto node : start_nodes.traverse_level_order()) {
-          if (node->size() == 0)
-            continue;
+          auto start_nodes = split_indexed_points_into_subranges(
+            partitions[partition], *_level_of_start_nodes);
+
+          if (global_config().is_journaling_enabled) {
+            journal_start_nodes(start_nodes.to_graphviz([](const auto& node) {
+              std::stringstream ss;
+              ss << OctreeNodeIndex64::to_string(node.index()) << " - "
+                 << node->size();
+              return ss.str();
+            }));
+          }
 
-          const auto child_task_name =
-            (boost::format("r%1% [%2%]") %
-             OctreeNodeIndex64::to_string(node.index()) % node->size())
-              .str();
+          for (auto node : start_nodes.traverse_level_order()) {
+            if (node->size() == 0)
+              continue;
 
-          subflow
-            .emplace(
-              [this, bounds, index = node.index(), _data = std::move(*node)](
-                tf::Subflow& subsubflow) {
+            _updated_start_nodes[partition].insert(node.index());
+
+            const auto child_task_name =
+              start_node_task_name(node.index(), partition, node->size());
+            const auto cost =
+              estimate_subtree_cost(node->size(),
+                                    static_cast<int32_t>(node.index().levels()) - 1,
+                                    _meta_parameters.max_depth);
+
+            schedule_subtree(
+              cost,
+              [this,
+               bounds,
+               partition,
+               index = node.index(),
+               _data = std::move(*node)](tf::Subflow& subsubflow) {
                 octree::NodeStructure root_node;
                 root_node.bounds = bounds;
                 root_node.level = -1;
@@ -1331,6 +1960,7 @@ TilingAlgorithmV3::build_execution_graph_for_first_iteration(
                 root_node.max_spacing = _meta_parameters.spacing_at_root;
                 root_node.morton_index = {};
                 root_node.name = "r";
+                root_node.partition = partition;
 
                 octree::NodeStructure this_node;
                 this_node.bounds = get_bounds_from_node_index(index, bounds);
@@ -1341,20 +1971,25 @@ TilingAlgorithmV3::build_execution_graph_for_first_iteration(
                 this_node.morton_index = index.to_static_morton_index();
                 this_node.name =
                   std::string{ "r" } + OctreeNodeIndex64::to_string(index);
+                this_node.partition = partition;
 
                 do_tiling_for_node({ std::begin(_data), std::end(_data) },
                                    this_node,
                                    root_node,
                                    subsubflow);
-              })
-            .name(child_task_name);
+              },
+              subflow,
+              child_task_name);
+          }
         }
       })
       .name("sort_and_get_start_nodes");
 
   for (auto& scatter_subtask : index_task.scattered_tasks) {
-    scatter_subtask.precede(sort_estimate_get_start_node);
+    scatter_subtask.precede(sort_task);
   }
+  sort_task.precede(normals_task);
+  normals_task.precede(sort_estimate_get_start_node);
 
   return { index_task.begin_task, sort_estimate_get_start_node };
 }
@@ -1380,13 +2015,25 @@ TilingAlgorithmV3::build_execution_graph_for_later_iterations(
         std::begin(_root_node_points) + point_data_offset;
       const auto indexed_points_end =
         indexed_points_begin + std::distance(points_begin, points_end);
-      auto& task_output = _indexed_points_ranges[task_index];
 
       index_and_sort_points({ points_begin, points_end },
                             { indexed_points_begin, indexed_points_end },
                             bounds);
-      task_output = split_indexed_points_into_subranges(
-        { indexed_points_begin, indexed_points_end }, *_level_of_start_nodes);
+      // Each task only sees its own chunk of the batch, so the neighbourhoods
+      // for the normals are restricted to this chunk
+      if (_meta_parameters.estimate_normals) {
+        estimate_normals({ indexed_points_begin, indexed_points_end },
+                         { indexed_points_begin, indexed_points_end },
+                         {});
+      }
+
+      const auto partitions =
+        partition_indexed_points({ indexed_points_begin, indexed_points_end });
+      for (size_t partition = 0; partition < partitions.size(); ++partition) {
+        _indexed_points_ranges[partition][task_index] =
+          split_indexed_points_into_subranges(partitions[partition],
+                                              *_level_of_start_nodes);
+      }
     },
     tf,
     num_indexing_threads,
@@ -1394,53 +2041,66 @@ TilingAlgorithmV3::build_execution_graph_for_later_iterations(
 
   auto transpose_task =
     tf.emplace([this, bounds](tf::Subflow& subflow) {
-        auto ranges_per_node =
-          merge_selected_start_nodes(_indexed_points_ranges);
-
-        if (global_config().is_journaling_enabled) {
-          journal_start_nodes(ranges_per_node.to_graphviz([](const auto& node) {
-            std::stringstream ss;
-            ss << OctreeNodeIndex64::to_string(node.index()) << " - "
-               << std::accumulate(std::begin(*node),
-                                  std::end(*node),
-                                  size_t{ 0 },
-                                  [](auto accum, const auto& range) {
-                                    return accum + range.size();
-                                  });
-            return ss.str();
-          }));
-        }
+        for (uint32_t partition = 0; partition < num_partitions();
+             ++partition) {
+          auto ranges_per_node =
+            merge_selected_start_nodes(_indexed_points_ranges[partition]);
+
+          if (global_config().is_journaling_enabled) {
+            journal_start_nodes(
+              ranges_per_node.to_graphviz([](const auto& node) {
+                std::stringstream ss;
+                ss << OctreeNodeIndex64::to_string(node.index()) << " - "
+                   << std::accumulate(std::begin(*node),
+                                      std::end(*node),
+                                      size_t{ 0 },
+                                      [](auto accum, const auto& range) {
+                                        return accum + range.size();
+                                      });
+                return ss.str();
+              }));
+          }
 
-        // ranges_per_node is an Octree where some of the nodes contain the
-        // starting data for tiling
+          // ranges_per_node is an Octree where some of the nodes contain the
+          // starting data for tiling
 
-        for (auto node : ranges_per_node.traverse_level_order()) {
-          if (node->empty())
-            continue;
+          for (auto node : ranges_per_node.traverse_level_order()) {
+            if (node->empty())
+              continue;
 
-          const auto num_points = std::accumulate(
-            std::begin(*node),
-            std::end(*node),
-            size_t{ 0 },
-            [](auto accum, const auto& range) { return accum + range.size(); });
-          const auto child_task_name =
-            (boost::format("r%1% [%2%]") %
-             OctreeNodeIndex64::to_string(node.index()) % num_points)
-              .str();
-
-          subflow
-            .emplace(
-              [this, bounds, index = node.index(), _data = std::move(*node)](
-                tf::Subflow& subsubflow) {
+            const auto num_points = std::accumulate(
+              std::begin(*node),
+              std::end(*node),
+              size_t{ 0 },
+              [](auto accum, const auto& range) { return accum + range.size(); });
+            _points_per_partition[partition] += num_points;
+            _updated_start_nodes[partition].insert(node.index());
+
+            const auto child_task_name =
+              start_node_task_name(node.index(), partition, num_points);
+            const auto cost =
+              estimate_subtree_cost(num_points,
+                                    static_cast<int32_t>(node.index().levels()) - 1,
+                                    _meta_parameters.max_depth);
+
+            schedule_subtree(
+              cost,
+              [this,
+               bounds,
+               partition,
+               index = node.index(),
+               _data = std::move(*node)](tf::Subflow& subsubflow) {
                 auto process_data =
-                  prepare_range_for_tiling(_data, index, bounds);
+                  prepare_range_for_tiling(_data, index, partition, bounds);
 
                 do_tiling_for_node(std::move(process_data.points),
                                    process_data.node,
                                    process_data.root_node,
                                    subsubflow);
-              })
-            .name(child_task_name);
+              },
+              subflow,
+              child_task_name);
+          }
         }
       })
       .name("merge_ranges_for_start_nodes");
@@ -1621,6 +2281,7 @@ NodeTilingData
 TilingAlgorithmV3::prepare_range_for_tiling(
   const std::vector<util::Range<IndexedPointsIter>>& start_node_data,
   OctreeNodeIndex64 node_index,
+  uint32_t partition,
   const AABB& bounds)
 {
   const auto start_node_point_count = std::accumulate(
@@ -1644,6 +2305,7 @@ TilingAlgorithmV3::prepare_range_for_tiling(
   root_node.max_spacing = _meta_parameters.spacing_at_root;
   root_node.morton_index = {};
   root_node.name = "r";
+  root_node.partition = partition;
 
   octree::NodeStructure this_node;
   this_node.bounds = get_bounds_from_node_index(node_index, bounds);
@@ -1654,28 +2316,19 @@ TilingAlgorithmV3::prepare_range_for_tiling(
   this_node.morton_index = node_index.to_static_morton_index();
   this_node.name =
     std::string{ "r" } + OctreeNodeIndex64::to_string(node_index);
+  this_node.partition = partition;
 
   return { std::move(merged_data), this_node, root_node };
 }
 
 void
 TilingAlgorithmV3::reconstruct_single_node(const OctreeNodeIndex64& node,
-                                           const AABB& root_bounds)
+                                           const AABB& root_bounds,
+                                           uint32_t partition)
 {
-  PointBuffer data;
-  for (uint8_t octant = 0; octant < 8; ++octant) {
-    const auto child_index = node.child(octant);
-    const auto node_name =
-      concat("r", OctreeNodeIndex64::to_string(child_index));
-
-    PointBuffer tmp;
-    _persistence.retrieve_points(node_name, tmp);
-
-    if (tmp.empty())
-      continue;
+  auto& persistence = persistence_for_partition(partition);
 
-    data.append_buffer(tmp);
-  }
+  auto data = read_child_nodes(node, persistence);
 
   // 2) Calculate morton indices for child data
   std::vector<IndexedPoint64> indexed_points;
@@ -1686,7 +2339,7 @@ TilingAlgorithmV3::reconstruct_single_node(const OctreeNodeIndex64& node,
                                   root_bounds,
                                   OutlierPointsBehaviour::ClampToBounds);
 
-  if (!_persistence.is_lossless()) {
+  if (!std::is_sorted(std::begin(indexed_points), std::end(indexed_points))) {
     std::sort(std::begin(indexed_points), std::end(indexed_points));
   }
 
@@ -1706,7 +2359,8 @@ TilingAlgorithmV3::reconstruct_single_node(const OctreeNodeIndex64& node,
   const auto node_bounds = get_bounds_from_node_index(node, root_bounds);
   const auto node_name = concat("r", OctreeNodeIndex64::to_string(node));
 
-  _persistence.persist_points(
+  persist_node_points(
+    persistence,
     member_iterator(std::begin(indexed_points),
                     &IndexedPoint64::point_reference),
     member_iterator(selected_points_end, &IndexedPoint64::point_reference),
@@ -1715,22 +2369,23 @@ TilingAlgorithmV3::reconstruct_single_node(const OctreeNodeIndex64& node,
 }
 
 void
-TilingAlgorithmV3::reconstruct_left_out_nodes(const AABB& root_bounds)
+TilingAlgorithmV3::reconstruct_left_out_nodes(const AABB& root_bounds,
+                                              uint32_t partition)
 {
   if (*_level_of_start_nodes == 0) {
     return;
   }
 
-  const auto node_exists = [this](const OctreeNodeIndex64& node_index) {
+  auto& persistence = persistence_for_partition(partition);
+  const auto node_exists = [&persistence](const OctreeNodeIndex64& node_index) {
     const auto node_name =
       concat("r", OctreeNodeIndex64::to_string(node_index));
-    return _persistence.node_exists(node_name);
+    return persistence.node_exists(node_name);
   };
 
-  // Collect all nodes that we left out and have to reconstruct. These are the
-  // direct and indirect parent nodes of the existing nodes at
-  // '_level_of_start_nodes'
-  std::unordered_set<OctreeNodeIndex64> nodes_to_reconstruct;
+  // The nodes that we left out are the direct and indirect parent nodes of the
+  // existing nodes at '_level_of_start_nodes'
+  std::unordered_set<OctreeNodeIndex64> start_nodes;
 
   const auto max_possible_nodes =
     static_cast<size_t>(std::pow(8, *_level_of_start_nodes));
@@ -1740,7 +2395,22 @@ TilingAlgorithmV3::reconstruct_left_out_nodes(const AABB& root_bounds)
     if (!node_exists(node_index))
       continue;
 
-    auto cur_node = node_index;
+    start_nodes.insert(node_index);
+  }
+
+  reconstruct_ancestors(start_nodes, root_bounds, partition);
+  _updated_start_nodes[partition].clear();
+}
+
+void
+TilingAlgorithmV3::reconstruct_ancestors(
+  const std::unordered_set<OctreeNodeIndex64>& start_nodes,
+  const AABB& root_bounds,
+  uint32_t partition)
+{
+  std::unordered_set<OctreeNodeIndex64> nodes_to_reconstruct;
+  for (const auto& start_node : start_nodes) {
+    auto cur_node = start_node;
     while (cur_node.levels() > 0) {
       cur_node = cur_node.parent();
       nodes_to_reconstruct.insert(cur_node);
@@ -1770,10 +2440,42 @@ TilingAlgorithmV3::reconstruct_left_out_nodes(const AABB& root_bounds)
 
   const auto t_start = std::chrono::high_resolution_clock::now();
 
-  for (auto& node : sorted_nodes_to_reconstruct) {
-    reconstruct_single_node(node, root_bounds);
+  // Nodes on the same level only read from their own children, so they are
+  // independent of each other and can be reconstructed in parallel. Each level
+  // starts once the deeper level is complete. There are usually fewer nodes on
+  // a level than threads, so every node gets its own task
+  tf::Taskflow reconstruct_taskflow;
+  std::optional<tf::Task> deeper_level_done;
+  auto level_begin = std::begin(sorted_nodes_to_reconstruct);
+  while (level_begin != std::end(sorted_nodes_to_reconstruct)) {
+    const auto level = level_begin->levels();
+    const auto level_end =
+      std::find_if(level_begin, std::end(sorted_nodes_to_reconstruct), [level](const auto& node) {
+        return node.levels() != level;
+      });
+
+    auto level_done = reconstruct_taskflow.placeholder();
+    level_done.name(concat("reconstructed_level_", level));
+    for (auto iter = level_begin; iter != level_end; ++iter) {
+      const auto& node = *iter;
+      auto reconstruct_task =
+        reconstruct_taskflow.emplace([this, &node, &root_bounds, partition]() {
+          reconstruct_single_node(node, root_bounds, partition);
+        });
+      reconstruct_task.name(concat("reconstruct_r", OctreeNodeIndex64::to_string(node)));
+      if (deeper_level_done) {
+        deeper_level_done->precede(reconstruct_task);
+      }
+      reconstruct_task.precede(level_done);
+    }
+
+    deeper_level_done = level_done;
+    level_begin = level_end;
   }
 
+  tf::Executor executor{ total_thread_count(_meta_parameters.thread_count) };
+  executor.run(reconstruct_taskflow).get();
+
   const auto t_end = std::chrono::high_resolution_clock::now();
   if (global_config().is_journaling_enabled) {
     const auto delta_t = t_end - t_start;
@@ -4,13 +4,23 @@
 #include "datastructures/PointBuffer.h"
 #include "io/PointsPersistence.h"
 #include "process/Tiler.h"
+#include "tiling/ClassificationPartitioning.h"
 #include "tiling/Node.h"
 #include "tiling/Sampling.h"
+#include "tiling/TaskGranularity.h"
 
 #include <containers/Range.h>
 
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <taskflow/taskflow.hpp>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 struct ProgressReporter;
@@ -45,6 +55,134 @@ private:
   std::mutex _lock;
 };
 
+/**
+ * Helper structure that stores the NodeOccupancy of each interior node that was
+ * sampled with a minimum spacing in a thread-safe manner. This is used to
+ * sample the points of later batches incrementally at each node.
+ *
+ * With a memory budget, the least recently used occupancies are dropped once
+ * all occupancies exceed the budget. The nodes of dropped occupancies are
+ * sampled together with their previously selected points again, which also
+ * gives them a new occupancy
+ */
+struct NodeOccupancyCache
+{
+  NodeOccupancyCache() {}
+  NodeOccupancyCache(const NodeOccupancyCache&) = delete;
+  NodeOccupancyCache(NodeOccupancyCache&&) = delete;
+  NodeOccupancyCache& operator=(const NodeOccupancyCache&) = delete;
+  NodeOccupancyCache& operator=(NodeOccupancyCache&&) = delete;
+
+  void set_memory_budget(std::optional<unit::byte> memory_budget)
+  {
+    std::lock_guard guard{ _lock };
+    _memory_budget = memory_budget ? std::optional<size_t>{ static_cast<size_t>(
+                                       memory_budget->value()) }
+                                   : std::nullopt;
+    evict_until_within_budget();
+  }
+
+  /**
+   * Returns the occupancy of the given node, or nullptr if the node has not
+   * been sampled with a minimum spacing yet or if its occupancy was dropped.
+   * The occupancy stays valid while it is in use, even if it is dropped in the
+   * meantime
+   */
+  std::shared_ptr<NodeOccupancy> find_occupancy(const octree::NodeStructure& node)
+  {
+    std::lock_guard guard{ _lock };
+    const auto iter = _occupancies.find(key_for(node));
+    if (iter == std::end(_occupancies))
+      return nullptr;
+
+    // An occupancy only grows while its node is tiled, which happens after it
+    // was looked up, so its size is measured again with each lookup
+    auto& entry = iter->second;
+    _byte_size -= entry.byte_size;
+    entry.byte_size = entry.occupancy->content_byte_size();
+    _byte_size += entry.byte_size;
+    _lru_order.splice(std::end(_lru_order), _lru_order, entry.lru_position);
+
+    auto occupancy = entry.occupancy;
+    evict_until_within_budget();
+    return occupancy;
+  }
+
+  void emplace_occupancy(const octree::NodeStructure& node,
+                         NodeOccupancy&& occupancy)
+  {
+    std::lock_guard guard{ _lock };
+    auto key = key_for(node);
+    const auto iter = _occupancies.find(key);
+    if (iter != std::end(_occupancies)) {
+      erase_entry(iter);
+    }
+
+    Entry entry;
+    entry.occupancy = std::make_shared<NodeOccupancy>(std::move(occupancy));
+    entry.byte_size = entry.occupancy->content_byte_size();
+    entry.lru_position = _lru_order.insert(std::end(_lru_order), key);
+    _byte_size += entry.byte_size;
+    _occupancies.emplace(std::move(key), std::move(entry));
+    evict_until_within_budget();
+  }
+
+  void clear()
+  {
+    std::lock_guard guard{ _lock };
+    _occupancies.clear();
+    _lru_order.clear();
+    _byte_size = 0;
+  }
+
+  /**
+   * Number of bytes of all occupancies, as of their last lookup
+   */
+  size_t byte_size() const
+  {
+    std::lock_guard guard{ _lock };
+    return _byte_size;
+  }
+
+private:
+  struct Entry
+  {
+    std::shared_ptr<NodeOccupancy> occupancy;
+    size_t byte_size = 0;
+    std::list<std::string>::iterator lru_position;
+  };
+
+  static std::string key_for(const octree::NodeStructure& node)
+  {
+    return std::to_string(node.partition) + "/" + node.name;
+  }
+
+  void erase_entry(std::unordered_map<std::string, Entry>::iterator iter)
+  {
+    _byte_size -= iter->second.byte_size;
+    _lru_order.erase(iter->second.lru_position);
+    _occupancies.erase(iter);
+  }
+
+  void evict_until_within_budget()
+  {
+    if (!_memory_budget)
+      return;
+    while (_byte_size > *_memory_budget && !_lru_order.empty()) {
+      erase_entry(_occupancies.find(_lru_order.front()));
+    }
+  }
+
+  std::unordered_map<std::string, Entry> _occupancies;
+  /**
+   * Keys of all occupancies, from the least to the most recently used one
+   */
+  std::list<std::string> _lru_order;
+  size_t _byte_size = 0;
+  std::optional<size_t> _memory_budget;
+  mutable std::mutex _lock;
+};
+
 /**
  * Helper structure that encapsulates data for tiling a single node
  */
@@ -64,6 +202,71 @@ struct NodeTilingData
   octree::NodeStructure root_node;
 };
 
+/**
+ * Helper structure that dispatches the subtrees of a batch in the order of their
+ * estimated remaining cost. Each subtree is pushed together with one task that
+ * pops the most expensive pending subtree once it runs, which is not
+ * necessarily the subtree that it was created for. Whichever worker runs or
+ * steals a task thus always starts the largest remaining work, so the few huge
+ * subtrees of a batch start first instead of dominating its tail
+ */
+struct SubtreeQueue
+{
+  using Job = std::function<void(tf::Subflow&)>;
+
+  SubtreeQueue() {}
+  SubtreeQueue(const SubtreeQueue&) = delete;
+  SubtreeQueue(SubtreeQueue&&) = delete;
+  SubtreeQueue& operator=(const SubtreeQueue&) = delete;
+  SubtreeQueue& operator=(SubtreeQueue&&) = delete;
+
+  void push(double cost, Job job)
+  {
+    std::lock_guard guard{ _lock };
+    _entries.push_back({ cost, _next_sequence_number++, std::move(job) });
+    std::push_heap(std::begin(_entries), std::end(_entries), &Entry::runs_later);
+  }
+
+  size_t size() const
+  {
+    std::lock_guard guard{ _lock };
+    return _entries.size();
+  }
+
+  /**
+   * Removes and returns the pending job with the highest cost. Jobs with the
+   * same cost are returned in the order in which they were pushed
+   */
+  Job pop_most_expensive()
+  {
+    std::lock_guard guard{ _lock };
+    assert(!_entries.empty());
+    std::pop_heap(std::begin(_entries), std::end(_entries), &Entry::runs_later);
+    auto job = std::move(_entries.back().job);
+    _entries.pop_back();
+    return job;
+  }
+
+private:
+  struct Entry
+  {
+    double cost;
+    uint64_t sequence_number;
+    Job job;
+
+    static bool runs_later(const Entry& l, const Entry& r)
+    {
+      if (l.cost != r.cost)
+        return l.cost < r.cost;
+      return l.sequence_number > r.sequence_number;
+    }
+  };
+
+  std::vector<Entry> _entries;
+  uint64_t _next_sequence_number = 0;
+  mutable std::mutex _lock;
+};
+
 /**
  * Base class for different tiling algorithms
  */
@@ -87,9 +290,58 @@ struct TilingAlgorithmBase
   /**
    * Finalize the computation after all points have been indexed
    */
-  virtual void finalize(const AABB& bounds) {}
+  virtual void finalize(const AABB& bounds);
+
+  /**
+   * Number of points that were tiled into each octree, if the points are
+   * partitioned by classification. Empty otherwise
+   */
+  virtual std::vector<size_t> points_per_partition() const { return {}; }
+
+  /**
+   * Number of levels at the top of the octree, including the root, whose nodes
+   * were reconstructed from their children. The points in these nodes are
+   * copies of points in deeper nodes
+   */
+  virtual uint32_t reconstructed_levels() const { return 0; }
+
+  /**
+   * Brings the nodes that are only written by 'finalize' up to date with the
+   * points tiled so far, so that the octree can be read before tiling has
+   * finished. Algorithms that write all nodes while tiling do nothing here
+   */
+  virtual void reconstruct_updated_nodes(const AABB& bounds) {}
 
 protected:
+  /**
+   * Returns the persistence for the octree of the given classification group
+   */
+  PointsPersistence& persistence_for_partition(uint32_t partition);
+
+  /**
+   * Persists the given points of a node in the point order of the output (see
+   * TilerMetaParameters::point_order). The given points are in Morton order. A
+   * persistence that applies the point order itself when encoding the node
+   * gets them in this order, so that reading the node back needs no sorting
+   */
+  template<typename Iter>
+  void persist_node_points(PointsPersistence& persistence,
+                           Iter points_begin,
+                           Iter points_end,
+                           const AABB& node_bounds,
+                           const std::string& node_name)
+  {
+    if (_meta_parameters.point_order == PointOrder::Morton || persistence.applies_point_order()) {
+      persistence.persist_points(points_begin, points_end, node_bounds, node_name);
+      return;
+    }
+
+    std::vector<PointBuffer::PointReference> ordered_points{ points_begin, points_end };
+    order_points_in_node(ordered_points, node_bounds, _meta_parameters.point_order);
+    persistence.persist_points(
+      std::begin(ordered_points), std::end(ordered_points), node_bounds, node_name);
+  }
+
   std::vector<NodeTilingData> tile_node(octree::NodeData&& node_data,
                                         const octree::NodeStructure& node_structure,
                                         const octree::NodeStructure& root_node_structure,
@@ -101,6 +353,35 @@ protected:
                                                  octree::NodeStructure const& node,
                                                  octree::NodeStructure const& root_node,
                                                  size_t previously_taken_points);
+  std::vector<NodeTilingData> tile_internal_node_incrementally(
+    octree::NodeData& new_points,
+    octree::NodeStructure const& node,
+    octree::NodeStructure const& root_node,
+    NodeOccupancy& occupancy);
+  std::vector<NodeTilingData> complete_internal_node(
+    octree::NodeData& all_points,
+    octree::NodeData::iterator partition_point,
+    octree::NodeStructure const& node,
+    octree::NodeStructure const& root_node,
+    size_t previously_taken_points,
+    SamplingBehaviour sampling_behaviour);
+  std::vector<NodeTilingData> complete_internal_node_incrementally(
+    octree::NodeData& new_points,
+    octree::NodeData::iterator partition_point,
+    octree::NodeStructure const& node,
+    octree::NodeStructure const& root_node);
+  bool can_sample_in_parallel(size_t points_count,
+                              const octree::NodeStructure& node_structure,
+                              const octree::NodeStructure& root_node_structure) const;
+  void tile_node_in_parallel(octree::NodeData&& node_data,
+                             const octree::NodeStructure& node_structure,
+                             const octree::NodeStructure& root_node_structure,
+                             tf::Subflow& subflow);
+  void tile_child_nodes(std::vector<NodeTilingData> child_nodes, tf::Subflow& subflow);
+  tf::Task schedule_subtree(double cost,
+                            SubtreeQueue::Job job,
+                            tf::Subflow& subflow,
+                            const std::string& task_name);
   void do_tiling_for_node(octree::NodeData&& node_data,
                           const octree::NodeStructure& node_structure,
                           const octree::NodeStructure& root_node_structure,
@@ -110,9 +391,15 @@ protected:
   ProgressReporter* _progress_reporter;
   PointsPersistence& _persistence;
   TilerMetaParameters _meta_parameters;
+  // One persistence per classification group if the points are partitioned by
+  // classification, empty otherwise
+  std::vector<PointsPersistence*> _partition_persistences;
 
   octree::NodeData _root_node_points;
   PointsCache _points_cache;
+  NodeOccupancyCache _node_occupancies;
+  SubtreeQueue _pending_subtrees;
+  TaskGranularity _task_granularity;
 };
 
 /**
@@ -120,8 +407,9 @@ protected:
  * paper. It uses:
  *
  * -  Parallel indexing
- * -  Sequential sorting
- * -  Processing from the root node
+ * -  Parallel sorting (sorted chunks that are merged pairwise)
+ * -  Processing from the root node, where nodes with many points are sampled
+ *    by multiple tasks if the sampling strategy selects one point per grid cell
  */
 struct TilingAlgorithmV1 : TilingAlgorithmBase
 {
@@ -208,13 +496,23 @@ private:
   std::vector<Octree<util::Range<IndexedPointsIter>>> _indexed_points_ranges;
 };
 
+/**
+ * Version 3 of the tiling algorithm. Like version 2, it starts tiling from
+ * nodes deeper in the octree and reconstructs the skipped nodes afterwards, but
+ * selects the start nodes on a fixed level for all batches.
+ *
+ * If a PartitionedOutput is given, the points are partitioned by their
+ * classification after indexing and each classification group is tiled into a
+ * separate octree. The start nodes of all octrees are processed concurrently
+ */
 struct TilingAlgorithmV3 : TilingAlgorithmBase
 {
   TilingAlgorithmV3(SamplingStrategy& sampling_strategy,
                     ProgressReporter* progress_reporter,
                     PointsPersistence& persistence,
                     TilerMetaParameters meta_parameters,
-                    const fs::path& output_dir);
+                    const fs::path& output_dir,
+                    std::optional<PartitionedOutput> partitioned_output = std::nullopt);
 
   std::pair<tf::Task, tf::Task> build_execution_graph(
     util::Range<PointBuffer::PointIterator> points,
@@ -224,11 +522,44 @@ struct TilingAlgorithmV3 : TilingAlgorithmBase
 
   void finalize(const AABB& bounds) override;
 
+  std::vector<size_t> points_per_partition() const override;
+
+  uint32_t reconstructed_levels() const override;
+
+  /**
+   * Reconstructs the nodes above all start nodes that received points since the
+   * last call, so that all levels of the octree are up to date between batches.
+   * 'finalize' reconstructs these nodes anyway, this is only needed if the
+   * octree is read before tiling has finished
+   */
+  void reconstruct_updated_nodes(const AABB& bounds) override;
+
+  /**
+   * Selects the start nodes of all batches on the given level, instead of
+   * estimating the level from the first batch. This has to be called before
+   * the first batch is processed
+   */
+  void set_level_of_start_nodes(size_t level);
+
 private:
   using IndexedPoints = std::vector<IndexedPoint64>;
   using IndexedPointsIter = typename IndexedPoints::iterator;
   using PointsIter = typename PointBuffer::PointIterator;
 
+  size_t num_partitions() const;
+  /**
+   * Splits a sorted range of indexed points into one sorted range per
+   * classification group. Without partitioning, this returns 'indexed_points'
+   */
+  std::vector<util::Range<IndexedPointsIter>> partition_indexed_points(
+    util::Range<IndexedPointsIter> indexed_points) const;
+  /**
+   * Name of the start node task for the given node in the given partition
+   */
+  std::string start_node_task_name(const OctreeNodeIndex64& node_index,
+                                   uint32_t partition,
+                                   size_t num_points) const;
+
   std::pair<tf::Task, tf::Task> build_execution_graph_for_first_iteration(
     util::Range<PointBuffer::PointIterator> points,
     const AABB& bounds,
@@ -280,19 +611,37 @@ private:
   NodeTilingData prepare_range_for_tiling(
     const std::vector<util::Range<IndexedPointsIter>>& start_node_data,
     OctreeNodeIndex64 node_index,
+    uint32_t partition,
     const AABB& bounds);
 
   /**
    * Reconstruct the nodes that we left out initially
    */
-  void reconstruct_left_out_nodes(const AABB& root_bounds);
+  void reconstruct_left_out_nodes(const AABB& root_bounds, uint32_t partition);
+  /**
+   * Reconstruct the direct and indirect parent nodes of the given start nodes,
+   * from the deepest to the most shallow level. The nodes of each level are
+   * reconstructed in parallel
+   */
+  void reconstruct_ancestors(const std::unordered_set<OctreeNodeIndex64>& start_nodes,
+                             const AABB& root_bounds,
+                             uint32_t partition);
   /**
    * Reconstruct the given node
    */
-  void reconstruct_single_node(const OctreeNodeIndex64& node, const AABB& root_bounds);
+  void reconstruct_single_node(const OctreeNodeIndex64& node,
+                               const AABB& root_bounds,
+                               uint32_t partition);
 
   fs::path _output_dir;
+  std::optional<ClassificationPartitioning> _partitioning;
 
-  std::vector<Octree<util::Range<IndexedPointsIter>>> _indexed_points_ranges;
+  // Split ranges of each indexing task, per partition (i.e. indexed as
+  // [partition][task])
+  std::vector<std::vector<Octree<util::Range<IndexedPointsIter>>>> _indexed_points_ranges;
   std::optional<size_t> _level_of_start_nodes;
+  std::vector<size_t> _points_per_partition;
+  // Start nodes that received points since the nodes above them were last
+  // reconstructed, per partition
+  std::vector<std::unordered_set<OctreeNodeIndex64>> _updated_start_nodes;
 };
\ No newline at end of file
@@ -22,6 +22,8 @@ enum class OutputFormat
   BINZ,
   // Cesium 3D Tiles format (https://github.com/CesiumGS/3d-tiles)
   CZM_3DTILES,
+  // Cesium 3D Tiles 1.1 format with binary glTF tiles (meshopt-compressed)
+  CZM_3DTILES_GLB,
   // LAS format
   LAS,
   // Compressed LAS format (LAZ)
@@ -40,6 +42,7 @@ static const std::unordered_set<std::pair<OutputFormat, std::string>,
     { OutputFormat::BIN, "BIN" },
     { OutputFormat::BINZ, "BINZ" },
     { OutputFormat::CZM_3DTILES, "3DTILES" },
+    { OutputFormat::CZM_3DTILES_GLB, "3DTILES_GLB" },
     { OutputFormat::LAS, "LAS" },
     { OutputFormat::LAZ, "LAZ" },
     { OutputFormat::ENTWINE_LAS, "ENTWINE_LAS" },
@@ -168,12 +168,10 @@ Proj4Transform::transformPointsTo(TargetSRS targetSRS,
   }
 
   for (auto& point_ref : points) {
-    auto& pos = point_ref.position();
+    const auto pos = point_ref.position();
     
     PJ_COORD new_pos = proj_trans(transformation, PJ_FWD, proj_coord(pos.x, pos.y, pos.z, 0.0));
-    pos.x = new_pos.xyz.x;
-    pos.y = new_pos.xyz.y;
-    pos.z = new_pos.xyz.z;
+    point_ref.set_position({ new_pos.xyz.x, new_pos.xyz.y, new_pos.xyz.z });
   }
 }
 
@@ -190,11 +188,9 @@ Proj4Transform::transformPointsTo(TargetSRS targetSRS,
   }
 
   for (auto point_ref : points) {
-    auto& pos = point_ref.position();
+    const auto pos = point_ref.position();
     PJ_COORD new_pos = proj_trans(transformation, PJ_FWD, proj_coord(pos.x, pos.y, pos.z, 0.0));
-    pos.x = new_pos.xyz.x;
-    pos.y = new_pos.xyz.y;
-    pos.z = new_pos.xyz.z;
+    point_ref.set_position({ new_pos.xyz.x, new_pos.xyz.y, new_pos.xyz.z });
   }
 }
 
@@ -211,7 +207,7 @@ PJ* Proj4Transform::getTargetTransformation(TargetSRS targetSRS) const
 }
 
 Vector3<double>
-setOriginToSmallestPoint(std::vector<Vector3<double>>& points)
+setOriginToSmallestPoint(gsl::span<Vector3<double>> points)
 {
   const auto dblMax = std::numeric_limits<double>::max();
   const auto smallestPoint = std::accumulate(points.begin(),
@@ -239,7 +235,7 @@ setOriginToSmallestPoint(gsl::span<PointBuffer::PointReference> points)
                     });
 
   for (auto& point : points) {
-    point.position() -= smallestPoint;
+    point.set_position(point.position() - smallestPoint);
   }
 
   return smallestPoint;
@@ -111,7 +111,7 @@ private:
 /// smallest point prior to subtraction is returned
 /// </summary>
 Vector3<double>
-setOriginToSmallestPoint(std::vector<Vector3<double>>& points);
+setOriginToSmallestPoint(gsl::span<Vector3<double>> points);
 
 template<typename Iter>
 Vector3<double>
@@ -127,7 +127,9 @@ setOriginToSmallestPoint(Iter points_begin, Iter points_end)
                     });
 
   std::for_each(
-    points_begin, points_end, [smallestPoint](auto& point) { point.position() -= smallestPoint; });
+    points_begin, points_end, [smallestPoint](auto& point) {
+      point.set_position(point.position() - smallestPoint);
+    });
 
   return smallestPoint;
 }
\ No newline at end of file
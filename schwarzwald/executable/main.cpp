@@ -193,9 +193,12 @@ parseArguments(int argc, char** argv)
   TilerProcess::Arguments tiler_args;
   ConverterArguments converter_args;
   std::string output_folder;
+  std::string cache_folder;
   std::vector<std::string> source_files;
   std::string cache_size_string;
+  std::vector<double> stream_bounds;
   std::string rgb_mapping_string;
+  bool compact_3dtiles;
   bool create_journal;
 
   bpo::options_description options("Options");
@@ -213,8 +216,9 @@ parseArguments(int argc, char** argv)
     "source,i",
     bpo::value<std::vector<std::string>>(&source_files)->multitoken(),
     "List of one or more input files and/or folders. For each folder, all "
-    "LAS/LAZ files in the "
-    "folder and all its subfolders are processed.")(
+    "LAS/LAZ/COPC files and EPT datasets in the "
+    "folder and all its subfolders are processed. An EPT dataset is given by "
+    "its folder or its ept.json file.")(
     "outdir,o",
     bpo::value<std::string>(&output_folder),
     "Output directory. If unspecified, the current working directory is "
@@ -241,7 +245,8 @@ parseArguments(int argc, char** argv)
     "output-format",
     bpo::value<std::string>()->default_value("3DTILES"),
     "Output format for the conversion. Accepted values are: 3DTILES (Cesium 3D "
-    "Tiles format), "
+    "Tiles format), 3DTILES_GLB (Cesium 3D Tiles 1.1 format with binary glTF "
+    "tiles, using quantized positions and meshopt compression), "
     "ENTWINE_LAS (Entwine format using LAS files, compatible with Potree), "
     "ENTWINE_LAZ (Entwine "
     "format using LAZ files, compatible with Potree), BIN (custom binary "
@@ -266,11 +271,23 @@ parseArguments(int argc, char** argv)
     "values, same as not specifying this option). This feature is only "
     "supported when "
     "output-format is 3DTILES")(
+    "compact-3dtiles",
+    bpo::bool_switch(&compact_3dtiles)->default_value(false),
+    "Write 3D Tiles with a compact encoding: positions quantized to 16 bits "
+    "per axis relative to the bounds of each node, 16-bit RGB565 colors and "
+    "2-byte oct-encoded normals. This roughly halves the size of the tiles, "
+    "at the cost of precision. Nodes are quantized every time they are "
+    "written, so combine this with --cache-size to write each node only once. "
+    "Only supported when output-format is 3DTILES")(
     "cache-size",
     bpo::value<std::string>(&cache_size_string),
     "Size of a local cache in memory used during conversion for storing "
     "points in. You can specify "
-    "this using common SI-suffixes (e.g. 800MiB or 256MB)")(
+    "this using common SI-suffixes (e.g. 800MiB or 256MB). If specified, "
+    "nodes are staged in this cache during tiling and each node is written "
+    "to the output format only once at the end. Nodes that do not fit into "
+    "the cache are written early. A quarter of the cache keeps the sampling "
+    "state of interior nodes between batches")(
     "journal",
     bpo::bool_switch(&create_journal)->default_value(false),
     "Create a detailed journal in the output folder with information about "
@@ -319,7 +336,92 @@ parseArguments(int argc, char** argv)
     "and dynamically assigned to reading and indexing. Please not that reading "
     "is parallelized on "
     "a file-level, so there can never be more read threads than there are "
-    "files.");
+    "files.")(
+    "estimate-normals",
+    bpo::bool_switch(&tiler_args.estimate_normals)->default_value(false),
+    "Estimate a normal for each point from its nearest neighbours and write "
+    "the normals to the output. The normals are oriented towards positive Z. "
+    "Only supported for output formats that can store normals")(
+    "partition-by-classification",
+    bpo::bool_switch(&tiler_args.partition_by_classification)->default_value(false),
+    "Build a separate octree for each classification group (ground, "
+    "vegetation, buildings, water, other). Each octree is written to a "
+    "subdirectory of the output directory that is named after its group. "
+    "Requires input files with classifications and the FAST tiling strategy")(
+    "defer-attributes",
+    bpo::bool_switch(&tiler_args.defer_attributes)->default_value(false),
+    "Tile only the positions of the points and store all other attributes "
+    "separately until the nodes are written. This reduces the amount of data "
+    "that is sorted, sampled and cached during tiling, which pays off for "
+    "input files with many attributes. The stored attributes count towards "
+    "--cache-size and are spilled to a temporary file in the output directory "
+    "once the cache is full. Requires --cache-size")(
+    "exact-bounds",
+    bpo::bool_switch(&tiler_args.exact_bounds)->default_value(false),
+    "Calculate the bounds of the dataset from the points instead of the file "
+    "headers, which might be padded or wrong. This reads all input files once "
+    "before tiling. The bounds of each file are cached in --cache-dir, so "
+    "that later runs only read files that changed")(
+    "cache-dir",
+    bpo::value<std::string>(&cache_folder),
+    "Directory for caches that later runs can reuse, e.g. the exact bounds of "
+    "the input files (see --exact-bounds). Defaults to the 'cache' directory "
+    "in the output directory, which is kept when the output directory is "
+    "cleared. Nothing is ever written to the input directories")(
+    "quadtree",
+    bpo::bool_switch(&tiler_args.quadtree)->default_value(false),
+    "Tile flat datasets (e.g. airborne scans) like a quadtree: The octree "
+    "is anchored at the bottom of the dataset, so that the top levels only "
+    "subdivide in X and Y, and Z is subdivided once the nodes are about as "
+    "high as the dataset. This creates fewer, fuller nodes. With 3DTILES "
+    "output, the bounding volumes are clipped to the bounds of the dataset")(
+    "retile",
+    bpo::bool_switch(&tiler_args.retile)->default_value(false),
+    "Tile the output of a previous tiler run again with different "
+    "parameters (e.g. spacing, sampling or output format) instead of tiling "
+    "the source files. Each source directory (-i) has to be the output "
+    "directory of a previous run, with one of the output formats LAS, LAZ, "
+    "ENTWINE_LAS or ENTWINE_LAZ. Several source directories are merged into "
+    "a single octree. The subtrees are tiled independently of each other, "
+    "which is faster than tiling the original source files")(
+    "stream",
+    bpo::bool_switch(&tiler_args.stream)->default_value(false),
+    "Tile point files that arrive continuously (e.g. from a mobile mapping "
+    "sensor) into a live octree. The single source directory (-i) is watched "
+    "for new LAS/LAZ files, which have to be moved into the directory once "
+    "they are complete. The updated nodes are written with the flush interval "
+    "(see --stream-flush-interval) or after the given number of points (see "
+    "--stream-flush-points), so new points are visible within seconds. "
+    "Streaming ends once a file named 'end_of_stream' is created in the "
+    "source directory. Requires --stream-bounds and one of the output "
+    "formats LAS, LAZ, ENTWINE_LAS or ENTWINE_LAZ")(
+    "stream-bounds",
+    bpo::value<std::vector<double>>(&stream_bounds)->multitoken(),
+    "Bounds of the octree when streaming, as 'minX minY minZ maxX maxY "
+    "maxZ'. Points outside of these bounds are dropped")(
+    "stream-flush-interval",
+    bpo::value<uint32_t>(&tiler_args.stream_flush_interval)->default_value(5),
+    "Maximum time in seconds between receiving points and writing the nodes "
+    "that contain them when streaming")(
+    "stream-flush-points",
+    bpo::value<size_t>(&tiler_args.stream_flush_points)->default_value(1'000'000),
+    "When streaming, the updated nodes are also written once this many "
+    "points were tiled since they were last written")(
+    "progressive-levels",
+    bpo::value<uint32_t>(&tiler_args.progressive_levels)->default_value(0),
+    "If greater than zero, the given number of top levels of the octree are "
+    "published as a complete preview in the 'preview' subdirectory of the "
+    "output directory while tiling is running. The preview is updated after "
+    "the batches, at most once per minute, and removed once the final output "
+    "is written")(
+    "point-order",
+    bpo::value<std::string>()->default_value("MORTON"),
+    "Order of the points inside each node of the output. Valid options are "
+    "MORTON, HILBERT or LOD_PREFIX. HILBERT keeps consecutive points closer "
+    "together, which makes compressed output (e.g. ENTWINE_LAZ) smaller. "
+    "With LOD_PREFIX, the first points of each node are a spatially uniform "
+    "subsample of the node, so that clients can read only the first part of "
+    "a node for a coarser version of it");
 
   bpo::options_description converter_options("Converter options");
   converter_options.add_options()(
@@ -404,6 +506,8 @@ parseArguments(int argc, char** argv)
                    [](const auto& str) { return fs::path{ str }; });
     tiler_args.output_directory =
       output_folder.empty() ? fs::current_path() : fs::path{ output_folder };
+    tiler_args.cache_directory =
+      cache_folder.empty() ? tiler_args.output_directory / "cache" : fs::path{ cache_folder };
 
     global_config().is_journaling_enabled = create_journal;
     global_config().root_directory = tiler_args.output_directory;
@@ -421,6 +525,7 @@ parseArguments(int argc, char** argv)
       const std::unordered_map<std::string, OutputFormat>
         supported_output_formats = {
           { "3DTILES", OutputFormat::CZM_3DTILES },
+          { "3DTILES_GLB", OutputFormat::CZM_3DTILES_GLB },
           { "BIN", OutputFormat::BIN },
           { "LAS", OutputFormat::LAS },
           { "LAZ", OutputFormat::LAZ },
@@ -459,6 +564,9 @@ parseArguments(int argc, char** argv)
       }();
     }
 
+    tiler_args.pnts_encoding =
+      compact_3dtiles ? PNTSEncoding::Compact : PNTSEncoding::Default;
+
     if (tiler_variables.count("cache-size")) {
       parse_memory_size(cache_size_string)
         .map([&tiler_args](unit::byte cache_size) {
@@ -468,6 +576,17 @@ parseArguments(int argc, char** argv)
           [](std::string const& failure) { std::cout << failure << "\n"; });
     }
 
+    if (tiler_variables.count("stream-bounds")) {
+      if (stream_bounds.size() != 6) {
+        std::cout << "Option --stream-bounds requires 6 values (minX minY minZ maxX maxY maxZ)!"
+                  << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+      tiler_args.stream_bounds =
+        AABB{ { stream_bounds[0], stream_bounds[1], stream_bounds[2] },
+              { stream_bounds[3], stream_bounds[4], stream_bounds[5] } };
+    }
+
     tiler_args.source_projection =
       (tiler_variables.count("source-projection"))
         ? (std::make_optional(
@@ -496,6 +615,21 @@ parseArguments(int argc, char** argv)
       return matching_strategy->second;
     }();
 
+    tiler_args.point_order = [&]() -> PointOrder {
+      const std::unordered_map<std::string, PointOrder> supported_point_orders =
+        { { "MORTON", PointOrder::Morton },
+          { "HILBERT", PointOrder::Hilbert },
+          { "LOD_PREFIX", PointOrder::LODPrefix } };
+      const auto& arg = tiler_variables["point-order"].as<std::string>();
+      const auto matching_point_order = supported_point_orders.find(arg);
+      if (matching_point_order == supported_point_orders.end()) {
+        std::cout << "Point order \"" << arg << "\" not recognized!"
+                  << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+      return matching_point_order->second;
+    }();
+
     if (tiler_variables.count("threads")) {
 
       parse_threads_count(tiler_variables["threads"].as<std::string>())
@@ -0,0 +1,158 @@
+#include <catch2/catch_all.hpp>
+
+#include "io/AttributeStore.h"
+
+#include <algorithm>
+#include <random>
+#include <thread>
+
+static PointBuffer
+generate_points(size_t count, uint16_t first_intensity)
+{
+  std::vector<Vector3<double>> positions;
+  std::vector<uint16_t> intensities;
+  std::vector<uint8_t> classifications;
+  for (size_t idx = 0; idx < count; ++idx) {
+    positions.push_back({ static_cast<double>(idx), 1, 2 });
+    intensities.push_back(static_cast<uint16_t>(first_intensity + idx));
+    classifications.push_back(static_cast<uint8_t>(idx % 3));
+  }
+  return {
+    count, std::move(positions), {}, {}, std::move(intensities), std::move(classifications)
+  };
+}
+
+SCENARIO("AttributeStore", "[AttributeStore]")
+{
+  PointAttributes deferred_attributes;
+  deferred_attributes.insert(PointAttribute::Intensity);
+  AttributeStore store{ deferred_attributes };
+
+  const auto first_points = generate_points(20, 100);
+  const auto second_points = generate_points(30, 1000);
+
+  GIVEN("Two stored batches of points")
+  {
+    // Only parts of the first batch are stored, like a partially filled read
+    // buffer
+    auto first_stripped = store.store(first_points, 10);
+    auto second_stripped = store.store(second_points, second_points.count());
+
+    THEN("The points have IDs but no deferred attributes")
+    {
+      REQUIRE(first_stripped.count() == 10);
+      REQUIRE(first_stripped.has_point_ids());
+      REQUIRE(!first_stripped.hasIntensities());
+      REQUIRE(first_stripped.hasClassifications());
+      REQUIRE(first_stripped.point_ids()[9] == 9);
+      REQUIRE(second_stripped.point_ids()[0] == 10);
+    }
+
+    WHEN("Points of both batches are mixed and gathered")
+    {
+      PointBuffer mixed;
+      mixed.push_point(second_stripped.get_point(5));
+      mixed.push_point(first_stripped.get_point(3));
+      mixed.push_point(second_stripped.get_point(29));
+      store.gather(mixed);
+
+      THEN("The deferred attributes are restored")
+      {
+        REQUIRE(!mixed.has_point_ids());
+        REQUIRE(mixed.hasIntensities());
+        REQUIRE(mixed.intensities()[0] == 1005);
+        REQUIRE(mixed.intensities()[1] == 103);
+        REQUIRE(mixed.intensities()[2] == 1029);
+        REQUIRE(mixed.classifications()[0] == 5 % 3);
+        REQUIRE(mixed.positions()[2] == Vector3<double>{ 29, 1, 2 });
+      }
+    }
+  }
+
+  GIVEN("A store with a spill file")
+  {
+    const fs::path spill_file_path = "./_attribute_store_spill_test_.tmp";
+    {
+      AttributeStore spilling_store{ deferred_attributes, spill_file_path };
+      auto first_stripped = spilling_store.store(first_points, 10);
+      auto second_stripped = spilling_store.store(second_points, second_points.count());
+      const auto stored_bytes = spilling_store.stored_bytes();
+
+      WHEN("All chunks are spilled")
+      {
+        const auto freed_bytes = spilling_store.spill(stored_bytes);
+
+        THEN("No attributes are in memory anymore, but all are still stored")
+        {
+          REQUIRE(freed_bytes == stored_bytes);
+          REQUIRE(spilling_store.resident_bytes() == 0);
+          REQUIRE(spilling_store.stored_bytes() == stored_bytes);
+          REQUIRE(fs::exists(spill_file_path));
+        }
+
+        THEN("The deferred attributes are gathered from the spill file")
+        {
+          PointBuffer mixed;
+          mixed.push_point(second_stripped.get_point(5));
+          mixed.push_point(first_stripped.get_point(3));
+          spilling_store.gather(mixed);
+
+          REQUIRE(mixed.intensities()[0] == 1005);
+          REQUIRE(mixed.intensities()[1] == 103);
+          REQUIRE(mixed.classifications()[0] == 5 % 3);
+        }
+      }
+    }
+
+    THEN("The spill file is removed with the store")
+    {
+      REQUIRE(!fs::exists(spill_file_path));
+    }
+  }
+
+  GIVEN("A spilled chunk that is larger than the gaps that are read at once")
+  {
+    const fs::path spill_file_path = "./_attribute_store_spill_test_.tmp";
+    AttributeStore spilling_store{ deferred_attributes, spill_file_path };
+    const auto points = generate_points(10000, 0);
+    auto stripped = spilling_store.store(points, points.count());
+    spilling_store.spill(spilling_store.stored_bytes());
+
+    WHEN("Scattered points of the chunk are gathered in random order")
+    {
+      std::vector<size_t> indices;
+      for (size_t idx = 0; idx < 100; ++idx) {
+        indices.push_back(idx);
+        indices.push_back(5000 + 2 * idx);
+      }
+      indices.push_back(9999);
+      indices.push_back(42);
+      std::mt19937 rng{ 7 };
+      std::shuffle(std::begin(indices), std::end(indices), rng);
+
+      std::vector<PointBuffer> gathered_points(4);
+      std::vector<std::thread> threads;
+      for (auto& gathered : gathered_points) {
+        threads.emplace_back([&gathered, &indices, &stripped, &spilling_store]() {
+          for (auto idx : indices) {
+            gathered.push_point(stripped.get_point(idx));
+          }
+          spilling_store.gather(gathered);
+        });
+      }
+      for (auto& thread : threads) {
+        thread.join();
+      }
+
+      THEN("Every point gets its own attributes, also when gathered concurrently")
+      {
+        for (const auto& gathered : gathered_points) {
+          REQUIRE(gathered.count() == indices.size());
+          for (size_t idx = 0; idx < indices.size(); ++idx) {
+            REQUIRE(gathered.intensities()[idx] == static_cast<uint16_t>(indices[idx]));
+          }
+        }
+      }
+    }
+  }
+}
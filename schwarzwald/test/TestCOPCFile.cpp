@@ -0,0 +1,185 @@
+#include <catch2/catch_all.hpp>
+
+#include "io/COPCFile.h"
+
+#include <cstring>
+#include <sstream>
+#include <string>
+
+/**
+ * In-memory COPC file, into which values are written at arbitrary offsets, the
+ * way that the hierarchy pages are laid out in a real file
+ */
+struct COPCBuffer
+{
+  template<typename T>
+  void write_value(size_t offset, T value)
+  {
+    if (data.size() < offset + sizeof(T)) {
+      data.resize(offset + sizeof(T));
+    }
+    std::memcpy(data.data() + offset, &value, sizeof(T));
+  }
+
+  /**
+   * Writes the 32-byte hierarchy entry with the given index to the page at
+   * 'page_offset'
+   */
+  void write_entry(size_t page_offset,
+                   size_t entry_index,
+                   int32_t level,
+                   int32_t x,
+                   int32_t y,
+                   int32_t z,
+                   uint64_t offset,
+                   int32_t byte_size,
+                   int32_t points_count)
+  {
+    const auto entry_offset = page_offset + entry_index * 32;
+    write_value(entry_offset, level);
+    write_value(entry_offset + 4, x);
+    write_value(entry_offset + 8, y);
+    write_value(entry_offset + 12, z);
+    write_value(entry_offset + 16, offset);
+    write_value(entry_offset + 24, byte_size);
+    write_value(entry_offset + 28, points_count);
+  }
+
+  std::stringstream stream() const
+  {
+    return std::stringstream{ std::string{ std::begin(data), std::end(data) } };
+  }
+
+  std::vector<char> data;
+};
+
+static std::string
+entwine_name(const PointFileNode& node)
+{
+  return OctreeNodeIndex64::to_string(node.index, MortonIndexNamingConvention::Entwine);
+}
+
+SCENARIO("copc::read_info", "[COPCFile]")
+{
+  GIVEN("A LAS header with a COPC info VLR")
+  {
+    COPCBuffer info_data;
+    info_data.write_value(0, 1.0);
+    info_data.write_value(8, 2.0);
+    info_data.write_value(16, 3.0);
+    info_data.write_value(24, 4.0);
+    info_data.write_value(40, uint64_t{ 100 });
+    info_data.write_value(48, uint64_t{ 96 });
+    info_data.data.resize(160);
+
+    laszip_vlr vlrs[2] = {};
+    std::strncpy(vlrs[0].user_id, "LASF_Projection", sizeof(vlrs[0].user_id));
+    vlrs[0].record_id = 1;
+    std::strncpy(vlrs[1].user_id, "copc", sizeof(vlrs[1].user_id));
+    vlrs[1].record_id = 1;
+    vlrs[1].record_length_after_header = 160;
+    vlrs[1].data = reinterpret_cast<laszip_U8*>(info_data.data.data());
+
+    laszip_header header = {};
+    header.number_of_variable_length_records = 2;
+    header.vlrs = vlrs;
+
+    THEN("The info VLR is found and parsed")
+    {
+      REQUIRE(is_copc_file(header));
+      const auto* info_vlr = copc::find_info_vlr(header);
+      REQUIRE(info_vlr == &vlrs[1]);
+
+      const auto info = copc::read_info(*info_vlr, "test.copc.laz");
+      REQUIRE(info.center == Vector3<double>{ 1, 2, 3 });
+      REQUIRE(info.halfsize == 4.0);
+      REQUIRE(info.root_hierarchy_offset == 100);
+      REQUIRE(info.root_hierarchy_size == 96);
+    }
+
+    WHEN("The info VLR is too small")
+    {
+      vlrs[1].record_length_after_header = 48;
+
+      THEN("Reading it fails")
+      {
+        REQUIRE_THROWS(copc::read_info(vlrs[1], "test.copc.laz"));
+      }
+    }
+
+    WHEN("The header has no info VLR")
+    {
+      header.number_of_variable_length_records = 1;
+
+      THEN("The file is no COPC file") { REQUIRE(!is_copc_file(header)); }
+    }
+  }
+}
+
+SCENARIO("copc::read_hierarchy", "[COPCFile]")
+{
+  GIVEN("A root hierarchy page that refers to a child page")
+  {
+    constexpr size_t RootPageOffset = 100;
+    constexpr size_t ChildPageOffset = 300;
+
+    COPCBuffer buffer;
+    buffer.write_entry(RootPageOffset, 0, 0, 0, 0, 0, 5000, 1000, 10);
+    buffer.write_entry(RootPageOffset, 1, 1, 1, 0, 1, ChildPageOffset, 64, -1);
+    buffer.write_entry(RootPageOffset, 2, 1, 0, 0, 0, 4000, 1000, 5);
+    // Nodes without points are not part of the hierarchy
+    buffer.write_entry(RootPageOffset, 3, 1, 1, 1, 1, 0, 0, 0);
+    buffer.write_entry(ChildPageOffset, 0, 1, 1, 0, 1, 6000, 1000, 7);
+    buffer.write_entry(ChildPageOffset, 1, 2, 2, 1, 3, 3000, 1000, 3);
+
+    const copc::Info info{ { 0, 0, 0 }, 8, RootPageOffset, 4 * 32 };
+
+    WHEN("The hierarchy is read")
+    {
+      auto stream = buffer.stream();
+      const auto nodes = copc::read_hierarchy(stream, info, 25, "test.copc.laz");
+
+      THEN("The nodes of both pages are read in the order of their chunks")
+      {
+        REQUIRE(nodes.size() == 4);
+        REQUIRE(entwine_name(nodes[0]) == "2-2-1-3");
+        REQUIRE(entwine_name(nodes[1]) == "1-0-0-0");
+        REQUIRE(entwine_name(nodes[2]) == "0-0-0-0");
+        REQUIRE(entwine_name(nodes[3]) == "1-1-0-1");
+      }
+
+      THEN("The first point of each node follows from the offsets of the chunks")
+      {
+        REQUIRE(nodes[0].points_count == 3);
+        REQUIRE(nodes[0].first_point == 0);
+        REQUIRE(nodes[1].points_count == 5);
+        REQUIRE(nodes[1].first_point == 3);
+        REQUIRE(nodes[2].points_count == 10);
+        REQUIRE(nodes[2].first_point == 8);
+        REQUIRE(nodes[3].points_count == 7);
+        REQUIRE(nodes[3].first_point == 18);
+      }
+    }
+
+    WHEN("The file contains a different number of points than the hierarchy")
+    {
+      auto stream = buffer.stream();
+
+      THEN("Reading the hierarchy fails")
+      {
+        REQUIRE_THROWS(copc::read_hierarchy(stream, info, 24, "test.copc.laz"));
+      }
+    }
+
+    WHEN("A page has a size that is no multiple of the entry size")
+    {
+      buffer.write_entry(RootPageOffset, 1, 1, 1, 0, 1, ChildPageOffset, 48, -1);
+      auto stream = buffer.stream();
+
+      THEN("Reading the hierarchy fails")
+      {
+        REQUIRE_THROWS(copc::read_hierarchy(stream, info, 25, "test.copc.laz"));
+      }
+    }
+  }
+}
@@ -0,0 +1,70 @@
+#include <catch2/catch_all.hpp>
+
+#include "tiling/ClassificationPartitioning.h"
+#include "tiling/OctreeAlgorithms.h"
+
+SCENARIO("ClassificationPartitioning", "[ClassificationPartitioning]")
+{
+  GIVEN("Invalid classification groups")
+  {
+    THEN("Construction fails")
+    {
+      REQUIRE_THROWS(ClassificationPartitioning{ {} });
+      REQUIRE_THROWS(ClassificationPartitioning{ { { "a", { 2 } }, { "b", { 2, 3 } } } });
+      REQUIRE_THROWS(ClassificationPartitioning{ { { "a", {} }, { "b", {} } } });
+    }
+  }
+
+  GIVEN("The default classification groups")
+  {
+    const ClassificationPartitioning partitioning{ default_classification_groups() };
+
+    THEN("Each classification maps to the correct group")
+    {
+      REQUIRE(partitioning.group_of(uint8_t{ 2 }) == 0);
+      REQUIRE(partitioning.group_of(uint8_t{ 5 }) == 1);
+      REQUIRE(partitioning.group_of(uint8_t{ 6 }) == 2);
+      REQUIRE(partitioning.group_of(uint8_t{ 9 }) == 3);
+      REQUIRE(partitioning.group_of(uint8_t{ 0 }) == 4);
+      REQUIRE(partitioning.group_of(uint8_t{ 17 }) == 4);
+    }
+
+    WHEN("A range of Morton-sorted points is partitioned")
+    {
+      const size_t count = 64;
+      std::vector<Vector3<double>> positions;
+      std::vector<uint8_t> classifications;
+      for (size_t idx = 0; idx < count; ++idx) {
+        positions.push_back({ static_cast<double>(idx), static_cast<double>(idx % 7), 0 });
+        classifications.push_back(static_cast<uint8_t>(idx % 10));
+      }
+      PointBuffer points{ count, std::move(positions), {}, {}, {}, std::move(classifications) };
+
+      const AABB bounds{ { 0, 0, 0 }, { 64, 64, 64 } };
+      std::vector<IndexedPoint64> indexed_points;
+      index_points<MortonIndex64Levels>(std::begin(points),
+                                        std::end(points),
+                                        std::back_inserter(indexed_points),
+                                        bounds,
+                                        OutlierPointsBehaviour::ClampToBounds);
+      std::sort(std::begin(indexed_points), std::end(indexed_points));
+
+      const auto groups = partitioning.partition(util::range(indexed_points));
+
+      THEN("Each group range contains only points of this group in Morton order")
+      {
+        REQUIRE(groups.size() == partitioning.size());
+
+        size_t total_points = 0;
+        for (uint32_t group = 0; group < groups.size(); ++group) {
+          total_points += groups[group].size();
+          for (const auto& point : groups[group]) {
+            REQUIRE(partitioning.group_of(point) == group);
+          }
+          REQUIRE(std::is_sorted(std::begin(groups[group]), std::end(groups[group])));
+        }
+        REQUIRE(total_points == count);
+      }
+    }
+  }
+}
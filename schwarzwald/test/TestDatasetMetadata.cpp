@@ -0,0 +1,65 @@
+#include <catch2/catch_all.hpp>
+
+#include "pointcloud/FileStats.h"
+#include "tiling/OctreeAlgorithms.h"
+
+SCENARIO("DatasetMetadata", "[DatasetMetadata]")
+{
+  GIVEN("A flat dataset")
+  {
+    DatasetMetadata dataset_metadata;
+    dataset_metadata.add_file_metadata(
+      "a.las", 100, AABB{ { 0, 0, 10 }, { 1000, 500, 15 } }, 20, false);
+    dataset_metadata.add_file_metadata(
+      "b.las", 100, AABB{ { 0, 500, 12 }, { 1000, 1000, 20 } }, 20, false);
+
+    THEN("The cubic bounds are centered on all axes")
+    {
+      const auto& cubic_bounds = dataset_metadata.total_bounds_cubic();
+      REQUIRE(cubic_bounds.min == Vector3<double>{ 0, 0, -485 });
+      REQUIRE(cubic_bounds.max == Vector3<double>{ 1000, 1000, 515 });
+      REQUIRE(dataset_metadata.quadtree_levels() == 0);
+    }
+
+    WHEN("Quadtree levels are used")
+    {
+      dataset_metadata.use_quadtree_levels();
+
+      THEN("The cubic bounds start at the bottom of the dataset")
+      {
+        const auto& cubic_bounds = dataset_metadata.total_bounds_cubic();
+        REQUIRE(cubic_bounds.min == Vector3<double>{ 0, 0, 10 });
+        REQUIRE(cubic_bounds.max == Vector3<double>{ 1000, 1000, 1010 });
+        REQUIRE(dataset_metadata.total_bounds_tight().min.z == 10);
+        REQUIRE(dataset_metadata.total_bounds_tight().max.z == 20);
+      }
+
+      THEN("The top levels don't subdivide Z")
+      {
+        // log2(1000 / 10)
+        REQUIRE(dataset_metadata.quadtree_levels() == 6);
+
+        const auto& cubic_bounds = dataset_metadata.total_bounds_cubic();
+        const auto top = calculate_morton_index<21>({ 1000, 1000, 20 }, cubic_bounds);
+        const auto bottom = calculate_morton_index<21>({ 0, 0, 10 }, cubic_bounds);
+        for (uint32_t level = 0; level < dataset_metadata.quadtree_levels(); ++level) {
+          REQUIRE((top.get_octant_at_level(level) & 1) == 0);
+          REQUIRE((bottom.get_octant_at_level(level) & 1) == 0);
+        }
+      }
+    }
+
+    WHEN("Quadtree levels are used and more files are added")
+    {
+      dataset_metadata.use_quadtree_levels();
+      dataset_metadata.add_file_metadata(
+        "c.las", 100, AABB{ { 0, 0, 5 }, { 1000, 1000, 10 } }, 20, false);
+
+      THEN("The cubic bounds still start at the bottom of the dataset")
+      {
+        REQUIRE(dataset_metadata.total_bounds_cubic().min.z == 5);
+        REQUIRE(dataset_metadata.total_bounds_cubic().max.z == 1005);
+      }
+    }
+  }
+}
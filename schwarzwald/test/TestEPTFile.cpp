@@ -0,0 +1,169 @@
+#include <catch2/catch_all.hpp>
+
+#include "io/EPTFile.h"
+#include "io/LASPersistence.h"
+#include "io/PointcloudFactory.h"
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+
+static void
+write_file(const fs::path& file_path, const std::string& content)
+{
+  std::ofstream stream{ file_path };
+  stream << content;
+}
+
+/**
+ * Writes an EPT dataset with four nodes to the given directory. The hierarchy
+ * is split into two pages, the node 1-1-1-1 and its child are listed in the
+ * page of 1-1-1-1. Returns the points of the nodes in depth-first order
+ */
+static PointBuffer
+write_ept_dataset(const fs::path& directory, const PointAttributes& attributes)
+{
+  fs::create_directories(directory / "ept-data");
+  fs::create_directories(directory / "ept-hierarchy");
+
+  write_file(directory / "ept.json",
+             R"({"bounds":[0,0,0,8,8,8],"boundsConforming":[0,0,0,8,8,8],)"
+             R"("dataType":"laszip","hierarchyType":"json","points":10})");
+  write_file(directory / "ept-hierarchy" / "0-0-0-0.json",
+             R"({"0-0-0-0":4,"1-0-0-0":3,"1-1-1-1":-1})");
+  write_file(directory / "ept-hierarchy" / "1-1-1-1.json", R"({"1-1-1-1":2,"2-3-3-3":1})");
+
+  const AABB root_bounds{ { 0, 0, 0 }, { 8, 8, 8 } };
+  LASPersistence persistence{
+    (directory / "ept-data").string(), attributes, attributes, Compressed::Yes
+  };
+  const auto write_node = [&](const std::string& node_name,
+                              std::vector<Vector3<double>> positions) {
+    const auto count = positions.size();
+    persistence.persist_points(PointBuffer{ count, std::move(positions) }, root_bounds, node_name);
+  };
+  write_node("0-0-0-0", { { 1, 1, 1 }, { 2, 6, 2 }, { 5, 3, 7 }, { 7, 7, 1 } });
+  write_node("1-0-0-0", { { 0.5, 0.5, 0.5 }, { 1.5, 2.5, 3.5 }, { 3, 1, 2 } });
+  write_node("1-1-1-1", { { 4.5, 4.5, 4.5 }, { 5.5, 6.5, 5 } });
+  write_node("2-3-3-3", { { 7, 7.5, 6.5 } });
+
+  std::vector<Vector3<double>> positions{ { 1, 1, 1 },       { 2, 6, 2 },       { 5, 3, 7 },
+                                          { 7, 7, 1 },       { 0.5, 0.5, 0.5 }, { 1.5, 2.5, 3.5 },
+                                          { 3, 1, 2 },       { 4.5, 4.5, 4.5 }, { 5.5, 6.5, 5 },
+                                          { 7, 7.5, 6.5 } };
+  const auto count = positions.size();
+  return { count, std::move(positions) };
+}
+
+SCENARIO("EPTFile", "[EPTFile]")
+{
+  const fs::path directory = "./_ept_file_test_";
+  fs::remove_all(directory);
+
+  PointAttributes attributes;
+  attributes.insert(PointAttribute::Position);
+
+  GIVEN("An EPT dataset with a hierarchy that spans two pages")
+  {
+    const auto dataset_directory = directory / "dataset";
+    const auto expected_points = write_ept_dataset(dataset_directory, attributes);
+
+    WHEN("The dataset is opened")
+    {
+      EPTFile file{ dataset_directory / "ept.json" };
+
+      THEN("The nodes of all hierarchy pages are read in depth-first order")
+      {
+        const auto& nodes = file.get_metadata().nodes;
+        REQUIRE(nodes.size() == 4);
+        REQUIRE(nodes[0].index == OctreeNodeIndex64{});
+        REQUIRE(nodes[1].index == OctreeNodeIndex64{ 0 });
+        REQUIRE(nodes[2].index == OctreeNodeIndex64{ 7 });
+        REQUIRE(nodes[3].index == (OctreeNodeIndex64{ 7, 7 }));
+        REQUIRE(nodes[2].points_count == 2);
+        REQUIRE(nodes[3].points_count == 1);
+        REQUIRE(pc::get_point_count(file) == 10);
+      }
+
+      THEN("The begin and end iterators span the points of all nodes")
+      {
+        const auto begin = std::cbegin(file);
+        const auto end = std::cend(file);
+        REQUIRE(begin.distance_to_end() == 10);
+        REQUIRE(std::distance(begin, end) == 10);
+      }
+
+      THEN("The exact bounds are the bounds of the points, not the conforming bounds")
+      {
+        AABB points_bounds;
+        for (const auto& position : expected_points.positions()) {
+          points_bounds.update(position);
+        }
+        const auto exact_bounds = pc::get_exact_bounds(file);
+        REQUIRE(exact_bounds.min.distanceTo(points_bounds.min) <= 0.001);
+        REQUIRE(exact_bounds.max.distanceTo(points_bounds.max) <= 0.001);
+        REQUIRE(exact_bounds.max.y < file.conforming_bounds().max.y);
+      }
+
+      THEN("Reading the node files in parallel yields the same exact bounds")
+      {
+        AABB parallel_bounds;
+        tf::Taskflow taskflow;
+        taskflow.emplace([&file, &parallel_bounds](tf::Subflow& subflow) {
+          parallel_bounds = ept_exact_bounds(file, subflow);
+        });
+        tf::Executor executor{ 2 };
+        executor.run(taskflow).wait();
+
+        const auto serial_bounds = ept_exact_bounds(file);
+        REQUIRE(parallel_bounds.min == serial_bounds.min);
+        REQUIRE(parallel_bounds.max == serial_bounds.max);
+      }
+
+      WHEN("All points are read")
+      {
+        PointBuffer actual_points;
+        const auto end =
+          pc::read_points(std::cbegin(file), 10, pc::metadata(file), attributes, actual_points);
+
+        THEN("The points are read node by node across the node files")
+        {
+          REQUIRE(end == std::cend(file));
+          REQUIRE(actual_points.count() == expected_points.count());
+          for (size_t idx = 0; idx < expected_points.count(); ++idx) {
+            const auto distance =
+              actual_points.positions()[idx].distanceTo(expected_points.positions()[idx]);
+            REQUIRE(distance <= 0.001);
+          }
+        }
+      }
+    }
+
+    WHEN("The source files of a directory with the dataset are found")
+    {
+      write_file(directory / "other.las", "points");
+      auto source_files = find_source_files_in_directory(directory);
+      std::sort(std::begin(source_files), std::end(source_files));
+
+      THEN("The dataset is a single source and its node files are skipped")
+      {
+        REQUIRE(source_files.size() == 2);
+        REQUIRE(source_files[0] == dataset_directory / "ept.json");
+        REQUIRE(source_files[1] == directory / "other.las");
+      }
+    }
+
+    WHEN("The source files of the dataset directory itself are found")
+    {
+      const auto source_files = find_source_files_in_directory(dataset_directory);
+
+      THEN("Only the ept.json file is a source")
+      {
+        REQUIRE(source_files.size() == 1);
+        REQUIRE(source_files[0] == dataset_directory / "ept.json");
+      }
+    }
+  }
+
+  fs::remove_all(directory);
+}
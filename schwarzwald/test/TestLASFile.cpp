@@ -2,8 +2,10 @@
 
 #include "io/LASFile.h"
 #include "io/LASPersistence.h"
+#include "pointcloud/ExactBounds.h"
 
 #include <boost/scope_exit.hpp>
+#include <fstream>
 #include <random>
 #include <sstream>
 
@@ -249,6 +251,17 @@ SCENARIO("LASFile in read-mode")
       REQUIRE(pc::get_point_count(file) == count);
     }
 
+    THEN("The exact bounds are the bounds of the points")
+    {
+      AABB points_bounds;
+      for (const auto& position : expected_points.positions()) {
+        points_bounds.update(position);
+      }
+      const auto exact_bounds = pc::get_exact_bounds(file);
+      REQUIRE(exact_bounds.min.distanceTo(points_bounds.min) <= 0.001);
+      REQUIRE(exact_bounds.max.distanceTo(points_bounds.max) <= 0.001);
+    }
+
     THEN("The begin and end iterators point to a correct range")
     {
       const auto begin = std::cbegin(file);
@@ -272,6 +285,65 @@ SCENARIO("LASFile in read-mode")
   }
 }
 
+SCENARIO("Caching exact bounds")
+{
+  fs::path file_path = "./tmp_testexactbounds.las";
+  fs::path cache_directory = "./_exact_bounds_cache_";
+  {
+    std::ofstream file{ file_path };
+    file << "points";
+  }
+  const AABB bounds{ { 1, 2, 3 }, { 4, 5, 6 } };
+
+  BOOST_SCOPE_EXIT(&file_path, &cache_directory)
+  {
+    fs::remove(file_path);
+    fs::remove_all(cache_directory);
+  }
+  BOOST_SCOPE_EXIT_END
+
+  WHEN("The exact bounds are cached")
+  {
+    write_cached_exact_bounds(cache_directory, file_path, bounds);
+
+    THEN("The cached bounds can be read from the cache directory")
+    {
+      const auto cache_path = exact_bounds_cache_path(cache_directory, file_path);
+      REQUIRE(cache_path.parent_path() == cache_directory);
+      REQUIRE(fs::is_regular_file(cache_path));
+      REQUIRE(read_cached_exact_bounds(cache_directory, file_path) == bounds);
+    }
+
+    THEN("Nothing is written next to the file")
+    {
+      size_t files_count = 0;
+      for (const auto& entry : fs::directory_iterator{ fs::current_path() }) {
+        if (entry.path().filename().string().find("tmp_testexactbounds") != std::string::npos)
+          ++files_count;
+      }
+      REQUIRE(files_count == 1);
+    }
+
+    THEN("The bounds are not cached for another file")
+    {
+      REQUIRE(!read_cached_exact_bounds(cache_directory, "./tmp_otherexactbounds.las"));
+    }
+
+    WHEN("The file is modified")
+    {
+      {
+        std::ofstream file{ file_path, std::ios::app };
+        file << " and more points";
+      }
+
+      THEN("The cached bounds are invalid")
+      {
+        REQUIRE(!read_cached_exact_bounds(cache_directory, file_path));
+      }
+    }
+  }
+}
+
 SCENARIO("LASFile in write-mode")
 {
   const size_t count = 1024;
@@ -0,0 +1,81 @@
+#include <catch2/catch_all.hpp>
+
+#include "io/MeshoptVertexCodec.h"
+
+#include <random>
+#include <vector>
+
+static std::vector<std::byte>
+make_vertices(size_t count, size_t vertex_size)
+{
+  // Slowly changing bytes with some noise, similar to Morton-ordered attributes
+  std::mt19937 rng{ 42 };
+  std::vector<std::byte> vertices(count * vertex_size);
+  for (size_t idx = 0; idx < vertices.size(); ++idx) {
+    const auto vertex = idx / vertex_size;
+    const auto byte = idx % vertex_size;
+    vertices[idx] = static_cast<std::byte>(vertex * (byte + 1) + rng() % (byte + 1));
+  }
+  return vertices;
+}
+
+SCENARIO("Meshopt vertex codec", "[MeshoptVertexCodec]")
+{
+  GIVEN("Vertex buffers of different sizes")
+  {
+    for (size_t vertex_size : { 4u, 8u, 12u, 36u }) {
+      for (size_t count : { 0u, 1u, 16u, 17u, 256u, 1000u }) {
+        const auto vertices = make_vertices(count, vertex_size);
+
+        WHEN("The vertices are encoded and decoded")
+        {
+          const auto encoded = encode_vertex_buffer(vertices, vertex_size);
+          const auto decoded = decode_vertex_buffer(encoded, count, vertex_size);
+
+          THEN("The decoded vertices are identical")
+          {
+            REQUIRE(decoded == vertices);
+          }
+        }
+      }
+    }
+  }
+
+  GIVEN("A constant vertex buffer")
+  {
+    const std::vector<std::byte> vertices(4096 * 8, std::byte{ 17 });
+
+    WHEN("The vertices are encoded")
+    {
+      const auto encoded = encode_vertex_buffer(vertices, 8);
+
+      THEN("The encoded buffer is much smaller")
+      {
+        REQUIRE(encoded.size() < vertices.size() / 10);
+        REQUIRE(decode_vertex_buffer(encoded, 4096, 8) == vertices);
+      }
+    }
+  }
+
+  GIVEN("A truncated buffer")
+  {
+    const auto vertices = make_vertices(100, 8);
+    auto encoded = encode_vertex_buffer(vertices, 8);
+    encoded.resize(encoded.size() / 2);
+
+    THEN("Decoding fails")
+    {
+      REQUIRE_THROWS(decode_vertex_buffer(encoded, 100, 8));
+    }
+  }
+
+  GIVEN("An invalid vertex size")
+  {
+    const auto vertices = make_vertices(4, 6);
+
+    THEN("Encoding fails")
+    {
+      REQUIRE_THROWS(encode_vertex_buffer(vertices, 6));
+    }
+  }
+}
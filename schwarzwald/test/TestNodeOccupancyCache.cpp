@@ -0,0 +1,93 @@
+#include <catch2/catch_all.hpp>
+
+#include "tiling/TilingAlgorithms.h"
+
+#include <boost/units/systems/information/byte.hpp>
+
+static octree::NodeStructure
+make_node(const std::string& name)
+{
+  octree::NodeStructure node;
+  node.name = name;
+  return node;
+}
+
+static NodeOccupancy
+make_occupancy(size_t occupied_cells_count)
+{
+  NodeOccupancy occupancy;
+  occupancy.occupied_cells.resize(occupied_cells_count);
+  occupancy.occupied_cells.shrink_to_fit();
+  return occupancy;
+}
+
+SCENARIO("NodeOccupancyCache", "[NodeOccupancyCache]")
+{
+  NodeOccupancyCache cache;
+  const auto occupancy_bytes = make_occupancy(100).content_byte_size();
+
+  GIVEN("A memory budget that fits two occupancies")
+  {
+    cache.set_memory_budget(static_cast<double>(2 * occupancy_bytes) *
+                            boost::units::information::bytes);
+    cache.emplace_occupancy(make_node("r0"), make_occupancy(100));
+    cache.emplace_occupancy(make_node("r1"), make_occupancy(100));
+
+    WHEN("The first occupancy is used and a third one is added")
+    {
+      REQUIRE(cache.find_occupancy(make_node("r0")));
+      cache.emplace_occupancy(make_node("r2"), make_occupancy(100));
+
+      THEN("The least recently used occupancy is dropped")
+      {
+        REQUIRE(cache.byte_size() == 2 * occupancy_bytes);
+        REQUIRE(cache.find_occupancy(make_node("r0")));
+        REQUIRE(!cache.find_occupancy(make_node("r1")));
+        REQUIRE(cache.find_occupancy(make_node("r2")));
+      }
+    }
+
+    WHEN("An occupancy grows while it is used")
+    {
+      const auto occupancy = cache.find_occupancy(make_node("r0"));
+      occupancy->occupied_cells.resize(200);
+      occupancy->occupied_cells.shrink_to_fit();
+
+      THEN("Its new size is counted and the other occupancy is dropped on the next lookup")
+      {
+        REQUIRE(cache.byte_size() == 2 * occupancy_bytes);
+        REQUIRE(cache.find_occupancy(make_node("r0")));
+        REQUIRE(cache.byte_size() == 2 * occupancy_bytes);
+        REQUIRE(!cache.find_occupancy(make_node("r1")));
+      }
+    }
+
+    WHEN("The budget shrinks while an occupancy is in use")
+    {
+      const auto occupancy = cache.find_occupancy(make_node("r0"));
+      cache.set_memory_budget(0.0 * boost::units::information::bytes);
+
+      THEN("All occupancies are dropped, but the one in use stays valid")
+      {
+        REQUIRE(cache.byte_size() == 0);
+        REQUIRE(!cache.find_occupancy(make_node("r0")));
+        REQUIRE(occupancy->occupied_cells.size() == 100);
+      }
+    }
+  }
+
+  GIVEN("No memory budget")
+  {
+    for (size_t idx = 0; idx < 16; ++idx) {
+      cache.emplace_occupancy(make_node("r" + std::to_string(idx)), make_occupancy(100));
+    }
+
+    THEN("All occupancies are kept until the cache is cleared")
+    {
+      REQUIRE(cache.byte_size() == 16 * occupancy_bytes);
+      cache.clear();
+      REQUIRE(cache.byte_size() == 0);
+      REQUIRE(!cache.find_occupancy(make_node("r0")));
+    }
+  }
+}
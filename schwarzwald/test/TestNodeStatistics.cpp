@@ -0,0 +1,131 @@
+#include <catch2/catch_all.hpp>
+
+#include "datastructures/PointBuffer.h"
+#include "io/PNTSWriter.h"
+#include "pointcloud/NodeStatistics.h"
+
+SCENARIO("compute_node_statistics", "[NodeStatistics]")
+{
+  GIVEN("Points with intensities and classifications")
+  {
+    std::vector<Vector3<double>> positions = { { 0, 0, 0 }, { 1, 0, 0 }, { 2, 0, 0 } };
+    std::vector<uint16_t> intensities = { 30, 10, 20 };
+    std::vector<uint8_t> classifications = { 6, 2, 2 };
+    PointBuffer points{ positions.size(), positions, {}, {}, intensities, classifications };
+
+    WHEN("The statistics are computed for all attributes")
+    {
+      const auto statistics = compute_node_statistics(
+        std::begin(points),
+        std::end(points),
+        { PointAttribute::Position, PointAttribute::Intensity, PointAttribute::Classification });
+
+      THEN("The intensity range is correct")
+      {
+        REQUIRE(statistics.intensity);
+        REQUIRE(statistics.intensity->min == 10);
+        REQUIRE(statistics.intensity->max == 30);
+      }
+      THEN("The classification histogram contains all classes")
+      {
+        REQUIRE(statistics.classification_histogram.size() == 2);
+        REQUIRE(statistics.classification_histogram[0].classification == 2);
+        REQUIRE(statistics.classification_histogram[0].count == 2);
+        REQUIRE(statistics.classification_histogram[1].classification == 6);
+        REQUIRE(statistics.classification_histogram[1].count == 1);
+      }
+      THEN("There are no statistics for missing attributes")
+      {
+        REQUIRE(!statistics.gps_time);
+      }
+    }
+
+    WHEN("The statistics are computed without the classification attribute")
+    {
+      const auto statistics = compute_node_statistics(
+        std::begin(points),
+        std::end(points),
+        { PointAttribute::Position, PointAttribute::Intensity });
+
+      THEN("There is no classification histogram")
+      {
+        REQUIRE(statistics.classification_histogram.empty());
+      }
+    }
+  }
+}
+
+SCENARIO("Statistics of written .pnts files", "[NodeStatistics]")
+{
+  GIVEN("Points with intensities and classifications")
+  {
+    std::vector<Vector3<double>> positions = { { 0, 0, 0 }, { 1, 0, 0 }, { 2, 0, 0 } };
+    std::vector<uint16_t> intensities = { 30, 10, 20 };
+    std::vector<uint8_t> classifications = { 6, 2, 2 };
+    PointBuffer points{ positions.size(), positions, {}, {}, intensities, classifications };
+    const PointAttributes attributes = { PointAttribute::Position,
+                                         PointAttribute::Intensity,
+                                         PointAttribute::Classification };
+
+    WHEN("The points are written by a PNTSWriter, partly as point references")
+    {
+      PNTSWriter writer{ "./_node_statistics_test_.pnts", attributes, RGBMapping::None };
+      writer.write_points(points);
+      std::vector<PointBuffer::PointReference> point_references(std::begin(points),
+                                                                std::end(points));
+      writer.write_points(gsl::make_span(point_references).subspan(1));
+      const auto statistics = writer.statistics();
+
+      THEN("The writer accumulated the statistics of all written attributes")
+      {
+        REQUIRE(statistics.intensity);
+        REQUIRE(statistics.intensity->min == 10);
+        REQUIRE(statistics.intensity->max == 30);
+        REQUIRE(statistics.classification_histogram.size() == 2);
+        REQUIRE(statistics.classification_histogram[0].classification == 2);
+        REQUIRE(statistics.classification_histogram[0].count == 4);
+        REQUIRE(statistics.classification_histogram[1].classification == 6);
+        REQUIRE(statistics.classification_histogram[1].count == 1);
+      }
+    }
+  }
+}
+
+SCENARIO("NodeStatistics::merge", "[NodeStatistics]")
+{
+  GIVEN("Two node statistics with overlapping classifications")
+  {
+    NodeStatistics first;
+    first.intensity = AttributeRange<uint16_t>{ 10, 20 };
+    first.classification_histogram = { { 1, 5 }, { 2, 3 } };
+
+    NodeStatistics second;
+    second.intensity = AttributeRange<uint16_t>{ 5, 15 };
+    second.gps_time = AttributeRange<double>{ 1.0, 2.0 };
+    second.classification_histogram = { { 2, 4 }, { 7, 1 } };
+
+    WHEN("They are merged")
+    {
+      first.merge(second);
+
+      THEN("The ranges are combined")
+      {
+        REQUIRE(first.intensity->min == 5);
+        REQUIRE(first.intensity->max == 20);
+        REQUIRE(first.gps_time);
+        REQUIRE(first.gps_time->min == 1.0);
+        REQUIRE(first.gps_time->max == 2.0);
+      }
+      THEN("The histograms are summed up and stay sorted")
+      {
+        REQUIRE(first.classification_histogram.size() == 3);
+        REQUIRE(first.classification_histogram[0].classification == 1);
+        REQUIRE(first.classification_histogram[0].count == 5);
+        REQUIRE(first.classification_histogram[1].classification == 2);
+        REQUIRE(first.classification_histogram[1].count == 7);
+        REQUIRE(first.classification_histogram[2].classification == 7);
+        REQUIRE(first.classification_histogram[2].count == 1);
+      }
+    }
+  }
+}
@@ -0,0 +1,114 @@
+#include <catch2/catch_all.hpp>
+
+#include "tiling/NormalEstimation.h"
+#include "tiling/OctreeAlgorithms.h"
+
+using V3 = Vector3<double>;
+
+static PointBuffer
+sample_plane(const V3& origin, const V3& axis1, const V3& axis2, size_t count_per_axis)
+{
+  std::vector<V3> positions;
+  positions.reserve(count_per_axis * count_per_axis);
+  for (size_t u = 0; u < count_per_axis; ++u) {
+    for (size_t v = 0; v < count_per_axis; ++v) {
+      const auto fu = static_cast<double>(u) / count_per_axis;
+      const auto fv = static_cast<double>(v) / count_per_axis;
+      positions.push_back(origin + V3{ axis1.x * fu, axis1.y * fu, axis1.z * fu } +
+                          V3{ axis2.x * fv, axis2.y * fv, axis2.z * fv });
+    }
+  }
+  const auto count = positions.size();
+  return { count, std::move(positions), {}, std::vector<Vector3<float>>(count) };
+}
+
+static std::vector<IndexedPoint64>
+index_and_sort(PointBuffer& points, const AABB& bounds)
+{
+  std::vector<IndexedPoint64> indexed_points;
+  indexed_points.reserve(points.count());
+  index_points<MortonIndex64Levels>(std::begin(points),
+                                    std::end(points),
+                                    std::back_inserter(indexed_points),
+                                    bounds,
+                                    OutlierPointsBehaviour::ClampToBounds);
+  std::sort(std::begin(indexed_points), std::end(indexed_points));
+  return indexed_points;
+}
+
+SCENARIO("estimate_normal_from_points", "[NormalEstimation]")
+{
+  WHEN("Less than three points are given")
+  {
+    std::vector<V3> points = { { 0, 0, 0 }, { 1, 0, 0 } };
+    THEN("The default normal is returned")
+    {
+      REQUIRE(estimate_normal_from_points(points) == Vector3<float>{ 0, 0, 1 });
+    }
+  }
+
+  WHEN("The points lie in the XZ plane")
+  {
+    std::vector<V3> points = { { 0, 0, 0 }, { 1, 0, 0 }, { 0, 0, 1 }, { 1, 0, 1 }, { 0.5, 0, 2 } };
+    const auto normal = estimate_normal_from_points(points);
+    THEN("The normal points along the Y axis")
+    {
+      REQUIRE(std::abs(normal.x) == Catch::Approx(0).margin(1e-5));
+      REQUIRE(std::abs(normal.y) == Catch::Approx(1).margin(1e-5));
+      REQUIRE(std::abs(normal.z) == Catch::Approx(0).margin(1e-5));
+    }
+  }
+
+  WHEN("The points lie in a plane facing downwards")
+  {
+    std::vector<V3> points = { { 0, 0, 0 }, { 1, 0, -1 }, { 0, 1, 0 }, { 1, 1, -1 } };
+    const auto normal = estimate_normal_from_points(points);
+    THEN("The normal is oriented towards positive Z")
+    {
+      const auto expected = static_cast<float>(1 / std::sqrt(2.0));
+      REQUIRE(normal.x == Catch::Approx(expected).margin(1e-5));
+      REQUIRE(normal.y == Catch::Approx(0).margin(1e-5));
+      REQUIRE(normal.z == Catch::Approx(expected).margin(1e-5));
+    }
+  }
+}
+
+SCENARIO("estimate_normals", "[NormalEstimation]")
+{
+  GIVEN("Points sampled from a tilted plane")
+  {
+    auto points = sample_plane({ 0, 0, 0 }, { 10, 0, 5 }, { 0, 10, 0 }, 64);
+    const AABB bounds{ { 0, 0, 0 }, { 10, 10, 10 } };
+    auto indexed_points = index_and_sort(points, bounds);
+
+    WHEN("Normals are estimated")
+    {
+      estimate_normals(util::range(indexed_points), util::range(indexed_points), {});
+
+      THEN("All normals are perpendicular to the plane")
+      {
+        const auto expected_x = static_cast<float>(-1 / std::sqrt(5.0));
+        const auto expected_z = static_cast<float>(2 / std::sqrt(5.0));
+        for (const auto& normal : points.normals()) {
+          REQUIRE(normal.x == Catch::Approx(expected_x).margin(1e-3));
+          REQUIRE(normal.y == Catch::Approx(0).margin(1e-3));
+          REQUIRE(normal.z == Catch::Approx(expected_z).margin(1e-3));
+        }
+      }
+    }
+  }
+
+  GIVEN("Points without normals")
+  {
+    std::vector<V3> positions = { { 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 }, { 1, 1, 0 } };
+    PointBuffer points{ positions.size(), positions };
+    auto indexed_points = index_and_sort(points, { { 0, 0, 0 }, { 1, 1, 1 } });
+
+    THEN("Estimating normals does nothing")
+    {
+      REQUIRE_NOTHROW(
+        estimate_normals(util::range(indexed_points), util::range(indexed_points), {}));
+      REQUIRE(!points.hasNormals());
+    }
+  }
+}
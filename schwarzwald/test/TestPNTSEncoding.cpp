@@ -0,0 +1,213 @@
+#include <catch2/catch_all.hpp>
+
+#include "io/PNTSEncoding.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+SCENARIO("Quantized positions", "[PNTSEncoding]")
+{
+  GIVEN("Positions in a non-cubic volume")
+  {
+    std::vector<Vector3<double>> positions = {
+      { -10.0, 2.0, 100.0 }, { 30.0, 2.5, 100.0 }, { 5.123, 2.25, 100.0 }, { 12.0, 2.1, 100.0 }
+    };
+
+    WHEN("The positions are quantized and dequantized")
+    {
+      const auto volume = quantized_volume_for(positions);
+
+      std::vector<QuantizedPosition> quantized_positions(positions.size());
+      quantize_positions(positions, volume, quantized_positions);
+
+      std::vector<Vector3<double>> decoded_positions(positions.size());
+      dequantize_positions(quantized_positions, volume, decoded_positions);
+
+      THEN("The volume tightly encloses the positions")
+      {
+        REQUIRE(volume.offset.x == -10.0);
+        REQUIRE(volume.offset.y == 2.0);
+        REQUIRE(volume.offset.z == 100.0);
+        REQUIRE(volume.scale.x == 40.0);
+        REQUIRE(volume.scale.y == 0.5);
+        REQUIRE(volume.scale.z == 0.0);
+      }
+      THEN("The extreme positions map to the ends of the quantized range")
+      {
+        REQUIRE(quantized_positions[0].x == 0);
+        REQUIRE(quantized_positions[1].x == 65535);
+        REQUIRE(quantized_positions[1].y == 65535);
+      }
+      THEN("The decoded positions are within half a quantization step")
+      {
+        for (size_t idx = 0; idx < positions.size(); ++idx) {
+          REQUIRE(std::abs(decoded_positions[idx].x - positions[idx].x) <= 40.0 / 65535 / 2);
+          REQUIRE(std::abs(decoded_positions[idx].y - positions[idx].y) <= 0.5 / 65535 / 2);
+          REQUIRE(decoded_positions[idx].z == 100.0);
+        }
+      }
+    }
+  }
+}
+
+SCENARIO("RGB565 colors", "[PNTSEncoding]")
+{
+  GIVEN("Some colors")
+  {
+    std::vector<Vector3<uint8_t>> colors = {
+      { 0, 0, 0 }, { 255, 255, 255 }, { 255, 0, 0 }, { 0, 255, 0 }, { 0, 0, 255 }, { 100, 150, 200 }
+    };
+
+    WHEN("The colors are encoded and decoded")
+    {
+      std::vector<uint16_t> encoded_colors(colors.size());
+      encode_rgb565(colors, encoded_colors);
+
+      std::vector<Vector3<uint8_t>> decoded_colors(colors.size());
+      decode_rgb565(encoded_colors, decoded_colors);
+
+      THEN("The encoding matches the bit layout of RGB565")
+      {
+        REQUIRE(encoded_colors[0] == 0x0000);
+        REQUIRE(encoded_colors[1] == 0xFFFF);
+        REQUIRE(encoded_colors[2] == 0xF800);
+        REQUIRE(encoded_colors[3] == 0x07E0);
+        REQUIRE(encoded_colors[4] == 0x001F);
+      }
+      THEN("The decoded colors are close to the original colors")
+      {
+        for (size_t idx = 0; idx < colors.size(); ++idx) {
+          REQUIRE(std::abs(decoded_colors[idx].x - colors[idx].x) < 8);
+          REQUIRE(std::abs(decoded_colors[idx].y - colors[idx].y) < 4);
+          REQUIRE(std::abs(decoded_colors[idx].z - colors[idx].z) < 8);
+        }
+      }
+    }
+  }
+}
+
+SCENARIO("Oct-encoded normals", "[PNTSEncoding]")
+{
+  GIVEN("Unit normals in both hemispheres")
+  {
+    std::vector<Vector3<float>> normals = { { 0, 0, 1 },
+                                            { 0, 0, -1 },
+                                            { 1, 0, 0 },
+                                            { 0, -1, 0 },
+                                            { 0.48f, 0.6f, 0.64f },
+                                            { -0.48f, 0.6f, -0.64f } };
+
+    WHEN("The normals are encoded and decoded")
+    {
+      std::vector<NORMAL_OCT16P> encoded_normals(normals.size());
+      encode_normals_oct16p(normals, encoded_normals);
+
+      std::vector<Vector3<float>> decoded_normals(normals.size());
+      decode_normals_oct16p(encoded_normals, decoded_normals);
+
+      THEN("The decoded normals point in nearly the same direction")
+      {
+        for (size_t idx = 0; idx < normals.size(); ++idx) {
+          const auto& normal = normals[idx];
+          const auto& decoded = decoded_normals[idx];
+          const auto cos_angle =
+            normal.x * decoded.x + normal.y * decoded.y + normal.z * decoded.z;
+          REQUIRE(cos_angle > 0.999f);
+        }
+      }
+    }
+  }
+}
+
+#ifdef __AVX2__
+SCENARIO("AVX2 encoding kernels", "[PNTSEncoding]")
+{
+  // Not a multiple of the block sizes of the AVX2 kernels, so that the scalar
+  // kernels encode the last points
+  constexpr size_t Count = 1003;
+  std::mt19937 rng{ 42 };
+
+  GIVEN("Random positions and a quantized volume that is flat along one axis")
+  {
+    std::uniform_real_distribution<double> dist{ -1000.0, 1000.0 };
+    std::vector<Vector3<double>> positions(Count);
+    for (auto& position : positions) {
+      position = { dist(rng), dist(rng), 5.0 };
+    }
+    auto volume = quantized_volume_for(positions);
+    // Positions outside of the volume are clamped
+    volume.scale.x *= 0.5;
+
+    WHEN("The positions are quantized by both kernels")
+    {
+      std::vector<QuantizedPosition> scalar_positions(Count);
+      std::vector<QuantizedPosition> avx2_positions(Count);
+      quantize_positions_scalar(positions, volume, scalar_positions);
+      quantize_positions_avx2(positions, volume, avx2_positions);
+
+      THEN("Both kernels produce identical results")
+      {
+        for (size_t idx = 0; idx < Count; ++idx) {
+          REQUIRE(avx2_positions[idx].x == scalar_positions[idx].x);
+          REQUIRE(avx2_positions[idx].y == scalar_positions[idx].y);
+          REQUIRE(avx2_positions[idx].z == scalar_positions[idx].z);
+        }
+      }
+    }
+  }
+
+  GIVEN("Random colors")
+  {
+    std::uniform_int_distribution<int> dist{ 0, 255 };
+    std::vector<Vector3<uint8_t>> colors(Count);
+    for (auto& color : colors) {
+      color = { static_cast<uint8_t>(dist(rng)),
+                static_cast<uint8_t>(dist(rng)),
+                static_cast<uint8_t>(dist(rng)) };
+    }
+    colors[0] = { 255, 255, 255 };
+    colors[1] = { 0, 0, 0 };
+
+    WHEN("The colors are encoded by both kernels")
+    {
+      std::vector<uint16_t> scalar_colors(Count);
+      std::vector<uint16_t> avx2_colors(Count);
+      encode_rgb565_scalar(colors, scalar_colors);
+      encode_rgb565_avx2(colors, avx2_colors);
+
+      THEN("Both kernels produce identical results") { REQUIRE(avx2_colors == scalar_colors); }
+    }
+  }
+
+  GIVEN("Random normals, zero normals and normals along the axes")
+  {
+    std::uniform_real_distribution<float> dist{ -1.f, 1.f };
+    std::vector<Vector3<float>> normals(Count);
+    for (auto& normal : normals) {
+      normal = { dist(rng), dist(rng), dist(rng) };
+    }
+    normals[0] = { 0, 0, 0 };
+    normals[1] = { 0, 0, -1 };
+    normals[2] = { -1, 0, 0 };
+    normals[3] = { 0, -0.f, -0.f };
+    normals[4] = { 0.5f, -0.5f, 0 };
+
+    WHEN("The normals are encoded by both kernels")
+    {
+      std::vector<NORMAL_OCT16P> scalar_normals(Count);
+      std::vector<NORMAL_OCT16P> avx2_normals(Count);
+      encode_normals_oct16p_scalar(normals, scalar_normals);
+      encode_normals_oct16p_avx2(normals, avx2_normals);
+
+      THEN("Both kernels produce identical results")
+      {
+        for (size_t idx = 0; idx < Count; ++idx) {
+          REQUIRE(avx2_normals[idx].x == scalar_normals[idx].x);
+          REQUIRE(avx2_normals[idx].y == scalar_normals[idx].y);
+        }
+      }
+    }
+  }
+}
+#endif
@@ -0,0 +1,162 @@
+#include <catch2/catch_all.hpp>
+
+#include "datastructures/PointBuffer.h"
+
+#include <random>
+
+static PointBuffer
+random_points(size_t count, const Vector3<double>& min, double extent)
+{
+  std::mt19937 rng{ 42 };
+  std::uniform_real_distribution<double> dist{ 0, extent };
+  std::vector<Vector3<double>> positions;
+  std::vector<uint16_t> intensities;
+  for (size_t idx = 0; idx < count; ++idx) {
+    positions.push_back(min + Vector3<double>{ dist(rng), dist(rng), dist(rng) });
+    intensities.push_back(static_cast<uint16_t>(idx));
+  }
+  return { count, std::move(positions), {}, {}, std::move(intensities) };
+}
+
+SCENARIO("PointBuffer with local positions", "[PointBuffer]")
+{
+  // Typical UTM coordinates, which are not representable as floats
+  const Vector3<double> origin{ 500000, 5400000, 300 };
+  const double extent = 100;
+  const auto global_points = random_points(1000, origin, extent);
+
+  REQUIRE(PointBuffer::local_positions_are_precise({ extent, extent, extent }));
+  REQUIRE(!PointBuffer::local_positions_are_precise({ 5400000, 5400000, 5400000 }));
+
+  GIVEN("A PointBuffer whose positions are made local")
+  {
+    auto points = global_points;
+    points.make_positions_local(origin);
+
+    THEN("The positions are close to the original positions")
+    {
+      REQUIRE(points.has_local_positions());
+      REQUIRE(points.content_byte_size() < global_points.content_byte_size());
+      for (size_t idx = 0; idx < points.count(); ++idx) {
+        REQUIRE(points.get_point(idx).position().distanceTo(global_points.positions()[idx]) <
+                0.0001);
+        REQUIRE(*points.get_point(idx).intensity() == *global_points.get_point(idx).intensity());
+      }
+    }
+
+    WHEN("A PointBuffer with global positions is appended")
+    {
+      points.append_buffer(global_points);
+
+      THEN("The appended positions are stored relative to the same origin")
+      {
+        REQUIRE(points.count() == 2 * global_points.count());
+        REQUIRE(points.local_positions().size() == points.count());
+        for (size_t idx = 0; idx < global_points.count(); ++idx) {
+          REQUIRE(points.get_point(global_points.count() + idx)
+                    .position()
+                    .distanceTo(global_points.positions()[idx]) < 0.0001);
+        }
+      }
+    }
+
+    WHEN("A position is set")
+    {
+      const Vector3<double> new_position = origin + Vector3<double>{ 1, 2, 3 };
+      points.get_point(0).set_position(new_position);
+
+      THEN("The new position can be read back")
+      {
+        REQUIRE(points.get_point(0).position().distanceTo(new_position) < 0.0001);
+      }
+    }
+
+    WHEN("The positions are made global again")
+    {
+      points.make_positions_global();
+
+      THEN("The positions are close to the original positions")
+      {
+        REQUIRE(!points.has_local_positions());
+        for (size_t idx = 0; idx < points.count(); ++idx) {
+          REQUIRE(points.positions()[idx].distanceTo(global_points.positions()[idx]) < 0.0001);
+        }
+      }
+    }
+  }
+}
+
+SCENARIO("PointBuffer schema", "[PointBuffer]")
+{
+  PointAttributes attributes;
+  attributes.insert(PointAttribute::Position);
+  attributes.insert(PointAttribute::Classification);
+
+  GIVEN("A PointBuffer with positions and classifications")
+  {
+    PointBuffer points{ 4, attributes };
+    for (size_t idx = 0; idx < points.count(); ++idx) {
+      points.classifications()[idx] = static_cast<uint8_t>(idx + 1);
+    }
+
+    THEN("Only the attributes of the schema are stored")
+    {
+      REQUIRE(points.schema() == attributes);
+      REQUIRE(points.hasClassifications());
+      REQUIRE(!points.hasIntensities());
+      REQUIRE(points.intensities().empty());
+    }
+
+    WHEN("A PointBuffer with intensities is appended")
+    {
+      std::vector<Vector3<double>> positions(2, Vector3<double>{ 1, 2, 3 });
+      std::vector<uint16_t> intensities{ 42, 43 };
+      const PointBuffer other{ 2, std::move(positions), {}, {}, std::move(intensities) };
+      points.append_buffer(other);
+
+      THEN("The intensities are added with default values for the existing points")
+      {
+        REQUIRE(points.count() == 6);
+        REQUIRE(points.hasIntensities());
+        REQUIRE(points.intensities()[0] == 0);
+        REQUIRE(points.intensities()[4] == 42);
+        REQUIRE(points.intensities()[5] == 43);
+        REQUIRE(points.classifications()[3] == 4);
+        REQUIRE(points.classifications()[4] == 0);
+        REQUIRE(points.positions()[5] == Vector3<double>{ 1, 2, 3 });
+      }
+    }
+
+    WHEN("The buffer is cleared and a PointBuffer without classifications is appended")
+    {
+      points.clear();
+      std::vector<Vector3<double>> positions(2, Vector3<double>{ 1, 2, 3 });
+      const PointBuffer other{ 2, std::move(positions) };
+      points.append_buffer(other);
+
+      THEN("The classifications of the appended points have default values")
+      {
+        REQUIRE(points.count() == 2);
+        REQUIRE(points.classifications()[0] == 0);
+        REQUIRE(points.classifications()[1] == 0);
+        REQUIRE(points.positions()[1] == Vector3<double>{ 1, 2, 3 });
+      }
+    }
+
+    WHEN("Points are pushed beyond the capacity")
+    {
+      const auto first_point = points.get_point(0);
+      for (size_t idx = 0; idx < 100; ++idx) {
+        points.push_point(first_point);
+      }
+
+      THEN("The buffer grows and keeps its contents")
+      {
+        REQUIRE(points.count() == 104);
+        REQUIRE(points.capacity() >= 104);
+        REQUIRE(points.classifications()[3] == 4);
+        REQUIRE(points.classifications()[103] == 1);
+      }
+    }
+  }
+}
@@ -0,0 +1,37 @@
+#include <catch2/catch_all.hpp>
+
+#include "io/PointFileHierarchy.h"
+
+SCENARIO("sort_nodes_spatially", "[PointFileHierarchy]")
+{
+  GIVEN("The nodes of a hierarchy in breadth-first order")
+  {
+    std::vector<PointFileNode> nodes{ { OctreeNodeIndex64{}, 10, 0 },
+                                      { OctreeNodeIndex64{ 0 }, 10, 10 },
+                                      { OctreeNodeIndex64{ 7 }, 10, 20 },
+                                      { OctreeNodeIndex64{ 0, 3 }, 10, 30 },
+                                      { OctreeNodeIndex64{ 7, 1 }, 10, 40 },
+                                      { OctreeNodeIndex64{ 0, 3, 5 }, 10, 50 } };
+
+    WHEN("The nodes are sorted spatially")
+    {
+      sort_nodes_spatially(nodes);
+
+      THEN("The nodes are in depth-first order")
+      {
+        REQUIRE(nodes[0].index == OctreeNodeIndex64{});
+        REQUIRE(nodes[1].index == OctreeNodeIndex64{ 0 });
+        REQUIRE(nodes[2].index == (OctreeNodeIndex64{ 0, 3 }));
+        REQUIRE(nodes[3].index == (OctreeNodeIndex64{ 0, 3, 5 }));
+        REQUIRE(nodes[4].index == OctreeNodeIndex64{ 7 });
+        REQUIRE(nodes[5].index == (OctreeNodeIndex64{ 7, 1 }));
+      }
+
+      THEN("The position of the points in the file is kept")
+      {
+        REQUIRE(nodes[3].first_point == 50);
+        REQUIRE(nodes[4].first_point == 20);
+      }
+    }
+  }
+}
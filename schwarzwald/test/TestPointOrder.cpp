@@ -0,0 +1,158 @@
+#include <catch2/catch_all.hpp>
+
+#include "tiling/OctreeAlgorithms.h"
+#include "tiling/PointOrder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <tuple>
+
+SCENARIO("Hilbert keys", "[PointOrder]")
+{
+  GIVEN("The centers of the cells of a 4x4x4 grid")
+  {
+    const AABB bounds{ { 0, 0, 0 }, { 4, 4, 4 } };
+    std::vector<std::pair<uint64_t, Vector3<double>>> cells;
+    for (int x = 0; x < 4; ++x) {
+      for (int y = 0; y < 4; ++y) {
+        for (int z = 0; z < 4; ++z) {
+          const Vector3<double> center{ x + 0.5, y + 0.5, z + 0.5 };
+          cells.emplace_back(calculate_hilbert_key(center, bounds), center);
+        }
+      }
+    }
+
+    WHEN("The cells are sorted by their Hilbert keys")
+    {
+      std::sort(std::begin(cells), std::end(cells), [](const auto& l, const auto& r) {
+        return l.first < r.first;
+      });
+
+      THEN("All keys are unique and consecutive cells are neighbours")
+      {
+        for (size_t idx = 1; idx < cells.size(); ++idx) {
+          REQUIRE(cells[idx - 1].first != cells[idx].first);
+          const auto delta = cells[idx].second - cells[idx - 1].second;
+          REQUIRE(std::abs(delta.x) + std::abs(delta.y) + std::abs(delta.z) == 1);
+        }
+      }
+    }
+  }
+}
+
+SCENARIO("Keys for bounds with a zero extent", "[PointOrder]")
+{
+  GIVEN("Points on a plane and the flat bounds of the points")
+  {
+    const AABB flat_bounds{ { 0, 0, 1 }, { 4, 4, 1 } };
+    const AABB cubic_bounds{ { 0, 0, 1 }, { 4, 4, 5 } };
+
+    THEN("The keys are those of the cubic bounds with all points in the lowest cells along z")
+    {
+      for (int x = 0; x < 4; ++x) {
+        for (int y = 0; y < 4; ++y) {
+          const Vector3<double> position{ x + 0.5, y + 0.5, 1 };
+          REQUIRE(calculate_hilbert_key(position, flat_bounds) ==
+                  calculate_hilbert_key(position, cubic_bounds));
+          REQUIRE(calculate_morton_index<MortonIndex64Levels>(position, flat_bounds) ==
+                  calculate_morton_index<MortonIndex64Levels>(position, cubic_bounds));
+        }
+      }
+    }
+  }
+}
+
+SCENARIO("Ordering the points of a node", "[PointOrder]")
+{
+  GIVEN("Points in the cells of a 2x2x2 grid")
+  {
+    const AABB bounds{ { 0, 0, 0 }, { 2, 2, 2 } };
+    std::vector<Vector3<double>> positions;
+    for (int x = 0; x < 2; ++x) {
+      for (int y = 0; y < 2; ++y) {
+        for (int z = 0; z < 2; ++z) {
+          positions.push_back({ x + 0.5, y + 0.5, z + 0.5 });
+        }
+      }
+    }
+    PointBuffer points{ positions.size(), positions };
+    std::vector<PointBuffer::PointReference> point_references{ std::begin(points),
+                                                               std::end(points) };
+
+    WHEN("The points are ordered along the Hilbert curve")
+    {
+      order_points_in_node(point_references, bounds, PointOrder::Hilbert);
+
+      THEN("All points are kept and consecutive points are neighbours")
+      {
+        REQUIRE(point_references.size() == positions.size());
+        for (size_t idx = 1; idx < point_references.size(); ++idx) {
+          const auto delta =
+            point_references[idx].position() - point_references[idx - 1].position();
+          REQUIRE(std::abs(delta.x) + std::abs(delta.y) + std::abs(delta.z) == 1);
+        }
+      }
+    }
+
+    WHEN("The points are ordered along the Z-order curve")
+    {
+      order_points_in_node(point_references, bounds, PointOrder::Morton);
+
+      THEN("The points have the order of their octants")
+      {
+        for (size_t idx = 0; idx < point_references.size(); ++idx) {
+          REQUIRE(point_references[idx].position() == positions[idx]);
+        }
+      }
+    }
+  }
+}
+
+SCENARIO("Ordering the points of a node by LOD prefix", "[PointOrder]")
+{
+  GIVEN("Two points in each cell of a 4x4x4 grid")
+  {
+    const AABB bounds{ { 0, 0, 0 }, { 4, 4, 4 } };
+    std::vector<Vector3<double>> positions;
+    for (int copy = 0; copy < 2; ++copy) {
+      for (int x = 0; x < 4; ++x) {
+        for (int y = 0; y < 4; ++y) {
+          for (int z = 0; z < 4; ++z) {
+            positions.push_back({ x + 0.25 + copy * 0.5, y + 0.5, z + 0.5 });
+          }
+        }
+      }
+    }
+    PointBuffer points{ positions.size(), positions };
+    std::vector<PointBuffer::PointReference> point_references{ std::begin(points),
+                                                               std::end(points) };
+
+    WHEN("The points are ordered by LOD prefix")
+    {
+      order_points_in_node(point_references, bounds, PointOrder::LODPrefix);
+
+      THEN("The first 8 points are in different octants of the node")
+      {
+        std::set<uint8_t> octants;
+        for (size_t idx = 0; idx < 8; ++idx) {
+          octants.insert(get_octant(point_references[idx].position(), bounds));
+        }
+        REQUIRE(octants.size() == 8);
+      }
+
+      THEN("The first 64 points are in different cells of the grid")
+      {
+        std::set<std::tuple<int, int, int>> cells;
+        for (size_t idx = 0; idx < 64; ++idx) {
+          const auto position = point_references[idx].position();
+          cells.insert({ static_cast<int>(position.x),
+                         static_cast<int>(position.y),
+                         static_cast<int>(position.z) });
+        }
+        REQUIRE(cells.size() == 64);
+        REQUIRE(point_references.size() == positions.size());
+      }
+    }
+  }
+}
@@ -0,0 +1,129 @@
+#include <catch2/catch_all.hpp>
+
+#include "datastructures/PositionsSoA.h"
+
+// The AVX2 path compares blocks of four positions, so it counts the
+// comparisons of a whole block when it exits early
+#ifdef __AVX2__
+constexpr bool ComparesBlocks = true;
+#else
+constexpr bool ComparesBlocks = false;
+#endif
+
+static PositionsSoA<4>
+positions_along_x(size_t count)
+{
+  PositionsSoA<4> positions;
+  for (size_t idx = 0; idx < count; ++idx) {
+    positions.push_back({ static_cast<double>(idx) * 10, 0, 0 });
+  }
+  return positions;
+}
+
+SCENARIO("PositionsSoA::all_distant", "[PositionsSoA]")
+{
+  GIVEN("Seven positions, which is one full block of four and three remaining positions")
+  {
+    const auto positions = positions_along_x(7);
+
+    THEN("The positions are stored in order")
+    {
+      REQUIRE(positions.size() == 7);
+      REQUIRE(positions[5] == Vector3<double>{ 50, 0, 0 });
+    }
+
+    WHEN("A position is far from all positions")
+    {
+      size_t num_comparisons = 0;
+      const auto distant = positions.all_distant({ 35, 0, 0 }, 4.0, &num_comparisons);
+
+      THEN("It is distant and was compared to all positions")
+      {
+        REQUIRE(distant);
+        REQUIRE(num_comparisons == 7);
+      }
+    }
+
+    WHEN("A position is close to a position in the first block")
+    {
+      size_t num_comparisons = 0;
+      const auto distant = positions.all_distant({ 11, 0, 0 }, 4.0, &num_comparisons);
+
+      THEN("The test exits early")
+      {
+        REQUIRE(!distant);
+        REQUIRE(num_comparisons == (ComparesBlocks ? 4 : 2));
+      }
+    }
+
+    WHEN("A position is close to one of the remaining positions")
+    {
+      size_t num_comparisons = 0;
+      const auto distant = positions.all_distant({ 60, 1, 0 }, 4.0, &num_comparisons);
+
+      THEN("The remaining positions are tested one by one")
+      {
+        REQUIRE(!distant);
+        REQUIRE(num_comparisons == 7);
+      }
+    }
+
+    WHEN("A position is exactly at the spacing of another position")
+    {
+      const auto distant = positions.all_distant({ 22, 0, 0 }, 4.0);
+
+      THEN("It is distant") { REQUIRE(distant); }
+    }
+
+    WHEN("The same position is tested with increasing counts of stored positions")
+    {
+      THEN("Each count gives the same result as a plain loop")
+      {
+        for (size_t count = 0; count <= 9; ++count) {
+          const auto subset = positions_along_x(count);
+          for (double x = -5; x <= 95; x += 2.5) {
+            bool expected = true;
+            for (size_t idx = 0; idx < count; ++idx) {
+              const auto dx = subset[idx].x - x;
+              expected = expected && (dx * dx + 1.0) >= 9.0;
+            }
+            REQUIRE(subset.all_distant({ x, 1, 0 }, 9.0) == expected);
+          }
+        }
+      }
+    }
+  }
+
+  GIVEN("No positions")
+  {
+    PositionsSoA<4> positions;
+
+    THEN("Every position is distant without any comparisons")
+    {
+      size_t num_comparisons = 0;
+      REQUIRE(positions.empty());
+      REQUIRE(positions.all_distant({ 0, 0, 0 }, 1.0, &num_comparisons));
+      REQUIRE(num_comparisons == 0);
+    }
+  }
+}
+
+SCENARIO("PositionsSoA::content_byte_size", "[PositionsSoA]")
+{
+  GIVEN("Positions that fit into the inline capacity")
+  {
+    const auto positions = positions_along_x(4);
+
+    THEN("No memory is allocated dynamically") { REQUIRE(positions.content_byte_size() == 0); }
+  }
+
+  GIVEN("More positions than the inline capacity")
+  {
+    const auto positions = positions_along_x(5);
+
+    THEN("The allocated coordinate arrays are counted")
+    {
+      REQUIRE(positions.content_byte_size() >= 3 * 5 * sizeof(double));
+    }
+  }
+}
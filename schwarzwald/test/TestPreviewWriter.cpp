@@ -0,0 +1,98 @@
+#include <catch2/catch_all.hpp>
+
+#include "io/PointsPersistence.h"
+#include "process/PreviewWriter.h"
+#include "tiling/TilingAlgorithms.h"
+
+#include <taskflow/taskflow.hpp>
+
+static PointBuffer
+generate_grid_points(size_t side_length)
+{
+  std::vector<Vector3<double>> positions;
+  positions.reserve(side_length * side_length * side_length);
+  for (size_t x = 0; x < side_length; ++x) {
+    for (size_t y = 0; y < side_length; ++y) {
+      for (size_t z = 0; z < side_length; ++z) {
+        positions.push_back({ x + 0.5, y + 0.5, z + 0.5 });
+      }
+    }
+  }
+  const auto count = positions.size();
+  return { count, std::move(positions) };
+}
+
+static TilerMetaParameters
+make_fast_meta_parameters()
+{
+  TilerMetaParameters meta_parameters;
+  meta_parameters.spacing_at_root = 1.f;
+  meta_parameters.max_depth = 20;
+  meta_parameters.max_points_per_node = 64;
+  meta_parameters.batch_read_size = 4096;
+  meta_parameters.internal_cache_size = 4096;
+  meta_parameters.shift_points_to_origin = false;
+  meta_parameters.create_journal = false;
+  meta_parameters.tiling_strategy = TilingStrategy::Fast;
+  meta_parameters.thread_count = AdaptiveThreadCount{ 4 };
+  meta_parameters.estimate_normals = false;
+  meta_parameters.point_order = PointOrder::Morton;
+  return meta_parameters;
+}
+
+SCENARIO("PreviewWriter", "[PreviewWriter]")
+{
+  const fs::path directory = "./_preview_writer_test_";
+  fs::remove_all(directory);
+  fs::create_directories(directory);
+
+  PointAttributes attributes;
+  attributes.insert(PointAttribute::Position);
+  const AABB bounds{ { 0, 0, 0 }, { 16, 16, 16 } };
+
+  GIVEN("An octree that received a batch of the 'Fast' tiling strategy")
+  {
+    auto sampling_strategy = make_sampling_strategy<RandomSortedGridSampling>(size_t{ 64 });
+    PointsPersistence persistence{ MemoryPersistence{ attributes } };
+    TilingAlgorithmV3 tiling_algorithm{
+      sampling_strategy, nullptr, persistence, make_fast_meta_parameters(), directory
+    };
+    tiling_algorithm.set_level_of_start_nodes(2);
+
+    auto points = generate_grid_points(16);
+    tf::Taskflow taskflow;
+    tiling_algorithm.build_execution_graph(
+      { std::begin(points), std::end(points) }, bounds, 4, taskflow);
+    tf::Executor executor{ 4 };
+    executor.run(taskflow).get();
+
+    PreviewWriter preview_writer{ directory / "preview",
+                                  3,
+                                  bounds,
+                                  [&attributes](const fs::path&) {
+                                    return PointsPersistence{ MemoryPersistence{ attributes } };
+                                  },
+                                  {} };
+
+    THEN("The levels above the start nodes are not written yet")
+    {
+      REQUIRE(!persistence.node_exists("r"));
+      REQUIRE(preview_writer.publish(persistence) == 0);
+    }
+
+    WHEN("The updated nodes are reconstructed before publishing, like the Tiler does")
+    {
+      tiling_algorithm.reconstruct_updated_nodes(bounds);
+      const auto preview_points_count = preview_writer.publish(persistence);
+
+      THEN("The preview contains the top levels of the octree")
+      {
+        REQUIRE(persistence.node_exists("r"));
+        REQUIRE(preview_points_count > 0);
+        REQUIRE(fs::exists(preview_writer.preview_directory()));
+      }
+    }
+  }
+
+  fs::remove_all(directory);
+}
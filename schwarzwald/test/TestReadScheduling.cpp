@@ -0,0 +1,89 @@
+#include <catch2/catch_all.hpp>
+
+#include "process/ReadScheduling.h"
+
+#include <numeric>
+
+static DatasetMetadata
+make_dataset(const std::vector<std::pair<fs::path, bool>>& files, size_t points_per_file)
+{
+  DatasetMetadata dataset_metadata;
+  for (const auto& [file_path, is_compressed] : files) {
+    dataset_metadata.add_file_metadata(
+      file_path, points_per_file, AABB{ { 0, 0, 0 }, { 1, 1, 1 } }, 20, is_compressed);
+  }
+  return dataset_metadata;
+}
+
+static std::deque<ReadCommand>
+make_read_commands(const DatasetMetadata& dataset_metadata)
+{
+  std::deque<ReadCommand> read_commands;
+  for (const auto& [file_path, metadata] : dataset_metadata.get_all_files_metadata()) {
+    read_commands.push_back({ &file_path, metadata.points_count });
+  }
+  return read_commands;
+}
+
+static size_t
+points_of_thread(const std::vector<ReadCommand>& read_commands)
+{
+  return std::accumulate(
+    std::begin(read_commands), std::end(read_commands), size_t{ 0 }, [](auto accum, const auto& cmd) {
+      return accum + cmd.to_read_count;
+    });
+}
+
+SCENARIO("schedule_read_commands", "[ReadScheduling]")
+{
+  GIVEN("A compressed and an uncompressed file of the same size")
+  {
+    const auto dataset_metadata = make_dataset({ { "a.laz", true }, { "b.las", false } }, 1000);
+    const ReadCostModel cost_model{ dataset_metadata };
+    auto read_commands = make_read_commands(dataset_metadata);
+
+    WHEN("Only some of the points fit into the batch")
+    {
+      const auto schedule = schedule_read_commands(read_commands, 2, 1000, cost_model);
+
+      THEN("Each file is read by a single thread")
+      {
+        REQUIRE(schedule.points_count == 1000);
+        REQUIRE(schedule.read_commands_per_thread[0].size() == 1);
+        REQUIRE(schedule.read_commands_per_thread[1].size() == 1);
+      }
+
+      THEN("Fewer points are read from the more expensive file")
+      {
+        const auto& compressed_thread =
+          (schedule.read_commands_per_thread[0][0].file_path->extension() == ".laz")
+            ? schedule.read_commands_per_thread[0]
+            : schedule.read_commands_per_thread[1];
+        const auto& uncompressed_thread =
+          (schedule.read_commands_per_thread[0][0].file_path->extension() == ".laz")
+            ? schedule.read_commands_per_thread[1]
+            : schedule.read_commands_per_thread[0];
+        REQUIRE(points_of_thread(compressed_thread) < points_of_thread(uncompressed_thread));
+      }
+
+      THEN("The remaining points stay in the remaining ReadCommands")
+      {
+        const auto remaining_points = points_of_thread({ std::begin(read_commands), std::end(read_commands) });
+        REQUIRE(remaining_points == 1000);
+      }
+    }
+  }
+
+  GIVEN("Measured throughputs for some files")
+  {
+    const auto dataset_metadata = make_dataset({ { "a.las", false }, { "b.las", false } }, 1000);
+    ReadCostModel cost_model{ dataset_metadata };
+    cost_model.record_read("a.las", 100, std::chrono::milliseconds{ 100 });
+    cost_model.record_read("b.las", 100, std::chrono::milliseconds{ 10 });
+
+    THEN("The measured throughput determines the cost")
+    {
+      REQUIRE(cost_model.cost_per_point("a.las") > cost_model.cost_per_point("b.las"));
+    }
+  }
+}
@@ -0,0 +1,129 @@
+#include <catch2/catch_all.hpp>
+
+#include "process/Retiler.h"
+#include "util/stuff.h"
+
+#include <fstream>
+
+static void
+write_properties_json(const fs::path& directory, const std::string& extra_properties)
+{
+  std::ofstream stream{ directory / "properties.json" };
+  stream << R"({"source_properties":{"bounds":{"min":[0,0,0],"max":[8,8,8]},)"
+         << R"("root_spacing":0.5,"processed_points":100)" << extra_properties << "}}";
+}
+
+static void
+touch(const fs::path& file_path)
+{
+  std::ofstream stream{ file_path };
+}
+
+SCENARIO("read_tiled_output", "[Retiler]")
+{
+  const fs::path directory = "./_retiler_test_";
+  fs::remove_all(directory);
+  fs::create_directories(directory);
+
+  GIVEN("The output of a LAS tiler run")
+  {
+    write_properties_json(directory, R"(,"reconstructed_levels":2)");
+    touch(directory / "r.las");
+    touch(directory / "r07.las");
+    touch(directory / "r0.las");
+    touch(directory / "properties.las.json");
+
+    WHEN("The output is read")
+    {
+      const auto tiled_output = read_tiled_output(directory);
+
+      THEN("The properties and all nodes are read")
+      {
+        REQUIRE(tiled_output.bounds.max == Vector3<double>{ 8, 8, 8 });
+        REQUIRE(tiled_output.spacing_at_root == 0.5f);
+        REQUIRE(tiled_output.points_count == 100);
+        REQUIRE(tiled_output.reconstructed_levels == 2);
+        REQUIRE(tiled_output.nodes.size() == 3);
+        REQUIRE(tiled_output.nodes[0].index == OctreeNodeIndex64{});
+        REQUIRE(tiled_output.nodes[1].index == OctreeNodeIndex64{ 0 });
+        REQUIRE(tiled_output.nodes[2].index == (OctreeNodeIndex64{ 0, 7 }));
+        REQUIRE(tiled_output.nodes[2].file == directory / "r07.las");
+      }
+    }
+  }
+
+  GIVEN("The output of an Entwine tiler run without reconstructed levels")
+  {
+    write_properties_json(directory, "");
+    fs::create_directories(directory / "ept-data");
+    touch(directory / "ept-data" / "0-0-0-0.laz");
+    touch(directory / "ept-data" / "1-1-0-1.laz");
+
+    WHEN("The output is read")
+    {
+      const auto tiled_output = read_tiled_output(directory);
+
+      THEN("All nodes are assumed to contain distinct points")
+      {
+        REQUIRE(tiled_output.reconstructed_levels == 0);
+        REQUIRE(tiled_output.nodes.size() == 2);
+        REQUIRE(tiled_output.nodes[1].index == OctreeNodeIndex64{ 5 });
+      }
+    }
+  }
+
+  GIVEN("The output of a 3D Tiles tiler run")
+  {
+    write_properties_json(directory, R"(,"reconstructed_levels":3)");
+    touch(directory / "r.pnts");
+    touch(directory / "r0.pnts");
+
+    THEN("The output can't be read")
+    {
+      REQUIRE_THROWS_AS(read_tiled_output(directory), std::invalid_argument);
+    }
+  }
+
+  fs::remove_all(directory);
+}
+
+SCENARIO("calculate_common_root_cube", "[Retiler]")
+{
+  GIVEN("Cubes that lie on a common grid")
+  {
+    const std::vector<AABB> cubes{ { { 0, 0, 0 }, { 4, 4, 4 } },
+                                   { { 4, 0, 0 }, { 8, 4, 4 } },
+                                   { { 8, 4, 0 }, { 10, 6, 2 } } };
+
+    WHEN("The common root cube is calculated")
+    {
+      const auto root_cube = calculate_common_root_cube(cubes);
+
+      THEN("Each cube is a node of the common root cube")
+      {
+        REQUIRE(root_cube.min == Vector3<double>{ 0, 0, 0 });
+        REQUIRE(root_cube.max == Vector3<double>{ 16, 16, 16 });
+        REQUIRE(find_node_with_bounds(cubes[0], root_cube) == (OctreeNodeIndex64{ 0, 0 }));
+        REQUIRE(find_node_with_bounds(cubes[1], root_cube) == (OctreeNodeIndex64{ 0, 4 }));
+        REQUIRE(find_node_with_bounds(cubes[2], root_cube) == (OctreeNodeIndex64{ 4, 2, 0 }));
+      }
+    }
+  }
+
+  GIVEN("Cubes that don't lie on a common grid")
+  {
+    const std::vector<AABB> cubes{ { { 0, 0, 0 }, { 4, 4, 4 } }, { { 3, 0, 0 }, { 6, 3, 3 } } };
+
+    WHEN("The common root cube is calculated")
+    {
+      const auto root_cube = calculate_common_root_cube(cubes);
+
+      THEN("The common root cube is the cubic hull of the cubes")
+      {
+        REQUIRE(root_cube.min == Vector3<double>{ 0, -1, -1 });
+        REQUIRE(root_cube.max == Vector3<double>{ 6, 5, 5 });
+        REQUIRE(!find_node_with_bounds(cubes[1], root_cube));
+      }
+    }
+  }
+}
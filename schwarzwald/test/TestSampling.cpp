@@ -0,0 +1,213 @@
+#include <catch2/catch_all.hpp>
+
+#include "tiling/OctreeAlgorithms.h"
+#include "tiling/Sampling.h"
+
+#include <random>
+#include <set>
+
+static PointBuffer
+random_points(size_t count, double extent, uint32_t seed)
+{
+  std::mt19937 rng{ seed };
+  std::uniform_real_distribution<double> dist{ 0, extent };
+  std::vector<Vector3<double>> positions;
+  positions.reserve(count);
+  for (size_t idx = 0; idx < count; ++idx) {
+    positions.push_back({ dist(rng), dist(rng), dist(rng) });
+  }
+  return { count, std::move(positions) };
+}
+
+static std::vector<IndexedPoint64>
+index_and_sort(PointBuffer& points, const AABB& bounds)
+{
+  std::vector<IndexedPoint64> indexed_points;
+  indexed_points.reserve(points.count());
+  index_points<MortonIndex64Levels>(std::begin(points),
+                                    std::end(points),
+                                    std::back_inserter(indexed_points),
+                                    bounds,
+                                    OutlierPointsBehaviour::ClampToBounds);
+  std::sort(std::begin(indexed_points), std::end(indexed_points));
+  return indexed_points;
+}
+
+SCENARIO("Incremental sampling of a node", "[Sampling]")
+{
+  const AABB bounds{ { 0, 0, 0 }, { 64, 64, 64 } };
+  const float spacing = 8;
+  // The root node is at level -1
+  const int32_t node_level = -1;
+  const MortonIndex64 node_key;
+
+  // A sparse first batch, so that the second batch also selects some points
+  auto first_batch_points = random_points(20, 64, 1);
+  auto second_batch_points = random_points(5000, 64, 2);
+  auto first_batch = index_and_sort(first_batch_points, bounds);
+  auto second_batch = index_and_sort(second_batch_points, bounds);
+
+  GIVEN("A node that was sampled with RANDOM_GRID")
+  {
+    auto sampling = make_sampling_strategy<RandomSortedGridSampling>(size_t{ 100 });
+    const auto first_selected_end = sample_points(sampling,
+                                                  std::begin(first_batch),
+                                                  std::end(first_batch),
+                                                  node_key,
+                                                  node_level,
+                                                  bounds,
+                                                  spacing,
+                                                  SamplingBehaviour::AlwaysAdhereToMinSpacing);
+    auto occupancy = make_node_occupancy(
+      sampling, std::begin(first_batch), first_selected_end, node_key, node_level, bounds, spacing);
+
+    WHEN("The next batch is sampled incrementally")
+    {
+      const auto second_selected_end = sample_points_incrementally(sampling,
+                                                                   std::begin(second_batch),
+                                                                   std::end(second_batch),
+                                                                   node_key,
+                                                                   node_level,
+                                                                   bounds,
+                                                                   spacing,
+                                                                   occupancy);
+
+      THEN("Each grid cell contains at most one selected point of both batches")
+      {
+        REQUIRE(second_selected_end != std::begin(second_batch));
+
+        const auto cell_level = grid_cell_level_for_node(node_level, bounds, spacing);
+        std::set<uint64_t> cells;
+        for (auto iter = std::begin(first_batch); iter != first_selected_end; ++iter) {
+          REQUIRE(cells.insert(grid_cell_of(*iter, cell_level)).second);
+        }
+        for (auto iter = std::begin(second_batch); iter != second_selected_end; ++iter) {
+          REQUIRE(cells.insert(grid_cell_of(*iter, cell_level)).second);
+        }
+        REQUIRE(occupancy.occupied_cells.size() == cells.size());
+      }
+
+      THEN("The remaining points are sorted")
+      {
+        REQUIRE(std::is_sorted(second_selected_end, std::end(second_batch)));
+      }
+    }
+  }
+
+  GIVEN("A node that was sampled with MIN_DISTANCE")
+  {
+    auto sampling = make_sampling_strategy<PoissonDiskSampling>(size_t{ 100 });
+    const auto first_selected_end = sample_points(sampling,
+                                                  std::begin(first_batch),
+                                                  std::end(first_batch),
+                                                  node_key,
+                                                  node_level,
+                                                  bounds,
+                                                  spacing,
+                                                  SamplingBehaviour::AlwaysAdhereToMinSpacing);
+    auto occupancy = make_node_occupancy(
+      sampling, std::begin(first_batch), first_selected_end, node_key, node_level, bounds, spacing);
+
+    WHEN("The next batch is sampled incrementally")
+    {
+      const auto second_selected_end = sample_points_incrementally(sampling,
+                                                                   std::begin(second_batch),
+                                                                   std::end(second_batch),
+                                                                   node_key,
+                                                                   node_level,
+                                                                   bounds,
+                                                                   spacing,
+                                                                   occupancy);
+
+      THEN("All selected points of both batches adhere to the minimum spacing")
+      {
+        std::vector<Vector3<double>> selected;
+        for (auto iter = std::begin(first_batch); iter != first_selected_end; ++iter) {
+          selected.push_back(iter->point_reference.position());
+        }
+        for (auto iter = std::begin(second_batch); iter != second_selected_end; ++iter) {
+          selected.push_back(iter->point_reference.position());
+        }
+        REQUIRE(second_selected_end != std::begin(second_batch));
+
+        auto min_squared_distance = std::numeric_limits<double>::max();
+        for (size_t first = 0; first < selected.size(); ++first) {
+          for (size_t second = first + 1; second < selected.size(); ++second) {
+            min_squared_distance =
+              std::min(min_squared_distance, selected[first].squaredDistanceTo(selected[second]));
+          }
+        }
+        REQUIRE(min_squared_distance >= spacing * spacing);
+      }
+    }
+  }
+}
+
+SCENARIO("Sampling a node in chunks", "[Sampling]")
+{
+  const AABB bounds{ { 0, 0, 0 }, { 64, 64, 64 } };
+  const float spacing = 8;
+  const int32_t node_level = -1;
+  const MortonIndex64 node_key;
+
+  auto points = random_points(5000, 64, 3);
+  auto indexed_points = index_and_sort(points, bounds);
+  auto sampling = make_sampling_strategy<GridCenterSampling>(size_t{ 100 });
+  const auto cell_level =
+    sampling_grid_cell_level(sampling, node_key, node_level, bounds, spacing);
+
+  GIVEN("The points split at grid cells")
+  {
+    auto chunked_points = indexed_points;
+    const auto chunks =
+      split_at_grid_cells(std::begin(chunked_points), std::end(chunked_points), cell_level, 7);
+
+    THEN("No grid cell is split between two chunks")
+    {
+      REQUIRE(chunks.size() > 1);
+      REQUIRE(chunks.front().first == std::begin(chunked_points));
+      REQUIRE(chunks.back().second == std::end(chunked_points));
+      for (size_t idx = 1; idx < chunks.size(); ++idx) {
+        REQUIRE(chunks[idx].first == chunks[idx - 1].second);
+        REQUIRE(grid_cell_of(*(chunks[idx].first - 1), cell_level) <
+                grid_cell_of(*chunks[idx].first, cell_level));
+      }
+    }
+
+    WHEN("Each chunk is sampled separately")
+    {
+      std::vector<IndexedPoint64> selected_points;
+      for (const auto& [chunk_begin, chunk_end] : chunks) {
+        const auto selected_end = sample_points(sampling,
+                                                chunk_begin,
+                                                chunk_end,
+                                                node_key,
+                                                node_level,
+                                                bounds,
+                                                spacing,
+                                                SamplingBehaviour::AlwaysAdhereToMinSpacing);
+        selected_points.insert(std::end(selected_points), chunk_begin, selected_end);
+      }
+
+      THEN("The same points are selected as when sampling all points at once")
+      {
+        const auto selected_end = sample_points(sampling,
+                                                std::begin(indexed_points),
+                                                std::end(indexed_points),
+                                                node_key,
+                                                node_level,
+                                                bounds,
+                                                spacing,
+                                                SamplingBehaviour::AlwaysAdhereToMinSpacing);
+        REQUIRE(static_cast<size_t>(std::distance(std::begin(indexed_points), selected_end)) ==
+                selected_points.size());
+        REQUIRE(std::equal(std::begin(selected_points),
+                           std::end(selected_points),
+                           std::begin(indexed_points),
+                           [](const IndexedPoint64& l, const IndexedPoint64& r) {
+                             return l.morton_index == r.morton_index;
+                           }));
+      }
+    }
+  }
+}
@@ -0,0 +1,265 @@
+#include <catch2/catch_all.hpp>
+
+#include "io/AttributeStore.h"
+#include "io/PointsPersistence.h"
+#include "math/AABB.h"
+#include "pointcloud/PointAttributes.h"
+
+#include <boost/units/systems/information/byte.hpp>
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+static PointBuffer
+generate_points(size_t count, double offset)
+{
+  std::vector<Vector3<double>> positions;
+  positions.reserve(count);
+  for (size_t idx = 0; idx < count; ++idx) {
+    positions.push_back({ offset + idx, offset, offset });
+  }
+  return { count, std::move(positions) };
+}
+
+static bool
+same_positions(const PointBuffer& l, const PointBuffer& r)
+{
+  return std::equal(
+    l.positions().begin(), l.positions().end(), r.positions().begin(), r.positions().end());
+}
+
+SCENARIO("StagingPersistence", "[StagingPersistence]")
+{
+  PointAttributes attributes;
+  attributes.insert(PointAttribute::Position);
+  const AABB bounds{ { 0, 0, 0 }, { 1, 1, 1 } };
+
+  const auto points_r0 = generate_points(16, 0);
+  const auto points_r1 = generate_points(16, 100);
+
+  GIVEN("A memory budget that fits all nodes")
+  {
+    const auto budget = 1024.0 * 1024.0 * boost::units::information::bytes;
+    StagingPersistence persistence{
+      std::make_unique<PointsPersistence>(MemoryPersistence{ attributes }),
+      attributes,
+      budget,
+      4,
+      PointOrder::Morton
+    };
+
+    persistence.persist_points(points_r0, bounds, "r0");
+    persistence.persist_points(points_r1, bounds, "r1");
+
+    THEN("The nodes are staged and can be retrieved")
+    {
+      REQUIRE(persistence.node_exists("r0"));
+      REQUIRE(persistence.node_exists("r1"));
+      REQUIRE(persistence.staged_bytes() > 0);
+
+      PointBuffer retrieved;
+      persistence.retrieve_points("r1", retrieved);
+      REQUIRE(same_positions(retrieved, points_r1));
+    }
+
+    WHEN("A node is persisted again")
+    {
+      persistence.persist_points(points_r1, bounds, "r0");
+
+      THEN("The node is overwritten")
+      {
+        PointBuffer retrieved;
+        persistence.retrieve_points("r0", retrieved);
+        REQUIRE(same_positions(retrieved, points_r1));
+      }
+    }
+
+    WHEN("The persistence is flushed")
+    {
+      persistence.flush();
+
+      THEN("No nodes are staged anymore but all nodes still exist")
+      {
+        REQUIRE(persistence.staged_bytes() == 0);
+        REQUIRE(persistence.node_exists("r0"));
+
+        PointBuffer retrieved;
+        persistence.retrieve_points("r0", retrieved);
+        REQUIRE(same_positions(retrieved, points_r0));
+      }
+    }
+  }
+
+  GIVEN("A memory budget that fits only one node")
+  {
+    const auto budget =
+      static_cast<double>(points_r0.content_byte_size()) * boost::units::information::bytes;
+    StagingPersistence persistence{
+      std::make_unique<PointsPersistence>(MemoryPersistence{ attributes }),
+      attributes,
+      budget,
+      4,
+      PointOrder::Morton
+    };
+
+    persistence.persist_points(points_r0, bounds, "r0");
+    persistence.persist_points(points_r1, bounds, "r1");
+
+    THEN("Nodes are spilled to the backend and can still be retrieved")
+    {
+      REQUIRE(persistence.staged_bytes() <= points_r0.content_byte_size());
+
+      PointBuffer retrieved;
+      persistence.retrieve_points("r0", retrieved);
+      REQUIRE(same_positions(retrieved, points_r0));
+      persistence.retrieve_points("r1", retrieved);
+      REQUIRE(same_positions(retrieved, points_r1));
+    }
+  }
+
+  GIVEN("A memory budget that fits a quarter of the nodes of concurrent writers")
+  {
+    constexpr size_t ThreadCount = 8;
+    constexpr size_t NodesPerThread = 16;
+    const auto node_bytes = points_r0.content_byte_size();
+    const auto budget_bytes = node_bytes * ThreadCount * NodesPerThread / 4;
+    StagingPersistence persistence{
+      std::make_unique<PointsPersistence>(MemoryPersistence{ attributes }),
+      attributes,
+      static_cast<double>(budget_bytes) * boost::units::information::bytes,
+      4,
+      PointOrder::Morton
+    };
+
+    WHEN("All threads persist their nodes")
+    {
+      std::vector<std::thread> threads;
+      for (size_t thread_idx = 0; thread_idx < ThreadCount; ++thread_idx) {
+        threads.emplace_back([&persistence, thread_idx] {
+          for (size_t node_idx = 0; node_idx < NodesPerThread; ++node_idx) {
+            const auto offset = static_cast<double>(thread_idx * NodesPerThread + node_idx);
+            persistence.persist_points(generate_points(16, offset),
+                                       { { 0, 0, 0 }, { 1, 1, 1 } },
+                                       "r" + std::to_string(thread_idx) + "-" +
+                                         std::to_string(node_idx));
+          }
+        });
+      }
+      for (auto& thread : threads) {
+        thread.join();
+      }
+
+      THEN("The spills free the excess over the budget, but not more than one node in addition")
+      {
+        REQUIRE(persistence.staged_bytes() <= budget_bytes);
+        REQUIRE(persistence.staged_bytes() + node_bytes > budget_bytes);
+      }
+
+      THEN("All nodes can be retrieved")
+      {
+        for (size_t thread_idx = 0; thread_idx < ThreadCount; ++thread_idx) {
+          for (size_t node_idx = 0; node_idx < NodesPerThread; ++node_idx) {
+            const auto offset = static_cast<double>(thread_idx * NodesPerThread + node_idx);
+            PointBuffer retrieved;
+            persistence.retrieve_points(
+              "r" + std::to_string(thread_idx) + "-" + std::to_string(node_idx), retrieved);
+            REQUIRE(same_positions(retrieved, generate_points(16, offset)));
+          }
+        }
+      }
+    }
+  }
+
+  GIVEN("A point order other than the Morton order")
+  {
+    const AABB node_bounds{ { 0, 0, 0 }, { 2, 2, 2 } };
+    std::vector<Vector3<double>> positions;
+    for (size_t octant = 0; octant < 8; ++octant) {
+      positions.push_back(
+        { 0.5 + ((octant >> 2) & 1), 0.5 + ((octant >> 1) & 1), 0.5 + (octant & 1) });
+    }
+    PointBuffer grid_points{ positions.size(), std::move(positions) };
+    std::vector<PointBuffer::PointReference> point_references{ std::begin(grid_points),
+                                                               std::end(grid_points) };
+    order_points_in_node(point_references, node_bounds, PointOrder::Morton);
+    PointBuffer morton_points{ gsl::make_span(point_references) };
+
+    const auto budget = 1024.0 * 1024.0 * boost::units::information::bytes;
+    StagingPersistence persistence{
+      std::make_unique<PointsPersistence>(MemoryPersistence{ attributes }),
+      attributes,
+      budget,
+      4,
+      PointOrder::Hilbert
+    };
+    persistence.persist_points(morton_points, node_bounds, "r");
+
+    THEN("The staged node keeps the Morton order")
+    {
+      PointBuffer retrieved;
+      persistence.retrieve_points("r", retrieved);
+      REQUIRE(same_positions(retrieved, morton_points));
+    }
+
+    WHEN("The persistence is flushed")
+    {
+      persistence.flush();
+
+      THEN("The node is written in the point order")
+      {
+        std::vector<PointBuffer::PointReference> hilbert_points{ std::begin(morton_points),
+                                                                 std::end(morton_points) };
+        order_points_in_node(hilbert_points, node_bounds, PointOrder::Hilbert);
+
+        PointBuffer retrieved;
+        persistence.retrieve_points("r", retrieved);
+        REQUIRE(same_positions(retrieved, PointBuffer{ gsl::make_span(hilbert_points) }));
+        REQUIRE(!same_positions(retrieved, morton_points));
+      }
+    }
+  }
+
+  GIVEN("Deferred attributes and a memory budget that fits no node")
+  {
+    PointAttributes input_attributes = attributes;
+    input_attributes.insert(PointAttribute::Intensity);
+    PointAttributes deferred_attributes;
+    deferred_attributes.insert(PointAttribute::Intensity);
+    auto attribute_store = std::make_shared<AttributeStore>(deferred_attributes);
+
+    std::vector<Vector3<double>> positions{ { 0, 0, 0 }, { 1, 0, 0 }, { 2, 0, 0 } };
+    std::vector<uint16_t> intensities{ 10, 20, 30 };
+    PointBuffer points_with_intensities{ 3, std::move(positions), {}, {}, std::move(intensities) };
+    attribute_store->store(points_with_intensities);
+
+    const auto budget = 1.0 * boost::units::information::bytes;
+    StagingPersistence persistence{ std::make_unique<PointsPersistence>(
+                                      MemoryPersistence{ input_attributes }),
+                                    input_attributes,
+                                    budget,
+                                    4,
+                                    PointOrder::Morton,
+                                    attribute_store };
+    persistence.persist_points(points_with_intensities, bounds, "r0");
+    const auto stored_bytes = attribute_store->stored_bytes();
+
+    WHEN("The spilled node is retrieved twice")
+    {
+      PointBuffer retrieved;
+      persistence.retrieve_points("r0", retrieved);
+      persistence.retrieve_points("r0", retrieved);
+
+      THEN("The points get their IDs back instead of being stored again")
+      {
+        REQUIRE(attribute_store->stored_bytes() == stored_bytes);
+        REQUIRE(retrieved.has_point_ids());
+        REQUIRE(!retrieved.hasIntensities());
+
+        attribute_store->gather(retrieved);
+        REQUIRE(retrieved.intensities()[2] == 30);
+      }
+    }
+  }
+}
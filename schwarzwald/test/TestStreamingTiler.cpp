@@ -0,0 +1,126 @@
+#include <catch2/catch_all.hpp>
+
+#include "io/PointsPersistence.h"
+#include "process/StreamingTiler.h"
+
+#include <string>
+#include <vector>
+
+static TilerMetaParameters
+make_streaming_meta_parameters(size_t batch_size)
+{
+  TilerMetaParameters meta_parameters;
+  meta_parameters.spacing_at_root = 1.f;
+  meta_parameters.max_depth = 20;
+  meta_parameters.max_points_per_node = 64;
+  meta_parameters.batch_read_size = batch_size;
+  meta_parameters.internal_cache_size = batch_size;
+  meta_parameters.shift_points_to_origin = false;
+  meta_parameters.create_journal = false;
+  meta_parameters.tiling_strategy = TilingStrategy::Fast;
+  meta_parameters.thread_count = AdaptiveThreadCount{ 4 };
+  meta_parameters.estimate_normals = false;
+  meta_parameters.point_order = PointOrder::Morton;
+  return meta_parameters;
+}
+
+/**
+ * One layer of a grid of points with the given height, with one point in the
+ * center of each cell of a 16x16 grid
+ */
+static PointBuffer
+generate_layer(double z)
+{
+  std::vector<Vector3<double>> positions;
+  for (size_t x = 0; x < 16; ++x) {
+    for (size_t y = 0; y < 16; ++y) {
+      positions.push_back({ x + 0.5, y + 0.5, z });
+    }
+  }
+  const auto count = positions.size();
+  return { count, std::move(positions) };
+}
+
+SCENARIO("StreamingTiler", "[StreamingTiler]")
+{
+  PointAttributes attributes;
+  attributes.insert(PointAttribute::Position);
+  // Flat bounds, whose cubic root node reaches above them
+  const AABB bounds{ { 0, 0, 0 }, { 16, 16, 8 } };
+  constexpr size_t BatchSize = 256;
+
+  GIVEN("A StreamingTiler that flushes after every batch")
+  {
+    PointsPersistence persistence{ MemoryPersistence{ attributes } };
+    const auto& tiled_nodes = persistence.get<MemoryPersistence>().get_points();
+
+    // The flush callback runs on the background thread, so the octree is only
+    // checked there and the results are checked once the tiler has finished
+    size_t flush_count = 0;
+    std::vector<std::string> nodes_without_parent;
+    auto check_ancestors = [&](size_t) {
+      ++flush_count;
+      for (const auto& [node_name, points] : tiled_nodes) {
+        if (node_name.size() > 1 && !tiled_nodes.count(node_name.substr(0, node_name.size() - 1))) {
+          nodes_without_parent.push_back(node_name);
+        }
+      }
+    };
+
+    StreamingTiler tiler{ bounds,
+                          make_streaming_meta_parameters(BatchSize),
+                          make_sampling_strategy<RandomSortedGridSampling>(size_t{ 64 }),
+                          { std::chrono::milliseconds{ 10 }, 1 },
+                          nullptr,
+                          persistence,
+                          attributes,
+                          check_ancestors };
+
+    WHEN("Several small batches are inserted")
+    {
+      constexpr size_t NumLayers = 8;
+      for (size_t layer = 0; layer < NumLayers; ++layer) {
+        tiler.insert(generate_layer(layer + 0.5));
+      }
+      const auto tiled_points_count = tiler.finish();
+
+      THEN("All points are in the octree")
+      {
+        REQUIRE(tiled_points_count == NumLayers * BatchSize);
+        REQUIRE(tiler.dropped_points_count() == 0);
+
+        // The points of the reconstructed levels are copies of deeper points
+        size_t points_in_octree = 0;
+        for (const auto& [node_name, points] : tiled_nodes) {
+          if (node_name.size() - 1 >= tiler.reconstructed_levels()) {
+            points_in_octree += points.count();
+          }
+        }
+        REQUIRE(points_in_octree == NumLayers * BatchSize);
+      }
+
+      THEN("The ancestors of all nodes exist after each flush")
+      {
+        REQUIRE(flush_count > 0);
+        REQUIRE(nodes_without_parent.empty());
+        REQUIRE(tiled_nodes.count("r"));
+      }
+    }
+
+    WHEN("Points outside of the bounds are inserted")
+    {
+      // Inside of the cubic root node, but above the bounds
+      tiler.insert(generate_layer(10));
+      // Outside of the root node
+      tiler.insert(generate_layer(-10));
+      tiler.insert(generate_layer(1));
+      const auto tiled_points_count = tiler.finish();
+
+      THEN("These points are dropped")
+      {
+        REQUIRE(tiler.dropped_points_count() == 2 * BatchSize);
+        REQUIRE(tiled_points_count == BatchSize);
+      }
+    }
+  }
+}
@@ -0,0 +1,38 @@
+#include <catch2/catch_all.hpp>
+
+#include "tiling/TilingAlgorithms.h"
+
+#include <vector>
+
+SCENARIO("SubtreeQueue", "[SubtreeQueue]")
+{
+  SubtreeQueue queue;
+  std::vector<int> executed_jobs;
+  const auto make_job = [&executed_jobs](int id) -> SubtreeQueue::Job {
+    return [&executed_jobs, id](tf::Subflow&) { executed_jobs.push_back(id); };
+  };
+
+  GIVEN("Jobs with different costs")
+  {
+    queue.push(10, make_job(1));
+    queue.push(1000, make_job(2));
+    queue.push(10, make_job(3));
+    queue.push(500, make_job(4));
+
+    WHEN("All jobs are popped")
+    {
+      tf::Taskflow taskflow;
+      taskflow.emplace([&queue](tf::Subflow& subflow) {
+        for (size_t idx = 0; idx < 4; ++idx) {
+          queue.pop_most_expensive()(subflow);
+        }
+      });
+      tf::Executor{ 1 }.run(taskflow).wait();
+
+      THEN("The most expensive jobs run first and equal costs keep their order")
+      {
+        REQUIRE(executed_jobs == std::vector<int>{ 2, 4, 1, 3 });
+      }
+    }
+  }
+}
@@ -0,0 +1,58 @@
+#include <catch2/catch_all.hpp>
+
+#include "tiling/TaskGranularity.h"
+
+using namespace std::chrono_literals;
+
+SCENARIO("TaskGranularity", "[TaskGranularity]")
+{
+  TaskGranularity granularity;
+  granularity.set_concurrency(4);
+
+  GIVEN("No measurements")
+  {
+    THEN("The default task size is used")
+    {
+      REQUIRE(granularity.min_points_per_task() == 100'000);
+      REQUIRE(granularity.should_spawn_task(100'000, 0));
+      REQUIRE(!granularity.should_spawn_task(99'999, 0));
+    }
+  }
+
+  GIVEN("Measured dispatch latencies and node durations")
+  {
+    granularity.record_dispatch_latency(50us);
+    granularity.record_dispatch_latency(10us);
+    granularity.record_dispatch_latency(2ms);
+    for (size_t idx = 0; idx < 10; ++idx) {
+      // 100ns per point
+      granularity.record_node_duration(10'000, 1ms);
+    }
+
+    THEN("The task size is derived from the smallest latency and the time per point")
+    {
+      // 100 * 10us / 100ns, up to rounding
+      REQUIRE(granularity.min_points_per_task() >= 9'999);
+      REQUIRE(granularity.min_points_per_task() <= 10'000);
+    }
+
+    THEN("No tasks are spawned while enough tasks are pending")
+    {
+      REQUIRE(granularity.should_spawn_task(20'000, 15));
+      REQUIRE(!granularity.should_spawn_task(20'000, 16));
+    }
+  }
+
+  GIVEN("Very expensive tasks")
+  {
+    granularity.record_dispatch_latency(1s);
+    for (size_t idx = 0; idx < 10; ++idx) {
+      granularity.record_node_duration(10'000, 1ms);
+    }
+
+    THEN("The task size is limited")
+    {
+      REQUIRE(granularity.min_points_per_task() == 10'000'000);
+    }
+  }
+}
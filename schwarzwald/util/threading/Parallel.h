@@ -212,4 +212,84 @@ scatter(InputIterator begin,
   return result;
 }
 
+/**
+ * Parallel sort using taskflow. Sorts 'concurrency' chunks of the range in
+ * parallel and merges adjacent sorted chunks pairwise until the whole range is
+ * sorted. Returns the task that runs before the sorting and the task that runs
+ * after the range is sorted
+ */
+template<typename RandomAccessIterator, typename Taskflow>
+std::pair<tf::Task, tf::Task>
+sort(RandomAccessIterator first,
+     RandomAccessIterator last,
+     Taskflow& taskflow,
+     size_t concurrency,
+     std::string name_prefix = "")
+{
+  auto begin_task = taskflow.placeholder();
+  auto end_task = taskflow.placeholder();
+
+  const auto name_tasks = !name_prefix.empty();
+  if (name_tasks) {
+    begin_task.name(util::concat(name_prefix, "_begin"));
+    end_task.name(util::concat(name_prefix, "_end"));
+  }
+
+  const auto distance = static_cast<size_t>(std::abs(std::distance(first, last)));
+  if (concurrency < 2 || distance <= concurrency) {
+    auto sort_task = taskflow.emplace([=]() { std::sort(first, last); });
+    if (name_tasks) {
+      sort_task.name(name_prefix);
+    }
+    begin_task.precede(sort_task);
+    sort_task.precede(end_task);
+    return std::make_pair(begin_task, end_task);
+  }
+
+  struct SortedRange
+  {
+    RandomAccessIterator begin, end;
+    tf::Task task;
+  };
+
+  std::vector<SortedRange> sorted_ranges;
+  const auto chunks = split_range_into_chunks(concurrency, first, last);
+  for (size_t idx = 0; idx < chunks.size(); ++idx) {
+    const auto [chunk_begin, chunk_end] = chunks[idx];
+    auto sort_task = taskflow.emplace([=]() { std::sort(chunk_begin, chunk_end); });
+    if (name_tasks) {
+      sort_task.name(util::concat(name_prefix, "_", idx));
+    }
+    begin_task.precede(sort_task);
+    sorted_ranges.push_back({ chunk_begin, chunk_end, sort_task });
+  }
+
+  // Merge adjacent ranges pairwise, each level of merges can run in parallel
+  for (size_t level = 0; sorted_ranges.size() > 1; ++level) {
+    std::vector<SortedRange> merged_ranges;
+    for (size_t idx = 0; idx + 1 < sorted_ranges.size(); idx += 2) {
+      auto& left = sorted_ranges[idx];
+      auto& right = sorted_ranges[idx + 1];
+      const auto merge_begin = left.begin;
+      const auto merge_middle = right.begin;
+      const auto merge_end = right.end;
+      auto merge_task = taskflow.emplace(
+        [=]() { std::inplace_merge(merge_begin, merge_middle, merge_end); });
+      if (name_tasks) {
+        merge_task.name(util::concat(name_prefix, "_merge_", level, "_", idx / 2));
+      }
+      left.task.precede(merge_task);
+      right.task.precede(merge_task);
+      merged_ranges.push_back({ merge_begin, merge_end, merge_task });
+    }
+    if (sorted_ranges.size() % 2 == 1) {
+      merged_ranges.push_back(sorted_ranges.back());
+    }
+    sorted_ranges = std::move(merged_ranges);
+  }
+
+  sorted_ranges.front().task.precede(end_task);
+  return std::make_pair(begin_task, end_task);
+}
+
 } // namespace parallel
\ No newline at end of file